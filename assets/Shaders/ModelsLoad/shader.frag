@@ -1,5 +1,12 @@
 #version 450
 
+// Permutations, see permutations.txt:
+//   DEBUG_VIEW  undefined for the texture, else one of the views below in place of it
+//   ALPHA_TEST  discard the fragments whose texture alpha is under ALPHA_CUTOFF
+#define DEBUG_VIEW_UV 1
+#define DEBUG_VIEW_VERTEX_COLOR 2
+#define ALPHA_CUTOFF 0.5
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 
@@ -8,6 +15,15 @@ layout(location = 0) out vec4 outColor;
 layout(set = 0, binding = 1) uniform sampler2D texSampler;
 
 void main() {
+#if defined(DEBUG_VIEW) && DEBUG_VIEW == DEBUG_VIEW_UV
+    outColor = vec4(fragTexCoord, 0.0, 1.0);
+#elif defined(DEBUG_VIEW) && DEBUG_VIEW == DEBUG_VIEW_VERTEX_COLOR
+    outColor = vec4(fragColor, 1.0);
+#else
     outColor = texture(texSampler, fragTexCoord);
-    
+#endif
+#ifdef ALPHA_TEST
+    if (outColor.a < ALPHA_CUTOFF)
+        discard;
+#endif
 }
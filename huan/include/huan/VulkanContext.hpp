@@ -6,6 +6,7 @@
 
 #include <vulkan/vulkan.hpp>
 #include <optional>
+#include <span>
 #include <vector>
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -13,9 +14,22 @@
 
 #include <huan/common.hpp>
 #include <huan/backend/swapchain.hpp>
+#include <huan/backend/resource/defragmentation_system.hpp>
+#include <huan/backend/resource/geometry_arena.hpp>
+#include <huan/backend/resource/resource_handles.hpp>
+#include <huan/backend/resource/staging_ring.hpp>
+#include <huan/backend/shader.hpp>
+#include <huan/backend/shader/shader_archive.hpp>
+#include <huan/backend/pipeline/pipeline_compiler.hpp>
+#include <huan/backend/render_queue.hpp>
+#include <huan/backend/gpu_culler.hpp>
+#include <huan/scene_framework/frustum_culler.hpp>
+#include <huan/scene_framework/occlusion_culler.hpp>
 
 const std::string MODEL_PATH = "../../../../assets/Models/viking_room/viking_room.obj";
 const std::string TEXTURE_PATH = "../../../../assets/Models/viking_room/viking_room.png";
+// Shader names (and their variant IDs in the shader archive) are relative to this directory
+const std::string SHADER_ROOT = "../../../../assets/Shaders/";
 
 struct GLFWwindow;
 
@@ -26,6 +40,10 @@ namespace runtime::vulkan
 class Image;
 class Buffer;
 } // namespace vulkan
+namespace utils
+{
+class ThreadPool;
+}
 
 struct Vertex
 {
@@ -63,6 +81,42 @@ struct Vertex
     }
 };
 
+/**
+ * @brief Per instance vertex input of the instanced draws, the world matrix as 4 columns.
+ */
+struct InstanceData
+{
+    static constexpr uint32_t Binding = 1;
+    static constexpr uint32_t FirstLocation = 3;
+
+    glm::mat4 m_model;
+
+    static vk::VertexInputBindingDescription getBindingDescription()
+    {
+        vk::VertexInputBindingDescription bindingDescription;
+        bindingDescription.setBinding(Binding).setStride(sizeof(InstanceData)).setInputRate(
+            vk::VertexInputRate::eInstance);
+
+        return bindingDescription;
+    }
+
+    static std::vector<vk::VertexInputAttributeDescription> getAttributeDescriptions()
+    {
+        std::vector<vk::VertexInputAttributeDescription> attributeDescriptions(4);
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            attributeDescriptions[column].binding = Binding;
+            attributeDescriptions[column].location = FirstLocation + column;
+            attributeDescriptions[column].format = vk::Format::eR32G32B32A32Sfloat;
+            attributeDescriptions[column].offset = column * sizeof(glm::vec4);
+        }
+
+        return attributeDescriptions;
+    }
+};
+// The transforms of the RenderQueue are uploaded as they are
+static_assert(sizeof(InstanceData) == sizeof(glm::mat4));
+
 struct VulkanFrameData
 {
     vk::CommandBuffer m_commandBuffer;
@@ -70,8 +124,13 @@ struct VulkanFrameData
     vk::Semaphore m_imageAvailableSemaphore;
     vk::Semaphore m_renderFinishedSemaphore;
 
-    Scope<runtime::vulkan::Buffer> m_uniformBuffer;
+    runtime::BufferHandle m_uniformBuffer;
     vk::DescriptorSet m_descriptorSet;
+    // Grown on demand, hold the InstanceData and the indirect commands then counts of the frame
+    runtime::BufferHandle m_instanceBuffer;
+    runtime::BufferHandle m_indirectBuffer;
+    // Uploads to the buffers above when the host can't map them, reset once m_fence signaled
+    runtime::StagingRing m_stagingRing;
 };
 
 struct UniformBufferObject
@@ -81,6 +140,43 @@ struct UniformBufferObject
     alignas(16) glm::mat4 m_proj;
 };
 
+/**
+ * @brief What the memory heaps of the device allow, probed once when the allocator is created.
+ */
+struct DeviceMemoryCapabilities
+{
+    // Some memory type is both DEVICE_LOCAL and HOST_VISIBLE: ReBAR, integrated GPUs, software rasterizers
+    bool hasHostVisibleDeviceLocal = false;
+    // The whole device local memory is host visible, e.g. integrated GPUs or lavapipe
+    bool isUnifiedMemory = false;
+    // Largest heap holding a HOST_VISIBLE | DEVICE_LOCAL type, only 256MB on discrete GPUs without ReBAR
+    vk::DeviceSize hostVisibleDeviceLocalHeapSize = 0;
+    vk::DeviceSize deviceLocalHeapSize = 0;
+};
+
+/**
+ * @brief Indirect drawing features of the device, probed and enabled when the device is created.
+ */
+struct DeviceDrawCapabilities
+{
+    // multiDrawIndirect and drawIndirectFirstInstance, without which the instanced draws are recorded one by one
+    bool hasMultiDrawIndirect = false;
+    // Vulkan 1.2 drawIndirectCount, on top of the above
+    bool hasDrawIndirectCount = false;
+};
+
+/**
+ * @brief Vulkan 1.2 descriptor indexing features, probed and enabled when the device is created. Without them the
+ * LayoutCache drops the update-after-bind flags and builds plain layouts.
+ */
+struct DeviceDescriptorCapabilities
+{
+    // descriptorBindingSampledImageUpdateAfterBind, also covers combined image samplers
+    bool hasSampledImageUpdateAfterBind = false;
+    // descriptorBindingStorageImageUpdateAfterBind
+    bool hasStorageImageUpdateAfterBind = false;
+};
+
 class HUAN_API VulkanContext
 {
 public:
@@ -107,6 +203,39 @@ public:
     {
         return initialized;
     }
+    [[nodiscard]] bool isDeviceExtensionEnabled(std::string_view extensionName) const;
+    [[nodiscard]] const DeviceMemoryCapabilities& getMemoryCapabilities() const
+    {
+        return memoryCapabilities;
+    }
+    [[nodiscard]] const DeviceDrawCapabilities& getDrawCapabilities() const
+    {
+        return drawCapabilities;
+    }
+    [[nodiscard]] const DeviceDescriptorCapabilities& getDescriptorCapabilities() const
+    {
+        return descriptorCapabilities;
+    }
+    /**
+     * @brief Pipeline of the default material, ready from the start: the fallback of background compilations.
+     */
+    [[nodiscard]] runtime::PipelineHandle getDefaultPipeline() const
+    {
+        return m_defaultPipeline;
+    }
+    /**
+     * SPIR-V and reflection of a shader variant: from the shader archive, else from the SPIR-V cache, else compiled
+     * from SHADER_ROOT + shaderName when the shader compiler is built in.
+     * @note Thread safe, pipelines compiled in the background load their shaders through it.
+     * @param fromSource Skip the shader archive, e.g. to see the edits of a hot reloaded shader.
+     * @param dependencies If not null, receives the shader file then the files it includes. The includes are only
+     * known when the shader is loaded from source.
+     * @return False with the reason in `infoLog` if the variant can't be found or compiled.
+     */
+    bool loadShaderBinary(std::string_view shaderName, vk::ShaderStageFlagBits stage,
+                          const runtime::vulkan::ShaderVariant& variant, std::vector<uint32_t>& spirv,
+                          std::vector<runtime::vulkan::ShaderResource>& resources, std::string& infoLog,
+                          bool fromSource = false, std::vector<std::string>* dependencies = nullptr) const;
 
 private:
     void initLogSystem();
@@ -115,20 +244,29 @@ private:
     void initVulkan();
     [[nodiscard]] static std::vector<const char*> getRequiredInstanceExtensions();
     [[nodiscard]] static std::vector<const char*> getRequiredDeviceExtensions();
+    // Enabled only if the physical device supports them
+    [[nodiscard]] static std::vector<const char*> getOptionalDeviceExtensions();
     void createInstance();
     void createDebugMessenger();
     void pickPhysicalDevice();
     void queryQueueFamilyIndices();
     void createDevice();
     void createAllocator();
+    void probeMemoryCapabilities();
     void getQueues();
 
     void createSurface();
     void createSwapchain();
     void createDescriptorPool();
     void createDescriptorSets();
+    void writeDescriptorSets();
     void createGraphicsPipeline();
-    void createDescriptorSetLayout();
+    void loadShaderArchive();
+    /**
+     * @brief Blocking, throws if the shader can't be loaded. See loadShaderBinary().
+     */
+    runtime::vulkan::ShaderModule loadShaderModule(std::string_view shaderName, vk::ShaderStageFlagBits stage,
+                                                   const runtime::vulkan::ShaderVariant& variant = {});
     void createRenderPass();
     void createFramebuffers();
     vk::Format findSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling,
@@ -148,8 +286,16 @@ private:
     void createSynchronization();
     void createUniformBuffers();
     void createFrameData();
+    void createGpuCuller();
 
     void recordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+    runtime::vulkan::Buffer* reserveFrameBuffer(runtime::BufferHandle& handle, vk::BufferUsageFlags usage,
+                                                vk::DeviceSize size, std::string_view name);
+    bool uploadInstanceData(vk::CommandBuffer commandBuffer, std::span<const glm::mat4> transforms);
+    void bindInstanceData(vk::CommandBuffer commandBuffer, std::span<const glm::mat4> transforms);
+    [[nodiscard]] bool isIndirectDrawUsable() const;
+    bool uploadIndirectDraws(vk::CommandBuffer commandBuffer);
+    void recordDraws(vk::CommandBuffer commandBuffer);
     void recreateSwapChain();
 
 public:
@@ -173,8 +319,12 @@ INNER_VISIBLE:
     vk::DebugUtilsMessengerCreateInfoEXT debugCreateInfo;
     vk::DebugUtilsMessengerEXT debugMessenger;
     vk::PhysicalDevice physicalDevice;
+    std::vector<const char*> m_enabledDeviceExtensions;
     vk::Device device;
     VmaAllocator allocator;
+    DeviceMemoryCapabilities memoryCapabilities;
+    DeviceDrawCapabilities drawCapabilities;
+    DeviceDescriptorCapabilities descriptorCapabilities;
     QueueFamilyIndices queueFamilyIndices;
     vk::Queue graphicsQueue;
     vk::Queue presentQueue;
@@ -183,10 +333,17 @@ INNER_VISIBLE:
     vk::SurfaceKHR surface;
     Scope<Swapchain> swapchain;
 
+    runtime::ShaderArchive m_shaderArchive;
+    // Both owned by the LayoutCache
     vk::PipelineLayout m_pipelineLayout;
     vk::DescriptorSetLayout m_descriptorSetLayout;
     vk::DescriptorPool m_descriptorPool;
-    vk::Pipeline m_graphicsPipeline;
+    // For the sets whose layout the LayoutCache made update-after-bind, only created when the device supports it
+    vk::DescriptorPool m_updateAfterBindDescriptorPool;
+    // Owned by the PipelineStateCache, resolved through the PipelineCompiler
+    runtime::PipelineHandle m_defaultPipeline;
+    // Variant of the default pipeline the model is drawn with, requested from the PipelineCompiler
+    runtime::PipelineHandle m_modelPipeline;
     vk::RenderPass m_renderPass;
 
     // 画架们
@@ -195,16 +352,37 @@ INNER_VISIBLE:
     vk::CommandPool m_commandPool;
     vk::CommandPool m_transferCommandPool;
 
+    Scope<utils::ThreadPool> m_frameWorkers;
+    // Of the frame being recorded, its planes cull the draws
+    UniformBufferObject m_uniformData{};
+    framework::scene_graph::FrustumCuller m_frustumCuller;
+    // Draws with no occluder added, e.g. by Scene::collectOccluders(), are only frustum culled
+    framework::scene_graph::OcclusionCuller m_occlusionCuller;
+    // Survives the frames to keep its capacity
+    std::vector<framework::scene_graph::DrawItem> m_visibleDraws;
+    runtime::RenderQueue m_renderQueue;
+    // Replaces the CPU culling and the render queue when enabled and supported
+    Scope<runtime::GpuCuller> m_gpuCuller;
+    // Frames whose draws didn't share a single state, culled on the CPU instead
+    uint32_t m_mixedStateFrameCount = 0;
+
     std::vector<VulkanFrameData> m_frameDatas;
     uint32_t m_currentFrame = 0;
+    // Monotonic, unlike m_currentFrame which wraps around maxFramesInFlight
+    uint32_t m_frameNumber = 0;
 
-    Scope<runtime::vulkan::Buffer> m_vertexBuffer;
-    Scope<runtime::vulkan::Buffer> m_indexBuffer;
+    // Ranges of the shared GeometryArena buffers
+    runtime::GeometryAllocation m_vertexAllocation;
+    runtime::GeometryAllocation m_indexAllocation;
 
-    Scope<runtime::vulkan::Image> m_textureImage;
+    // Rewrites the descriptor sets once the texture was moved by the DefragmentationSystem
+    runtime::DefragmentationSystem::ListenerId m_relocationListener = runtime::DefragmentationSystem::NoListener;
+    runtime::ImageHandle m_textureImage;
+    runtime::ImageViewHandle m_textureImageView;
     vk::Sampler m_textureSampler;
 
-    Scope<runtime::vulkan::Image> m_depthImage;
+    runtime::ImageHandle m_depthImage;
+    runtime::ImageViewHandle m_depthImageView;
 
 
     bool initialized = false;
@@ -214,5 +392,7 @@ INNER_VISIBLE:
     std::vector<Vertex> m_vertices = {};
 
     std::vector<uint32_t> m_indices = {};
+    // In model space
+    framework::scene_graph::BoundingBox m_modelBounds;
 };
 } // namespace huan
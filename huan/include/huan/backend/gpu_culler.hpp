@@ -0,0 +1,167 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "huan/common.hpp"
+#include "huan/backend/pipeline/pipeline_compiler.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
+#include "huan/backend/resource/resource_handles.hpp"
+#include "huan/backend/resource/staging_ring.hpp"
+#include "huan/scene_framework/bounding_volumes.hpp"
+#include "huan/scene_framework/frustum_culler.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class ShaderModule;
+}
+
+/**
+ * Frustum culling on the device. The draws of a frame, one per instance, are uploaded with their world bounds, then
+ * the GpuCulling/cull.comp shader tests them and appends the commands of the visible ones with an atomic counter.
+ * drawIndexedIndirectCount() draws them without the CPU ever knowing how many survived, so the per draw work leaves
+ * the render thread.
+ * The commands come in no particular order, only their set is deterministic, and one indirect call draws them all:
+ * every draw of a frame has to share its pipeline and descriptor set, see hasMixedStates().
+ * With validation on, the commands are read back once the frame is done and compared with what FrustumCuller finds
+ * for the same draws.
+ * @note Needs drawIndirectCount and drawIndirectFirstInstance, and records its dispatch in the graphics command
+ * buffer, outside of a render pass.
+ */
+class HUAN_API GpuCuller
+{
+public:
+    /**
+     * Input of the shader, std430 layout of DrawRecord in cull.comp.
+     */
+    struct DrawRecord
+    {
+        // w unused
+        glm::vec4 center;
+        glm::vec4 extents;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
+    static_assert(sizeof(DrawRecord) == 48);
+
+    struct Stats
+    {
+        uint32_t drawCount = 0;
+        // Frames read back and compared with the CPU culler, and those which disagreed
+        uint32_t validatedFrameCount = 0;
+        uint32_t mismatchFrameCount = 0;
+        // Frames whose pipeline wasn't ready and had no fallback, nothing was drawn
+        uint32_t skippedFrameCount = 0;
+    };
+
+    static constexpr uint32_t WorkgroupSize = 64;
+
+    GpuCuller() = default;
+    HUAN_NO_COPY(GpuCuller)
+
+    /**
+     * @param frameCount Frames in flight, each has its own buffers.
+     * @return False if the pipeline can't be created.
+     */
+    bool create(const vulkan::ShaderModule& shader, uint32_t frameCount, bool isValidationEnabled);
+    /**
+     * @brief Releases the buffers and descriptor sets, once the device is idle. The pipeline belongs to the
+     * PipelineStateCache.
+     */
+    void destroy();
+
+    void clear();
+    /**
+     * @brief Adds an instance of `draw`, the draw and its transform get the index of the instance.
+     */
+    uint32_t add(const framework::scene_graph::BoundingBox& worldBounds,
+                 const framework::scene_graph::DrawItem& draw, const glm::mat4& world, PipelineHandle pipeline,
+                 vk::DescriptorSet descriptorSet);
+    /**
+     * @return True if the draws added since clear() don't all share their pipeline and descriptor set. The frame
+     * can't be culled on the device then, the caller culls it on the CPU instead.
+     */
+    [[nodiscard]] bool hasMixedStates() const
+    {
+        return m_hasMixedStates;
+    }
+    /**
+     * @brief World matrices of the instances, to bind as the per instance vertex buffer before draw().
+     */
+    [[nodiscard]] std::span<const glm::mat4> getInstanceTransforms() const
+    {
+        return m_instanceTransforms;
+    }
+
+    /**
+     * @brief Uploads the draws and records the culling dispatch, outside of a render pass.
+     * @param frame Frame in flight, whose previous use must be over.
+     */
+    void dispatch(vk::CommandBuffer commandBuffer, uint32_t frame, const framework::scene_graph::Frustum& frustum);
+    /**
+     * @brief Binds the pipeline and descriptor set of the draws and records the indirect draw of what dispatch()
+     * kept. Skipped while the pipeline isn't ready and has no fallback, e.g. during a hot reload.
+     */
+    void draw(vk::CommandBuffer commandBuffer, uint32_t frame, vk::PipelineLayout layout);
+
+    [[nodiscard]] const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct FrameResources
+    {
+        BufferHandle records;
+        BufferHandle commands;
+        BufferHandle count;
+        // Count then commands, copied after the dispatch when validating
+        BufferHandle readback;
+        // Uploads the records when the host can't map them
+        StagingRing stagingRing;
+        vk::DescriptorSet descriptorSet;
+        // The buffers were recreated or moved by the DefragmentationSystem since the last write
+        bool isDescriptorSetDirty = true;
+        uint32_t drawCount = 0;
+        // What the CPU culler kept, sorted first instances
+        std::vector<uint32_t> expectedInstances;
+        bool isReadbackPending = false;
+    };
+
+    vk::Device m_device;
+    vk::Pipeline m_pipeline;
+    vk::PipelineLayout m_pipelineLayout;
+    vk::DescriptorPool m_descriptorPool;
+    std::vector<FrameResources> m_frames;
+    // The records, commands and count buffers are moved by the DefragmentationSystem
+    DefragmentationSystem::ListenerId m_relocationListener = DefragmentationSystem::NoListener;
+    bool m_isValidationEnabled = false;
+
+    std::vector<DrawRecord> m_records;
+    std::vector<glm::mat4> m_instanceTransforms;
+    // Shared by every draw of the frame
+    PipelineHandle m_drawPipeline;
+    vk::DescriptorSet m_drawDescriptorSet;
+    bool m_hasMixedStates = false;
+    framework::scene_graph::FrustumCuller m_referenceCuller;
+    std::vector<framework::scene_graph::DrawItem> m_referenceDraws;
+    std::vector<uint32_t> m_readbackInstances;
+    Stats m_stats{};
+
+    void reserveBuffers(FrameResources& frame, uint32_t frameIndex);
+    void writeDescriptorSet(const FrameResources& frame) const;
+    void validate(FrameResources& frame);
+};
+} // namespace huan::runtime
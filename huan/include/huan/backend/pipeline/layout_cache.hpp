@@ -0,0 +1,106 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class ShaderModule;
+struct ShaderResource;
+} // namespace vulkan
+
+struct DescriptorSetLayoutDesc
+{
+    // Sorted by binding, bindingFlags is parallel to it
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+    std::vector<vk::DescriptorBindingFlags> bindingFlags;
+
+    [[nodiscard]] bool isUpdateAfterBind() const;
+    [[nodiscard]] uint64_t computeHash() const;
+};
+
+struct PipelineLayoutDesc
+{
+    // Indexed by set number, sets without bindings stay empty
+    std::vector<DescriptorSetLayoutDesc> sets;
+    std::vector<vk::PushConstantRange> pushConstantRanges;
+
+    [[nodiscard]] uint64_t computeHash() const;
+};
+
+/**
+ * @brief A cached pipeline layout and the set layouts it was made of, owned by the LayoutCache.
+ */
+struct PipelineLayoutInfo
+{
+    vk::PipelineLayout handle;
+    // Indexed by set number
+    std::vector<vk::DescriptorSetLayout> setLayouts;
+};
+
+/**
+ * Descriptor set layouts and pipeline layouts built from the reflected resources of a program, cached by the hash
+ * of their bindings so that identical layouts are shared by every pipeline using them.
+ * A binding used by several stages is visible to all of them, ShaderResourceMode::Dynamic gives dynamic buffers and
+ * ShaderResourceMode::UpdateAfterBind gives update-after-bind bindings in an update-after-bind set, plain ones on a
+ * device without the feature (DeviceDescriptorCapabilities).
+ * @note Thread safe. Layouts live until destroy().
+ */
+class LayoutCache final : public DeferredSystem<LayoutCache>
+{
+    friend class DeferredSystem<LayoutCache>;
+
+public:
+    /**
+     * @brief Merge the resources of every stage of a program into one layout description.
+     * @return False if two stages disagree on the type of a binding.
+     */
+    static bool buildDesc(const std::vector<const vulkan::ShaderModule*>& modules, PipelineLayoutDesc& desc);
+    static bool buildDesc(const std::vector<vulkan::ShaderResource>& resources, PipelineLayoutDesc& desc);
+
+    /**
+     * @return Null on failure.
+     */
+    vk::DescriptorSetLayout getOrCreateSetLayout(const DescriptorSetLayoutDesc& desc);
+    /**
+     * @return Pointer stable until destroy(), null on failure.
+     */
+    const PipelineLayoutInfo* getOrCreatePipelineLayout(const PipelineLayoutDesc& desc);
+    /**
+     * @brief buildDesc() then getOrCreatePipelineLayout().
+     */
+    const PipelineLayoutInfo* getOrCreatePipelineLayout(const std::vector<const vulkan::ShaderModule*>& modules);
+
+    void destroy();
+
+    /**
+     * @return Whether sets of `setLayout` must come from a pool created with eUpdateAfterBind.
+     */
+    [[nodiscard]] bool isUpdateAfterBind(vk::DescriptorSetLayout setLayout) const;
+
+    [[nodiscard]] size_t getSetLayoutCount() const;
+    [[nodiscard]] size_t getPipelineLayoutCount() const;
+
+protected:
+    explicit LayoutCache();
+
+private:
+    vk::DescriptorSetLayout getOrCreateSetLayoutLocked(const DescriptorSetLayoutDesc& desc);
+
+    vk::Device& deviceHandle;
+    std::unordered_map<uint64_t, vk::DescriptorSetLayout> m_setLayouts;
+    std::unordered_map<uint64_t, PipelineLayoutInfo> m_pipelineLayouts;
+    // The layouts actually created with eUpdateAfterBindPool, i.e. supported by the device
+    std::vector<vk::DescriptorSetLayout> m_updateAfterBindSetLayouts;
+    mutable std::mutex m_mutex;
+};
+} // namespace huan::runtime
@@ -0,0 +1,58 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <string>
+
+#include "vulkan/vulkan.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+/**
+ * The driver's vk::PipelineCache, persisted across runs so that pipelines compiled once come back from disk.
+ * The saved data is only fed back to the driver when its header matches the current physical device (vendor,
+ * device, pipeline cache UUID) and driver version, a stale or corrupted file is discarded instead.
+ */
+class PipelineCache final : public DeferredSystem<PipelineCache>
+{
+    friend class DeferredSystem<PipelineCache>;
+
+public:
+    /**
+     * @brief Create the cache, seeded with the file of the previous run if it's still valid.
+     */
+    void init();
+    /**
+     * @brief Write the current content to disk, atomically.
+     */
+    bool save() const;
+    /**
+     * @brief Save, then destroy the cache. Pipelines created with it stay valid.
+     */
+    void destroy();
+
+    [[nodiscard]] vk::PipelineCache getHandle() const;
+    /**
+     * @return True if init() reused data from a previous run.
+     */
+    [[nodiscard]] bool isWarm() const;
+
+protected:
+    explicit PipelineCache();
+
+private:
+    /**
+     * @return False if `data` wasn't produced by this device and driver.
+     */
+    [[nodiscard]] bool isCompatible(const std::vector<char>& data) const;
+
+    vk::Device& deviceHandle;
+    vk::PhysicalDevice& physicalDeviceHandle;
+
+    std::string m_filePath;
+    vk::PipelineCache m_cache;
+    bool m_warm = false;
+};
+} // namespace huan::runtime
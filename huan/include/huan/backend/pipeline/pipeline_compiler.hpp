@@ -0,0 +1,173 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "huan/backend/pipeline/pipeline_state_cache.hpp"
+#include "huan/backend/shader.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+#include "huan/common_templates/slot_map.hpp"
+#include "huan/utils/file_watcher.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::runtime
+{
+// A pipeline requested from the PipelineCompiler, possibly still compiling
+using PipelineHandle = Handle<vk::Pipeline>;
+
+enum class PipelineStatus : uint8_t
+{
+    Pending,
+    Ready,
+    Failed,
+};
+
+struct PipelineShaderDesc
+{
+    // Relative to SHADER_ROOT, like the names given to VulkanContext::loadShaderModule()
+    std::string name;
+    vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eVertex;
+    vulkan::ShaderVariant variant;
+};
+
+struct GraphicsPipelineRequest
+{
+    std::vector<PipelineShaderDesc> shaders;
+    // state.shaderModules is filled by the worker, a null state.layout is built from the shader resources.
+    // The layout and render pass must outlive the compilation
+    GraphicsPipelineState state;
+    // Used by resolve() until this pipeline is ready, or if it fails. Null to skip the draws meanwhile
+    PipelineHandle fallback;
+};
+
+/**
+ * @brief Compilation metrics, latencies are from request() to the frame the pipeline became usable.
+ */
+struct PipelineCompilerMetrics
+{
+    // Requested or reloading and not done yet
+    uint32_t queueDepth = 0;
+    uint32_t requested = 0;
+    uint32_t completed = 0;
+    uint32_t failed = 0;
+    // Requests answered with the handle of an identical earlier request
+    uint32_t deduplicated = 0;
+    // Hot reloads swapped in, and the ones which failed and kept the previous pipeline
+    uint32_t reloaded = 0;
+    uint32_t reloadFailed = 0;
+    double lastLatencyMs = 0.0;
+    double averageLatencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    // Time spent on the worker: shader loading or compilation, then pipeline creation
+    double averageCompileMs = 0.0;
+};
+
+/**
+ * Creates graphics pipelines (GLSL -> SPIR-V -> VkPipeline) on worker threads, so that a new material variant
+ * never stalls the render thread. request() returns at once; draws resolve() the handle every frame and get the
+ * pipeline once ready, the fallback meanwhile, or null to skip the draw.
+ * Finished compilations are only published by update(), called once per frame, so resolve() takes no lock.
+ * With globalAppSettings.isShaderHotReloadEnabled and the shader compiler built in, the shader files and includes of
+ * every pipeline are watched: an edit recompiles the pipelines using it in the background, from source, and update()
+ * swaps the new pipeline in. A reload that fails logs the error and keeps the previous pipeline; a failed pipeline
+ * is retried on the next edit. Replaced pipelines are released once no frame in flight can use them.
+ * @note request(), update() and resolve() must be called from the render thread.
+ */
+class PipelineCompiler final : public DeferredSystem<PipelineCompiler>
+{
+    friend class DeferredSystem<PipelineCompiler>;
+
+public:
+    PipelineHandle request(const GraphicsPipelineRequest& request);
+    /**
+     * @brief Register a pipeline created synchronously, typically to use it as the fallback of requests.
+     * @param request How the pipeline was made, if it should be hot reloaded and identical request() calls should get
+     * it. Null to never reload it.
+     */
+    PipelineHandle adopt(vk::Pipeline pipeline, const GraphicsPipelineRequest* request = nullptr);
+    /**
+     * @brief Publish the pipelines finished since the last frame, start the reloads of the edited shaders and release
+     * the replaced pipelines which are old enough. Called once per frame with the monotonic frame number.
+     */
+    void update(uint32_t frameNumber);
+    /**
+     * @return The pipeline if ready, else the resolved fallback, else null.
+     */
+    [[nodiscard]] vk::Pipeline resolve(PipelineHandle handle) const;
+    [[nodiscard]] PipelineStatus getStatus(PipelineHandle handle) const;
+    /**
+     * @brief Block until every request is done, then publish them.
+     */
+    void waitIdle();
+    /**
+     * @brief Wait for the workers and forget every request. The pipelines belong to the PipelineStateCache.
+     */
+    void destroy();
+
+    [[nodiscard]] PipelineCompilerMetrics getMetrics() const;
+
+protected:
+    explicit PipelineCompiler();
+
+private:
+    struct CompileResult
+    {
+        vk::Pipeline pipeline;
+        std::string infoLog;
+        double compileMilliseconds = 0.0;
+        // Files read to build the shaders, includes too when they were compiled from source
+        std::vector<std::string> dependencies;
+    };
+    struct Record
+    {
+        PipelineStatus status = PipelineStatus::Pending;
+        vk::Pipeline pipeline;
+        PipelineHandle fallback;
+        uint64_t key = 0;
+        std::chrono::steady_clock::time_point requestTime;
+        std::future<CompileResult> result;
+        // Kept to recompile the pipeline when one of its files changes, no shaders for adopted pipelines
+        GraphicsPipelineRequest request;
+        std::future<CompileResult> reload;
+        // Edited again while compiling, reload once done
+        bool isReloadQueued = false;
+    };
+    struct RetiredPipeline
+    {
+        vk::Pipeline pipeline;
+        uint32_t frameNumber = 0;
+    };
+
+    [[nodiscard]] static uint64_t computeRequestKey(const GraphicsPipelineRequest& request);
+    static CompileResult compile(const GraphicsPipelineRequest& request, bool fromSource);
+    static CompileResult takeResult(std::future<CompileResult>& future);
+    void complete(Record& record);
+    void completeReload(Record& record);
+    void startReload(Record& record);
+    void reloadChangedFiles();
+    void watchDependencies(PipelineHandle handle, const std::vector<std::string>& files);
+    void releaseRetiredPipelines();
+
+    Scope<utils::ThreadPool> m_workers;
+    SlotMap<Record> m_records;
+    std::unordered_map<uint64_t, PipelineHandle> m_requestKeys;
+    uint32_t m_pendingCount = 0;
+    uint32_t m_reloadCount = 0;
+    uint32_t m_frameNumber = 0;
+    PipelineCompilerMetrics m_metrics{};
+    double m_totalLatencyMs = 0.0;
+    double m_totalCompileMs = 0.0;
+
+    // Null unless hot reload is enabled
+    Scope<utils::FileWatcher> m_watcher;
+    // Normalized file -> pipelines built from it
+    std::unordered_map<std::string, std::vector<PipelineHandle>> m_dependents;
+    std::vector<RetiredPipeline> m_retiredPipelines;
+};
+} // namespace huan::runtime
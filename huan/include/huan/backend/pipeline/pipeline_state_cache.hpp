@@ -0,0 +1,128 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class ShaderModule;
+}
+
+/**
+ * @brief Everything a graphics pipeline is built from. Viewport and scissor are always dynamic.
+ */
+struct GraphicsPipelineState
+{
+    // Only read while the pipeline is created, the modules can be destroyed afterwards
+    std::vector<const vulkan::ShaderModule*> shaderModules;
+
+    std::vector<vk::VertexInputBindingDescription> vertexBindings;
+    std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+
+    vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+    vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+    vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+    bool depthBiasEnable = false;
+    float lineWidth = 1.0f;
+
+    vk::SampleCountFlagBits rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    bool depthTestEnable = true;
+    bool depthWriteEnable = true;
+    vk::CompareOp depthCompareOp = vk::CompareOp::eLess;
+
+    // One per color attachment of the subpass
+    std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments;
+    // On top of viewport and scissor
+    std::vector<vk::DynamicState> dynamicStates;
+
+    vk::PipelineLayout layout;
+    vk::RenderPass renderPass;
+    uint32_t subpass = 0;
+
+    /**
+     * @brief Hash of the whole state, shader modules being identified by their SPIR-V.
+     */
+    [[nodiscard]] uint64_t computeHash() const;
+};
+
+/**
+ * @brief What a compute pipeline is built from.
+ */
+struct ComputePipelineState
+{
+    // Only read while the pipeline is created
+    const vulkan::ShaderModule* shaderModule = nullptr;
+    vk::PipelineLayout layout;
+
+    [[nodiscard]] uint64_t computeHash() const;
+};
+
+/**
+ * Graphics and compute pipelines keyed by the hash of their state: asking twice for the same state returns the
+ * same pipeline. Every pipeline is created through the persistent PipelineCache.
+ * The cache owns its pipelines, they live until destroy().
+ * @note getOrCreate() is thread safe, pipelines are created outside of the lock so workers don't serialize.
+ */
+class PipelineStateCache final : public DeferredSystem<PipelineStateCache>
+{
+    friend class DeferredSystem<PipelineStateCache>;
+
+public:
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        double creationMilliseconds = 0.0;
+    };
+
+    /**
+     * @return The pipeline for this state, created if it's the first request. Null if the creation failed.
+     */
+    vk::Pipeline getOrCreate(const GraphicsPipelineState& state);
+    vk::Pipeline getOrCreate(const ComputePipelineState& state);
+    /**
+     * @brief Destroy the pipelines created for `layout` or `renderPass`, before destroying those.
+     */
+    void evict(vk::PipelineLayout layout, vk::RenderPass renderPass = nullptr);
+    /**
+     * @brief Destroy a single pipeline, e.g. one replaced by a hot reload. The GPU must be done with it.
+     */
+    void release(vk::Pipeline pipeline);
+    void destroy();
+
+    [[nodiscard]] size_t getPipelineCount() const;
+    [[nodiscard]] Stats getStats() const;
+
+protected:
+    explicit PipelineStateCache();
+
+private:
+    struct Entry
+    {
+        vk::Pipeline pipeline;
+        vk::PipelineLayout layout;
+        vk::RenderPass renderPass;
+    };
+
+    template <class State>
+    vk::Pipeline getOrCreateEntry(const State& state, vk::RenderPass renderPass);
+    vk::Pipeline create(const GraphicsPipelineState& state);
+    vk::Pipeline create(const ComputePipelineState& state);
+
+    vk::Device& deviceHandle;
+    std::unordered_map<uint64_t, Entry> m_pipelines;
+    Stats m_stats{};
+    mutable std::mutex m_mutex;
+};
+} // namespace huan::runtime
@@ -0,0 +1,241 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "huan/common.hpp"
+#include "huan/backend/pipeline/pipeline_compiler.hpp"
+#include "huan/scene_framework/components/material.hpp"
+#include "huan/scene_framework/frustum_culler.hpp"
+#include "huan/utils/radix_sort.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
+
+namespace huan::runtime
+{
+/**
+ * Draws of a frame sorted by a 64 bits key, then recorded binding the pipeline and the descriptor set only when they
+ * change from the previous draw. From the most significant bits:
+ * - Opaque and masked: pass (2) | pipeline (14) | material (16) | depth (32), front to back within a state, which
+ *   groups the state changes and lets the depth test reject the hidden fragments early.
+ * - Blended: pass (2) | inverted depth (32) | pipeline (14) | material (16), back to front as blending needs.
+ * Pipelines and descriptor sets get small IDs on first sight, kept across frames so that the order is stable. Those
+ * not pushed for IDRetireFrameCount frames are forgotten by clear() and their IDs reused, so the IDs follow the states
+ * in use rather than every state ever seen. Past 2^14 pipelines or 2^16 descriptor sets in use at once the IDs wrap
+ * around: the draws are still right, only less grouped.
+ * After sorting, the draws sharing the state and the geometry are merged into one instanced draw, at the place of
+ * the first of them. Blended draws are merged only with their neighbours, which keeps them back to front.
+ * The instanced draws can also be submitted indirectly, one call per run of draws sharing the pipeline and the
+ * descriptor set, so that the CPU cost follows the state changes rather than the draws.
+ * @note Not thread safe, sort() splits its work between the workers.
+ */
+class HUAN_API RenderQueue
+{
+public:
+    enum class Pass : uint8_t
+    {
+        Opaque = 0,
+        Masked = 1,
+        Blended = 2,
+    };
+
+    struct Stats
+    {
+        // Instanced draws, run by the GPU
+        uint32_t drawCount = 0;
+        uint32_t instanceCount = 0;
+        // Draw commands recorded by the CPU, one per indirect call when drawing indirectly
+        uint32_t callCount = 0;
+        uint32_t pipelineBindCount = 0;
+        uint32_t descriptorSetBindCount = 0;
+        // Instances whose pipeline isn't ready and has no fallback
+        uint32_t skippedCount = 0;
+        double sortMilliseconds = 0.0;
+    };
+
+    static constexpr uint32_t PipelineIDBits = 14;
+    static constexpr uint32_t MaterialIDBits = 16;
+    // clear() calls after which the ID of a pipeline or descriptor set not pushed since is reused
+    static constexpr uint32_t IDRetireFrameCount = 64;
+    // The maxDrawIndirectCount every device with multiDrawIndirect supports, longer runs are split
+    static constexpr uint32_t MaxIndirectRunLength = 65535;
+
+    RenderQueue() = default;
+    HUAN_NO_COPY(RenderQueue)
+
+    [[nodiscard]] static Pass getPass(framework::scene_graph::AlphaMode alphaMode);
+    /**
+     * @param viewDepth Distance along the view direction, negative values count as 0.
+     */
+    [[nodiscard]] static uint64_t makeKey(Pass pass, uint32_t pipelineID, uint32_t materialID, float viewDepth);
+
+    /**
+     * @brief Forgets the draws of the last frame, and the IDs of the states unused for IDRetireFrameCount frames.
+     */
+    void clear();
+    void push(const framework::scene_graph::DrawItem& draw, const glm::mat4& world, PipelineHandle pipeline,
+              vk::DescriptorSet descriptorSet, Pass pass, float viewDepth);
+    /**
+     * @brief Sorts the draws, then groups them into instanced draws.
+     * @param workers Null to sort on the calling thread only.
+     */
+    void sort(utils::ThreadPool* workers = nullptr);
+    /**
+     * @brief Records the instanced draws. Their descriptor set is bound at set 0 of `layout`, and the instance
+     * transforms must be bound as a per instance vertex buffer beforehand.
+     */
+    void record(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout);
+    /**
+     * @brief Same as record(), with one indirect call per run.
+     * @param buffer Holds getIndirectCommands() at offset 0 and, if `useCount`, getIndirectCounts() at
+     * `countsOffset`.
+     * @param useCount Use drawIndexedIndirectCount(), the GPU may then lower the counts, else drawIndexedIndirect().
+     * Both need multiDrawIndirect and drawIndirectFirstInstance, the former drawIndirectCount as well.
+     */
+    void recordIndirect(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout, vk::Buffer buffer,
+                        vk::DeviceSize countsOffset, bool useCount);
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_draws.size();
+    }
+    /**
+     * @brief World matrices of the instances after sort(), each draw reads its own range with firstInstance.
+     */
+    [[nodiscard]] std::span<const glm::mat4> getInstanceTransforms() const
+    {
+        return m_instanceTransforms;
+    }
+    /**
+     * @brief The instanced draws after sort(), in order.
+     */
+    [[nodiscard]] std::span<const vk::DrawIndexedIndirectCommand> getIndirectCommands() const
+    {
+        return m_indirectCommands;
+    }
+    /**
+     * @brief Command count of each run after sort(), the runs follow each other in getIndirectCommands().
+     */
+    [[nodiscard]] std::span<const uint32_t> getIndirectCounts() const
+    {
+        return m_indirectCounts;
+    }
+    [[nodiscard]] const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct QueuedDraw
+    {
+        framework::scene_graph::DrawItem draw;
+        glm::mat4 world;
+        PipelineHandle pipeline;
+        vk::DescriptorSet descriptorSet;
+        Pass pass;
+    };
+    /**
+     * Draws of the same state and geometry, drawn as one.
+     */
+    struct Batch
+    {
+        // The first of its draws in the sorted order, the others only add their transform
+        uint32_t draw;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+    /**
+     * Batches of the same pipeline and descriptor set, submitted by one indirect call.
+     */
+    struct IndirectRun
+    {
+        uint32_t firstBatch;
+        uint32_t batchCount;
+        uint32_t instanceCount;
+    };
+    /**
+     * What the command buffer has bound so far while recording.
+     */
+    struct BoundState
+    {
+        PipelineHandle handle;
+        vk::Pipeline resolved;
+        vk::Pipeline pipeline;
+        vk::DescriptorSet descriptorSet;
+    };
+    struct GeometryKey
+    {
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+
+        bool operator==(const GeometryKey& that) const = default;
+    };
+    struct GeometryKeyHash
+    {
+        size_t operator()(const GeometryKey& key) const;
+    };
+    /**
+     * IDs of the pipelines or of the descriptor sets, the freed ones are given again first.
+     */
+    template <class Handle>
+    class StateIDs
+    {
+    public:
+        uint32_t get(Handle handle, uint32_t frame);
+        /**
+         * @brief Frees the IDs of the handles not used for IDRetireFrameCount frames.
+         */
+        void retire(uint32_t frame);
+
+    private:
+        struct Entry
+        {
+            uint32_t id;
+            uint32_t lastFrame;
+        };
+        std::unordered_map<Handle, Entry> m_entries;
+        std::vector<uint32_t> m_freeIDs;
+    };
+
+    std::vector<QueuedDraw> m_draws;
+    // Sorted together, the values index m_draws
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order;
+    utils::RadixSortScratch m_sortScratch;
+    std::vector<Batch> m_batches;
+    // Batch of each sorted draw
+    std::vector<uint32_t> m_drawBatches;
+    std::vector<glm::mat4> m_instanceTransforms;
+    std::vector<IndirectRun> m_indirectRuns;
+    std::vector<vk::DrawIndexedIndirectCommand> m_indirectCommands;
+    std::vector<uint32_t> m_indirectCounts;
+    // Batches of the current state by geometry, cleared when the state changes
+    std::unordered_map<GeometryKey, uint32_t, GeometryKeyHash> m_stateBatches;
+    StateIDs<uint32_t> m_pipelineIDs;
+    StateIDs<VkDescriptorSet> m_materialIDs;
+    // clear() calls so far
+    uint32_t m_frame = 0;
+    Stats m_stats{};
+
+    void buildBatches();
+    void buildIndirectRuns();
+    void resetRecordStats();
+    /**
+     * @return False if the pipeline of `queued` isn't ready and has no fallback, nothing is bound then.
+     */
+    bool bindState(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout, const QueuedDraw& queued,
+                   BoundState& state);
+};
+} // namespace huan::runtime
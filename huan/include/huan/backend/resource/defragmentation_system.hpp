@@ -0,0 +1,120 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "vk_mem_alloc.h"
+#include "vulkan/vulkan.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class RelocatableAllocation;
+}
+
+/**
+ * @brief What one defragmentation (possibly spread over many frames) achieved.
+ */
+struct DefragmentationReport
+{
+    vk::DeviceSize bytesMoved = 0;
+    // Bytes of VkDeviceMemory given back to the driver, i.e. what was reclaimed
+    vk::DeviceSize bytesFreed = 0;
+    uint32_t allocationsMoved = 0;
+    uint32_t deviceMemoryBlocksFreed = 0;
+    uint32_t passCount = 0;
+    uint32_t frameCount = 0;
+    double milliseconds = 0.0;
+};
+
+/**
+ * Incremental VMA defragmentation, running a few passes per frame within a time budget.
+ * Moved resources get a new handle (their VmaAllocation stays the same), so only the resources created with a
+ * registered relocation listener (BuilderBase::setRelocationListener()) are moved; that listener refreshes whatever
+ * caches their raw handles, e.g. descriptor sets. Everything else stays where it is.
+ * @note The first pass with moves of a frame waits on the fences of the frames in flight, since they may still use
+ * the old memory, then every pass only waits for its own copies. Passes only happen when a defragmentation was
+ * requested or the fragmentation ratio got over the trigger.
+ */
+class DefragmentationSystem final : public DeferredSystem<DefragmentationSystem>
+{
+    friend class DeferredSystem<DefragmentationSystem>;
+
+public:
+    using RelocationListener = std::function<void(vulkan::RelocatableAllocation& resource)>;
+    using ListenerId = uint32_t;
+    static constexpr ListenerId NoListener = UINT32_MAX;
+
+    /**
+     * Start defragmenting the default pools (`pool == nullptr`) or a custom pool.
+     * @return False if a defragmentation is already running or VMA refused to start.
+     */
+    bool begin(VmaPool pool = nullptr);
+    /**
+     * Called once per frame, before any command of the frame is recorded. Runs passes until done or until the time
+     * budget of the frame is spent, and checks the fragmentation every few frames when idle.
+     */
+    void update(uint32_t frameIndex);
+    /**
+     * Run the remaining passes right away, ignoring the time budget.
+     */
+    void finish();
+    void cancel();
+    [[nodiscard]] bool isRunning() const;
+
+    ListenerId addRelocationListener(RelocationListener listener);
+    void removeRelocationListener(ListenerId id);
+    [[nodiscard]] bool hasRelocationListener(ListenerId id) const;
+
+    /**
+     * @param unusedBytes Receives the free bytes inside the VMA blocks, if not null.
+     * @return Ratio of free space inside the VMA blocks, 0 when not fragmented at all.
+     */
+    [[nodiscard]] float computeFragmentation(vk::DeviceSize* unusedBytes = nullptr) const;
+    [[nodiscard]] const DefragmentationReport& getLastReport() const;
+    [[nodiscard]] const DefragmentationReport& getTotalReport() const;
+
+    void setFrameBudget(double milliseconds);
+    void setTriggerRatio(float ratio);
+
+protected:
+    explicit DefragmentationSystem();
+
+private:
+    /**
+     * @return True if the defragmentation is complete.
+     */
+    bool runPass();
+    /**
+     * @brief Waits on the fences of every frame, once per update() or finish().
+     */
+    void waitForFramesInFlight();
+    void end();
+    /**
+     * @brief Calls the listener the resource was created with.
+     */
+    void notifyRelocated(vulkan::RelocatableAllocation& resource);
+
+    vk::Device& deviceHandle;
+    VmaAllocator& allocatorHandle;
+
+    VmaDefragmentationContext m_context = nullptr;
+    double m_frameBudgetMs;
+    float m_triggerRatio;
+    uint32_t m_lastCheckFrame = 0;
+    bool m_isFrameQueueDrained = false;
+
+    DefragmentationReport m_currentReport{};
+    DefragmentationReport m_lastReport{};
+    DefragmentationReport m_totalReport{};
+
+    std::vector<std::pair<ListenerId, RelocationListener>> m_listeners;
+    ListenerId m_nextListenerId = 0;
+};
+} // namespace huan::runtime
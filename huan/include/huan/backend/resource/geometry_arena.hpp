@@ -0,0 +1,126 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <mutex>
+
+#include "vk_mem_alloc.h"
+#include "vulkan/vulkan.hpp"
+#include "huan/common.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
+#include "huan/backend/resource/resource_handles.hpp"
+#include "huan/utils/offset_allocator.hpp"
+
+namespace huan::runtime
+{
+/**
+ * @brief A range of one of the GeometryArena buffers. Offsets are in bytes and aligned to the element stride.
+ */
+struct GeometryAllocation
+{
+    uint32_t offset = utils::OffsetAllocator::NoSpace;
+    // Requested bytes, the range reserved in the arena may be a bit larger because of the alignment
+    uint32_t size = 0;
+    uint32_t stride = 0;
+    // internal: allocation inside the arena's OffsetAllocator, and the arena generation it belongs to
+    utils::OffsetAllocator::Allocation allocation{};
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool isValid() const
+    {
+        return allocation.isValid();
+    }
+    /**
+     * @return First element of the range, i.e. the `vertexOffset` or `firstIndex` of a draw call.
+     */
+    [[nodiscard]] uint32_t getFirstElement() const
+    {
+        return stride == 0 ? 0 : offset / stride;
+    }
+    [[nodiscard]] uint32_t getElementCount() const
+    {
+        return stride == 0 ? 0 : size / stride;
+    }
+};
+
+/**
+ * One big vertex buffer and one big index buffer living in their own VMA pool, sub-allocated with an
+ * OffsetAllocator. Every mesh goes in there, so a frame binds vertex/index buffers once and only changes
+ * `firstIndex` / `vertexOffset` per draw, which is also what indirect draws need.
+ * Indices are always 32 bits, 16 bits index data is widened on upload.
+ */
+class GeometryArena final : public DeferredSystem<GeometryArena>
+{
+    friend class DeferredSystem<GeometryArena>;
+
+public:
+    static constexpr vk::IndexType IndexType = vk::IndexType::eUint32;
+
+    struct Stats
+    {
+        vk::DeviceSize vertexCapacity = 0;
+        vk::DeviceSize vertexFree = 0;
+        vk::DeviceSize vertexLargestFreeRegion = 0;
+        vk::DeviceSize indexCapacity = 0;
+        vk::DeviceSize indexFree = 0;
+        vk::DeviceSize indexLargestFreeRegion = 0;
+        uint32_t vertexAllocationCount = 0;
+        uint32_t indexAllocationCount = 0;
+    };
+
+    /**
+     * @param data Uploaded right away through a staging buffer when not null.
+     * @return An invalid allocation if the arena is full.
+     */
+    [[nodiscard]] GeometryAllocation allocateVertices(uint32_t vertexCount, uint32_t stride, const void* data = nullptr);
+    [[nodiscard]] GeometryAllocation allocateIndices(uint32_t indexCount, const uint32_t* data = nullptr);
+    [[nodiscard]] GeometryAllocation allocateIndices(uint32_t indexCount, const uint16_t* data);
+    void freeVertices(GeometryAllocation& allocation);
+    void freeIndices(GeometryAllocation& allocation);
+
+    void uploadVertices(const GeometryAllocation& allocation, const void* data);
+    void uploadIndices(const GeometryAllocation& allocation, const uint32_t* data);
+
+    /**
+     * @brief Bind the arena's vertex buffer at `binding` and its index buffer.
+     */
+    void bind(vk::CommandBuffer commandBuffer, uint32_t binding = 0) const;
+
+    [[nodiscard]] const vulkan::Buffer& getVertexBuffer() const;
+    [[nodiscard]] const vulkan::Buffer& getIndexBuffer() const;
+    [[nodiscard]] BufferHandle getVertexBufferHandle() const;
+    [[nodiscard]] BufferHandle getIndexBufferHandle() const;
+    [[nodiscard]] VmaPool getPool() const;
+    [[nodiscard]] Stats getStats() const;
+
+    /**
+     * Release the buffers and the pool, must happen before the allocator is destroyed.
+     * Allocations made before are then ignored by freeVertices() / freeIndices().
+     */
+    void destroy();
+
+protected:
+    explicit GeometryArena();
+
+private:
+    GeometryAllocation allocate(utils::OffsetAllocator& allocator, uint64_t size, uint32_t stride);
+
+    vk::Device& deviceHandle;
+    VmaAllocator& allocatorHandle;
+
+    VmaPool m_pool = nullptr;
+    DefragmentationSystem::ListenerId m_relocationListener = DefragmentationSystem::NoListener;
+    BufferHandle m_vertexBuffer;
+    BufferHandle m_indexBuffer;
+
+    mutable std::mutex m_mutex;
+    utils::OffsetAllocator m_vertexAllocator;
+    utils::OffsetAllocator m_indexAllocator;
+    uint32_t m_vertexAllocationCount = 0;
+    uint32_t m_indexAllocationCount = 0;
+    // Bumped by destroy(), so ranges of the released buffers aren't freed into the reset allocators
+    uint32_t m_generation = 0;
+};
+} // namespace huan::runtime
@@ -0,0 +1,139 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "vk_mem_alloc.h"
+#include "vulkan/vulkan.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+/**
+ * @brief What a VMA allocation is used for. Every VulkanAllocated resource is tagged with one of these.
+ */
+enum class AllocationCategory : uint8_t
+{
+    Unknown = 0,
+    Vertex,
+    Index,
+    Texture,
+    Staging,
+    Uniform,
+    Storage,
+    Attachment,
+    Count
+};
+
+[[nodiscard]] const char* toString(AllocationCategory category);
+/**
+ * @brief Guess the category from buffer usage, used when the builder didn't specify one.
+ */
+[[nodiscard]] AllocationCategory deduceAllocationCategory(vk::BufferUsageFlags usage);
+/**
+ * @brief Guess the category from image usage, used when the builder didn't specify one.
+ */
+[[nodiscard]] AllocationCategory deduceAllocationCategory(vk::ImageUsageFlags usage);
+
+/**
+ * @brief Budget and usage of one memory heap, refreshed every frame through vmaGetHeapBudgets.
+ */
+struct HeapBudget
+{
+    vk::MemoryHeapFlags flags{};
+    vk::DeviceSize size = 0;
+    // Estimated bytes the process may use from this heap (VK_EXT_memory_budget, or 80% of the heap size without it)
+    vk::DeviceSize budget = 0;
+    // Estimated bytes currently used by the process, including other allocators
+    vk::DeviceSize usage = 0;
+    // Bytes of VkDeviceMemory blocks owned by VMA
+    vk::DeviceSize blockBytes = 0;
+    // Bytes actually handed out to allocations
+    vk::DeviceSize allocationBytes = 0;
+    uint32_t allocationCount = 0;
+};
+
+/**
+ * Keeps track of every VMA allocation made through VulkanAllocated, sorted by AllocationCategory and heap.
+ * Call update() once per frame to refresh the heap budgets; warnings are logged when a heap gets close to its budget.
+ */
+class MemoryTelemetry final : public DeferredSystem<MemoryTelemetry>
+{
+    friend class DeferredSystem<MemoryTelemetry>;
+
+public:
+    void registerAllocation(VmaAllocator allocator, VmaAllocation allocation, AllocationCategory category,
+                            std::string_view debugName);
+    void unregisterAllocation(VmaAllocation allocation);
+
+    /**
+     * Refresh heap budgets. Should be called once per frame, before any allocation of this frame.
+     * @param frameIndex Monotonic frame number, forwarded to vmaSetCurrentFrameIndex
+     */
+    void update(uint32_t frameIndex);
+
+    /**
+     * @return Whether `size` more bytes fit into `heapIndex` without crossing the warning ratio of its budget.
+     */
+    [[nodiscard]] bool isWithinBudget(uint32_t heapIndex, vk::DeviceSize size) const;
+    /**
+     * @brief isWithinBudget() for the heap of `memoryType`, checked before every VulkanAllocated allocation.
+     */
+    [[nodiscard]] bool isMemoryTypeWithinBudget(uint32_t memoryType, vk::DeviceSize size) const;
+    [[nodiscard]] std::vector<HeapBudget> getHeapBudgets() const;
+    [[nodiscard]] vk::DeviceSize getCategoryBytes(AllocationCategory category) const;
+    [[nodiscard]] uint32_t getCategoryCount(AllocationCategory category) const;
+    [[nodiscard]] size_t getAllocationCount() const;
+
+    /**
+     * @brief Ratio of the budget after which a heap is considered close to over-commit. Default from AppSettings.
+     */
+    void setWarningRatio(float ratio);
+    [[nodiscard]] float getWarningRatio() const;
+
+    /**
+     * Dump heaps, categories and (optionally) every live allocation as JSON.
+     * @param detailed Also list every allocation and embed the full vmaBuildStatsString output under "vma".
+     */
+    [[nodiscard]] std::string dumpJson(bool detailed = false) const;
+    /**
+     * Print the still living allocations. Used right before the allocator is destroyed.
+     */
+    void reportLeaks() const;
+
+protected:
+    explicit MemoryTelemetry();
+
+private:
+    struct AllocationRecord
+    {
+        AllocationCategory category = AllocationCategory::Unknown;
+        uint32_t memoryType = 0;
+        uint32_t heapIndex = 0;
+        vk::DeviceSize size = 0;
+        std::string name;
+    };
+
+    void refreshHeapBudgets();
+    void checkHeap(uint32_t heapIndex);
+
+    VmaAllocator& allocatorHandle;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<VmaAllocation, AllocationRecord> m_records;
+    std::array<vk::DeviceSize, static_cast<size_t>(AllocationCategory::Count)> m_categoryBytes{};
+    std::array<uint32_t, static_cast<size_t>(AllocationCategory::Count)> m_categoryCounts{};
+    std::vector<HeapBudget> m_heapBudgets;
+    // Bytes registered since the last update(), so the warning doesn't wait a whole frame
+    std::vector<vk::DeviceSize> m_pendingHeapBytes;
+    std::vector<bool> m_heapWarned;
+    float m_warningRatio;
+};
+} // namespace huan::runtime
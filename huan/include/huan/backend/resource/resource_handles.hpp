@@ -0,0 +1,23 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include "huan/common_templates/slot_map.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class Buffer;
+class Image;
+class ImageView;
+class Sampler;
+} // namespace vulkan
+
+// Handles into the ResourceRegistry, cheap to copy and safe to keep around: a stale handle resolves to nullptr
+using BufferHandle = Handle<vulkan::Buffer>;
+using ImageHandle = Handle<vulkan::Image>;
+using ImageViewHandle = Handle<vulkan::ImageView>;
+using SamplerHandle = Handle<vulkan::Sampler>;
+} // namespace huan::runtime
@@ -0,0 +1,167 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <functional>
+#include <tuple>
+#include <vector>
+
+#include "huan/common_templates/deferred_system.hpp"
+#include "huan/common_templates/slot_map.hpp"
+#include "huan/backend/resource/resource_handles.hpp"
+#include "huan/backend/resource/sampler.hpp"
+#include "huan/backend/resource/vulkan_buffer.hpp"
+#include "huan/backend/resource/vulkan_image.hpp"
+#include "huan/backend/resource/vulkan_image_view.hpp"
+
+namespace huan::runtime
+{
+/**
+ * Owns every GPU resource, one dense SlotMap per type. Everything else refers to resources through handles, and
+ * releases them explicitly with destroy() (right away) or destroyDeferred() (once the frames in flight are done).
+ * @note Render thread only. Pointers returned by get() are valid until the next creation/destruction of that type.
+ */
+class ResourceRegistry final : public DeferredSystem<ResourceRegistry>
+{
+    friend class DeferredSystem<ResourceRegistry>;
+
+public:
+    template <class T>
+    Handle<T> add(T&& resource);
+    template <class T, class... Args>
+    Handle<T> emplace(Args&&... args);
+
+    /**
+     * @return nullptr if the handle is null or stale.
+     */
+    template <class T>
+    [[nodiscard]] T* get(Handle<T> handle);
+    template <class T>
+    [[nodiscard]] const T* get(Handle<T> handle) const;
+    template <class T>
+    [[nodiscard]] bool contains(Handle<T> handle) const;
+    template <class T>
+    [[nodiscard]] size_t getCount() const;
+
+    /**
+     * Destroy the resource right away and reset the handle. Destroying an image destroys its views as well.
+     * @return False if the handle was already stale.
+     */
+    template <class T>
+    bool destroy(Handle<T>& handle);
+    /**
+     * Destroy the resource once the frames currently in flight are done with it, and reset the handle.
+     */
+    template <class T>
+    void destroyDeferred(Handle<T>& handle);
+
+    ImageViewHandle createImageView(ImageHandle image, vk::ImageViewType viewType,
+                                    vk::Format format = vk::Format::eUndefined, uint32_t mipLevels = 0);
+
+    /**
+     * Called once per frame with the monotonic frame number, release the deferred resources which are old enough.
+     */
+    void update(uint32_t frameNumber);
+    /**
+     * Destroy everything, deferred resources included. Must happen before the allocator is destroyed.
+     */
+    void clear();
+
+protected:
+    explicit ResourceRegistry() = default;
+
+private:
+    struct PendingDestruction
+    {
+        uint32_t frameNumber = 0;
+        std::function<void()> destroy;
+    };
+
+    template <class T>
+    SlotMap<T>& storage();
+    template <class T>
+    const SlotMap<T>& storage() const;
+    void destroyViewsOf(vulkan::Image& image);
+
+    std::tuple<SlotMap<vulkan::Buffer>, SlotMap<vulkan::Image>, SlotMap<vulkan::ImageView>, SlotMap<vulkan::Sampler>>
+        m_storages;
+    std::vector<PendingDestruction> m_pendingDestructions;
+    uint32_t m_frameNumber = 0;
+};
+
+template <class T>
+Handle<T> ResourceRegistry::add(T&& resource)
+{
+    return storage<T>().insert(std::move(resource));
+}
+
+template <class T, class... Args>
+Handle<T> ResourceRegistry::emplace(Args&&... args)
+{
+    return storage<T>().emplace(std::forward<Args>(args)...);
+}
+
+template <class T>
+T* ResourceRegistry::get(Handle<T> handle)
+{
+    return storage<T>().get(handle);
+}
+
+template <class T>
+const T* ResourceRegistry::get(Handle<T> handle) const
+{
+    return storage<T>().get(handle);
+}
+
+template <class T>
+bool ResourceRegistry::contains(Handle<T> handle) const
+{
+    return storage<T>().contains(handle);
+}
+
+template <class T>
+size_t ResourceRegistry::getCount() const
+{
+    return storage<T>().size();
+}
+
+template <class T>
+bool ResourceRegistry::destroy(Handle<T>& handle)
+{
+    if constexpr (std::is_same_v<T, vulkan::Image>)
+    {
+        if (auto* image = get(handle))
+        {
+            destroyViewsOf(*image);
+        }
+    }
+    const bool erased = storage<T>().erase(handle);
+    handle = {};
+    return erased;
+}
+
+template <class T>
+void ResourceRegistry::destroyDeferred(Handle<T>& handle)
+{
+    if (!contains(handle))
+    {
+        handle = {};
+        return;
+    }
+    m_pendingDestructions.push_back({m_frameNumber, [this, pending = handle]() mutable { destroy(pending); }});
+    handle = {};
+}
+
+template <class T>
+SlotMap<T>& ResourceRegistry::storage()
+{
+    return std::get<SlotMap<T>>(m_storages);
+}
+
+template <class T>
+const SlotMap<T>& ResourceRegistry::storage() const
+{
+    return std::get<SlotMap<T>>(m_storages);
+}
+} // namespace huan::runtime
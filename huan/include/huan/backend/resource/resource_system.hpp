@@ -9,8 +9,11 @@
 #include "huan/common.hpp"
 #include "huan/common_templates/deferred_system.hpp"
 #include "vulkan/vulkan.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
 #include "huan/backend/resource/vulkan_buffer.hpp"
 #include "huan/backend/resource/vulkan_image.hpp"
+#include "huan/backend/resource/resource_handles.hpp"
+#include "huan/backend/resource/staging_ring.hpp"
 
 #include <queue>
 
@@ -21,8 +24,24 @@ class ResourceSystem final : public DeferredSystem<ResourceSystem>
 {
     friend class DeferredSystem<ResourceSystem>;
 
+public:
+    /**
+     * @brief Bytes written per path since startup, to see how often a frame pays a blocking submission.
+     */
+    struct UploadStats
+    {
+        // memcpy into mapped memory
+        uint64_t directBytes = 0;
+        // Copied through a StagingRing, recorded into the caller's command buffer
+        uint64_t recordedBytes = 0;
+        // Copied through uploadBuffer(), a submission and a wait each
+        uint64_t immediateBytes = 0;
+        uint64_t immediateSubmitCount = 0;
+    };
+
 private:
     std::queue<Scope<vulkan::Buffer>> m_deletingBufferQueue{};
+    UploadStats m_uploadStats{};
 public:
     // TODO: 临时位置
     template <typename Func>
@@ -31,37 +50,95 @@ public:
 
 #pragma region 创建StagingBuffer
     Scope<vulkan::Buffer> createStagingBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
-                                              const void* srcData = nullptr);
+                                              const void* srcData = nullptr, const std::string& debugName = {});
     template <class T>
     vulkan::Buffer createStagingBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData);
 #pragma endregion
 
+    /**
+     * @brief Copy `srcData` into a device local buffer through a temporary staging buffer, waits for the copy.
+     */
+    void uploadBuffer(const vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size,
+                      vk::DeviceSize dstOffset = 0);
+
+#pragma region 创建UniformBuffer
+    /**
+     * @brief Persistently mapped, host visible uniform buffer, owned by the ResourceRegistry.
+     */
+    BufferHandle createUniformBuffer(vk::DeviceSize size, const std::string& debugName = {});
+#pragma endregion
+
+#pragma region 创建ReadbackBuffer
+    /**
+     * @brief Persistently mapped, host cached buffer the device copies into, for the CPU to read back.
+     * @note Call invalidate() before reading.
+     */
+    BufferHandle createReadbackBuffer(vk::DeviceSize size, const std::string& debugName = {});
+#pragma endregion
+
 #pragma region 创建DeviceLocalBuffer
-    Scope<vulkan::Buffer> createDeviceLocalBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
-                                                  void* srcData = nullptr);
+    /**
+     * @param relocationListener Lets the DefragmentationSystem move it, see BuilderBase::setRelocationListener().
+     */
+    BufferHandle createDeviceLocalBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size, void* srcData = nullptr,
+                                         const std::string& debugName = {},
+                                         DefragmentationSystem::ListenerId relocationListener =
+                                             DefragmentationSystem::NoListener);
     template <class T>
-    vulkan::Buffer createDeviceLocalBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData);
+    BufferHandle createDeviceLocalBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData);
 
 #pragma endregion
+#pragma region 创建DynamicBuffer
+    /**
+     * Buffer rewritten by the CPU, e.g. per frame geometry. VMA puts it in host visible memory, HOST_VISIBLE |
+     * DEVICE_LOCAL when the device has some room (ReBAR, UMA), and maps it. If it prefers device local memory the
+     * host can't see, writes go through staging.
+     * @param relocationListener Lets the DefragmentationSystem move it, see BuilderBase::setRelocationListener().
+     */
+    BufferHandle createDynamicBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size, const void* srcData = nullptr,
+                                     const std::string& debugName = {},
+                                     DefragmentationSystem::ListenerId relocationListener =
+                                         DefragmentationSystem::NoListener);
+    /**
+     * @brief memcpy into `dst` when it is mapped, staging copy otherwise.
+     * @return True if written directly.
+     */
+    bool writeBuffer(vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size, vk::DeviceSize dstOffset = 0);
+    /**
+     * @brief memcpy into `dst` when it is mapped, otherwise through `stagingRing` with the copy recorded into
+     * `commandBuffer`. Never submits, for the per frame writes.
+     * @note Must be recorded outside of a render pass.
+     * @return True if written directly, otherwise the readers of `dst` need a barrier after the transfer.
+     */
+    bool writeBuffer(vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size, vk::DeviceSize dstOffset,
+                     vk::CommandBuffer commandBuffer, StagingRing& stagingRing);
+    [[nodiscard]] const UploadStats& getUploadStats() const;
+#pragma endregion
 #pragma region 创建DeviceDedicateBuffer
-    Scope<vulkan::Buffer> createDeviceDedicateBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size, void* srcData = nullptr);
+    BufferHandle createDeviceDedicateBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size, void* srcData = nullptr,
+                                            const std::string& debugName = {});
     template <class T>
-    vulkan::Buffer createDeviceDedicateBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData);
+    BufferHandle createDeviceDedicateBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData);
 #pragma endregion
 #pragma endregion
 
 #pragma region Image
 
-    Scope<vulkan::Image> createImage(vk::ImageType imageType, const vk::Extent3D& extent, uint32_t mipLevels,
+    /**
+     * @param relocationListener Lets the DefragmentationSystem move it, see BuilderBase::setRelocationListener().
+     */
+    ImageHandle createImage(vk::ImageType imageType, const vk::Extent3D& extent, uint32_t mipLevels,
                                      vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage,
                                      vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
-                                     void* data = nullptr);
+                                     void* data = nullptr, const std::string& debugName = {},
+                                     DefragmentationSystem::ListenerId relocationListener =
+                                         DefragmentationSystem::NoListener);
 #pragma endregion 
     // void createImageView(vulkan::Image& image, vk::ImageViewType viewType, vk::Format format,
     //                      vk::ImageAspectFlags aspectFlags, uint32_t mipLevels);
     uint32_t findRequiredMemoryTypeIndex(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
-    static vulkan::ImageView* createImageView(vulkan::Image& image, vk::ImageViewType imageViewType, vk::Format format,
-                                             uint32_t mipLevels);
+    static ImageViewHandle createImageView(ImageHandle image, vk::ImageViewType imageViewType, vk::Format format,
+                                           uint32_t mipLevels);
     static void transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout,
                                       vk::ImageLayout newLayout);
     [[nodiscard]] static bool hasStencilComponent(vk::Format format);
@@ -129,21 +206,39 @@ public:
         queue.waitIdle();
     }
 
+    /**
+     * @brief Waits on a fence of its own instead of for the whole queue to go idle.
+     */
+    void submitAndWaitFence(vk::Queue queue)
+    {
+        cmd.end();
+
+        vk::SubmitInfo submitInfo{};
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmd;
+
+        const vk::Fence fence = device.createFence({});
+        queue.submit(submitInfo, fence);
+        // No timeout, errors throw
+        static_cast<void>(device.waitForFences(fence, true, UINT64_MAX));
+        device.destroyFence(fence);
+    }
+
     // 禁止复制
     ScopedCommandBuffer(const ScopedCommandBuffer&) = delete;
     ScopedCommandBuffer& operator=(const ScopedCommandBuffer&) = delete;
 };
 
 template <class T>
-vulkan::Buffer ResourceSystem::createDeviceLocalBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData)
+BufferHandle ResourceSystem::createDeviceLocalBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData)
 {
-    return createDeviceLocalBuffer(usage, srcData.size() * sizeof(T), &srcData);
+    return createDeviceLocalBuffer(usage, srcData.size() * sizeof(T), const_cast<T*>(srcData.data()));
 }
 
 template <class T>
-vulkan::Buffer ResourceSystem::createDeviceDedicateBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData)
+BufferHandle ResourceSystem::createDeviceDedicateBuffer(vk::BufferUsageFlags usage, const vk::ArrayProxy<T>& srcData)
 {
-    return createDeviceDedicateBuffer(usage, srcData.size() * sizeof(T), &srcData);
+    return createDeviceDedicateBuffer(usage, srcData.size() * sizeof(T), const_cast<T*>(srcData.data()));
 }
 
 template <typename Func>
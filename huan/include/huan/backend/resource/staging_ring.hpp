@@ -0,0 +1,55 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.hpp"
+#include "huan/common.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class Buffer;
+}
+
+/**
+ * Upload memory of one frame in flight, for the buffers the host can't write, e.g. device local memory without
+ * ReBAR. The data is copied into a persistently mapped buffer and its copy recorded into the frame's own command
+ * buffer: no submission, no wait. Grows to what a frame needs and keeps it.
+ * @note The copies are recorded outside of a render pass, the caller adds the barrier towards their readers.
+ */
+class HUAN_API StagingRing
+{
+public:
+    static constexpr vk::DeviceSize MinCapacity = 64 * 1024;
+    static constexpr vk::DeviceSize Alignment = 16;
+
+    StagingRing();
+    HUAN_NO_COPY(StagingRing)
+    StagingRing(StagingRing&& that) noexcept;
+    StagingRing& operator=(StagingRing&& that) noexcept;
+    ~StagingRing();
+
+    /**
+     * @brief Forgets the writes of the previous use of the frame, whose commands must be done.
+     */
+    void reset();
+    /**
+     * @brief Frees the memory, once the device is idle.
+     */
+    void destroy();
+    void write(vk::CommandBuffer commandBuffer, const vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size,
+               vk::DeviceSize dstOffset = 0);
+
+    [[nodiscard]] vk::DeviceSize getCapacity() const;
+
+private:
+    Scope<vulkan::Buffer> m_buffer;
+    vk::DeviceSize m_offset = 0;
+    // Outgrown during the frame, its copies still read them until reset()
+    std::vector<Scope<vulkan::Buffer>> m_retiredBuffers;
+};
+} // namespace huan::runtime
@@ -6,11 +6,52 @@
 #include "vulkan_resource.hpp"
 #include "huan/common.hpp"
 #include "huan/log/Log.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
+#include "huan/backend/resource/memory_telemetry.hpp"
 
 namespace huan::runtime::vulkan
 {
+/**
+ * Type erased owner of a VMA allocation. Every VulkanAllocated stores itself as the allocation's user data, so the
+ * DefragmentationSystem can get back to the resource from a VmaDefragmentationMove.
+ */
+class RelocatableAllocation
+{
+public:
+    virtual ~RelocatableAllocation() = default;
+
+    /**
+     * @return The listener refreshing what caches the handles, DefragmentationSystem::NoListener if it can't move.
+     */
+    [[nodiscard]] virtual DefragmentationSystem::ListenerId getRelocationListener() const
+    {
+        return DefragmentationSystem::NoListener;
+    }
+
+    /**
+     * Create a new handle bound to `dstAllocation` and record the copy of the content into `commandBuffer`.
+     * @return False if the resource can't be moved, the move is then ignored.
+     */
+    virtual bool beginRelocation(vk::CommandBuffer commandBuffer, VmaAllocation dstAllocation)
+    {
+        return false;
+    }
+    /**
+     * The copy is done: destroy the old handle and switch to the new one. Called before vmaEndDefragmentationPass.
+     */
+    virtual void commitRelocation()
+    {
+    }
+    /**
+     * The allocation now refers to the new memory. Called after vmaEndDefragmentationPass.
+     */
+    virtual void onRelocated()
+    {
+    }
+};
+
 template <class ResourceType>
-class VulkanAllocated : public VulkanResource<ResourceType>
+class VulkanAllocated : public VulkanResource<ResourceType>, public RelocatableAllocation
 {
 public:
     using ParentType = ::huan::runtime::vulkan::VulkanResource<ResourceType>;
@@ -19,7 +60,10 @@ public:
     VulkanAllocated() = delete;
     HUAN_NO_COPY(VulkanAllocated)
     VulkanAllocated(VulkanAllocated&& that) noexcept;
-    VulkanAllocated& operator=(VulkanAllocated&& that) noexcept = default;
+    /**
+     * Take over `that` allocation. Derived classes must release their own resource before calling this.
+     */
+    VulkanAllocated& operator=(VulkanAllocated&& that) noexcept;
 
 protected:
     /**
@@ -41,6 +85,10 @@ public:
      * @param size
      */
     void flush(vk::DeviceSize offset = 0, vk::DeviceSize size = vk::WholeSize) const;
+    /**
+     * Invalidate this memory if it is NOT `HOST_COHERENT`, before reading what the device wrote.
+     */
+    void invalidate(vk::DeviceSize offset = 0, vk::DeviceSize size = vk::WholeSize) const;
     /**
      * Retrieve a pointer to the host visible memory as an ubyte array.
      * @return The pointer is host visible memory.
@@ -52,6 +100,14 @@ public:
      * @return The vulkan memory object.
      */
     [[nodiscard]] vk::DeviceMemory getDeviceMemory() const;
+    /**
+     * @return What the allocation is used for, as reported to the MemoryTelemetry.
+     */
+    [[nodiscard]] runtime::AllocationCategory getAllocationCategory() const;
+    [[nodiscard]] VmaAllocator getAllocator() const;
+    [[nodiscard]] VmaAllocation getAllocation() const;
+    [[nodiscard]] DefragmentationSystem::ListenerId getRelocationListener() const override;
+    void onRelocated() override;
     /**
      * Map vulkan memory if it isn't already mapped to a host visible address.
      * Does nothing if the allocation is already mapped ( including persistently mapped).
@@ -102,6 +158,14 @@ public:
     size_t updateWithMapping(const vk::ArrayProxy<T>& object, size_t offset = 0);
 
 protected:
+    /**
+     * Tag the next allocation for the MemoryTelemetry. Must be called before createBuffer / createImage.
+     */
+    void setAllocationTag(runtime::AllocationCategory category, std::string_view name);
+    /**
+     * Opt into the DefragmentationSystem moves, `listener` must be registered. Set before createBuffer / createImage.
+     */
+    void setRelocationListener(DefragmentationSystem::ListenerId listener);
     // Create a raw vk::Buffer by self 
     [[nodiscard]] vk::Buffer createBuffer(const vk::BufferCreateInfo& createInfo);
     // Create a raw vk::Image by self
@@ -114,9 +178,19 @@ protected:
     virtual void clear();
 
 private:
+    /**
+     * Let VMA refuse the allocation rather than go over the budget of its heap, once the MemoryTelemetry says it
+     * wouldn't fit. VMA then tries the other memory types the create info allows, e.g. host memory for
+     * VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE.
+     */
+    void applyMemoryBudget(VkResult findResult, uint32_t memoryType, vk::DeviceSize size);
+
     VmaAllocator m_allocator;
     VmaAllocationCreateInfo m_allocationCreateInfo = {};
     VmaAllocation m_allocation = nullptr;
+    runtime::AllocationCategory m_allocationCategory = runtime::AllocationCategory::Unknown;
+    std::string m_allocationName;
+    DefragmentationSystem::ListenerId m_relocationListener = DefragmentationSystem::NoListener;
     /**
      * Pointer to the allocation memory, if host visible or (persistently)mapped.
      */
@@ -140,9 +214,41 @@ VulkanAllocated<ResourceType>::VulkanAllocated(VulkanAllocated&& that) noexcept
     : ParentType{static_cast<ParentType&&>(that)},
       m_allocator(that.m_allocator),
       m_allocationCreateInfo(std::exchange(that.m_allocationCreateInfo, {})),
-      m_allocation(std::exchange(that.m_allocation, nullptr)), m_mappedData(std::exchange(that.m_mappedData, nullptr)),
+      m_allocation(std::exchange(that.m_allocation, nullptr)),
+      m_allocationCategory(std::exchange(that.m_allocationCategory, runtime::AllocationCategory::Unknown)),
+      m_allocationName(std::move(that.m_allocationName)),
+      m_relocationListener(std::exchange(that.m_relocationListener, DefragmentationSystem::NoListener)),
+      m_mappedData(std::exchange(that.m_mappedData, nullptr)),
       m_isCoherent(std::exchange(that.m_isCoherent, false)), m_isPersistent(std::exchange(that.m_isPersistent, false))
 {
+    if (m_allocation != nullptr)
+    {
+        // The user data points to the owner, follow the move
+        vmaSetAllocationUserData(m_allocator, m_allocation, static_cast<RelocatableAllocation*>(this));
+    }
+}
+
+template <class ResourceType>
+VulkanAllocated<ResourceType>& VulkanAllocated<ResourceType>::operator=(VulkanAllocated&& that) noexcept
+{
+    if (this != &that)
+    {
+        ParentType::operator=(static_cast<ParentType&&>(that));
+        m_allocator = that.m_allocator;
+        m_allocationCreateInfo = std::exchange(that.m_allocationCreateInfo, {});
+        m_allocation = std::exchange(that.m_allocation, nullptr);
+        m_allocationCategory = std::exchange(that.m_allocationCategory, runtime::AllocationCategory::Unknown);
+        m_allocationName = std::move(that.m_allocationName);
+        m_relocationListener = std::exchange(that.m_relocationListener, DefragmentationSystem::NoListener);
+        m_mappedData = std::exchange(that.m_mappedData, nullptr);
+        m_isCoherent = std::exchange(that.m_isCoherent, false);
+        m_isPersistent = std::exchange(that.m_isPersistent, false);
+        if (m_allocation != nullptr)
+        {
+            vmaSetAllocationUserData(m_allocator, m_allocation, static_cast<RelocatableAllocation*>(this));
+        }
+    }
+    return *this;
 }
 
 template <class ResourceType>
@@ -174,6 +280,15 @@ void VulkanAllocated<ResourceType>::flush(vk::DeviceSize offset, vk::DeviceSize
     }
 }
 
+template <class ResourceType>
+void VulkanAllocated<ResourceType>::invalidate(vk::DeviceSize offset, vk::DeviceSize size) const
+{
+    if (!m_isCoherent)
+    {
+        vmaInvalidateAllocation(m_allocator, m_allocation, offset, size);
+    }
+}
+
 template <class ResourceType>
 const uint8_t* VulkanAllocated<ResourceType>::getData() const
 {
@@ -190,6 +305,42 @@ vk::DeviceMemory VulkanAllocated<ResourceType>::getDeviceMemory() const
     return allocInfo.deviceMemory;
 }
 
+template <class ResourceType>
+runtime::AllocationCategory VulkanAllocated<ResourceType>::getAllocationCategory() const
+{
+    return m_allocationCategory;
+}
+
+template <class ResourceType>
+VmaAllocator VulkanAllocated<ResourceType>::getAllocator() const
+{
+    return m_allocator;
+}
+
+template <class ResourceType>
+VmaAllocation VulkanAllocated<ResourceType>::getAllocation() const
+{
+    return m_allocation;
+}
+
+template <class ResourceType>
+DefragmentationSystem::ListenerId VulkanAllocated<ResourceType>::getRelocationListener() const
+{
+    return m_relocationListener;
+}
+
+template <class ResourceType>
+void VulkanAllocated<ResourceType>::onRelocated()
+{
+    // Mapped pointers (persistent or not) move along with the memory
+    if (mapped())
+    {
+        VmaAllocationInfo allocationInfo{};
+        vmaGetAllocationInfo(m_allocator, m_allocation, &allocationInfo);
+        m_mappedData = static_cast<uint8_t*>(allocationInfo.pMappedData);
+    }
+}
+
 template <class ResourceType>
 uint8_t* VulkanAllocated<ResourceType>::map()
 {
@@ -270,16 +421,39 @@ size_t VulkanAllocated<ResourceType>::updateWithMapping(const vk::ArrayProxy<T>&
     return updateWithMapping(static_cast<const uint8_t*>(object.data()), object.size() * sizeof(T), offset);
 }
 
+template <class ResourceType>
+void VulkanAllocated<ResourceType>::setAllocationTag(runtime::AllocationCategory category, std::string_view name)
+{
+    m_allocationCategory = category;
+    m_allocationName = name;
+}
+
+template <class ResourceType>
+void VulkanAllocated<ResourceType>::setRelocationListener(DefragmentationSystem::ListenerId listener)
+{
+    m_relocationListener = listener;
+}
+
 template <class ResourceType>
 vk::Buffer VulkanAllocated<ResourceType>::createBuffer(const vk::BufferCreateInfo& createInfo)
 {
+    uint32_t memoryType = 0;
+    applyMemoryBudget(vmaFindMemoryTypeIndexForBufferInfo(m_allocator,
+                                                          reinterpret_cast<const VkBufferCreateInfo*>(&createInfo),
+                                                          &m_allocationCreateInfo, &memoryType),
+                      memoryType, createInfo.size);
+
     vk::Buffer buffer = VK_NULL_HANDLE;
     VmaAllocationInfo allocationInfo{};
     const auto res =
         vmaCreateBuffer(m_allocator, reinterpret_cast<const VkBufferCreateInfo*>(&createInfo),
                         &m_allocationCreateInfo, reinterpret_cast<VkBuffer*>(&buffer), &m_allocation, &allocationInfo);
     if (res != VK_SUCCESS)
+    {
+        HUAN_CORE_ERROR("Failed to create buffer [{}] of {} bytes: {}", m_allocationName, createInfo.size,
+                        static_cast<int>(res))
         HUAN_CORE_BREAK("Failed to create buffer");
+    }
 
     postCreate(allocationInfo);
     return buffer;
@@ -292,24 +466,48 @@ vk::Image VulkanAllocated<ResourceType>::createImage(const vk::ImageCreateInfo&
     HUAN_CORE_ASSERT(0 < createInfo.arrayLayers, "Array layers must be greater than 0");
     HUAN_CORE_ASSERT(static_cast<VkImageUsageFlags>(createInfo.usage) != 0, "Usage must not equal 0");
 
+    // The size of an image is only known once it exists: refused only when its heap is already past the ratio
+    uint32_t memoryType = 0;
+    applyMemoryBudget(vmaFindMemoryTypeIndexForImageInfo(m_allocator,
+                                                         reinterpret_cast<const VkImageCreateInfo*>(&createInfo),
+                                                         &m_allocationCreateInfo, &memoryType),
+                      memoryType, 0);
+
     vk::Image image = VK_NULL_HANDLE;
     VmaAllocationInfo allocationInfo{};
     const auto res =
         vmaCreateImage(m_allocator, reinterpret_cast<const VkImageCreateInfo*>(&createInfo),
                        &m_allocationCreateInfo, reinterpret_cast<VkImage*>(&image), &m_allocation, &allocationInfo);
     if (res != VK_SUCCESS)
+    {
+        HUAN_CORE_ERROR("Failed to create image [{}]: {}", m_allocationName, static_cast<int>(res))
         HUAN_CORE_BREAK("Failed to create image");
+    }
 
     postCreate(allocationInfo);
     return image;
 }
 
+template <class ResourceType>
+void VulkanAllocated<ResourceType>::applyMemoryBudget(VkResult findResult, uint32_t memoryType, vk::DeviceSize size)
+{
+    // Without any memory type vmaCreate* fails on its own
+    if (findResult != VK_SUCCESS || runtime::MemoryTelemetry::getInstance()->isMemoryTypeWithinBudget(memoryType, size))
+        return;
+
+    HUAN_CORE_WARN("[MemoryTelemetry]: [{}] of {} bytes doesn't fit in the budget of memory type {}, allocating "
+                   "within the budget only",
+                   m_allocationName.empty() ? "unnamed" : m_allocationName, size, memoryType)
+    m_allocationCreateInfo.flags |= VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+}
+
 template <class ResourceType>
 void VulkanAllocated<ResourceType>::destroyBuffer(vk::Buffer buffer)
 {
     if (buffer != VK_NULL_HANDLE && m_allocation != nullptr)
     {
         unmap();
+        runtime::MemoryTelemetry::getInstance()->unregisterAllocation(m_allocation);
         vmaDestroyBuffer(m_allocator, static_cast<VkBuffer>(buffer), m_allocation);
         clear();
     }
@@ -321,6 +519,7 @@ void VulkanAllocated<ResourceType>::destroyImage(vk::Image image)
     if (image != VK_NULL_HANDLE && m_allocation != nullptr)
     {
         unmap();
+        runtime::MemoryTelemetry::getInstance()->unregisterAllocation(m_allocation);
         vmaDestroyImage(m_allocator, static_cast<VkImage>(image), m_allocation);
         clear();
     }
@@ -336,11 +535,16 @@ void VulkanAllocated<ResourceType>::postCreate(const VmaAllocationInfo& allocati
                    vk::MemoryPropertyFlagBits::eHostCoherent;
     m_mappedData = static_cast<uint8_t*>(allocationInfo.pMappedData);
     m_isPersistent = mapped();
+    vmaSetAllocationUserData(m_allocator, m_allocation, static_cast<RelocatableAllocation*>(this));
+
+    runtime::MemoryTelemetry::getInstance()->registerAllocation(m_allocator, m_allocation, m_allocationCategory,
+                                                                m_allocationName);
 }
 
 template <class ResourceType>
 void VulkanAllocated<ResourceType>::clear()
 {
+    m_allocation = nullptr;
     m_mappedData = nullptr;
     m_isPersistent = false;
     m_allocationCreateInfo = {};
@@ -29,14 +29,27 @@ public:
     explicit Buffer(vk::Device& device, const BufferBuilder& builder);
     HUAN_NO_COPY(Buffer)
     Buffer(Buffer&& that) noexcept = default;
-    Buffer& operator=(Buffer&& that) noexcept = default;
+    Buffer& operator=(Buffer&& that) noexcept;
     ~Buffer() override;
 
     vk::DeviceSize getSize() const;
     vk::DeviceSize getDeviceAddress() const;
+    vk::BufferUsageFlags getUsage() const;
+
+    /**
+     * Only buffers built with a relocation listener can be moved, the content is copied on the GPU.
+     */
+    bool beginRelocation(vk::CommandBuffer commandBuffer, VmaAllocation dstAllocation) override;
+    void commitRelocation() override;
 
 private:
     vk::DeviceSize m_size;
+    vk::BufferCreateFlags m_flags{};
+    vk::BufferUsageFlags m_usage{};
+    vk::SharingMode m_sharingMode = vk::SharingMode::eExclusive;
+    std::vector<uint32_t> m_queueFamilyIndices;
+    // New handle while a defragmentation move is in flight
+    vk::Buffer m_relocatedHandle = VK_NULL_HANDLE;
 };
 
 } // namespace huan::vulkan
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "vk_mem_alloc.h"
 #include "vulkan/vulkan.hpp"
 #include "huan/common.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
+#include "huan/backend/resource/memory_telemetry.hpp"
 
 namespace huan::runtime::vulkan
 {
@@ -15,10 +17,18 @@ public:
     [[nodiscard]] const VmaAllocationCreateInfo& getAllocationCreateInfo() const;
     [[nodiscard]] VmaAllocationCreateInfo& getAllocationCreateInfo();
     VmaAllocator getAllocator() const;
+    [[nodiscard]] runtime::AllocationCategory getAllocationCategory() const;
     CreateInfoType& getCreateInfo();
     const CreateInfoType& getCreateInfo() const;
     [[nodiscard]] const std::string& getDebugName() const;
+    [[nodiscard]] DefragmentationSystem::ListenerId getRelocationListener() const;
+    BuilderType& setAllocationCategory(runtime::AllocationCategory category);
     BuilderType& setDebugName(const std::string& debugName);
+    /**
+     * Let the DefragmentationSystem move the resource, `listener` (registered with addRelocationListener()) then
+     * refreshes whatever caches its handles. Adds the TRANSFER_SRC | TRANSFER_DST usage the move copies with.
+     */
+    BuilderType& setRelocationListener(DefragmentationSystem::ListenerId listener);
     BuilderType& setImplicitSharingMode();
     BuilderType& setMemoryTypeBits(uint32_t typeBits);
     BuilderType& setQueueFamilies(uint32_t count, const uint32_t* familyIndices);
@@ -37,9 +47,10 @@ protected:
     VmaAllocator m_allocator{};
     VmaAllocationCreateInfo m_allocationCreateInfo{};
     CreateInfoType m_createInfo{};
-#ifdef HUAN_DEBUG
+    runtime::AllocationCategory m_allocationCategory = runtime::AllocationCategory::Unknown;
+    // Always kept, since the memory telemetry tags allocations with it in every build type
     std::string m_debugName = {};
-#endif
+    DefragmentationSystem::ListenerId m_relocationListener = DefragmentationSystem::NoListener;
 };
 
 template <class BuilderType, class CreateInfoType>
@@ -60,6 +71,12 @@ VmaAllocator BuilderBase<BuilderType, CreateInfoType>::getAllocator() const
     return m_allocator;
 }
 
+template <class BuilderType, class CreateInfoType>
+runtime::AllocationCategory BuilderBase<BuilderType, CreateInfoType>::getAllocationCategory() const
+{
+    return m_allocationCategory;
+}
+
 template <class BuilderType, class CreateInfoType>
 const CreateInfoType& BuilderBase<BuilderType, CreateInfoType>::getCreateInfo() const
 {
@@ -69,19 +86,33 @@ const CreateInfoType& BuilderBase<BuilderType, CreateInfoType>::getCreateInfo()
 template <class BuilderType, class CreateInfoType>
 const std::string& BuilderBase<BuilderType, CreateInfoType>::getDebugName() const
 {
-#ifdef HUAN_DEBUG
     return m_debugName;
-#elif
-    return {};
-#endif
+}
+
+template <class BuilderType, class CreateInfoType>
+DefragmentationSystem::ListenerId BuilderBase<BuilderType, CreateInfoType>::getRelocationListener() const
+{
+    return m_relocationListener;
+}
+
+template <class BuilderType, class CreateInfoType>
+BuilderType& BuilderBase<BuilderType, CreateInfoType>::setAllocationCategory(runtime::AllocationCategory category)
+{
+    m_allocationCategory = category;
+    return *static_cast<BuilderType*>(this);
 }
 
 template <class BuilderType, class CreateInfoType>
 BuilderType& BuilderBase<BuilderType, CreateInfoType>::setDebugName(const std::string& debugName)
 {
-#ifdef HUAN_DEBUG
     m_debugName = debugName;
-#endif
+    return *static_cast<BuilderType*>(this);
+}
+
+template <class BuilderType, class CreateInfoType>
+BuilderType& BuilderBase<BuilderType, CreateInfoType>::setRelocationListener(DefragmentationSystem::ListenerId listener)
+{
+    m_relocationListener = listener;
     return *static_cast<BuilderType*>(this);
 }
 
@@ -95,13 +95,31 @@ public:
     const vk::ImageSubresource& getSubresource() const;
     uint32_t getArrayLayerCount() const;
     std::unordered_set<ImageView*>& getViews();
+    /**
+     * @brief Layout the image is left in between frames, as far as the owner told us. eUndefined if unknown.
+     */
+    vk::ImageLayout getLayout() const;
+    void setLayout(vk::ImageLayout layout);
 
     uint8_t* map() override;
 
+    /**
+     * Only images built with a relocation listener and in a known layout can be moved. Their views are recreated on
+     * commit.
+     */
+    bool beginRelocation(vk::CommandBuffer commandBuffer, VmaAllocation dstAllocation) override;
+    void commitRelocation() override;
+
 private:
     vk::ImageCreateInfo m_createInfo{};
     vk::ImageSubresource m_subresource{};
     std::unordered_set<ImageView*> m_views{};
+    std::vector<uint32_t> m_queueFamilyIndices;
+    vk::ImageLayout m_layout = vk::ImageLayout::eUndefined;
+    // The create info had extension structures we can't replay
+    bool m_hasExtensions = false;
+    // New handle while a defragmentation move is in flight
+    vk::Image m_relocatedHandle = VK_NULL_HANDLE;
 };
 
 
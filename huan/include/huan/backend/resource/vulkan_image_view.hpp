@@ -11,6 +11,8 @@ class Image;
 
 class ImageView : public VulkanResource<vk::ImageView>
 {
+    // Unlinks its views when destroyed first
+    friend class Image;
     using ParentType = VulkanResource<vk::ImageView>;
 
 public:
@@ -31,9 +33,16 @@ public:
     void setImage(Image& image);
     vk::ImageSubresourceLayers getSubresourceLayers() const;
     vk::ImageSubresourceRange getSubresourceRange() const;
+    /**
+     * @brief Destroy the handle and create it again on the image's current handle, e.g. after the image was moved.
+     */
+    void recreate();
 
 private:
+    vk::ImageView createHandle() const;
+
     Image* m_image = nullptr;
+    vk::ImageViewType m_viewType;
     vk::Format m_format;
     vk::ImageSubresourceRange m_subresourceRange{};
 
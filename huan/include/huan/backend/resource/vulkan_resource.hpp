@@ -53,11 +53,14 @@ VulkanResource<ResourceType>::VulkanResource(VulkanResource&& that) noexcept
 template <class ResourceType>
 VulkanResource<ResourceType>& VulkanResource<ResourceType>::operator=(VulkanResource&& that) noexcept
 {
-    m_resourceHandle = std::exchange(that.m_resourceHandle, {});
-    m_deviceHandle = std::exchange(that.m_deviceHandle, {});
+    if (this != &that)
+    {
+        // m_deviceHandle refers to the context's device, assigning through it would clobber the device itself
+        m_resourceHandle = std::exchange(that.m_resourceHandle, {});
 #ifdef HUAN_DEBUG
-    m_debugName = std::exchange(that.m_debugName, {});
-# endif
+        m_debugName = std::exchange(that.m_debugName, {});
+#endif
+    }
     return *this;
 }
 
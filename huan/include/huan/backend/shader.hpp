@@ -7,6 +7,7 @@
 
 #include "resource/vulkan_resource.hpp"
 
+#include <map>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -70,6 +71,15 @@ struct ShaderResource final
     std::string name;
 };
 
+/**
+ * @brief Inline the `#include "..."` of a GLSL source through the ShaderPreprocessor cache, with `#line` directives.
+ * @param sourceName Path of the source, names it in compiler messages and locates its includes.
+ * @param includedFiles If not null, receives the path of every file included, directly or not.
+ * @return False with the reason in `infoLog` on a missing include or an include cycle.
+ */
+HUAN_API bool preprocessShader(std::string_view source, std::string_view sourceName, std::string& output,
+                               std::string& infoLog, std::vector<std::string>* includedFiles = nullptr);
+
 class ShaderSource final
 {
   public:
@@ -93,7 +103,7 @@ class ShaderSource final
     std::string m_source;
 };
 
-class ShaderVariant final
+class HUAN_API ShaderVariant final
 {
   public:
     ShaderVariant() = default;
@@ -108,10 +118,19 @@ class ShaderVariant final
     void setRuntimeArraySizes(const std::unordered_map<std::string, size_t>& runtimeArraySizes);
     void setRuntimeArraySize(const std::string& name, size_t size);
 
+    /**
+     * @brief Given to the pipelines of the module through a VkSpecializationInfo. With HUAN_ENABLE_SPIRV_OPT it is
+     * also baked into the SPIR-V: once any is set, the SPIRVOptimizer freezes every specialization constant of the
+     * module, the others at their defaults.
+     */
+    void setSpecializationConstant(uint32_t constantID, uint32_t value);
+
     [[nodiscard]] const std::string& getPreamble() const;
     [[nodiscard]] const std::vector<std::string>& getProcesses() const;
 
     [[nodiscard]] const std::unordered_map<std::string, size_t>& getRuntimeArraySizes() const;
+    // Constant ID -> value, ordered so that hashing it is stable
+    [[nodiscard]] const std::map<uint32_t, uint32_t>& getSpecializationConstants() const;
 
     void clear();
 
@@ -123,14 +142,24 @@ class ShaderVariant final
     std::string m_preamble;
     std::vector<std::string> m_processes;
     std::unordered_map<std::string, size_t> m_runtimeArraySizes;
+    std::map<uint32_t, uint32_t> m_specializationConstants;
 };
 
 class ShaderModule : public VulkanResource<vk::ShaderModule>
 {
     using ParentType = VulkanResource<vk::ShaderModule>;
   public:
+#ifdef HUAN_ENABLE_SHADER_COMPILER
     ShaderModule(vk::Device& device, vk::ShaderStageFlagBits stage, const ShaderSource& glslSource,
                  const std::string& entryPoint, const ShaderVariant& variant);
+#endif
+    /**
+     * @brief From precompiled SPIR-V and its reflection, e.g. loaded from a ShaderArchive.
+     * @param variant What the SPIR-V was compiled with, only its specialization constants are kept.
+     */
+    ShaderModule(vk::Device& device, vk::ShaderStageFlagBits stage, std::vector<uint32_t>&& spirv,
+                 std::vector<ShaderResource>&& resources, const std::string& entryPoint,
+                 const ShaderVariant& variant = {});
     ShaderModule(const ShaderModule&) = delete;
     ShaderModule(ShaderModule&& that) noexcept;
     ShaderModule& operator=(const ShaderModule&) = delete;
@@ -143,16 +172,21 @@ class ShaderModule : public VulkanResource<vk::ShaderModule>
     [[nodiscard]] const std::vector<ShaderResource>& getResources() const;
     [[nodiscard]] const std::string& getInfoLog() const;
     [[nodiscard]] const std::vector<uint32_t>& getBinary() const;
+    // Of the variant, constant ID -> value, for the VkSpecializationInfo of the pipelines
+    [[nodiscard]] const std::map<uint32_t, uint32_t>& getSpecializationConstants() const;
 
     void setResourceMode(const std::string& resourceName, const ShaderResourceMode& resourceMode);
 
   private:
-    uint32_t m_id{};
+    void createHandle();
+
+    size_t m_id{};
     vk::ShaderStageFlagBits m_stage{};
     std::string m_entryPoint{};
     std::string m_infoLog{};
     std::vector<ShaderResource> m_resources{};
     std::vector<uint32_t> m_binary{}; // spir-v code
+    std::map<uint32_t, uint32_t> m_specializationConstants{};
 };
 
 } // namespace huan::engine::vulkan
@@ -3,23 +3,70 @@
 //
 
 #pragma once
+#include <atomic>
+#include <future>
 #include <glslang/Public/ShaderLang.h>
 
 #include "huan/backend/shader.hpp"
 
+namespace huan::utils
+{
+class ThreadPool;
+}
+
 namespace huan::runtime
 {
+/**
+ * @brief One GLSL -> SPIR-V compilation of GLSLCompiler::compileBatch().
+ */
+struct ShaderCompileJob
+{
+    vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eVertex;
+    // Preprocessed GLSL, includes already inlined
+    std::string source;
+    std::string entryPoint = "main";
+    vulkan::ShaderVariant variant;
+    // Only used in the logs
+    std::string name;
+};
+
+struct ShaderCompileResult
+{
+    bool success = false;
+    std::vector<uint32_t> spirv;
+    std::string infoLog;
+};
+
 /**
  * Convert SPIR-V code from GLSL source
+ * @note Thread safe: glslang is initialized once for the process, and every compilation has its own
+ * TShader/TProgram. The target env is global though, set it before compiling.
  */
-class GLSLCompiler final
+class HUAN_API GLSLCompiler final
 {
 public:
+    /**
+     * Compile the jobs in parallel on the shader compile workers.
+     * @return One future per job, in the same order.
+     */
+    static std::vector<std::future<ShaderCompileResult>> compileBatch(std::vector<ShaderCompileJob> jobs);
+    static std::future<ShaderCompileResult> compileAsync(ShaderCompileJob job);
+    /**
+     * @brief Workers shared by the shader compilations, created on first use.
+     */
+    static utils::ThreadPool& getThreadPool();
+
     static void setTargetEnv(glslang::EShTargetLanguage targetLanguage,
                              glslang::EShTargetLanguageVersion targetLanguageVersion);
 
     // Reset ENV to default
     static void resetTargetEnv();
+    [[nodiscard]] static glslang::EShTargetLanguage getTargetLanguage();
+    [[nodiscard]] static glslang::EShTargetLanguageVersion getTargetLanguageVersion();
+    /**
+     * @brief glslang version, anything cached from its output is invalid once it changes.
+     */
+    [[nodiscard]] static uint32_t getCompilerVersion();
 
     bool compileToSPIRV(vk::ShaderStageFlagBits stage,
                         const std::string& glslSource,
@@ -30,7 +77,14 @@ public:
         );
 
 private:
-    inline static glslang::EShTargetLanguage envTargetLanguage = glslang::EShTargetLanguage::EShTargetNone;
-    inline static glslang::EShTargetLanguageVersion envTargetLanguageVersion = glslang::EShTargetLanguageVersion::EShTargetSpv_1_0;
+    /**
+     * glslang::InitializeProcess() once, FinalizeProcess() at exit. Both are expensive and not safe to call
+     * while another thread compiles.
+     */
+    static void ensureProcessInitialized();
+
+    inline static std::atomic<glslang::EShTargetLanguage> envTargetLanguage = glslang::EShTargetLanguage::EShTargetNone;
+    inline static std::atomic<glslang::EShTargetLanguageVersion> envTargetLanguageVersion =
+        glslang::EShTargetLanguageVersion::EShTargetSpv_1_0;
 };
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace vk
+{
+enum class ShaderStageFlagBits : unsigned int;
+}
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+struct ShaderResource;
+class ShaderVariant;
+} // namespace vulkan
+
+/**
+ * Packed precompiled shaders written by huan_shaderc: an entry table sorted by variant ID, then the SPIR-V and
+ * reflected resources of every entry. Loading needs neither glslang nor spirv_cross.
+ */
+class HUAN_API ShaderArchive final
+{
+public:
+    ShaderArchive() = default;
+    HUAN_NO_COPY(ShaderArchive)
+    ShaderArchive(ShaderArchive&&) noexcept = default;
+    ShaderArchive& operator=(ShaderArchive&&) noexcept = default;
+
+    /**
+     * @brief Identify a permutation, independently from the order its definitions were added in.
+     * @param shaderName Path of the shader relative to the manifest root, e.g. "ModelsLoad/shader.frag".
+     */
+    [[nodiscard]] static uint64_t computeVariantID(std::string_view shaderName, vk::ShaderStageFlagBits stage,
+                                                   std::string_view entryPoint, const vulkan::ShaderVariant& variant);
+
+    /**
+     * @return False if the file is missing or invalid, the archive is then empty.
+     */
+    bool load(std::string_view filePath);
+    [[nodiscard]] bool contains(uint64_t variantID) const;
+    /**
+     * @return False if the archive has no such variant.
+     */
+    bool find(uint64_t variantID, std::vector<uint32_t>& spirv, std::vector<vulkan::ShaderResource>& resources) const;
+    [[nodiscard]] size_t getEntryCount() const;
+    [[nodiscard]] bool isEmpty() const;
+
+private:
+    struct Entry;
+    [[nodiscard]] const Entry* findEntry(uint64_t variantID) const;
+
+    std::vector<char> m_data;
+    // Points into m_data
+    const Entry* m_entries = nullptr;
+    uint32_t m_entryCount = 0;
+
+    friend class ShaderArchiveWriter;
+};
+
+/**
+ * @brief Collects compiled variants and writes them as a ShaderArchive.
+ */
+class HUAN_API ShaderArchiveWriter final
+{
+public:
+    /**
+     * @return False if the variant ID is already in the archive.
+     */
+    bool add(uint64_t variantID, vk::ShaderStageFlagBits stage, const std::vector<uint32_t>& spirv,
+             const std::vector<vulkan::ShaderResource>& resources);
+    /**
+     * @brief Atomic, an archive being loaded meanwhile is never seen half written.
+     */
+    bool write(std::string_view filePath) const;
+    [[nodiscard]] size_t getEntryCount() const;
+
+private:
+    struct PendingEntry
+    {
+        uint64_t variantID;
+        uint32_t stage;
+        std::vector<uint32_t> spirv;
+        std::vector<char> resources;
+    };
+    std::vector<PendingEntry> m_entries;
+};
+} // namespace huan::runtime
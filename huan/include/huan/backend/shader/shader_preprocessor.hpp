@@ -0,0 +1,105 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "huan/common.hpp"
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace huan::runtime
+{
+/**
+ * Inlines the `#include "..."` of GLSL sources. Include files are read and split once, then kept by absolute path,
+ * so preprocessing every variant of a shader family costs one read per unique file.
+ * `#pragma once` and `#ifndef X / #define X ... #endif` guards make repeated includes expand once, an include cycle
+ * without them is an error. The output carries `#line` directives (GL_GOOGLE_cpp_style_line_directive) so that
+ * compiler messages name the file and line the code came from.
+ * Includes are looked up next to the including file first, then relative to the working directory.
+ * @note Thread safe. Cached files are only re-read after invalidate() or clear().
+ */
+class ShaderPreprocessor final : public DeferredSystem<ShaderPreprocessor>
+{
+    friend class DeferredSystem<ShaderPreprocessor>;
+
+public:
+    struct Stats
+    {
+        // Include files read from disk, and includes served from the cache
+        uint32_t fileLoads = 0;
+        uint32_t cacheHits = 0;
+    };
+
+    /**
+     * @param sourceName Path of the source, names it in `#line` directives and locates its includes.
+     * @param includedFiles If not null, receives the resolved path of every file included, directly or not, once.
+     * @return False with the reason in `infoLog` on a missing include or an include cycle.
+     */
+    bool preprocess(std::string_view source, std::string_view sourceName, std::string& output, std::string& infoLog,
+                    std::vector<std::string>* includedFiles = nullptr);
+
+    /**
+     * @brief Forget a cached file, e.g. after it was edited.
+     */
+    void invalidate(const std::filesystem::path& file);
+    void clear();
+
+    [[nodiscard]] size_t getFileCount() const;
+    [[nodiscard]] Stats getStats() const;
+
+protected:
+    explicit ShaderPreprocessor() = default;
+
+private:
+    struct Segment
+    {
+        // Lines up to the next include, each '\n' terminated
+        std::string text;
+        // As written between the quotes, empty for the last segment
+        std::string include;
+        // 1 based line of the include directive
+        uint32_t includeLine = 0;
+    };
+    struct SourceFile
+    {
+        std::vector<Segment> segments;
+        bool isPragmaOnce = false;
+        // Macro of an include guard wrapping the whole file, empty if none
+        std::string guard;
+        // End of the #version line in the first segment and the number of the line after it, 0 and 1 if none
+        size_t versionEnd = 0;
+        uint32_t versionNextLine = 1;
+    };
+    struct ExpandState
+    {
+        std::string& output;
+        std::string& infoLog;
+        std::vector<std::string>* includedFiles;
+        // Files being expanded as (absolute path, name), outermost first
+        std::vector<std::pair<std::string, std::string>> stack;
+        // Files guarded against a second expansion, already expanded once
+        std::unordered_set<std::string> guardedFiles;
+        std::unordered_set<std::string> reportedFiles;
+    };
+
+    static SourceFile parse(std::string_view text);
+    /**
+     * @return Null if no candidate path can be read, else the cached file and its absolute path in `key`.
+     */
+    Ref<const SourceFile> load(const std::filesystem::path& directory, const std::string& include, std::string& key,
+                               std::string& path);
+    bool expand(const SourceFile& file, const std::filesystem::path& directory, bool isMainSource,
+                ExpandState& state);
+
+    std::unordered_map<std::string, Ref<const SourceFile>> m_files;
+    Stats m_stats{};
+    mutable std::mutex m_mutex;
+};
+} // namespace huan::runtime
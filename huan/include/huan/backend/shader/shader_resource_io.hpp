@@ -0,0 +1,28 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <vector>
+
+#include "huan/common.hpp"
+#include "huan/utils/binary_stream.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+struct ShaderResource;
+}
+
+/**
+ * @brief Binary form of reflected resources, stored next to the SPIR-V in the shader cache and archives.
+ * Fixed size records followed by a string table holding each distinct name once, records refer to names by offset.
+ * Reading it back replaces the spirv_cross pass entirely.
+ */
+HUAN_API void writeShaderResources(utils::BinaryWriter& writer, const std::vector<vulkan::ShaderResource>& resources);
+/**
+ * @return False if the data is truncated or invalid, `resources` is then left in an unspecified state.
+ */
+HUAN_API bool readShaderResources(utils::BinaryReader& reader, std::vector<vulkan::ShaderResource>& resources);
+} // namespace huan::runtime
@@ -0,0 +1,77 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "huan/common_templates/deferred_system.hpp"
+
+namespace vk
+{
+enum class ShaderStageFlagBits : unsigned int;
+}
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+struct ShaderResource;
+class ShaderVariant;
+} // namespace vulkan
+
+/**
+ * Content addressed on-disk cache of compiled shaders: one file per key holding the SPIR-V and its reflected
+ * resources, so a warm start neither runs glslang nor spirv_cross.
+ * The key covers everything the output depends on: preprocessed source (includes inlined), variant, stage,
+ * entry point, target env and glslang version. Entries are never invalidated, a change gives a new key.
+ * @note Thread safe, entries are written atomically, readers never see a partial one.
+ */
+class SPIRVCache final : public DeferredSystem<SPIRVCache>
+{
+    friend class DeferredSystem<SPIRVCache>;
+
+public:
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t stores = 0;
+        // Entries found but unreadable: truncated, corrupted or from another format version
+        uint32_t rejected = 0;
+    };
+
+    [[nodiscard]] static uint64_t computeKey(vk::ShaderStageFlagBits stage, std::string_view preprocessedSource,
+                                             std::string_view entryPoint, const vulkan::ShaderVariant& variant);
+
+    /**
+     * @return False on a miss, the outputs are left untouched.
+     */
+    bool load(uint64_t key, std::vector<uint32_t>& spirv, std::vector<vulkan::ShaderResource>& resources);
+    bool store(uint64_t key, const std::vector<uint32_t>& spirv,
+               const std::vector<vulkan::ShaderResource>& resources);
+
+    void setDirectory(const std::filesystem::path& directory);
+    [[nodiscard]] const std::filesystem::path& getDirectory() const;
+    void setEnabled(bool enabled);
+    [[nodiscard]] bool isEnabled() const;
+    [[nodiscard]] Stats getStats() const;
+
+protected:
+    explicit SPIRVCache();
+
+private:
+    [[nodiscard]] std::filesystem::path getEntryPath(uint64_t key) const;
+
+    std::filesystem::path m_directory;
+    bool m_enabled;
+
+    std::atomic<uint32_t> m_hits = 0;
+    std::atomic<uint32_t> m_misses = 0;
+    std::atomic<uint32_t> m_stores = 0;
+    std::atomic<uint32_t> m_rejected = 0;
+};
+} // namespace huan::runtime
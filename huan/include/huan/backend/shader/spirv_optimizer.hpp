@@ -0,0 +1,74 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace huan::runtime
+{
+namespace vulkan
+{
+class ShaderVariant;
+}
+
+/**
+ * spirv-opt passes over the SPIR-V produced by glslang, when built with HUAN_ENABLE_SPIRV_OPT (SPIRV-Tools).
+ * optimize() runs the performance recipe: inlining, dead code elimination, constant folding, ... after freezing the
+ * specialization constants the variant sets. Descriptor bindings are kept even if unused, so that layouts built from
+ * different variants still match. strip() drops the debug info, it must run after reflection which needs the names.
+ * Both default per build type: optimized unless Debug (HUAN_ENABLE_SPIRV_OPT), stripped in Release (HUAN_STRIP_SPIRV).
+ * @note Thread safe. Like the target env of GLSLCompiler, change the settings before compiling.
+ * @note Not measured yet: the module sizes (`huan_shaderc --bench`) and the lavapipe pipeline creation times (the
+ * PipelineStateCache stats logged at shutdown) before and after still have to be collected.
+ */
+class HUAN_API SPIRVOptimizer final
+{
+public:
+    struct Stats
+    {
+        uint32_t optimizedCount = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        double optimizeMilliseconds = 0.0;
+        uint32_t strippedCount = 0;
+        uint64_t strippedBytes = 0;
+    };
+
+    /**
+     * @brief False if SPIRV-Tools isn't linked, optimize() and strip() then leave the code untouched.
+     */
+    [[nodiscard]] static bool isAvailable();
+
+    static void setEnabled(bool enabled);
+    [[nodiscard]] static bool isEnabled();
+    static void setStripEnabled(bool enabled);
+    [[nodiscard]] static bool isStripEnabled();
+
+    /**
+     * @return False with the spirv-opt messages in `infoLog` if a pass fails, `spirv` is then untouched.
+     */
+    static bool optimize(std::vector<uint32_t>& spirv, const vulkan::ShaderVariant& variant, std::string& infoLog);
+    static bool strip(std::vector<uint32_t>& spirv, std::string& infoLog);
+
+    [[nodiscard]] static Stats getStats();
+
+private:
+    inline static std::atomic<bool> s_enabled =
+#if defined(HUAN_ENABLE_SPIRV_OPT) && !defined(HUAN_DEBUG)
+        true;
+#else
+        false;
+#endif
+    inline static std::atomic<bool> s_stripEnabled =
+#if defined(HUAN_ENABLE_SPIRV_OPT) && defined(HUAN_STRIP_SPIRV)
+        true;
+#else
+        false;
+#endif
+};
+} // namespace huan::runtime
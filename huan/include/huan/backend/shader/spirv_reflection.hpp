@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "spirv_cross/spirv_glsl.hpp"
+#include "huan/common.hpp"
 
 namespace vk
 {
@@ -24,7 +25,7 @@ class ShaderVariant;
 /**
  * 生成一系列的ShaderResource 基于 SPIRV反射代码 和 ShaderVariant
  */
-class SPIRVReflection final
+class HUAN_API SPIRVReflection final
 {
 public:
     static bool reflectShaderResources(vk::ShaderStageFlagBits stage,
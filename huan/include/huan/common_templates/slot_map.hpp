@@ -0,0 +1,239 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace huan
+{
+/**
+ * @brief 32 bits generational handle: 20 bits slot index, 12 bits generation. 0 is the null handle.
+ * @tparam T Only used to make handles of different resource types incompatible.
+ */
+template <class T>
+class Handle
+{
+public:
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t GenerationBits = 32 - IndexBits;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1;
+    static constexpr uint32_t MaxIndex = IndexMask;
+
+    constexpr Handle() = default;
+    constexpr Handle(uint32_t index, uint32_t generation)
+        : m_value(((generation & GenerationMask) << IndexBits) | (index & IndexMask))
+    {
+    }
+
+    [[nodiscard]] constexpr uint32_t getIndex() const
+    {
+        return m_value & IndexMask;
+    }
+    [[nodiscard]] constexpr uint32_t getGeneration() const
+    {
+        return m_value >> IndexBits;
+    }
+    [[nodiscard]] constexpr uint32_t getValue() const
+    {
+        return m_value;
+    }
+    [[nodiscard]] constexpr bool isValid() const
+    {
+        return m_value != 0;
+    }
+    constexpr explicit operator bool() const
+    {
+        return isValid();
+    }
+    constexpr bool operator==(const Handle&) const = default;
+
+private:
+    uint32_t m_value = 0;
+};
+
+/**
+ * Dense slot map: values live contiguously (cache friendly iteration), handles go through an indirection table of
+ * slots holding the dense index and a generation, which makes lookups O(1) and detects stale handles.
+ * Erasing moves the last value into the hole, so pointers to values are only stable until the next erase/insert.
+ * @note Not thread safe.
+ */
+template <class T>
+class SlotMap
+{
+public:
+    using HandleType = Handle<T>;
+
+    template <class... Args>
+    HandleType emplace(Args&&... args)
+    {
+        uint32_t slotIndex;
+        if (!m_freeSlots.empty())
+        {
+            slotIndex = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            slotIndex = static_cast<uint32_t>(m_slots.size());
+            if (slotIndex > HandleType::MaxIndex)
+                return {};
+            // Generation starts at 1, so that no valid handle equals the null handle
+            m_slots.push_back(Slot{0, 1});
+        }
+
+        auto& slot = m_slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(m_dense.size());
+        m_dense.emplace_back(std::forward<Args>(args)...);
+        m_denseToSlot.push_back(slotIndex);
+        return HandleType{slotIndex, slot.generation};
+    }
+
+    HandleType insert(T&& value)
+    {
+        return emplace(std::move(value));
+    }
+
+    [[nodiscard]] bool contains(HandleType handle) const
+    {
+        const uint32_t slotIndex = handle.getIndex();
+        return handle.isValid() && slotIndex < m_slots.size() &&
+               m_slots[slotIndex].generation == handle.getGeneration() && m_slots[slotIndex].denseIndex != Free;
+    }
+
+    /**
+     * @return nullptr if the handle is null or stale.
+     */
+    [[nodiscard]] T* get(HandleType handle)
+    {
+        return contains(handle) ? &m_dense[m_slots[handle.getIndex()].denseIndex] : nullptr;
+    }
+    [[nodiscard]] const T* get(HandleType handle) const
+    {
+        return contains(handle) ? &m_dense[m_slots[handle.getIndex()].denseIndex] : nullptr;
+    }
+
+    /**
+     * @brief Get the handle of a value stored in this map, from its address.
+     */
+    [[nodiscard]] HandleType handleOf(const T* value) const
+    {
+        if (value < m_dense.data() || value >= m_dense.data() + m_dense.size())
+            return {};
+        const auto slotIndex = m_denseToSlot[static_cast<size_t>(value - m_dense.data())];
+        return HandleType{slotIndex, m_slots[slotIndex].generation};
+    }
+
+    bool erase(HandleType handle)
+    {
+        if (!contains(handle))
+            return false;
+
+        auto& slot = m_slots[handle.getIndex()];
+        const uint32_t denseIndex = slot.denseIndex;
+        const uint32_t lastIndex = static_cast<uint32_t>(m_dense.size()) - 1;
+        if (denseIndex != lastIndex)
+        {
+            // Resources are rarely move assignable (they hold a device reference), so rebuild in place instead
+            std::destroy_at(&m_dense[denseIndex]);
+            std::construct_at(&m_dense[denseIndex], std::move(m_dense[lastIndex]));
+            m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+            m_slots[m_denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        m_dense.pop_back();
+        m_denseToSlot.pop_back();
+
+        slot.denseIndex = Free;
+        // Wrapping around skips 0, see emplace
+        slot.generation = (slot.generation + 1) & HandleType::GenerationMask;
+        if (slot.generation == 0)
+            slot.generation = 1;
+        m_freeSlots.push_back(handle.getIndex());
+        return true;
+    }
+
+    void clear()
+    {
+        // Newest first, in case values reference older ones
+        while (!m_dense.empty())
+        {
+            m_dense.pop_back();
+        }
+        m_denseToSlot.clear();
+        m_freeSlots.clear();
+        for (uint32_t i = 0; i < m_slots.size(); ++i)
+        {
+            auto& slot = m_slots[i];
+            if (slot.denseIndex != Free)
+            {
+                slot.denseIndex = Free;
+                slot.generation = (slot.generation + 1) & HandleType::GenerationMask;
+                if (slot.generation == 0)
+                    slot.generation = 1;
+            }
+            m_freeSlots.push_back(i);
+        }
+    }
+
+    void reserve(size_t capacity)
+    {
+        m_dense.reserve(capacity);
+        m_denseToSlot.reserve(capacity);
+        m_slots.reserve(capacity);
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_dense.size();
+    }
+    [[nodiscard]] bool empty() const
+    {
+        return m_dense.empty();
+    }
+
+    // Iteration over the dense values, in no particular order
+    auto begin()
+    {
+        return m_dense.begin();
+    }
+    auto end()
+    {
+        return m_dense.end();
+    }
+    auto begin() const
+    {
+        return m_dense.begin();
+    }
+    auto end() const
+    {
+        return m_dense.end();
+    }
+
+private:
+    static constexpr uint32_t Free = 0xffffffff;
+
+    struct Slot
+    {
+        uint32_t denseIndex = Free;
+        uint32_t generation = 1;
+    };
+
+    std::vector<T> m_dense;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+};
+} // namespace huan
+
+template <class T>
+struct std::hash<huan::Handle<T>>
+{
+    size_t operator()(const huan::Handle<T>& handle) const noexcept
+    {
+        return std::hash<uint32_t>{}(handle.getValue());
+    }
+};
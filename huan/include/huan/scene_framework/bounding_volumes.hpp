@@ -0,0 +1,138 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <limits>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace huan::framework::scene_graph
+{
+/**
+ * @brief Axis aligned box as plain data, unlike the AABB3D component. Empty when min > max.
+ */
+struct BoundingBox
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+    [[nodiscard]] glm::vec3 getCenter() const
+    {
+        return (min + max) * 0.5f;
+    }
+    /**
+     * @brief Half of the size along each axis.
+     */
+    [[nodiscard]] glm::vec3 getExtents() const
+    {
+        return (max - min) * 0.5f;
+    }
+    [[nodiscard]] float getSurfaceArea() const
+    {
+        if (isEmpty())
+            return 0.0f;
+        const glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    void merge(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void merge(const BoundingBox& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+    [[nodiscard]] bool overlaps(const BoundingBox& other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    /**
+     * @brief The box around this one once transformed, e.g. from model to world space.
+     */
+    [[nodiscard]] BoundingBox transformed(const glm::mat4& transform) const
+    {
+        // Arvo: each axis of the matrix moves the bounds by its smallest and largest contribution
+        BoundingBox result;
+        result.min = result.max = glm::vec3(transform[3]);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const glm::vec3 column(transform[axis]);
+            const glm::vec3 a = column * min[axis];
+            const glm::vec3 b = column * max[axis];
+            result.min += glm::min(a, b);
+            result.max += glm::max(a, b);
+        }
+        return result;
+    }
+};
+
+/**
+ * Six planes facing inwards, `dot(plane.xyz, point) + plane.w >= 0` inside. Extracted from a view projection
+ * matrix with a [0, 1] depth range (GLM_FORCE_DEPTH_ZERO_TO_ONE).
+ */
+struct Frustum
+{
+    enum Plane
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        PlaneCount
+    };
+
+    glm::vec4 planes[PlaneCount];
+
+    [[nodiscard]] static Frustum fromMatrix(const glm::mat4& viewProjection)
+    {
+        const auto row = [&viewProjection](int index) {
+            return glm::vec4(viewProjection[0][index], viewProjection[1][index], viewProjection[2][index],
+                             viewProjection[3][index]);
+        };
+        Frustum frustum;
+        frustum.planes[Left] = row(3) + row(0);
+        frustum.planes[Right] = row(3) - row(0);
+        frustum.planes[Bottom] = row(3) + row(1);
+        frustum.planes[Top] = row(3) - row(1);
+        frustum.planes[Near] = row(2);
+        frustum.planes[Far] = row(3) - row(2);
+        for (auto& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    /**
+     * @brief False only if the box is fully outside one plane, so boxes near the corners may pass.
+     */
+    [[nodiscard]] bool intersects(const BoundingBox& box) const
+    {
+        const glm::vec3 center = box.getCenter();
+        const glm::vec3 extents = box.getExtents();
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extents) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+} // namespace huan::framework::scene_graph
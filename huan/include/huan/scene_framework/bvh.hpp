@@ -0,0 +1,174 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "huan/common.hpp"
+#include "huan/scene_framework/bounding_volumes.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
+
+namespace huan::framework::scene_graph
+{
+/**
+ * Bounding volume hierarchy over world space boxes, e.g. the AABB3D of the meshes moved by their node's world matrix.
+ * Nodes have 4 children whose bounds are stored per axis, so a query tests the 4 of them at once with SSE.
+ * build() sorts the objects with a binned SAH, the subtrees in parallel. Between builds:
+ * - update() then refit() follows moving objects, keeping the tree but not its quality.
+ * - insert() puts the object in the leaf that grows the least, splitting it when full, remove() takes it out.
+ *   Before the first build the objects wait in an overflow list tested linearly. needsRebuild() tells when the
+ *   inserts got many enough to have degraded the tree.
+ * Queries append the user data of the objects hit, they allocate nothing once the output has grown.
+ * @note Not thread safe, but queries on a const tree can run concurrently.
+ */
+class HUAN_API SceneBVH
+{
+public:
+    using ObjectID = uint32_t;
+    static constexpr ObjectID InvalidObject = std::numeric_limits<ObjectID>::max();
+
+    struct RayHit
+    {
+        ObjectID object = InvalidObject;
+        uint32_t userData = 0;
+        // Along the ray direction, in its units
+        float distance = 0.0f;
+    };
+    struct Stats
+    {
+        uint32_t objectCount = 0;
+        uint32_t nodeCount = 0;
+        uint32_t leafCount = 0;
+        uint32_t overflowCount = 0;
+        uint32_t depth = 0;
+        double buildMilliseconds = 0.0;
+        double refitMilliseconds = 0.0;
+    };
+
+    SceneBVH() = default;
+    HUAN_NO_COPY(SceneBVH)
+    SceneBVH(SceneBVH&& that) noexcept = default;
+    SceneBVH& operator=(SceneBVH&& that) noexcept = default;
+
+    ObjectID insert(const BoundingBox& bounds, uint32_t userData);
+    void remove(ObjectID object);
+    /**
+     * @brief New bounds of a moved object. Queries see it at once, refit() tightens the tree around it.
+     * @note Ignored, with an error, for an object not in the tree, e.g. removed.
+     */
+    void update(ObjectID object, const BoundingBox& bounds);
+    void clear();
+
+    /**
+     * @param workers Null to build on the calling thread only.
+     */
+    void build(utils::ThreadPool* workers = nullptr);
+    /**
+     * @brief Recomputes the bounds of the nodes above objects updated or removed since the last build or refit.
+     */
+    void refit();
+    /**
+     * @brief True once the objects inserted since the last build are a large part of the tree.
+     */
+    [[nodiscard]] bool needsRebuild() const;
+
+    [[nodiscard]] bool isValid(ObjectID object) const;
+    [[nodiscard]] const BoundingBox& getBounds(ObjectID object) const;
+    [[nodiscard]] uint32_t getUserData(ObjectID object) const;
+    [[nodiscard]] size_t size() const
+    {
+        return m_objectCount;
+    }
+    [[nodiscard]] Stats getStats() const;
+
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& userData) const;
+    void queryBox(const BoundingBox& box, std::vector<uint32_t>& userData) const;
+    void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& userData) const;
+    /**
+     * @brief Closest object box hit by the ray within `maxDistance`.
+     * @return False if none.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+private:
+    static constexpr uint32_t LeafCapacity = 4;
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+    // Child of a node which is a leaf, or where an object is: leaf or overflow position
+    static constexpr uint32_t LeafFlag = 0x80000000u;
+    static constexpr uint32_t OverflowFlag = 0x80000000u;
+    // Below it the build splits at the median rather than by SAH, which bounds the depth and the traversal stack
+    static constexpr uint32_t MaxSAHDepth = 48;
+    static constexpr uint32_t TraversalStackSize = 256;
+
+    struct alignas(64) Node
+    {
+        // Bounds of the 4 children, empty slots have empty bounds
+        float minX[4];
+        float minY[4];
+        float minZ[4];
+        float maxX[4];
+        float maxY[4];
+        float maxZ[4];
+        // Node index, leaf index | LeafFlag or InvalidIndex
+        uint32_t children[4];
+        uint32_t parent;
+    };
+    struct Leaf
+    {
+        ObjectID objects[LeafCapacity];
+        uint32_t count;
+        // Node holding the leaf and its child slot there
+        uint32_t node;
+        uint32_t slot;
+    };
+    struct BuildContext;
+
+    // Objects, by ObjectID
+    std::vector<BoundingBox> m_bounds;
+    std::vector<uint32_t> m_userData;
+    // Leaf index, OverflowFlag | position in m_overflow, or InvalidIndex if free
+    std::vector<uint32_t> m_objectLocations;
+    std::vector<ObjectID> m_freeObjects;
+    size_t m_objectCount = 0;
+
+    // Node 0 is the root, parents come before their children
+    std::vector<Node> m_nodes;
+    std::vector<Leaf> m_leaves;
+    std::vector<uint8_t> m_dirtyNodes;
+    std::vector<ObjectID> m_overflow;
+    // Objects in the tree at the last build
+    size_t m_builtObjectCount = 0;
+    size_t m_insertedCount = 0;
+    bool m_hasDirtyNodes = false;
+    Stats m_stats{};
+
+    static void setSlot(Node& node, uint32_t slot, const BoundingBox& bounds);
+    static BoundingBox getSlot(const Node& node, uint32_t slot);
+    void buildNode(BuildContext& context, uint32_t first, uint32_t last, uint32_t nodeIndex, uint32_t depth) const;
+    uint32_t splitRange(BuildContext& context, uint32_t first, uint32_t last, bool isMedianSplit) const;
+    [[nodiscard]] BoundingBox getRangeBounds(const BuildContext& context, uint32_t first, uint32_t last) const;
+    [[nodiscard]] BoundingBox getLeafBounds(const Leaf& leaf) const;
+    // Grows the bounds of the slot and of its ancestors until they contain `bounds`
+    void growToFit(uint32_t nodeIndex, uint32_t slot, const BoundingBox& bounds);
+    void markDirty(uint32_t nodeIndex);
+    bool insertInTree(ObjectID object);
+    void addLeaf(ObjectID object, uint32_t nodeIndex, uint32_t slot);
+    void removeFromLeaf(ObjectID object, uint32_t leafIndex);
+    void pushOverflow(ObjectID object);
+
+    /**
+     * `nodeTest(node, insideMask)` returns the mask of the children to visit, setting in `insideMask` those fully
+     * inside the query, whose descendants are then visited without testing. `objectTest(object, isInside)` is called
+     * for the objects of the leaves visited and of the overflow.
+     */
+    template <class NodeTest, class ObjectTest>
+    void traverse(NodeTest&& nodeTest, ObjectTest&& objectTest) const;
+};
+} // namespace huan::framework::scene_graph
@@ -14,6 +14,7 @@ public:
     explicit Component(std::string&& name);
     explicit Component(const std::string& name);
     Component(Component&& that) noexcept = default;
+    Component& operator=(Component&& that) noexcept = default;
 
     virtual ~Component() = default;
     [[nodiscard]] const std::string& getName() const;
@@ -0,0 +1,230 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace huan::framework::scene_graph
+{
+/**
+ * @brief Index of a node in the component pools of its scene, given by Scene::addNode().
+ */
+using Entity = uint32_t;
+constexpr Entity InvalidEntity = std::numeric_limits<Entity>::max();
+
+/**
+ * Sparse set of the entities having a component of one type: `m_sparse[entity]` is the position of the entity in
+ * the packed arrays, so lookups are O(1) and iterating the pool is a linear scan.
+ */
+class ComponentPoolBase
+{
+public:
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    ComponentPoolBase() = default;
+    HUAN_NO_COPY(ComponentPoolBase)
+    virtual ~ComponentPoolBase() = default;
+
+    virtual void remove(Entity entity) = 0;
+    virtual void clear() = 0;
+
+    [[nodiscard]] bool contains(Entity entity) const
+    {
+        return entity < m_sparse.size() && m_sparse[entity] != InvalidIndex;
+    }
+    [[nodiscard]] size_t size() const
+    {
+        return m_entities.size();
+    }
+    /**
+     * @brief In the order of the components.
+     */
+    [[nodiscard]] const std::vector<Entity>& getEntities() const
+    {
+        return m_entities;
+    }
+
+protected:
+    std::vector<uint32_t> m_sparse;
+    std::vector<Entity> m_entities;
+};
+
+/**
+ * Components of type T stored by value, packed. Removing one moves the last into its place.
+ * @note Adding or removing components invalidates the references to the others.
+ */
+template <class T>
+class ComponentPool final : public ComponentPoolBase
+{
+public:
+    /**
+     * @brief Replaces the component if the entity has one already.
+     */
+    template <class... Args>
+    T& emplace(Entity entity, Args&&... args);
+    void remove(Entity entity) override;
+    void clear() override;
+
+    [[nodiscard]] T* tryGet(Entity entity)
+    {
+        return contains(entity) ? &m_components[m_sparse[entity]] : nullptr;
+    }
+    [[nodiscard]] const T* tryGet(Entity entity) const
+    {
+        return contains(entity) ? &m_components[m_sparse[entity]] : nullptr;
+    }
+    /**
+     * @note The entity must have the component.
+     */
+    [[nodiscard]] T& get(Entity entity)
+    {
+        return m_components[m_sparse[entity]];
+    }
+    [[nodiscard]] const T& get(Entity entity) const
+    {
+        return m_components[m_sparse[entity]];
+    }
+    /**
+     * @brief Parallel to getEntities().
+     */
+    [[nodiscard]] std::span<T> getComponents()
+    {
+        return m_components;
+    }
+    [[nodiscard]] std::span<const T> getComponents() const
+    {
+        return m_components;
+    }
+
+private:
+    std::vector<T> m_components;
+};
+
+/**
+ * Entities having all the components `T...`, iterated from the smallest pool. Allocates nothing.
+ * @note Components must not be added or removed while iterating.
+ */
+template <class... T>
+class ComponentView
+{
+public:
+    explicit ComponentView(ComponentPool<T>*... pools)
+        : m_pools(pools...)
+    {
+    }
+
+    /**
+     * @brief Calls `function(entity, T&...)` for every entity having all the components.
+     */
+    template <class F>
+    void each(F&& function) const;
+
+    /**
+     * @brief Upper bound of the entities visited.
+     */
+    [[nodiscard]] size_t sizeHint() const;
+
+private:
+    std::tuple<ComponentPool<T>*...> m_pools;
+};
+
+template <class T>
+template <class... Args>
+T& ComponentPool<T>::emplace(Entity entity, Args&&... args)
+{
+    if (contains(entity))
+    {
+        auto& component = m_components[m_sparse[entity]];
+        component = T(std::forward<Args>(args)...);
+        return component;
+    }
+    if (entity >= m_sparse.size())
+        m_sparse.resize(static_cast<size_t>(entity) + 1, InvalidIndex);
+    m_sparse[entity] = static_cast<uint32_t>(m_components.size());
+    m_entities.push_back(entity);
+    return m_components.emplace_back(std::forward<Args>(args)...);
+}
+
+template <class T>
+void ComponentPool<T>::remove(Entity entity)
+{
+    if (!contains(entity))
+        return;
+    const uint32_t index = m_sparse[entity];
+    const Entity last = m_entities.back();
+    if (last != entity)
+    {
+        m_components[index] = std::move(m_components.back());
+        m_entities[index] = last;
+        m_sparse[last] = index;
+    }
+    m_components.pop_back();
+    m_entities.pop_back();
+    m_sparse[entity] = InvalidIndex;
+}
+
+template <class T>
+void ComponentPool<T>::clear()
+{
+    m_components.clear();
+    m_entities.clear();
+    m_sparse.clear();
+}
+
+template <class... T>
+template <class F>
+void ComponentView<T...>::each(F&& function) const
+{
+    const bool hasAllPools = std::apply([](auto*... pools) { return ((pools != nullptr) && ...); }, m_pools);
+    if (!hasAllPools)
+        return;
+
+    if constexpr (sizeof...(T) == 1)
+    {
+        // The components and their entities side by side, no lookup at all
+        auto* pool = std::get<0>(m_pools);
+        const auto& entities = pool->getEntities();
+        const auto components = pool->getComponents();
+        for (size_t i = 0; i < components.size(); ++i)
+        {
+            function(entities[i], components[i]);
+        }
+    }
+    else
+    {
+        const ComponentPoolBase* smallest = nullptr;
+        std::apply(
+            [&smallest](auto*... pools) {
+                ((smallest = smallest == nullptr || pools->size() < smallest->size() ? pools : smallest), ...);
+            },
+            m_pools);
+        for (const Entity entity : smallest->getEntities())
+        {
+            std::apply(
+                [&](auto*... pools) {
+                    if ((pools->contains(entity) && ...))
+                        function(entity, pools->get(entity)...);
+                },
+                m_pools);
+        }
+    }
+}
+
+template <class... T>
+size_t ComponentView<T...>::sizeHint() const
+{
+    size_t result = std::numeric_limits<size_t>::max();
+    std::apply([&result](auto*... pools) { ((result = pools == nullptr ? 0 : std::min(result, pools->size())), ...); },
+               m_pools);
+    return result;
+}
+} // namespace huan::framework::scene_graph
@@ -0,0 +1,49 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "huan/utils/hash.hpp"
+
+namespace huan::framework::scene_graph
+{
+/**
+ * @brief Hash of the type name: a compile time constant, the same in the engine library and in the application.
+ */
+using ComponentTypeID = uint64_t;
+
+namespace detail
+{
+template <class T>
+constexpr std::string_view getTypeSignature()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+
+constexpr ComponentTypeID hashTypeSignature(std::string_view signature)
+{
+    // utils::Hasher::addBytes() goes through a void pointer, which isn't allowed in constant expressions
+    uint64_t value = utils::Hasher::OffsetBasis;
+    for (const char character : signature)
+    {
+        value = (value ^ static_cast<uint8_t>(character)) * utils::Hasher::Prime;
+    }
+    return value;
+}
+} // namespace detail
+
+template <class T>
+constexpr ComponentTypeID getComponentTypeID()
+{
+    constexpr ComponentTypeID id = detail::hashTypeSignature(detail::getTypeSignature<std::remove_cvref_t<T>>());
+    return id;
+}
+} // namespace huan::framework::scene_graph
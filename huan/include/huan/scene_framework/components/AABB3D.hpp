@@ -20,6 +20,9 @@ public:
 
     AABB3D(const glm::vec3& minPoint, const glm::vec3& maxPoint);
 
+    AABB3D(AABB3D&& that) noexcept = default;
+    AABB3D& operator=(AABB3D&& that) noexcept = default;
+
     ~AABB3D() override = default;
 
     [[nodiscard]] std::type_index getType() const override;
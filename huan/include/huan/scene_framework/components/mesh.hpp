@@ -19,6 +19,8 @@ class Mesh final : public Component
   public:
     Mesh(const std::string& name);
     Mesh(std::string&& name);
+    Mesh(Mesh&& that) noexcept = default;
+    Mesh& operator=(Mesh&& that) noexcept = default;
     ~Mesh() override = default;
     void updateBounds(const std::vector<glm::vec3>& vertexData, const std::vector<uint16_t>& indexData = {});
     virtual std::type_index getType() const override;
@@ -26,6 +28,10 @@ class Mesh final : public Component
     void addSubMesh(SubMesh& subMesh);
     const std::vector<SubMesh*>& getSubMeshes() const;
     void addNode(Node& node);
+    /**
+     * @brief Forgets `node`, before it is destroyed.
+     */
+    void removeNode(const Node& node);
     const std::vector<Node*>& getNodes() const;
 
   private:
@@ -0,0 +1,21 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include "huan/scene_framework/transform_system.hpp"
+
+namespace huan::framework::scene_graph
+{
+class Mesh;
+
+/**
+ * @brief The Mesh a node shows and the node's transform, stored by value in the component pools by
+ * Scene::setMesh(). What Scene::collectDraws() iterates, without going through the nodes.
+ */
+struct MeshInstance
+{
+    const Mesh* mesh = nullptr;
+    TransformID transform = InvalidTransformID;
+};
+} // namespace huan::framework::scene_graph
@@ -5,22 +5,19 @@
 #ifndef SUB_MESH_HPP
 #define SUB_MESH_HPP
 #include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
 #include <vulkan/vulkan.hpp>
 
 #include "material.hpp"
 #include "huan/common.hpp"
 #include "huan/backend/shader.hpp"
+#include "huan/backend/resource/geometry_arena.hpp"
 #include "huan/scene_framework/component.hpp"
 #include "huan/scene_framework/node.hpp"
 
 #include <optional>
 
-
-namespace huan::runtime::vulkan
-{
-class Buffer;
-}
-
 namespace huan::framework::scene_graph
 {
 struct VertexAttribute
@@ -34,14 +31,39 @@ class SubMesh final : public Component
 {
 public:
     explicit SubMesh(const std::string& name = {});
-    ~SubMesh() override = default;
+    ~SubMesh() override;
     std::type_index getType() const override;
-    vk::IndexType m_indexType{};
+    vk::IndexType m_indexType = runtime::GeometryArena::IndexType;
     uint32_t m_indexOffset = 0;
     uint32_t m_verticesCount = 0;
     uint32_t m_vertexIndices = 0;
-    std::unordered_map<std::string, runtime::vulkan::Buffer> m_vertexBuffers;
-    Scope<runtime::vulkan::Buffer> m_indexBuffer;
+    // Ranges of the shared GeometryArena buffers, owned by this SubMesh and released on destruction
+    runtime::GeometryAllocation m_vertexAllocation;
+    runtime::GeometryAllocation m_indexAllocation;
+
+    /**
+     * @brief Upload interleaved vertices and 32 bits indices into the GeometryArena.
+     */
+    bool setGeometry(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* indexData,
+                     uint32_t indexCount);
+    void releaseGeometry();
+    /**
+     * @return `firstIndex` of the drawIndexed call
+     */
+    [[nodiscard]] uint32_t getFirstIndex() const;
+    /**
+     * @return `vertexOffset` of the drawIndexed call
+     */
+    [[nodiscard]] int32_t getVertexOffset() const;
+    [[nodiscard]] uint32_t getIndexCount() const;
+
+    /**
+     * @brief Makes it an occluder of the OcclusionCuller: a CPU copy of simplified geometry, fully inside the mesh.
+     */
+    void setOccluderGeometry(std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+    [[nodiscard]] bool isOccluder() const;
+    [[nodiscard]] const std::vector<glm::vec3>& getOccluderPositions() const;
+    [[nodiscard]] const std::vector<uint32_t>& getOccluderIndices() const;
 
     void setAttribute(const std::string& name, const VertexAttribute& attribute);
     std::optional<VertexAttribute> getAttribute(const std::string& name) const;
@@ -56,6 +78,8 @@ private:
     std::unordered_map<std::string, VertexAttribute> m_vertexAttributes;
     const Material* m_material = nullptr;
     runtime::vulkan::ShaderVariant m_shaderVariant;
+    std::vector<glm::vec3> m_occluderPositions;
+    std::vector<uint32_t> m_occluderIndices;
 
     void computeShaderVariant();
 };
@@ -4,14 +4,9 @@
 
 #pragma once
 #include "huan/common.hpp"
+#include "huan/backend/resource/resource_handles.hpp"
 #include "huan/scene_framework/component.hpp"
 
-namespace huan::runtime::vulkan
-{
-class Sampler;
-class Image;
-} // namespace huan::vulkan
-
 namespace huan::framework::scene_graph
 {
 class Texture : public Component
@@ -22,13 +17,15 @@ class Texture : public Component
     Texture(Texture&& that) = default;
     ~Texture() override = default;
     [[nodiscard]] virtual std::type_index getType() const override;
-    void setImage(runtime::vulkan::Image* image);
-    [[nodiscard]] runtime::vulkan::Image* getImage() const;
-    void setSampler(runtime::vulkan::Sampler sampler);
+    // The resources are owned by the ResourceRegistry, the texture only refers to them
+    void setImage(runtime::ImageHandle image);
+    [[nodiscard]] runtime::ImageHandle getImage() const;
+    void setSampler(runtime::SamplerHandle sampler);
+    [[nodiscard]] runtime::SamplerHandle getSampler() const;
 
 private:
-    Scope<runtime::vulkan::Image> m_image;
-    Scope<runtime::vulkan::Sampler> m_sampler;
+    runtime::ImageHandle m_image;
+    runtime::SamplerHandle m_sampler;
 };
 
 } // namespace huan::framework
\ No newline at end of file
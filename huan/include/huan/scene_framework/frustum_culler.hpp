@@ -0,0 +1,109 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "huan/common.hpp"
+#include "huan/scene_framework/bounding_volumes.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
+
+namespace huan::framework::scene_graph
+{
+class SubMesh;
+class OcclusionCuller;
+
+/**
+ * @brief Arguments of one drawIndexed call, what the culling passes hand to the renderer.
+ */
+struct DrawItem
+{
+    // Null for geometry which is not a SubMesh, e.g. the model of the VulkanContext
+    const SubMesh* subMesh = nullptr;
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+    // Where the world matrix comes from, e.g. a TransformID, left to the renderer
+    uint32_t transform = 0;
+
+    [[nodiscard]] static DrawItem fromSubMesh(const SubMesh& subMesh, uint32_t transform);
+};
+
+/**
+ * Frustum culling of world space boxes. The boxes are stored as centers and extents, one array per axis, and tested
+ * 8 at a time with AVX2 (HUAN_ENABLE_AVX2), else 4 at a time with SSE. The boxes are split in blocks culled in
+ * parallel, the visible draws come out in the order they were added whatever the thread count.
+ * @note Allocates nothing once the arrays have grown to the number of boxes.
+ */
+class HUAN_API FrustumCuller
+{
+public:
+    struct Stats
+    {
+        uint32_t testedCount = 0;
+        uint32_t visibleCount = 0;
+        // In the frustum but hidden by the occluders
+        uint32_t occludedCount = 0;
+        double cullMilliseconds = 0.0;
+    };
+
+    FrustumCuller() = default;
+    HUAN_NO_COPY(FrustumCuller)
+    FrustumCuller(FrustumCuller&& that) noexcept = default;
+    FrustumCuller& operator=(FrustumCuller&& that) noexcept = default;
+
+    /**
+     * @return Index of the box, to move it with setBounds().
+     */
+    uint32_t add(const BoundingBox& worldBounds, const DrawItem& draw);
+    void setBounds(uint32_t index, const BoundingBox& worldBounds);
+    [[nodiscard]] BoundingBox getBounds(uint32_t index) const;
+    /**
+     * @brief Removes every box but keeps the memory, for scenes gathered again each frame.
+     */
+    void clear();
+    void reserve(size_t count);
+    [[nodiscard]] size_t size() const
+    {
+        return m_draws.size();
+    }
+
+    /**
+     * @brief Replaces `visible` by the draws whose box intersects the frustum, see Frustum::intersects().
+     * @param workers Null to cull on the calling thread only.
+     * @param occlusion If not null, rasterized already: the boxes in the frustum are then tested against it.
+     */
+    void cull(const Frustum& frustum, std::vector<DrawItem>& visible, utils::ThreadPool* workers = nullptr,
+              const OcclusionCuller* occlusion = nullptr);
+    [[nodiscard]] const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    // Boxes culled by one task, a multiple of the SIMD width
+    static constexpr uint32_t BlockSize = 16 * 1024;
+
+    // Padded to the SIMD width with boxes outside every frustum
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_extentX;
+    std::vector<float> m_extentY;
+    std::vector<float> m_extentZ;
+    std::vector<DrawItem> m_draws;
+    // Each block writes the indices of its visible boxes at its own offset, then they are packed
+    std::vector<uint32_t> m_visibleIndices;
+    std::vector<uint32_t> m_blockVisibleCounts;
+    std::vector<uint32_t> m_blockOccludedCounts;
+    Stats m_stats{};
+
+    void cullBlocks(const Frustum& frustum, const OcclusionCuller* occlusion, size_t firstBlock, size_t lastBlock);
+};
+} // namespace huan::framework::scene_graph
@@ -9,6 +9,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "huan/scene_framework/component_pool.hpp"
+#include "huan/scene_framework/transform_system.hpp"
+#include "huan/utils/interned_string.hpp"
+
 namespace huan::framework::scene_graph
 {
 class Component;
@@ -19,13 +23,26 @@ class Node
     Node(size_t id, const std::string& name);
     virtual ~Node() = default;
     [[nodiscard]] size_t getId() const;
-    [[nodiscard]] std::string getName() const;
+    [[nodiscard]] const std::string& getName() const;
+    [[nodiscard]] utils::InternedString getInternedName() const;
 
     void setParent(Node* parent);
     [[nodiscard]] Node* getParent() const;
     void addChild(Node* child);
+    void removeChild(Node* child);
     [[nodiscard]] const std::vector<Node*>& getChildren() const;
 
+    /**
+     * @brief Its transform in the TransformSystem of the scene, set by Scene::addNode().
+     */
+    void setTransform(TransformID transform);
+    [[nodiscard]] TransformID getTransform() const;
+    /**
+     * @brief Its index in the component pools of the scene, set by Scene::addNode().
+     */
+    void setEntity(Entity entity);
+    [[nodiscard]] Entity getEntity() const;
+
     void setComponent(Component* component);
     template <typename T>
     T* getComponent() const;
@@ -35,17 +52,24 @@ class Node
     [[nodiscard]] bool hasComponent(std::type_index type) const;
 
   private:
+    friend class Scene;
+    // Through Scene::renameNode(), which keeps its name index up to date
+    void setName(std::string_view name);
+
     const size_t m_id;
-    std::string m_name;
+    utils::InternedString m_name;
     Node* m_parent = nullptr;
     std::vector<Node*> m_children;
+    TransformID m_transform = InvalidTransformID;
+    Entity m_entity = InvalidEntity;
     std::unordered_map<std::type_index, Component*> m_components;
 };
 
 template <typename T>
 T* Node::getComponent() const
 {
-    return dynamic_cast<T*>(getComponent(typeid(T)));
+    // Stored under typeid(T), i.e. the getType() of a T
+    return static_cast<T*>(getComponent(typeid(T)));
 }
 
 template <typename T>
@@ -0,0 +1,139 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "huan/common.hpp"
+#include "huan/scene_framework/bounding_volumes.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
+
+namespace huan::framework::scene_graph
+{
+/**
+ * Software occlusion culling on the CPU, after masked occlusion culling (Hasselgren et al. 2016).
+ * Occluder triangles are rasterized into a 256x128 depth buffer made of 8x4 pixel tiles. A tile has no per pixel
+ * depth, only the farthest depth of the whole tile and a working layer: a 32 bits coverage mask and the farthest
+ * depth of the pixels it covers, folded into the tile once fully covered. Coverage masks are computed with SIMD,
+ * 8 or 4 pixels at once, and the rows of tiles are split between the workers.
+ * Occludees are boxes, visible unless every tile under their screen rectangle is nearer than their nearest point.
+ * Depth is the [0, 1] NDC depth, near is 0.
+ * The result only depends on the occluders and their order, not on the thread count.
+ * @note Occluders must be the inside of what they stand for, e.g. walls rather than their bounds, or what they
+ * don't hide gets culled.
+ */
+class HUAN_API OcclusionCuller
+{
+public:
+    static constexpr uint32_t Width = 256;
+    static constexpr uint32_t Height = 128;
+    static constexpr uint32_t TileWidth = 8;
+    static constexpr uint32_t TileHeight = 4;
+    static constexpr uint32_t TilesX = Width / TileWidth;
+    static constexpr uint32_t TilesY = Height / TileHeight;
+
+    struct Stats
+    {
+        uint32_t occluderCount = 0;
+        uint32_t triangleCount = 0;
+        // Triangles in front of the camera and not degenerate
+        uint32_t rasterizedCount = 0;
+        double rasterMilliseconds = 0.0;
+    };
+
+    OcclusionCuller();
+    HUAN_NO_COPY(OcclusionCuller)
+    OcclusionCuller(OcclusionCuller&& that) noexcept = default;
+    OcclusionCuller& operator=(OcclusionCuller&& that) noexcept = default;
+
+    /**
+     * @brief Clears the depth buffer and the occluders.
+     */
+    void begin(const glm::mat4& viewProjection);
+    /**
+     * @brief Triangle list in model space. The data is read by rasterize(), it must live until then.
+     */
+    void addOccluder(const glm::mat4& world, std::span<const glm::vec3> positions, std::span<const uint32_t> indices);
+    /**
+     * @param workers Null to rasterize on the calling thread only.
+     */
+    void rasterize(utils::ThreadPool* workers = nullptr);
+    [[nodiscard]] bool hasOccluders() const
+    {
+        return !m_occluders.empty();
+    }
+
+    /**
+     * @brief Conservative: false only if the box is certainly hidden, or out of the screen.
+     * @note Thread safe after rasterize().
+     */
+    [[nodiscard]] bool isVisible(const BoundingBox& worldBounds) const;
+    /**
+     * @brief Farthest depth of each tile, row by row, e.g. to display the buffer.
+     */
+    [[nodiscard]] std::span<const float> getTileDepths() const
+    {
+        return m_tileDepths;
+    }
+    [[nodiscard]] const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct Occluder
+    {
+        glm::mat4 world;
+        std::span<const glm::vec3> positions;
+        std::span<const uint32_t> indices;
+        // Of its vertices and triangles in the setup arrays
+        uint32_t firstVertex;
+        uint32_t firstTriangle;
+    };
+    /**
+     * Edge functions `a * x + b * y + c`, positive inside, and the depth plane, in pixels.
+     */
+    struct Triangle
+    {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        bool isEdgeInclusive[3];
+        float depthA;
+        float depthB;
+        float depthC;
+        float minDepth;
+        float maxDepth;
+        // Tiles touched by its bounds, inclusive, empty for triangles not rasterized
+        int32_t minTileX;
+        int32_t minTileY;
+        int32_t maxTileX;
+        int32_t maxTileY;
+    };
+
+    glm::mat4 m_viewProjection{1.0f};
+    std::vector<Occluder> m_occluders;
+    std::vector<glm::vec4> m_clipVertices;
+    std::vector<Triangle> m_triangles;
+    // Per tile, row by row: farthest depth of the tile, then the working layer
+    std::vector<float> m_tileDepths;
+    std::vector<float> m_layerDepths;
+    std::vector<uint32_t> m_layerMasks;
+    Stats m_stats{};
+
+    void setupOccluder(const Occluder& occluder);
+    void rasterizeRows(uint32_t firstRow, uint32_t lastRow);
+    void updateTile(uint32_t tile, uint32_t coverage, float depth);
+};
+} // namespace huan::framework::scene_graph
@@ -6,16 +6,28 @@
 #define SCENE_HPP
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <typeindex>
 
 #include "huan/common.hpp"
+#include "huan/scene_framework/component_pool.hpp"
+#include "huan/scene_framework/component_type.hpp"
+#include "huan/scene_framework/node.hpp"
+#include "huan/scene_framework/transform_system.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
 
 namespace huan::framework::scene_graph
 {
 class Component;
-class Node;
+class FrustumCuller;
+class Mesh;
+class OcclusionCuller;
 
 /**
  * Root collection for a bunch of nodes
@@ -35,11 +47,33 @@ class Scene
     [[nodiscard]] const std::string& getName() const;
 
     void setNodes(std::vector<Node*> nodes);
+    /**
+     * @brief Gives the node an entity, and a transform if it has none, child of its parent's.
+     */
     void addNode(Scope<Node>&& node);
+    /**
+     * Destroys the node, its children become children of its parent. Its components stored by value go with it,
+     * shared ones stay owned by the scene.
+     */
+    void removeNode(Node& node);
+    void renameNode(Node& node, std::string_view name);
     void addChild(Node* node);
+    /**
+     * @brief Links `node` under `parent`, or makes it a root if null, in the node tree and in the transforms.
+     */
+    void setParent(Node& node, Node* parent);
 
     void addComponent(Scope<Component>&& component);
+    /**
+     * @brief Attaches the component to the node, see setMesh() for a Mesh.
+     */
     void addComponent(Scope<Component>&& component, Node* node);
+    /**
+     * Shows `mesh` on the node, in place of its previous Mesh. The mesh is shared between nodes and owned by the
+     * scene, see addComponent(). Keeps the MeshInstance of the node up to date.
+     * @note The node must have been added to the scene.
+     */
+    void setMesh(Node& node, Mesh& mesh);
     void setComponents(const std::type_index& typeInfo, std::vector<Scope<Component>>&& components);
     template <typename T>
     void setComponents(std::vector<Scope<T>>&& components);
@@ -53,15 +87,70 @@ class Scene
     [[nodiscard]] bool hasComponent() const;
     [[nodiscard]] bool hasComponent(const std::type_index& type_info) const;
 
-    [[nodiscard]] Node* findNode(const std::string& name) const;
+    /**
+     * Components stored by value in packed per type pools, keyed by the entity of their node, unlike the components
+     * above which are owned through pointers and shared between nodes.
+     * @note Adding or removing a component of type T invalidates the references to the other T.
+     */
+    template <class T, class... Args>
+    T& emplaceComponent(const Node& node, Args&&... args);
+    template <class T>
+    void removeComponent(const Node& node);
+    template <class T>
+    [[nodiscard]] T* tryGetComponent(const Node& node);
+    /**
+     * @return Null if no component of type T was ever added.
+     */
+    template <class T>
+    [[nodiscard]] ComponentPool<T>* getComponentPool();
+    /**
+     * @brief Entities having all of `T...`, see ComponentView. Allocates nothing.
+     */
+    template <class... T>
+    [[nodiscard]] ComponentView<T...> view();
+    [[nodiscard]] Node* getNode(Entity entity) const;
+
+    /**
+     * @brief O(1). The shallowest node of that name, the first added among equally deep ones.
+     */
+    [[nodiscard]] Node* findNode(std::string_view name) const;
+    /**
+     * @brief Node at a '/' separated path of names from the root, e.g. "root/house/door". O(depth * children).
+     */
+    [[nodiscard]] Node* findNodeByPath(std::string_view path) const;
     void setRootNode(Node* root);
     [[nodiscard]] Node* getRootNode() const;
 
+    [[nodiscard]] TransformSystem& getTransformSystem();
+    [[nodiscard]] const TransformSystem& getTransformSystem() const;
+    /**
+     * @brief Recomputes the world matrices which changed, see TransformSystem::update().
+     */
+    void updateTransforms(utils::ThreadPool* workers = nullptr);
+    /**
+     * Adds to the culler a draw per SubMesh of every MeshInstance, with the mesh bounds moved by the node's world
+     * matrix as of the last updateTransforms(). The draws reference the node's transform.
+     */
+    void collectDraws(FrustumCuller& culler);
+    /**
+     * @brief Adds the occluder geometry of the SubMeshes having some, see SubMesh::setOccluderGeometry().
+     */
+    void collectOccluders(OcclusionCuller& culler);
+
   private:
+    void removeFromNameIndex(const Node& node);
+
     std::string m_name;
     std::vector<Scope<Node>> m_nodes;
     Node* m_root = nullptr;
     std::unordered_map<std::type_index, std::vector<Scope<Component>>> m_components;
+    TransformSystem m_transforms;
+    // Node of each entity
+    std::vector<Node*> m_entityNodes;
+    std::vector<Entity> m_freeEntities;
+    std::unordered_map<ComponentTypeID, Scope<ComponentPoolBase>> m_componentPools;
+    // Keys view the interned node names, in the order the nodes were added
+    std::unordered_map<std::string_view, std::vector<Node*>> m_nameIndex;
 };
 
 template <typename T>
@@ -89,7 +178,7 @@ std::vector<T*> Scene::getComponents() const
 
         result.resize(scene_components.size());
         std::transform(scene_components.begin(), scene_components.end(), result.begin(),
-                       [](const Scope<Component>& component) -> T* { return dynamic_cast<T*>(component.get()); });
+                       [](const Scope<Component>& component) -> T* { return static_cast<T*>(component.get()); });
     }
     return result;
 }
@@ -100,6 +189,42 @@ bool Scene::hasComponent() const
     return hasComponent(typeid(T));
 }
 
+template <class T, class... Args>
+T& Scene::emplaceComponent(const Node& node, Args&&... args)
+{
+    auto& pool = m_componentPools[getComponentTypeID<T>()];
+    if (!pool)
+        pool = createScope<ComponentPool<T>>();
+    return static_cast<ComponentPool<T>*>(pool.get())->emplace(node.getEntity(), std::forward<Args>(args)...);
+}
+
+template <class T>
+void Scene::removeComponent(const Node& node)
+{
+    if (auto* pool = getComponentPool<T>(); pool != nullptr)
+        pool->remove(node.getEntity());
+}
+
+template <class T>
+T* Scene::tryGetComponent(const Node& node)
+{
+    auto* pool = getComponentPool<T>();
+    return pool != nullptr ? pool->tryGet(node.getEntity()) : nullptr;
+}
+
+template <class T>
+ComponentPool<T>* Scene::getComponentPool()
+{
+    const auto it = m_componentPools.find(getComponentTypeID<T>());
+    return it != m_componentPools.end() ? static_cast<ComponentPool<T>*>(it->second.get()) : nullptr;
+}
+
+template <class... T>
+ComponentView<T...> Scene::view()
+{
+    return ComponentView<T...>(getComponentPool<T>()...);
+}
+
 } // namespace huan::framework
 
 #endif // SCENE_HPP
\ No newline at end of file
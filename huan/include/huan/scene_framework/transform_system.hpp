@@ -0,0 +1,152 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include "huan/common.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+}
+
+namespace huan::framework::scene_graph
+{
+/**
+ * @brief Stable name of a transform, unlike its dense index which changes when the hierarchy is re-sorted.
+ */
+using TransformID = uint32_t;
+constexpr TransformID InvalidTransformID = std::numeric_limits<TransformID>::max();
+
+/**
+ * Local translation / rotation / scale and world matrices of a whole hierarchy, in parallel arrays sorted breadth
+ * first: parents come before their children and each level of the hierarchy is a contiguous range.
+ * update() walks the levels in order and recomputes the world matrix of the transforms whose local TRS changed or
+ * whose parent's world matrix did, the transforms of a level being split between the workers.
+ * Changing the hierarchy only marks the order stale, it's sorted again once by the next update().
+ * @note Not thread safe. Dense indices and world matrices are valid from one update() to the next.
+ */
+class HUAN_API TransformSystem
+{
+public:
+    struct Stats
+    {
+        uint32_t transformCount = 0;
+        uint32_t levelCount = 0;
+        // World matrices recomputed by the last update
+        uint32_t updatedCount = 0;
+        double sortMilliseconds = 0.0;
+        double updateMilliseconds = 0.0;
+    };
+
+    /**
+     * @brief A transform at the origin, identity rotation and scale, child of `parent` if valid.
+     */
+    TransformID create(TransformID parent = InvalidTransformID);
+    /**
+     * @brief The children of `id` become children of its parent, keeping their local TRS. O(transform count).
+     */
+    void destroy(TransformID id);
+    void clear();
+    [[nodiscard]] bool isValid(TransformID id) const;
+
+    /**
+     * @return False, changing nothing, if `parent` is `id` or one of its descendants.
+     */
+    bool setParent(TransformID id, TransformID parent);
+    [[nodiscard]] TransformID getParent(TransformID id) const;
+
+    void setPosition(TransformID id, const glm::vec3& position);
+    void setRotation(TransformID id, const glm::quat& rotation);
+    void setScale(TransformID id, const glm::vec3& scale);
+    void setLocal(TransformID id, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    [[nodiscard]] const glm::vec3& getPosition(TransformID id) const;
+    [[nodiscard]] const glm::quat& getRotation(TransformID id) const;
+    [[nodiscard]] const glm::vec3& getScale(TransformID id) const;
+    /**
+     * @brief As of the last update().
+     */
+    [[nodiscard]] const glm::mat4& getWorldMatrix(TransformID id) const;
+
+    /**
+     * @param workers Null to update on the calling thread only.
+     */
+    void update(utils::ThreadPool* workers = nullptr);
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_denseToID.size();
+    }
+    [[nodiscard]] uint32_t getDenseIndex(TransformID id) const
+    {
+        return m_idToDense[id];
+    }
+    [[nodiscard]] TransformID getID(uint32_t denseIndex) const
+    {
+        return m_denseToID[denseIndex];
+    }
+    /**
+     * @brief Indexed by dense index.
+     */
+    [[nodiscard]] const std::vector<glm::mat4>& getWorldMatrices() const
+    {
+        return m_worldMatrices;
+    }
+    /**
+     * @brief Whether the last update() recomputed the world matrix at this dense index.
+     */
+    [[nodiscard]] bool hasWorldChanged(uint32_t denseIndex) const
+    {
+        return m_worldChanged[denseIndex] != 0;
+    }
+    [[nodiscard]] const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+    // Transforms given to one worker at a time, fewer aren't worth a task
+    static constexpr size_t ParallelGrainSize = 4096;
+
+    void markDirty(uint32_t denseIndex);
+    void sortBreadthFirst();
+    // Recomputes the dirty world matrices of [begin, end), returns how many
+    uint32_t updateRange(size_t begin, size_t end);
+
+    // By dense index
+    std::vector<TransformID> m_parentIDs;
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<glm::mat4> m_worldMatrices;
+    std::vector<uint8_t> m_localDirty;
+    std::vector<uint8_t> m_worldChanged;
+    std::vector<TransformID> m_denseToID;
+    // Dense index of the parent, only valid when the order isn't stale
+    std::vector<uint32_t> m_parents;
+    // Start of each level then the transform count, only valid when the order isn't stale
+    std::vector<uint32_t> m_levelOffsets;
+
+    // By TransformID
+    std::vector<uint32_t> m_idToDense;
+    std::vector<TransformID> m_freeIDs;
+
+    // Reused by sortBreadthFirst()
+    std::vector<uint32_t> m_sortOrder;
+    std::vector<uint32_t> m_childOffsets;
+    std::vector<uint32_t> m_children;
+
+    bool m_isOrderStale = false;
+    bool m_hasDirty = false;
+    Stats m_stats{};
+};
+} // namespace huan::framework::scene_graph
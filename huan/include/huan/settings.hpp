@@ -15,6 +15,39 @@ namespace huan
         int height = 600;
         bool isVulkanValidationEnabled = true;
         int maxFramesInFlight = 2;
+        // Warn once a memory heap uses more than this ratio of its budget
+        float memoryBudgetWarningRatio = 0.9f;
+        // Capacity of the shared geometry buffers every mesh is sub-allocated from
+        uint32_t geometryArenaVertexBytes = 64u * 1024u * 1024u;
+        uint32_t geometryArenaIndexBytes = 32u * 1024u * 1024u;
+        // Defragment once this ratio of the VMA blocks is free space, 0 to disable
+        float defragmentationTriggerRatio = 0.3f;
+        // Time spent on defragmentation passes per frame
+        double defragmentationFrameBudgetMs = 1.0;
+        uint64_t defragmentationMaxBytesPerPass = 16ull * 1024ull * 1024ull;
+        // Compiled shaders and their reflection are cached there, keyed by a hash of the preprocessed source
+        bool isShaderCacheEnabled = true;
+        const char* shaderCacheDirectory = "shader_cache";
+        // Precompiled shader variants written by huan_shaderc, the only shader source without the compiler
+        const char* shaderArchivePath = "shaders.hsa";
+        // Driver pipeline cache, reloaded at startup if written by the same device and driver
+        const char* pipelineCachePath = "pipeline_cache.bin";
+        // Workers of the background pipeline compiler, 0 for one per hardware thread minus one
+        uint32_t pipelineCompilerThreadCount = 2;
+        // Workers splitting the per frame CPU work, e.g. culling, with the main thread, 0 for one per hardware thread
+        // minus one
+        uint32_t frameWorkerThreadCount = 0;
+        // Recompile the pipelines whose shader files (or includes) change, only with the shader compiler built in
+        bool isShaderHotReloadEnabled = true;
+        // DEBUG_VIEW of the model's ModelsLoad/shader.frag variant: 0 for its texture, 1 for the UV, 2 for the vertex
+        // color. Compiled by the PipelineCompiler, the textured pipeline draws meanwhile
+        uint32_t modelDebugView = 0;
+        // Submit the draws with multi draw indirect when the device supports it, one call per pipeline and material
+        bool isIndirectDrawEnabled = true;
+        // Frustum cull in a compute shader writing the indirect draws, needs drawIndirectCount
+        bool isGpuCullingEnabled = false;
+        // Read the GPU culling results back and compare them with the CPU culler, e.g. on lavapipe
+        bool isGpuCullingValidationEnabled = false;
     };
 
    HUAN_API extern  AppSettings globalAppSettings;
@@ -0,0 +1,139 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace huan::utils
+{
+/**
+ * @brief Appends trivially copyable values to a byte buffer, in native endianness. Used for on-disk caches.
+ */
+class BinaryWriter
+{
+public:
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value)
+    {
+        write(&value, sizeof(T));
+    }
+    void write(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const char*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+    /**
+     * @brief uint32 length followed by the characters.
+     */
+    void writeString(std::string_view string)
+    {
+        write(static_cast<uint32_t>(string.size()));
+        write(string.data(), string.size());
+    }
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void writeVector(const std::vector<T>& values)
+    {
+        write(static_cast<uint32_t>(values.size()));
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    [[nodiscard]] const std::vector<char>& getData() const
+    {
+        return m_data;
+    }
+    [[nodiscard]] std::vector<char>& getData()
+    {
+        return m_data;
+    }
+    [[nodiscard]] size_t getSize() const
+    {
+        return m_data.size();
+    }
+
+private:
+    std::vector<char> m_data;
+};
+
+/**
+ * @brief Bounds checked reader of what BinaryWriter wrote. Every read returns false instead of overrunning.
+ */
+class BinaryReader
+{
+public:
+    BinaryReader(const char* data, size_t size)
+        : m_data(data), m_size(size)
+    {
+    }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    bool read(T& value)
+    {
+        return read(&value, sizeof(T));
+    }
+    bool read(void* data, size_t size)
+    {
+        if (m_size - m_offset < size)
+            return false;
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+    bool readString(std::string& string)
+    {
+        uint32_t size = 0;
+        if (!read(size) || m_size - m_offset < size)
+            return false;
+        string.assign(m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    bool readVector(std::vector<T>& values)
+    {
+        uint32_t count = 0;
+        if (!read(count) || (m_size - m_offset) / sizeof(T) < count)
+            return false;
+        values.resize(count);
+        return read(values.data(), count * sizeof(T));
+    }
+    /**
+     * @brief Skip `size` bytes and give a pointer to them, nullptr if there aren't enough.
+     */
+    const char* skip(size_t size)
+    {
+        if (m_size - m_offset < size)
+            return nullptr;
+        const char* begin = m_data + m_offset;
+        m_offset += size;
+        return begin;
+    }
+
+    [[nodiscard]] size_t getOffset() const
+    {
+        return m_offset;
+    }
+    [[nodiscard]] size_t getRemaining() const
+    {
+        return m_size - m_offset;
+    }
+    [[nodiscard]] bool isAtEnd() const
+    {
+        return m_offset == m_size;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+};
+} // namespace huan::utils
@@ -4,6 +4,7 @@
 
 #ifndef FILE_SYSTEM_HPP
 #define FILE_SYSTEM_HPP
+#include <atomic>
 #include <string_view>
 #include <vector>
 
@@ -23,11 +24,31 @@ public:
     {
         return getInstance()->Imp_loadBinaryFileImp(filePath);
     }
-    
+    /**
+     * @brief Unlike loadBinaryFile, a missing file is not an error.
+     * @return False if the file can't be read.
+     */
+    inline static bool tryLoadBytes(std::string_view filePath, std::vector<char>& bytes)
+    {
+        return getInstance()->Imp_tryLoadBytes(filePath, bytes);
+    }
+    /**
+     * Write to a temporary file next to `filePath` then rename it, so readers (other threads or processes) see
+     * either the old content or the new one, never a partial file. Creates the parent directories.
+     */
+    inline static bool writeFileAtomic(std::string_view filePath, const void* data, size_t size)
+    {
+        return getInstance()->Imp_writeFileAtomic(filePath, data, size);
+    }
 
 private:
     std::string Imp_loadFile(std::string_view filePath);
     std::vector<uint32_t> Imp_loadBinaryFileImp(std::string_view filePath);
+    bool Imp_tryLoadBytes(std::string_view filePath, std::vector<char>& bytes);
+    bool Imp_writeFileAtomic(std::string_view filePath, const void* data, size_t size);
+
+    // Makes temporary file names unique between threads
+    std::atomic<uint32_t> m_tempCounter = 0;
 };
 
 }
@@ -0,0 +1,67 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace huan::utils
+{
+/**
+ * Reports the files modified since the last pollChanges(), watched from a background thread.
+ * Uses inotify on Linux: the parent directories are watched, so editors saving through a temporary file and a rename
+ * are seen too. Other platforms compare the last write times every poll interval.
+ * @note watch() and pollChanges() are thread safe.
+ */
+class HUAN_API FileWatcher
+{
+public:
+    explicit FileWatcher(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+    HUAN_NO_COPY(FileWatcher)
+    HUAN_NO_MOVE(FileWatcher)
+    ~FileWatcher();
+
+    /**
+     * @return False if the file can't be watched, e.g. its directory doesn't exist.
+     */
+    bool watch(const std::filesystem::path& file);
+    [[nodiscard]] bool isWatching(const std::filesystem::path& file) const;
+    /**
+     * @return Each file changed since the previous call once, as normalized by normalize().
+     */
+    std::vector<std::string> pollChanges();
+
+    /**
+     * @brief Absolute, lexically normal and with '/' separators, the key files are identified by.
+     */
+    [[nodiscard]] static std::string normalize(const std::filesystem::path& file);
+
+private:
+    void run();
+    void pollWriteTimes();
+    void readNativeEvents();
+
+    std::chrono::milliseconds m_pollInterval;
+    std::thread m_thread;
+    std::atomic<bool> m_stopping = false;
+
+    mutable std::mutex m_mutex;
+    std::unordered_set<std::string> m_changed;
+    // Watched file -> last write time seen, the time is only used when polling
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_files;
+
+    // inotify instance and watch descriptor -> directory, unused when polling
+    int m_inotifyFd = -1;
+    std::unordered_map<int, std::string> m_directories;
+};
+} // namespace huan::utils
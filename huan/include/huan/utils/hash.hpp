@@ -0,0 +1,78 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace huan::utils
+{
+/**
+ * @brief Stable 64 bits FNV-1a, unlike std::hash the value is the same across runs, builds and platforms,
+ * so it can be used as a key of on-disk caches.
+ */
+class Hasher
+{
+public:
+    static constexpr uint64_t OffsetBasis = 0xcbf29ce484222325ull;
+    static constexpr uint64_t Prime = 0x100000001b3ull;
+
+    constexpr Hasher() = default;
+    constexpr explicit Hasher(uint64_t seed)
+        : m_value(seed)
+    {
+    }
+
+    constexpr Hasher& addBytes(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_value = (m_value ^ bytes[i]) * Prime;
+        }
+        return *this;
+    }
+
+    /**
+     * Strings are prefixed with their length, so that ("ab", "c") and ("a", "bc") don't collide.
+     */
+    Hasher& add(std::string_view string)
+    {
+        add(static_cast<uint64_t>(string.size()));
+        return addBytes(string.data(), string.size());
+    }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    Hasher& add(const T& value)
+    {
+        return addBytes(&value, sizeof(T));
+    }
+
+    [[nodiscard]] constexpr uint64_t get() const
+    {
+        return m_value;
+    }
+
+private:
+    uint64_t m_value = OffsetBasis;
+};
+
+[[nodiscard]] inline uint64_t hash64(const void* data, size_t size)
+{
+    return Hasher().addBytes(data, size).get();
+}
+
+[[nodiscard]] inline uint64_t hash64(std::string_view string)
+{
+    return hash64(string.data(), string.size());
+}
+
+[[nodiscard]] constexpr uint64_t hashCombine(uint64_t seed, uint64_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+} // namespace huan::utils
@@ -0,0 +1,64 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "huan/common.hpp"
+
+namespace huan::utils
+{
+/**
+ * Handle of a string stored once for the whole process: copies are a pointer, equality a pointer comparison, and
+ * str() stays valid until exit. Interning takes a lock, do it when loading rather than per frame.
+ */
+class HUAN_API InternedString
+{
+public:
+    /**
+     * @brief The empty string.
+     */
+    InternedString();
+    explicit InternedString(std::string_view string);
+
+    [[nodiscard]] const std::string& str() const
+    {
+        return *m_string;
+    }
+    [[nodiscard]] std::string_view view() const
+    {
+        return *m_string;
+    }
+    [[nodiscard]] bool empty() const
+    {
+        return m_string->empty();
+    }
+
+    bool operator==(const InternedString& other) const
+    {
+        return m_string == other.m_string;
+    }
+
+    /**
+     * @brief Strings interned so far.
+     */
+    [[nodiscard]] static size_t getInternedCount();
+
+private:
+    friend struct std::hash<InternedString>;
+
+    const std::string* m_string;
+};
+} // namespace huan::utils
+
+template <>
+struct std::hash<huan::utils::InternedString>
+{
+    size_t operator()(const huan::utils::InternedString& string) const noexcept
+    {
+        return std::hash<const void*>()(string.m_string);
+    }
+};
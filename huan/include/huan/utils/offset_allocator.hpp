@@ -0,0 +1,110 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// Adapted from OffsetAllocator (https://github.com/sebbbi/OffsetAllocator), under the MIT License:
+//
+// Copyright (c) 2023 Sebastian Aaltonen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace huan::utils
+{
+/**
+ * @brief Hard real-time O(1) offset allocator, a two-level segregated fit (TLSF) over an abstract range.
+ *
+ * It doesn't touch any memory itself: it only hands out offsets inside [0, size), which makes it suitable for
+ * sub-allocating big GPU buffers. Free ranges are kept in 256 bins indexed by a tiny floating point
+ * (5 bits exponent, 3 bits mantissa) of their size, and neighbours are coalesced on free.
+ */
+class OffsetAllocator final
+{
+public:
+    using NodeIndex = uint32_t;
+    static constexpr uint32_t NoSpace = 0xffffffff;
+
+    struct Allocation
+    {
+        uint32_t offset = NoSpace;
+        NodeIndex metadata = NoSpace; // internal: node index
+
+        [[nodiscard]] bool isValid() const
+        {
+            return offset != NoSpace;
+        }
+    };
+
+    struct StorageReport
+    {
+        uint32_t totalFreeSpace = 0;
+        uint32_t largestFreeRegion = 0;
+    };
+
+    explicit OffsetAllocator(uint32_t size, uint32_t maxAllocations = 128 * 1024);
+    OffsetAllocator(OffsetAllocator&& that) noexcept = default;
+    OffsetAllocator& operator=(OffsetAllocator&& that) noexcept = default;
+    OffsetAllocator(const OffsetAllocator&) = delete;
+    OffsetAllocator& operator=(const OffsetAllocator&) = delete;
+    ~OffsetAllocator() = default;
+
+    void reset();
+    /**
+     * @return An invalid allocation if there's no free range big enough or no node left.
+     */
+    [[nodiscard]] Allocation allocate(uint32_t size);
+    void free(Allocation allocation);
+
+    [[nodiscard]] uint32_t getAllocationSize(Allocation allocation) const;
+    [[nodiscard]] StorageReport getStorageReport() const;
+    [[nodiscard]] uint32_t getSize() const;
+
+private:
+    static constexpr uint32_t NumTopBins = 32;
+    static constexpr uint32_t BinsPerLeaf = 8;
+    static constexpr uint32_t TopBinsIndexShift = 3;
+    static constexpr uint32_t LeafBinsIndexMask = 0x7;
+    static constexpr uint32_t NumLeafBins = NumTopBins * BinsPerLeaf;
+    static constexpr NodeIndex Unused = 0xffffffff;
+
+    struct Node
+    {
+        uint32_t dataOffset = 0;
+        uint32_t dataSize = 0;
+        NodeIndex binListPrev = Unused;
+        NodeIndex binListNext = Unused;
+        NodeIndex neighborPrev = Unused;
+        NodeIndex neighborNext = Unused;
+        bool used = false;
+    };
+
+    NodeIndex insertNodeIntoBin(uint32_t size, uint32_t dataOffset);
+    void removeNodeFromBin(NodeIndex nodeIndex);
+
+    uint32_t m_size;
+    uint32_t m_maxAllocations;
+    uint32_t m_freeStorage = 0;
+
+    uint32_t m_usedBinsTop = 0;
+    uint8_t m_usedBins[NumTopBins]{};
+    NodeIndex m_binIndices[NumLeafBins]{};
+
+    std::vector<Node> m_nodes;
+    std::vector<NodeIndex> m_freeNodes;
+    uint32_t m_freeOffset = 0;
+};
+} // namespace huan::utils
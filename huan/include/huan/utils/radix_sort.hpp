@@ -0,0 +1,34 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace huan::utils
+{
+class ThreadPool;
+
+/**
+ * Buffers of radixSort(), kept from one sort to the next so that sorting allocates nothing once they have grown.
+ */
+struct RadixSortScratch
+{
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> histograms;
+};
+
+/**
+ * Stable LSD radix sort of 64 bits keys and the 32 bits values moving with them, 8 bits per pass. The passes where
+ * every key has the same byte are skipped, so keys using only a few bits are cheap.
+ * The arrays are cut in fixed size chunks counted and scattered in parallel, the result doesn't depend on the
+ * workers.
+ * @param workers Null to sort on the calling thread only.
+ */
+HUAN_API void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, RadixSortScratch& scratch,
+                        ThreadPool* workers = nullptr);
+} // namespace huan::utils
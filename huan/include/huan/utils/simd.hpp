@@ -0,0 +1,226 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HUAN_SIMD_SSE 1
+#include <immintrin.h>
+#endif
+// Only when the compiler targets it, see HUAN_ENABLE_AVX2: there is no runtime dispatch
+#if defined(HUAN_SIMD_SSE) && defined(__AVX2__)
+#define HUAN_SIMD_AVX2 1
+#endif
+
+namespace huan::utils
+{
+/**
+ * Four floats, one SSE register when available, else plain loops. Comparisons return the bitmask of the lanes
+ * where they hold, lane 0 in bit 0.
+ */
+struct Float4
+{
+    static constexpr int Width = 4;
+
+#ifdef HUAN_SIMD_SSE
+    __m128 value;
+#else
+    float value[4];
+#endif
+
+    static Float4 load(const float* data)
+    {
+#ifdef HUAN_SIMD_SSE
+        return {_mm_loadu_ps(data)};
+#else
+        return {{data[0], data[1], data[2], data[3]}};
+#endif
+    }
+    static Float4 broadcast(float x)
+    {
+#ifdef HUAN_SIMD_SSE
+        return {_mm_set1_ps(x)};
+#else
+        return {{x, x, x, x}};
+#endif
+    }
+    void store(float* data) const
+    {
+#ifdef HUAN_SIMD_SSE
+        _mm_storeu_ps(data, value);
+#else
+        for (int i = 0; i < 4; ++i)
+        {
+            data[i] = value[i];
+        }
+#endif
+    }
+};
+
+#ifdef HUAN_SIMD_SSE
+#define HUAN_SIMD_BINARY(Type, name, intrinsic)                                                                        \
+    inline Type name(Type a, Type b)                                                                                   \
+    {                                                                                                                  \
+        return {intrinsic(a.value, b.value)};                                                                          \
+    }
+#define HUAN_SIMD_COMPARE(Type, name, compare, movemask)                                                               \
+    inline int name(Type a, Type b)                                                                                    \
+    {                                                                                                                  \
+        return movemask(compare(a.value, b.value));                                                                    \
+    }
+#define HUAN_FLOAT4_BINARY(name, intrinsic) HUAN_SIMD_BINARY(Float4, name, intrinsic)
+#define HUAN_FLOAT4_COMPARE(name, intrinsic) HUAN_SIMD_COMPARE(Float4, name, intrinsic, _mm_movemask_ps)
+#else
+#define HUAN_FLOAT4_BINARY(name, expression)                                                                           \
+    inline Float4 name(Float4 a, Float4 b)                                                                             \
+    {                                                                                                                  \
+        Float4 result;                                                                                                 \
+        for (int i = 0; i < 4; ++i)                                                                                    \
+        {                                                                                                              \
+            const float x = a.value[i];                                                                                \
+            const float y = b.value[i];                                                                                \
+            result.value[i] = expression;                                                                              \
+        }                                                                                                              \
+        return result;                                                                                                 \
+    }
+#define HUAN_FLOAT4_COMPARE(name, expression)                                                                          \
+    inline int name(Float4 a, Float4 b)                                                                                \
+    {                                                                                                                  \
+        int mask = 0;                                                                                                  \
+        for (int i = 0; i < 4; ++i)                                                                                    \
+        {                                                                                                              \
+            const float x = a.value[i];                                                                                \
+            const float y = b.value[i];                                                                                \
+            mask |= (expression) ? 1 << i : 0;                                                                         \
+        }                                                                                                              \
+        return mask;                                                                                                   \
+    }
+#endif
+
+#ifdef HUAN_SIMD_SSE
+HUAN_FLOAT4_BINARY(operator+, _mm_add_ps)
+HUAN_FLOAT4_BINARY(operator-, _mm_sub_ps)
+HUAN_FLOAT4_BINARY(operator*, _mm_mul_ps)
+HUAN_FLOAT4_BINARY(vmin, _mm_min_ps)
+HUAN_FLOAT4_BINARY(vmax, _mm_max_ps)
+HUAN_FLOAT4_COMPARE(lessThan, _mm_cmplt_ps)
+HUAN_FLOAT4_COMPARE(lessEqual, _mm_cmple_ps)
+HUAN_FLOAT4_COMPARE(greaterEqual, _mm_cmpge_ps)
+
+inline Float4 vabs(Float4 a)
+{
+    return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.value)};
+}
+#else
+HUAN_FLOAT4_BINARY(operator+, x + y)
+HUAN_FLOAT4_BINARY(operator-, x - y)
+HUAN_FLOAT4_BINARY(operator*, x * y)
+HUAN_FLOAT4_BINARY(vmin, x < y ? x : y)
+HUAN_FLOAT4_BINARY(vmax, x > y ? x : y)
+HUAN_FLOAT4_COMPARE(lessThan, x < y)
+HUAN_FLOAT4_COMPARE(lessEqual, x <= y)
+HUAN_FLOAT4_COMPARE(greaterEqual, x >= y)
+
+inline Float4 vabs(Float4 a)
+{
+    for (float& x : a.value)
+    {
+        x = x < 0.0f ? -x : x;
+    }
+    return a;
+}
+#endif
+#undef HUAN_FLOAT4_BINARY
+#undef HUAN_FLOAT4_COMPARE
+
+#ifdef HUAN_SIMD_AVX2
+/**
+ * Eight floats in one AVX register, the same interface as Float4. Comparisons set bits 0 to 7.
+ */
+struct Float8
+{
+    static constexpr int Width = 8;
+
+    __m256 value;
+
+    static Float8 load(const float* data)
+    {
+        return {_mm256_loadu_ps(data)};
+    }
+    static Float8 broadcast(float x)
+    {
+        return {_mm256_set1_ps(x)};
+    }
+    void store(float* data) const
+    {
+        _mm256_storeu_ps(data, value);
+    }
+};
+
+#define HUAN_FLOAT8_COMPARE(name, predicate)                                                                           \
+    inline int name(Float8 a, Float8 b)                                                                                \
+    {                                                                                                                  \
+        return _mm256_movemask_ps(_mm256_cmp_ps(a.value, b.value, predicate));                                         \
+    }
+HUAN_SIMD_BINARY(Float8, operator+, _mm256_add_ps)
+HUAN_SIMD_BINARY(Float8, operator-, _mm256_sub_ps)
+HUAN_SIMD_BINARY(Float8, operator*, _mm256_mul_ps)
+HUAN_SIMD_BINARY(Float8, vmin, _mm256_min_ps)
+HUAN_SIMD_BINARY(Float8, vmax, _mm256_max_ps)
+HUAN_FLOAT8_COMPARE(lessThan, _CMP_LT_OQ)
+HUAN_FLOAT8_COMPARE(lessEqual, _CMP_LE_OQ)
+HUAN_FLOAT8_COMPARE(greaterEqual, _CMP_GE_OQ)
+#undef HUAN_FLOAT8_COMPARE
+
+inline Float8 vabs(Float8 a)
+{
+    return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value)};
+}
+#endif
+#ifdef HUAN_SIMD_SSE
+#undef HUAN_SIMD_BINARY
+#undef HUAN_SIMD_COMPARE
+#endif
+
+/**
+ * @brief `out = a * b` for column major 4x4 matrices, the layout of glm::mat4. `out` may alias `a` or `b`.
+ */
+inline void multiplyMat4(const float* a, const float* b, float* out)
+{
+#ifdef HUAN_SIMD_SSE
+    // Each column of the result is a combination of the columns of `a`
+    const __m128 a0 = _mm_loadu_ps(a);
+    const __m128 a1 = _mm_loadu_ps(a + 4);
+    const __m128 a2 = _mm_loadu_ps(a + 8);
+    const __m128 a3 = _mm_loadu_ps(a + 12);
+    __m128 columns[4];
+    for (int column = 0; column < 4; ++column)
+    {
+        const float* bColumn = b + column * 4;
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(bColumn[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(bColumn[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(bColumn[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(bColumn[3])));
+        columns[column] = result;
+    }
+    for (int column = 0; column < 4; ++column)
+    {
+        _mm_storeu_ps(out + column * 4, columns[column]);
+    }
+#else
+    float result[16];
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            result[column * 4 + row] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] +
+                                       a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+        }
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        out[i] = result[i];
+    }
+#endif
+}
+} // namespace huan::utils
@@ -0,0 +1,128 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "huan/common.hpp"
+
+namespace huan::utils
+{
+/**
+ * Fixed set of worker threads consuming a FIFO of tasks. submit() returns a future of the task's result,
+ * exceptions thrown by a task are stored in its future.
+ */
+class HUAN_API ThreadPool
+{
+public:
+    /**
+     * @param threadCount 0 picks one thread per hardware thread, minus the calling one.
+     */
+    explicit ThreadPool(uint32_t threadCount = 0);
+    HUAN_NO_COPY(ThreadPool)
+    HUAN_NO_MOVE(ThreadPool)
+    /**
+     * Runs the tasks still queued, then joins the workers.
+     */
+    ~ThreadPool();
+
+    template <class F, class... Args>
+    auto submit(F&& function, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+
+    /**
+     * Splits [0, count) into chunks of at least `grainSize` items, one per worker plus one run by the calling thread,
+     * and returns once `function(begin, end)` returned for all of them. The first exception is rethrown.
+     * @note Must not be called from a task of this pool, the caller waits for the workers.
+     */
+    template <class F>
+    void parallelFor(size_t count, size_t grainSize, F&& function);
+
+    /**
+     * @brief Block until the queue is empty and no worker is busy.
+     */
+    void waitIdle();
+
+    [[nodiscard]] uint32_t getThreadCount() const;
+    [[nodiscard]] size_t getPendingCount() const;
+
+private:
+    void enqueue(std::function<void()>&& task);
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_idle;
+    uint32_t m_busyCount = 0;
+    bool m_stopping = false;
+};
+
+template <class F, class... Args>
+auto ThreadPool::submit(F&& function, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+{
+    using ResultType = std::invoke_result_t<F, Args...>;
+    // std::function needs a copyable callable, packaged_task is move only
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(
+        [function = std::forward<F>(function), ... args = std::forward<Args>(args)]() mutable {
+            return std::invoke(std::move(function), std::move(args)...);
+        });
+    auto future = task->get_future();
+    enqueue([task]() { (*task)(); });
+    return future;
+}
+
+template <class F>
+void ThreadPool::parallelFor(size_t count, size_t grainSize, F&& function)
+{
+    if (count == 0)
+        return;
+    const size_t maxChunkCount = (count + std::max<size_t>(grainSize, 1) - 1) / std::max<size_t>(grainSize, 1);
+    const size_t chunkCount = std::min<size_t>(maxChunkCount, m_workers.size() + 1);
+    if (chunkCount <= 1)
+    {
+        function(size_t{0}, count);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunkCount - 1);
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize)
+    {
+        const size_t end = std::min(begin + chunkSize, count);
+        futures.push_back(submit([&function, begin, end]() { function(begin, end); }));
+    }
+    try
+    {
+        function(size_t{0}, chunkSize);
+    }
+    catch (...)
+    {
+        // The tasks still reference `function`
+        for (auto& future : futures)
+        {
+            future.wait();
+        }
+        throw;
+    }
+    for (auto& future : futures)
+    {
+        future.wait();
+    }
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+} // namespace huan::utils
@@ -0,0 +1,330 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/gpu_culler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <format>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/shader.hpp"
+#include "huan/backend/pipeline/layout_cache.hpp"
+#include "huan/backend/pipeline/pipeline_state_cache.hpp"
+#include "huan/backend/resource/resource_registry.hpp"
+#include "huan/backend/resource/resource_system.hpp"
+#include "huan/log/Log.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+constexpr uint32_t CommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+// Of the commands in the readback buffer, after the count
+constexpr vk::DeviceSize ReadbackCommandsOffset = 16;
+
+// Push constants of cull.comp
+struct Constants
+{
+    glm::vec4 planes[framework::scene_graph::Frustum::PlaneCount];
+    uint32_t drawCount;
+};
+// The reflected range ends with drawCount, whatever the padding
+constexpr uint32_t ConstantsSize = offsetof(Constants, drawCount) + sizeof(uint32_t);
+
+/**
+ * The buffer of `handle`, recreated at least twice as large when smaller than `size`.
+ * @return True if recreated.
+ */
+template <class Create>
+bool reserveBuffer(BufferHandle& handle, vk::DeviceSize size, Create&& create)
+{
+    auto* registry = ResourceRegistry::getInstance();
+    const auto* buffer = registry->get(handle);
+    if (buffer != nullptr && buffer->getSize() >= size)
+        return false;
+    const vk::DeviceSize capacity = std::max(size, buffer != nullptr ? buffer->getSize() * 2 : 4096);
+    registry->destroy(handle);
+    handle = create(capacity);
+    return true;
+}
+} // namespace
+
+bool GpuCuller::create(const vulkan::ShaderModule& shader, uint32_t frameCount, bool isValidationEnabled)
+{
+    m_device = VulkanContext::getInstance()->device;
+    m_isValidationEnabled = isValidationEnabled;
+
+    // Layouts from the reflection of the shader, both owned by the LayoutCache
+    const std::vector<const vulkan::ShaderModule*> modules = {&shader};
+    const auto* layoutInfo = LayoutCache::getInstance()->getOrCreatePipelineLayout(modules);
+    if (layoutInfo == nullptr || layoutInfo->setLayouts.empty())
+    {
+        HUAN_CORE_ERROR("[GpuCuller]: Failed to create the pipeline layout")
+        return false;
+    }
+    m_pipelineLayout = layoutInfo->handle;
+    ComputePipelineState state;
+    state.shaderModule = &shader;
+    state.layout = m_pipelineLayout;
+    m_pipeline = PipelineStateCache::getInstance()->getOrCreate(state);
+    if (!m_pipeline)
+        return false;
+
+    // Records, commands and count of every frame
+    const vk::DescriptorPoolSize poolSize{vk::DescriptorType::eStorageBuffer, 3 * frameCount};
+    vk::DescriptorPoolCreateInfo poolInfo;
+    poolInfo.setMaxSets(frameCount).setPoolSizes(poolSize);
+    m_descriptorPool = m_device.createDescriptorPool(poolInfo);
+    const std::vector setLayouts(frameCount, layoutInfo->setLayouts[0]);
+    vk::DescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.setDescriptorPool(m_descriptorPool).setSetLayouts(setLayouts);
+    const auto sets = m_device.allocateDescriptorSets(allocateInfo);
+
+    m_frames.resize(frameCount);
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        m_frames[i].descriptorSet = sets[i];
+    }
+    // Rewritten at the next dispatch of each frame, the moves happen between frames
+    m_relocationListener = DefragmentationSystem::getInstance()->addRelocationListener(
+        [this](vulkan::RelocatableAllocation&) {
+            for (auto& frame : m_frames)
+            {
+                frame.isDescriptorSetDirty = true;
+            }
+        });
+    HUAN_CORE_INFO("[GpuCuller]: Created, validation {}", m_isValidationEnabled ? "on" : "off")
+    return true;
+}
+
+void GpuCuller::destroy()
+{
+    DefragmentationSystem::getInstance()->removeRelocationListener(m_relocationListener);
+    m_relocationListener = DefragmentationSystem::NoListener;
+    auto* registry = ResourceRegistry::getInstance();
+    for (auto& frame : m_frames)
+    {
+        registry->destroy(frame.records);
+        registry->destroy(frame.commands);
+        registry->destroy(frame.count);
+        registry->destroy(frame.readback);
+        frame.stagingRing.destroy();
+    }
+    m_frames.clear();
+    if (m_descriptorPool)
+        m_device.destroyDescriptorPool(m_descriptorPool);
+    m_descriptorPool = nullptr;
+    m_pipeline = nullptr;
+    m_pipelineLayout = nullptr;
+}
+
+void GpuCuller::clear()
+{
+    m_records.clear();
+    m_instanceTransforms.clear();
+    m_drawPipeline = {};
+    m_drawDescriptorSet = nullptr;
+    m_hasMixedStates = false;
+    m_referenceCuller.clear();
+}
+
+uint32_t GpuCuller::add(const framework::scene_graph::BoundingBox& worldBounds,
+                        const framework::scene_graph::DrawItem& draw, const glm::mat4& world,
+                        PipelineHandle pipeline, vk::DescriptorSet descriptorSet)
+{
+    const auto index = static_cast<uint32_t>(m_records.size());
+    if (index == 0)
+    {
+        m_drawPipeline = pipeline;
+        m_drawDescriptorSet = descriptorSet;
+    }
+    else if (pipeline != m_drawPipeline || descriptorSet != m_drawDescriptorSet)
+    {
+        m_hasMixedStates = true;
+    }
+    m_records.push_back({glm::vec4(worldBounds.getCenter(), 0.0f), glm::vec4(worldBounds.getExtents(), 0.0f),
+                         draw.indexCount, draw.firstIndex, draw.vertexOffset, index});
+    m_instanceTransforms.push_back(world);
+    if (m_isValidationEnabled)
+    {
+        auto referenceDraw = draw;
+        referenceDraw.transform = index;
+        m_referenceCuller.add(worldBounds, referenceDraw);
+    }
+    return index;
+}
+
+void GpuCuller::dispatch(vk::CommandBuffer commandBuffer, uint32_t frameIndex,
+                         const framework::scene_graph::Frustum& frustum)
+{
+    FrameResources& frame = m_frames[frameIndex];
+    // The previous use of the frame is over, its commands can be read
+    if (frame.isReadbackPending)
+        validate(frame);
+    frame.stagingRing.reset();
+
+    frame.drawCount = static_cast<uint32_t>(m_records.size());
+    m_stats.drawCount = frame.drawCount;
+    if (frame.drawCount == 0)
+        return;
+    reserveBuffers(frame, frameIndex);
+    auto* registry = ResourceRegistry::getInstance();
+    // A staged copy is covered by the clear barrier below
+    ResourceSystem::getInstance()->writeBuffer(*registry->get(frame.records), m_records.data(),
+                                               m_records.size() * sizeof(DrawRecord), 0, commandBuffer,
+                                               frame.stagingRing);
+    if (frame.isDescriptorSetDirty)
+    {
+        writeDescriptorSet(frame);
+        frame.isDescriptorSetDirty = false;
+    }
+
+    const vk::Buffer countBuffer = registry->get(frame.count)->getHandle();
+    commandBuffer.fillBuffer(countBuffer, 0, sizeof(uint32_t), 0);
+    const vk::MemoryBarrier clearBarrier{vk::AccessFlagBits::eTransferWrite,
+                                         vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite};
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {},
+                                  clearBarrier, nullptr, nullptr);
+
+    Constants constants{};
+    std::copy(std::begin(frustum.planes), std::end(frustum.planes), constants.planes);
+    constants.drawCount = frame.drawCount;
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, 1, &frame.descriptorSet, 0,
+                                     nullptr);
+    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, ConstantsSize, &constants);
+    commandBuffer.dispatch((frame.drawCount + WorkgroupSize - 1) / WorkgroupSize, 1, 1);
+
+    vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eDrawIndirect;
+    vk::AccessFlags dstAccess = vk::AccessFlagBits::eIndirectCommandRead;
+    if (m_isValidationEnabled)
+    {
+        dstStages |= vk::PipelineStageFlagBits::eTransfer;
+        dstAccess |= vk::AccessFlagBits::eTransferRead;
+    }
+    const vk::MemoryBarrier cullBarrier{vk::AccessFlagBits::eShaderWrite, dstAccess};
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStages, {}, cullBarrier, nullptr,
+                                  nullptr);
+    if (!m_isValidationEnabled)
+        return;
+
+    const vk::Buffer readbackBuffer = registry->get(frame.readback)->getHandle();
+    const vk::BufferCopy countCopy{0, 0, sizeof(uint32_t)};
+    commandBuffer.copyBuffer(countBuffer, readbackBuffer, countCopy);
+    const vk::BufferCopy commandsCopy{0, ReadbackCommandsOffset, vk::DeviceSize{frame.drawCount} * CommandStride};
+    commandBuffer.copyBuffer(registry->get(frame.commands)->getHandle(), readbackBuffer, commandsCopy);
+    const vk::MemoryBarrier readbackBarrier{vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead};
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+                                  readbackBarrier, nullptr, nullptr);
+
+    // What the CPU finds for the same draws, compared once the GPU is done
+    m_referenceCuller.cull(frustum, m_referenceDraws);
+    frame.expectedInstances.clear();
+    for (const auto& draw : m_referenceDraws)
+    {
+        frame.expectedInstances.push_back(draw.transform);
+    }
+    std::ranges::sort(frame.expectedInstances);
+    frame.isReadbackPending = true;
+}
+
+void GpuCuller::draw(vk::CommandBuffer commandBuffer, uint32_t frameIndex, vk::PipelineLayout layout)
+{
+    const FrameResources& frame = m_frames[frameIndex];
+    if (frame.drawCount == 0)
+        return;
+    // Same as RenderQueue::bindState(): the fallback meanwhile, else nothing
+    const vk::Pipeline pipeline = PipelineCompiler::getInstance()->resolve(m_drawPipeline);
+    if (!pipeline)
+    {
+        m_stats.skippedFrameCount++;
+        return;
+    }
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 0, 1, &m_drawDescriptorSet, 0,
+                                     nullptr);
+    const auto* registry = ResourceRegistry::getInstance();
+    commandBuffer.drawIndexedIndirectCount(registry->get(frame.commands)->getHandle(), 0,
+                                           registry->get(frame.count)->getHandle(), 0, frame.drawCount,
+                                           CommandStride);
+}
+
+void GpuCuller::reserveBuffers(FrameResources& frame, uint32_t frameIndex)
+{
+    auto* resourceSystem = ResourceSystem::getInstance();
+    const vk::DeviceSize drawCount = frame.drawCount;
+    bool isRecreated = reserveBuffer(frame.records, drawCount * sizeof(DrawRecord), [&](vk::DeviceSize size) {
+        return resourceSystem->createDynamicBuffer(vk::BufferUsageFlagBits::eStorageBuffer, size, nullptr,
+                                                   std::format("GpuCullRecords[{}]", frameIndex),
+                                                   m_relocationListener);
+    });
+    isRecreated |= reserveBuffer(frame.commands, drawCount * CommandStride, [&](vk::DeviceSize size) {
+        return resourceSystem->createDeviceLocalBuffer(
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, size, nullptr,
+            std::format("GpuCullCommands[{}]", frameIndex), m_relocationListener);
+    });
+    isRecreated |= reserveBuffer(frame.count, sizeof(uint32_t), [&](vk::DeviceSize size) {
+        return resourceSystem->createDeviceLocalBuffer(
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, size, nullptr,
+            std::format("GpuCullCount[{}]", frameIndex), m_relocationListener);
+    });
+    frame.isDescriptorSetDirty |= isRecreated;
+    if (m_isValidationEnabled)
+    {
+        reserveBuffer(frame.readback, ReadbackCommandsOffset + drawCount * CommandStride, [&](vk::DeviceSize size) {
+            return resourceSystem->createReadbackBuffer(size, std::format("GpuCullReadback[{}]", frameIndex));
+        });
+    }
+}
+
+void GpuCuller::writeDescriptorSet(const FrameResources& frame) const
+{
+    const auto* registry = ResourceRegistry::getInstance();
+    const std::array bufferInfos = {
+        vk::DescriptorBufferInfo{registry->get(frame.records)->getHandle(), 0, vk::WholeSize},
+        vk::DescriptorBufferInfo{registry->get(frame.commands)->getHandle(), 0, vk::WholeSize},
+        vk::DescriptorBufferInfo{registry->get(frame.count)->getHandle(), 0, vk::WholeSize},
+    };
+    std::array<vk::WriteDescriptorSet, bufferInfos.size()> writes;
+    for (uint32_t binding = 0; binding < writes.size(); ++binding)
+    {
+        writes[binding]
+            .setDstSet(frame.descriptorSet)
+            .setDstBinding(binding)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(bufferInfos[binding]);
+    }
+    m_device.updateDescriptorSets(writes, nullptr);
+}
+
+void GpuCuller::validate(FrameResources& frame)
+{
+    frame.isReadbackPending = false;
+    const auto* readback = ResourceRegistry::getInstance()->get(frame.readback);
+    readback->invalidate();
+    const uint8_t* data = readback->getData();
+    uint32_t visibleCount = 0;
+    std::memcpy(&visibleCount, data, sizeof(uint32_t));
+    visibleCount = std::min(visibleCount, frame.drawCount);
+
+    m_readbackInstances.clear();
+    for (uint32_t i = 0; i < visibleCount; ++i)
+    {
+        vk::DrawIndexedIndirectCommand command;
+        std::memcpy(&command, data + ReadbackCommandsOffset + i * CommandStride, CommandStride);
+        m_readbackInstances.push_back(command.firstInstance);
+    }
+    std::ranges::sort(m_readbackInstances);
+
+    ++m_stats.validatedFrameCount;
+    if (m_readbackInstances != frame.expectedInstances)
+    {
+        ++m_stats.mismatchFrameCount;
+        HUAN_CORE_WARN("[GpuCuller]: The GPU kept {} of {} draws, the CPU culler {}", m_readbackInstances.size(),
+                       frame.drawCount, frame.expectedInstances.size())
+    }
+}
+} // namespace huan::runtime
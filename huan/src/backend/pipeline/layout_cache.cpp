@@ -0,0 +1,316 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/pipeline/layout_cache.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/shader.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+std::optional<vk::DescriptorType> toDescriptorType(const vulkan::ShaderResource& resource)
+{
+    const bool dynamic = resource.mode == vulkan::ShaderResourceMode::Dynamic;
+    switch (resource.type)
+    {
+    case vulkan::ShaderResourceType::InputAttachment:
+        return vk::DescriptorType::eInputAttachment;
+    case vulkan::ShaderResourceType::Image:
+        return vk::DescriptorType::eSampledImage;
+    case vulkan::ShaderResourceType::ImageSampler:
+        return vk::DescriptorType::eCombinedImageSampler;
+    case vulkan::ShaderResourceType::ImageStorage:
+        return vk::DescriptorType::eStorageImage;
+    case vulkan::ShaderResourceType::Sampler:
+        return vk::DescriptorType::eSampler;
+    case vulkan::ShaderResourceType::BufferUniform:
+        return dynamic ? vk::DescriptorType::eUniformBufferDynamic : vk::DescriptorType::eUniformBuffer;
+    case vulkan::ShaderResourceType::BufferStorage:
+        return dynamic ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eStorageBuffer;
+    default:
+        // Stage inputs/outputs, push and specialization constants
+        return std::nullopt;
+    }
+}
+bool isUpdateAfterBindSupported(vk::DescriptorType type)
+{
+    const auto& capabilities = VulkanContext::getInstance()->getDescriptorCapabilities();
+    switch (type)
+    {
+    case vk::DescriptorType::eSampledImage:
+    case vk::DescriptorType::eCombinedImageSampler:
+        return capabilities.hasSampledImageUpdateAfterBind;
+    case vk::DescriptorType::eStorageImage:
+        return capabilities.hasStorageImageUpdateAfterBind;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+bool DescriptorSetLayoutDesc::isUpdateAfterBind() const
+{
+    return std::ranges::any_of(bindingFlags, [](vk::DescriptorBindingFlags flags) {
+        return static_cast<bool>(flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+    });
+}
+
+uint64_t DescriptorSetLayoutDesc::computeHash() const
+{
+    utils::Hasher hasher;
+    hasher.add(static_cast<uint64_t>(bindings.size()));
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const auto& binding = bindings[i];
+        hasher.add(binding.binding)
+              .add(binding.descriptorType)
+              .add(binding.descriptorCount)
+              .add(binding.stageFlags)
+              .add(bindingFlags[i]);
+    }
+    return hasher.get();
+}
+
+uint64_t PipelineLayoutDesc::computeHash() const
+{
+    utils::Hasher hasher;
+    hasher.add(static_cast<uint64_t>(sets.size()));
+    for (const auto& set : sets)
+    {
+        hasher.add(set.computeHash());
+    }
+    hasher.add(static_cast<uint64_t>(pushConstantRanges.size()));
+    for (const auto& range : pushConstantRanges)
+    {
+        hasher.add(range.stageFlags).add(range.offset).add(range.size);
+    }
+    return hasher.get();
+}
+
+LayoutCache::LayoutCache()
+    : deviceHandle(VulkanContext::getInstance()->device)
+{
+}
+
+bool LayoutCache::buildDesc(const std::vector<const vulkan::ShaderModule*>& modules, PipelineLayoutDesc& desc)
+{
+    std::vector<vulkan::ShaderResource> resources;
+    for (const auto* module : modules)
+    {
+        resources.insert(resources.end(), module->getResources().begin(), module->getResources().end());
+    }
+    return buildDesc(resources, desc);
+}
+
+bool LayoutCache::buildDesc(const std::vector<vulkan::ShaderResource>& resources, PipelineLayoutDesc& desc)
+{
+    desc = {};
+    bool valid = true;
+    vk::ShaderStageFlags pushConstantStages;
+    uint32_t pushConstantBegin = std::numeric_limits<uint32_t>::max();
+    uint32_t pushConstantEnd = 0;
+
+    for (const auto& resource : resources)
+    {
+        if (resource.type == vulkan::ShaderResourceType::PushConstant)
+        {
+            pushConstantStages |= resource.stage;
+            pushConstantBegin = std::min(pushConstantBegin, resource.offset);
+            pushConstantEnd = std::max(pushConstantEnd, resource.offset + resource.size);
+            continue;
+        }
+        const auto descriptorType = toDescriptorType(resource);
+        if (!descriptorType)
+            continue;
+
+        if (desc.sets.size() <= resource.set)
+            desc.sets.resize(resource.set + 1);
+        auto& set = desc.sets[resource.set];
+        const vk::DescriptorBindingFlags flags = resource.mode == vulkan::ShaderResourceMode::UpdateAfterBind
+                                                     ? vk::DescriptorBindingFlagBits::eUpdateAfterBind
+                                                     : vk::DescriptorBindingFlags{};
+        // Runtime sized arrays reflect a size of 0, they need at least one descriptor
+        const uint32_t count = std::max(resource.arraySize, 1u);
+
+        const auto it = std::ranges::find(set.bindings, resource.binding, &vk::DescriptorSetLayoutBinding::binding);
+        if (it == set.bindings.end())
+        {
+            set.bindings.emplace_back(resource.binding, *descriptorType, count, resource.stage);
+            set.bindingFlags.push_back(flags);
+            continue;
+        }
+
+        // Same binding seen from another stage
+        if (it->descriptorType != *descriptorType)
+        {
+            HUAN_CORE_ERROR("[LayoutCache]: Set {} binding {} ({}) is a {} in one stage and a {} in another",
+                            resource.set, resource.binding, resource.name, vk::to_string(it->descriptorType),
+                            vk::to_string(*descriptorType))
+            valid = false;
+            continue;
+        }
+        it->stageFlags |= resource.stage;
+        it->descriptorCount = std::max(it->descriptorCount, count);
+        set.bindingFlags[static_cast<size_t>(it - set.bindings.begin())] |= flags;
+    }
+
+    // Sorted, so that the hash doesn't depend on the order of the stages
+    for (auto& set : desc.sets)
+    {
+        std::vector<size_t> order(set.bindings.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::ranges::sort(order, {}, [&](size_t i) { return set.bindings[i].binding; });
+
+        DescriptorSetLayoutDesc sorted;
+        for (const auto i : order)
+        {
+            sorted.bindings.push_back(set.bindings[i]);
+            sorted.bindingFlags.push_back(set.bindingFlags[i]);
+        }
+        set = std::move(sorted);
+    }
+
+    // A single range visible to every stage using push constants, two ranges can't share a stage
+    if (pushConstantStages)
+    {
+        desc.pushConstantRanges.emplace_back(pushConstantStages, pushConstantBegin,
+                                             pushConstantEnd - pushConstantBegin);
+    }
+    return valid;
+}
+
+vk::DescriptorSetLayout LayoutCache::getOrCreateSetLayout(const DescriptorSetLayoutDesc& desc)
+{
+    std::lock_guard lock(m_mutex);
+    return getOrCreateSetLayoutLocked(desc);
+}
+
+const PipelineLayoutInfo* LayoutCache::getOrCreatePipelineLayout(const PipelineLayoutDesc& desc)
+{
+    const uint64_t key = desc.computeHash();
+    std::lock_guard lock(m_mutex);
+    if (const auto it = m_pipelineLayouts.find(key); it != m_pipelineLayouts.end())
+        return &it->second;
+
+    PipelineLayoutInfo info;
+    for (const auto& set : desc.sets)
+    {
+        const auto setLayout = getOrCreateSetLayoutLocked(set);
+        if (!setLayout)
+            return nullptr;
+        info.setLayouts.push_back(setLayout);
+    }
+
+    vk::PipelineLayoutCreateInfo createInfo;
+    createInfo.setSetLayouts(info.setLayouts).setPushConstantRanges(desc.pushConstantRanges);
+    info.handle = deviceHandle.createPipelineLayout(createInfo);
+    if (!info.handle)
+    {
+        HUAN_CORE_ERROR("[LayoutCache]: Failed to create pipeline layout")
+        return nullptr;
+    }
+    return &m_pipelineLayouts.emplace(key, std::move(info)).first->second;
+}
+
+const PipelineLayoutInfo* LayoutCache::getOrCreatePipelineLayout(
+    const std::vector<const vulkan::ShaderModule*>& modules)
+{
+    PipelineLayoutDesc desc;
+    if (!buildDesc(modules, desc))
+        return nullptr;
+    return getOrCreatePipelineLayout(desc);
+}
+
+void LayoutCache::destroy()
+{
+    std::lock_guard lock(m_mutex);
+    for (const auto& [key, info] : m_pipelineLayouts)
+    {
+        deviceHandle.destroyPipelineLayout(info.handle);
+    }
+    m_pipelineLayouts.clear();
+    for (const auto& [key, setLayout] : m_setLayouts)
+    {
+        deviceHandle.destroyDescriptorSetLayout(setLayout);
+    }
+    m_setLayouts.clear();
+    m_updateAfterBindSetLayouts.clear();
+}
+
+bool LayoutCache::isUpdateAfterBind(vk::DescriptorSetLayout setLayout) const
+{
+    std::lock_guard lock(m_mutex);
+    return std::ranges::find(m_updateAfterBindSetLayouts, setLayout) != m_updateAfterBindSetLayouts.end();
+}
+
+size_t LayoutCache::getSetLayoutCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_setLayouts.size();
+}
+
+size_t LayoutCache::getPipelineLayoutCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pipelineLayouts.size();
+}
+
+vk::DescriptorSetLayout LayoutCache::getOrCreateSetLayoutLocked(const DescriptorSetLayoutDesc& desc)
+{
+    const uint64_t key = desc.computeHash();
+    if (const auto it = m_setLayouts.find(key); it != m_setLayouts.end())
+        return it->second;
+
+    // A plain binding where the device lacks the update-after-bind feature of its type, the set must then not be
+    // updated while bound
+    std::vector<vk::DescriptorBindingFlags> bindingFlags = desc.bindingFlags;
+    bool isUpdateAfterBind = false;
+    for (size_t i = 0; i < bindingFlags.size(); ++i)
+    {
+        if (!(bindingFlags[i] & vk::DescriptorBindingFlagBits::eUpdateAfterBind))
+            continue;
+        if (isUpdateAfterBindSupported(desc.bindings[i].descriptorType))
+        {
+            isUpdateAfterBind = true;
+            continue;
+        }
+        HUAN_CORE_WARN("[LayoutCache]: Binding {} ({}) can't be update-after-bind on this device, falling back to a "
+                       "plain binding",
+                       desc.bindings[i].binding, vk::to_string(desc.bindings[i].descriptorType))
+        bindingFlags[i] &= ~vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+    }
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo;
+    flagsInfo.setBindingFlags(bindingFlags);
+    vk::DescriptorSetLayoutCreateInfo createInfo;
+    createInfo.setBindings(desc.bindings);
+    if (isUpdateAfterBind)
+    {
+        createInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool).setPNext(&flagsInfo);
+    }
+
+    const auto setLayout = deviceHandle.createDescriptorSetLayout(createInfo);
+    if (!setLayout)
+    {
+        HUAN_CORE_ERROR("[LayoutCache]: Failed to create descriptor set layout")
+        return nullptr;
+    }
+    HUAN_CORE_TRACE("[LayoutCache]: Created descriptor set layout {:016x} with {} bindings", key,
+                    desc.bindings.size())
+    m_setLayouts.emplace(key, setLayout);
+    if (isUpdateAfterBind)
+        m_updateAfterBindSetLayouts.push_back(setLayout);
+    return setLayout;
+}
+} // namespace huan::runtime
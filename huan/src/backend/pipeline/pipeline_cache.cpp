@@ -0,0 +1,140 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/pipeline/pipeline_cache.hpp"
+
+#include <cstring>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+#include "huan/utils/binary_stream.hpp"
+#include "huan/utils/file_system.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+constexpr uint32_t CacheMagic = 0x434c5048; // "HPLC"
+constexpr uint32_t CacheFormatVersion = 1;
+
+// Prepended to the driver data, which the driver doesn't always validate itself
+struct CacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    // Not part of the Vulkan header, yet some drivers don't change their UUID on update
+    uint32_t driverVersion;
+    uint32_t reserved;
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+// VkPipelineCacheHeaderVersionOne, as laid out by the specification
+struct DriverCacheHeader
+{
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+static_assert(sizeof(DriverCacheHeader) == 32);
+} // namespace
+
+PipelineCache::PipelineCache()
+    : deviceHandle(VulkanContext::getInstance()->device),
+      physicalDeviceHandle(VulkanContext::getInstance()->physicalDevice),
+      m_filePath(globalAppSettings.pipelineCachePath)
+{
+}
+
+void PipelineCache::init()
+{
+    std::vector<char> data;
+    m_warm = false;
+    if (FileSystem::tryLoadBytes(m_filePath, data))
+    {
+        if (isCompatible(data))
+        {
+            m_warm = true;
+        }
+        else
+        {
+            HUAN_CORE_WARN("[PipelineCache]: {} was written by another device or driver, ignoring it", m_filePath)
+        }
+    }
+
+    vk::PipelineCacheCreateInfo createInfo;
+    if (m_warm)
+    {
+        createInfo.setInitialDataSize(data.size() - sizeof(CacheFileHeader))
+                  .setPInitialData(data.data() + sizeof(CacheFileHeader));
+    }
+    m_cache = deviceHandle.createPipelineCache(createInfo);
+    if (!m_cache)
+        HUAN_CORE_BREAK("Failed to create pipeline cache")
+
+    HUAN_CORE_INFO("[PipelineCache]: Created {}", m_warm ? fmt::format("from {} bytes", createInfo.initialDataSize)
+                                                         : std::string("empty"))
+}
+
+bool PipelineCache::save() const
+{
+    if (!m_cache)
+        return false;
+
+    const auto data = deviceHandle.getPipelineCacheData(m_cache);
+    const CacheFileHeader header{CacheMagic, CacheFormatVersion, physicalDeviceHandle.getProperties().driverVersion, 0,
+                                 data.size(), utils::hash64(data.data(), data.size())};
+    utils::BinaryWriter file;
+    file.write(header);
+    file.write(data.data(), data.size());
+    if (!FileSystem::writeFileAtomic(m_filePath, file.getData().data(), file.getSize()))
+    {
+        HUAN_CORE_WARN("[PipelineCache]: Failed to write {}", m_filePath)
+        return false;
+    }
+    HUAN_CORE_INFO("[PipelineCache]: Saved {} bytes to {}", data.size(), m_filePath)
+    return true;
+}
+
+void PipelineCache::destroy()
+{
+    if (!m_cache)
+        return;
+    save();
+    deviceHandle.destroyPipelineCache(m_cache);
+    m_cache = nullptr;
+}
+
+vk::PipelineCache PipelineCache::getHandle() const
+{
+    return m_cache;
+}
+
+bool PipelineCache::isWarm() const
+{
+    return m_warm;
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& data) const
+{
+    utils::BinaryReader reader(data.data(), data.size());
+    CacheFileHeader fileHeader{};
+    DriverCacheHeader driverHeader{};
+    if (!reader.read(fileHeader) || fileHeader.magic != CacheMagic || fileHeader.version != CacheFormatVersion ||
+        fileHeader.dataSize != reader.getRemaining() ||
+        fileHeader.dataHash != utils::hash64(data.data() + sizeof(CacheFileHeader), reader.getRemaining()) ||
+        !reader.read(driverHeader))
+        return false;
+
+    const auto properties = physicalDeviceHandle.getProperties();
+    return fileHeader.driverVersion == properties.driverVersion &&
+           driverHeader.headerSize >= sizeof(DriverCacheHeader) &&
+           driverHeader.headerVersion == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne) &&
+           driverHeader.vendorID == properties.vendorID && driverHeader.deviceID == properties.deviceID &&
+           std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+} // namespace huan::runtime
@@ -0,0 +1,390 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/pipeline/pipeline_compiler.hpp"
+
+#include <algorithm>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/pipeline/layout_cache.hpp"
+#include "huan/backend/pipeline/pipeline_cache.hpp"
+#include "huan/backend/shader/shader_archive.hpp"
+#include "huan/backend/shader/shader_preprocessor.hpp"
+#ifdef HUAN_ENABLE_SHADER_COMPILER
+#include "huan/backend/shader/spirv_cache.hpp"
+#endif
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+#include "huan/utils/file_system.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <class T>
+bool isFinished(const std::future<T>& future)
+{
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// The shader files of a pipeline built elsewhere and their includes
+std::vector<std::string> collectDependencies(const std::vector<PipelineShaderDesc>& shaders)
+{
+    std::vector<std::string> files;
+    for (const auto& shader : shaders)
+    {
+        const auto path = SHADER_ROOT + shader.name;
+        files.push_back(path);
+        std::vector<char> source;
+        std::string output;
+        std::string infoLog;
+        // A broken include still reports the files found before it
+        if (FileSystem::tryLoadBytes(path, source))
+            vulkan::preprocessShader(std::string_view(source.data(), source.size()), path, output, infoLog, &files);
+    }
+    return files;
+}
+} // namespace
+
+PipelineCompiler::PipelineCompiler()
+{
+    // The systems compile() reaches, created here since DeferredSystem::getInstance() takes no lock
+    LayoutCache::getInstance();
+    PipelineCache::getInstance();
+    PipelineStateCache::getInstance();
+    ShaderPreprocessor::getInstance();
+#ifdef HUAN_ENABLE_SHADER_COMPILER
+    SPIRVCache::getInstance();
+#endif
+    m_workers = createScope<utils::ThreadPool>(globalAppSettings.pipelineCompilerThreadCount);
+#ifdef HUAN_ENABLE_SHADER_COMPILER
+    if (globalAppSettings.isShaderHotReloadEnabled)
+        m_watcher = createScope<utils::FileWatcher>();
+#endif
+}
+
+PipelineHandle PipelineCompiler::request(const GraphicsPipelineRequest& request)
+{
+    const uint64_t key = computeRequestKey(request);
+    if (const auto it = m_requestKeys.find(key); it != m_requestKeys.end() && m_records.contains(it->second))
+    {
+        ++m_metrics.deduplicated;
+        return it->second;
+    }
+
+    Record record;
+    record.fallback = request.fallback;
+    record.key = key;
+    record.requestTime = std::chrono::steady_clock::now();
+    // Sources are the truth while hot reloading, an archived variant may be older than the file
+    record.result = m_workers->submit(&PipelineCompiler::compile, request, m_watcher != nullptr);
+    record.request = request;
+    const auto handle = m_records.insert(std::move(record));
+
+    m_requestKeys[key] = handle;
+    ++m_pendingCount;
+    ++m_metrics.requested;
+    return handle;
+}
+
+PipelineHandle PipelineCompiler::adopt(vk::Pipeline pipeline, const GraphicsPipelineRequest* request)
+{
+    Record record;
+    record.status = PipelineStatus::Ready;
+    record.pipeline = pipeline;
+    if (request != nullptr)
+    {
+        record.key = computeRequestKey(*request);
+        record.request = *request;
+    }
+    const auto handle = m_records.insert(std::move(record));
+
+    if (request != nullptr)
+    {
+        // An identical request gets this pipeline instead of compiling it again
+        m_requestKeys.try_emplace(m_records.get(handle)->key, handle);
+        if (m_watcher)
+            watchDependencies(handle, collectDependencies(request->shaders));
+    }
+    return handle;
+}
+
+void PipelineCompiler::update(uint32_t frameNumber)
+{
+    m_frameNumber = frameNumber;
+    if (m_pendingCount != 0 || m_reloadCount != 0)
+    {
+        for (auto& record : m_records)
+        {
+            if (record.status == PipelineStatus::Pending && isFinished(record.result))
+                complete(record);
+            else if (isFinished(record.reload))
+                completeReload(record);
+        }
+    }
+    if (m_watcher)
+        reloadChangedFiles();
+    releaseRetiredPipelines();
+}
+
+vk::Pipeline PipelineCompiler::resolve(PipelineHandle handle) const
+{
+    const auto* record = m_records.get(handle);
+    if (record == nullptr)
+        return nullptr;
+    if (record->status == PipelineStatus::Ready)
+        return record->pipeline;
+
+    // One level only, a fallback is meant to be a generic pipeline created up front
+    const auto* fallback = m_records.get(record->fallback);
+    return (fallback != nullptr && fallback->status == PipelineStatus::Ready) ? fallback->pipeline : nullptr;
+}
+
+PipelineStatus PipelineCompiler::getStatus(PipelineHandle handle) const
+{
+    const auto* record = m_records.get(handle);
+    return record == nullptr ? PipelineStatus::Failed : record->status;
+}
+
+void PipelineCompiler::waitIdle()
+{
+    m_workers->waitIdle();
+    update(m_frameNumber);
+}
+
+void PipelineCompiler::destroy()
+{
+    m_watcher.reset();
+    m_workers->waitIdle();
+    m_records.clear();
+    m_requestKeys.clear();
+    m_dependents.clear();
+    // Still owned by the PipelineStateCache, destroyed with it
+    m_retiredPipelines.clear();
+    m_pendingCount = 0;
+    m_reloadCount = 0;
+}
+
+PipelineCompilerMetrics PipelineCompiler::getMetrics() const
+{
+    auto metrics = m_metrics;
+    metrics.queueDepth = m_pendingCount + m_reloadCount;
+    const uint32_t doneCount = m_metrics.completed + m_metrics.failed;
+    metrics.averageLatencyMs = doneCount == 0 ? 0.0 : m_totalLatencyMs / doneCount;
+    metrics.averageCompileMs = doneCount == 0 ? 0.0 : m_totalCompileMs / doneCount;
+    return metrics;
+}
+
+uint64_t PipelineCompiler::computeRequestKey(const GraphicsPipelineRequest& request)
+{
+    utils::Hasher hasher;
+    hasher.add(static_cast<uint64_t>(request.shaders.size()));
+    for (const auto& shader : request.shaders)
+    {
+        hasher.add(ShaderArchive::computeVariantID(shader.name, shader.stage, "main", shader.variant));
+    }
+
+    // The modules don't exist yet, the shaders above stand for them
+    auto state = request.state;
+    state.shaderModules.clear();
+    hasher.add(state.computeHash());
+    return hasher.get();
+}
+
+PipelineCompiler::CompileResult PipelineCompiler::compile(const GraphicsPipelineRequest& request, bool fromSource)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    auto* context = VulkanContext::getInstance();
+    CompileResult result;
+
+    std::vector<vulkan::ShaderModule> modules;
+    modules.reserve(request.shaders.size());
+    for (const auto& shader : request.shaders)
+    {
+        std::vector<uint32_t> spirv;
+        std::vector<vulkan::ShaderResource> resources;
+        if (!context->loadShaderBinary(shader.name, shader.stage, shader.variant, spirv, resources, result.infoLog,
+                                       fromSource, &result.dependencies))
+        {
+            result.infoLog = fmt::format("{}: {}", shader.name, result.infoLog);
+            result.compileMilliseconds = millisecondsSince(begin);
+            return result;
+        }
+        modules.emplace_back(context->device, shader.stage, std::move(spirv), std::move(resources), "main",
+                             shader.variant);
+    }
+
+    auto state = request.state;
+    state.shaderModules.clear();
+    for (const auto& module : modules)
+    {
+        state.shaderModules.push_back(&module);
+    }
+    if (!state.layout)
+    {
+        const auto* layoutInfo = LayoutCache::getInstance()->getOrCreatePipelineLayout(state.shaderModules);
+        if (layoutInfo == nullptr)
+        {
+            result.infoLog = "Incompatible shader resources between stages";
+            result.compileMilliseconds = millisecondsSince(begin);
+            return result;
+        }
+        state.layout = layoutInfo->handle;
+    }
+    result.pipeline = PipelineStateCache::getInstance()->getOrCreate(state);
+    if (!result.pipeline)
+        result.infoLog = "Pipeline creation failed";
+    result.compileMilliseconds = millisecondsSince(begin);
+    return result;
+}
+
+PipelineCompiler::CompileResult PipelineCompiler::takeResult(std::future<CompileResult>& future)
+{
+    CompileResult result;
+    try
+    {
+        result = future.get();
+    }
+    catch (const std::exception& exception)
+    {
+        // Vulkan-Hpp reports creation errors as exceptions
+        result.infoLog = exception.what();
+    }
+    return result;
+}
+
+void PipelineCompiler::complete(Record& record)
+{
+    auto result = takeResult(record.result);
+    const double latency = millisecondsSince(record.requestTime);
+    --m_pendingCount;
+    m_totalLatencyMs += latency;
+    m_totalCompileMs += result.compileMilliseconds;
+    m_metrics.lastLatencyMs = latency;
+    m_metrics.maxLatencyMs = std::max(m_metrics.maxLatencyMs, latency);
+
+    record.pipeline = result.pipeline;
+    if (result.pipeline)
+    {
+        record.status = PipelineStatus::Ready;
+        ++m_metrics.completed;
+        HUAN_CORE_TRACE("[PipelineCompiler]: Pipeline {:016x} ready after {:.2f} ms ({:.2f} ms compiling)", record.key,
+                        latency, result.compileMilliseconds)
+    }
+    else
+    {
+        record.status = PipelineStatus::Failed;
+        ++m_metrics.failed;
+        // Keep the record, identical requests must not retry every frame
+        HUAN_CORE_ERROR("[PipelineCompiler]: Pipeline {:016x} failed, using its fallback: {}", record.key,
+                        result.infoLog)
+    }
+
+    if (m_watcher)
+    {
+        // Failed pipelines too, fixing the shader retries them
+        watchDependencies(m_records.handleOf(&record), result.dependencies);
+        if (record.isReloadQueued)
+            startReload(record);
+    }
+}
+
+void PipelineCompiler::completeReload(Record& record)
+{
+    auto result = takeResult(record.reload);
+    --m_reloadCount;
+    watchDependencies(m_records.handleOf(&record), result.dependencies);
+
+    if (!result.pipeline)
+    {
+        ++m_metrics.reloadFailed;
+        HUAN_CORE_ERROR("[PipelineCompiler]: Reloading pipeline {:016x} failed, keeping the previous one: {}",
+                        record.key, result.infoLog)
+    }
+    else
+    {
+        // An edit which doesn't change the SPIR-V gives back the same pipeline
+        if (record.pipeline && record.pipeline != result.pipeline)
+            m_retiredPipelines.push_back({record.pipeline, m_frameNumber});
+        record.pipeline = result.pipeline;
+        record.status = PipelineStatus::Ready;
+        ++m_metrics.reloaded;
+        HUAN_CORE_INFO("[PipelineCompiler]: Reloaded pipeline {:016x} in {:.2f} ms", record.key,
+                       result.compileMilliseconds)
+    }
+
+    if (record.isReloadQueued)
+        startReload(record);
+}
+
+void PipelineCompiler::startReload(Record& record)
+{
+    record.isReloadQueued = false;
+    record.reload = m_workers->submit(&PipelineCompiler::compile, record.request, true);
+    ++m_reloadCount;
+}
+
+void PipelineCompiler::reloadChangedFiles()
+{
+    for (const auto& file : m_watcher->pollChanges())
+    {
+        // Includes are cached, the next compilation must read the edit
+        ShaderPreprocessor::getInstance()->invalidate(file);
+        const auto it = m_dependents.find(file);
+        if (it == m_dependents.end())
+            continue;
+
+        HUAN_CORE_INFO("[PipelineCompiler]: {} changed, reloading {} pipelines", file, it->second.size())
+        for (const auto handle : it->second)
+        {
+            auto* record = m_records.get(handle);
+            if (record == nullptr)
+                continue;
+            // Compiling already, it may have read the file before this edit
+            if (record->status == PipelineStatus::Pending || record->reload.valid())
+                record->isReloadQueued = true;
+            else
+                startReload(*record);
+        }
+    }
+}
+
+void PipelineCompiler::watchDependencies(PipelineHandle handle, const std::vector<std::string>& files)
+{
+    if (!m_watcher || m_records.get(handle)->request.shaders.empty())
+        return;
+    for (const auto& file : files)
+    {
+        auto key = utils::FileWatcher::normalize(file);
+        if (!m_watcher->watch(key))
+        {
+            HUAN_CORE_WARN("[PipelineCompiler]: Can't watch {}", key)
+            continue;
+        }
+        auto& dependents = m_dependents[std::move(key)];
+        if (std::ranges::find(dependents, handle) == dependents.end())
+            dependents.push_back(handle);
+    }
+}
+
+void PipelineCompiler::releaseRetiredPipelines()
+{
+    const auto latency = static_cast<uint32_t>(globalAppSettings.maxFramesInFlight);
+    std::erase_if(m_retiredPipelines, [&](const RetiredPipeline& retired) {
+        if (retired.frameNumber + latency > m_frameNumber)
+            return false;
+        // The cache hands out the same pipeline for the same state, e.g. after an edit was undone
+        const bool isUsed = std::ranges::any_of(
+            m_records, [&](const Record& record) { return record.pipeline == retired.pipeline; });
+        if (!isUsed)
+            PipelineStateCache::getInstance()->release(retired.pipeline);
+        return true;
+    });
+}
+} // namespace huan::runtime
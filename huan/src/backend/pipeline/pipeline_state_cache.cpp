@@ -0,0 +1,311 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/pipeline/pipeline_state_cache.hpp"
+
+#include <chrono>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/pipeline/pipeline_cache.hpp"
+#include "huan/backend/shader.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+// Storage of a VkSpecializationInfo, must not move once specialize() pointed into it
+struct Specialization
+{
+    std::vector<vk::SpecializationMapEntry> entries;
+    std::vector<uint32_t> values;
+    vk::SpecializationInfo info;
+};
+
+/**
+ * @brief The specialization constants of `module`, which are only frozen in its SPIR-V when it was optimized.
+ * @return Null if the module has none.
+ */
+const vk::SpecializationInfo* specialize(const vulkan::ShaderModule& module, Specialization& specialization)
+{
+    const auto& constants = module.getSpecializationConstants();
+    if (constants.empty())
+        return nullptr;
+    for (const auto& [constantID, value] : constants)
+    {
+        const auto offset = static_cast<uint32_t>(specialization.values.size() * sizeof(uint32_t));
+        specialization.entries.emplace_back(constantID, offset, sizeof(uint32_t));
+        specialization.values.push_back(value);
+    }
+    specialization.info.setMapEntries(specialization.entries)
+                       .setDataSize(specialization.values.size() * sizeof(uint32_t))
+                       .setPData(specialization.values.data());
+    return &specialization.info;
+}
+
+void addSpecializationConstants(utils::Hasher& hasher, const vulkan::ShaderModule& module)
+{
+    // The same SPIR-V makes different pipelines when it isn't optimized
+    hasher.add(static_cast<uint64_t>(module.getSpecializationConstants().size()));
+    for (const auto& [constantID, value] : module.getSpecializationConstants())
+    {
+        hasher.add(constantID).add(value);
+    }
+}
+} // namespace
+
+uint64_t GraphicsPipelineState::computeHash() const
+{
+    // Field by field, padding bytes of the Vulkan structs are not guaranteed to be zero
+    utils::Hasher hasher;
+    hasher.add(static_cast<uint64_t>(shaderModules.size()));
+    for (const auto* module : shaderModules)
+    {
+        hasher.add(static_cast<uint64_t>(module->getID()))
+              .add(module->getStage())
+              .add(std::string_view(module->getEntryPoint()));
+        addSpecializationConstants(hasher, *module);
+    }
+
+    hasher.add(static_cast<uint64_t>(vertexBindings.size()));
+    for (const auto& binding : vertexBindings)
+    {
+        hasher.add(binding.binding).add(binding.stride).add(binding.inputRate);
+    }
+    hasher.add(static_cast<uint64_t>(vertexAttributes.size()));
+    for (const auto& attribute : vertexAttributes)
+    {
+        hasher.add(attribute.location).add(attribute.binding).add(attribute.format).add(attribute.offset);
+    }
+    hasher.add(topology);
+
+    hasher.add(polygonMode).add(cullMode).add(frontFace).add(depthBiasEnable).add(lineWidth);
+    hasher.add(rasterizationSamples);
+    hasher.add(depthTestEnable).add(depthWriteEnable).add(depthCompareOp);
+
+    hasher.add(static_cast<uint64_t>(colorBlendAttachments.size()));
+    for (const auto& attachment : colorBlendAttachments)
+    {
+        hasher.add(attachment.blendEnable)
+              .add(attachment.srcColorBlendFactor)
+              .add(attachment.dstColorBlendFactor)
+              .add(attachment.colorBlendOp)
+              .add(attachment.srcAlphaBlendFactor)
+              .add(attachment.dstAlphaBlendFactor)
+              .add(attachment.alphaBlendOp)
+              .add(attachment.colorWriteMask);
+    }
+    hasher.add(static_cast<uint64_t>(dynamicStates.size()));
+    for (const auto dynamicState : dynamicStates)
+    {
+        hasher.add(dynamicState);
+    }
+
+    hasher.add(static_cast<VkPipelineLayout>(layout)).add(static_cast<VkRenderPass>(renderPass)).add(subpass);
+    return hasher.get();
+}
+
+uint64_t ComputePipelineState::computeHash() const
+{
+    utils::Hasher hasher;
+    // Never equal to the hash of a graphics state starting with the same values
+    hasher.add(vk::PipelineBindPoint::eCompute);
+    hasher.add(static_cast<uint64_t>(shaderModule->getID())).add(std::string_view(shaderModule->getEntryPoint()));
+    addSpecializationConstants(hasher, *shaderModule);
+    hasher.add(static_cast<VkPipelineLayout>(layout));
+    return hasher.get();
+}
+
+PipelineStateCache::PipelineStateCache()
+    : deviceHandle(VulkanContext::getInstance()->device)
+{
+}
+
+vk::Pipeline PipelineStateCache::getOrCreate(const GraphicsPipelineState& state)
+{
+    return getOrCreateEntry(state, state.renderPass);
+}
+
+vk::Pipeline PipelineStateCache::getOrCreate(const ComputePipelineState& state)
+{
+    return getOrCreateEntry(state, nullptr);
+}
+
+template <class State>
+vk::Pipeline PipelineStateCache::getOrCreateEntry(const State& state, vk::RenderPass renderPass)
+{
+    const uint64_t key = state.computeHash();
+    {
+        std::lock_guard lock(m_mutex);
+        if (const auto it = m_pipelines.find(key); it != m_pipelines.end())
+        {
+            ++m_stats.hits;
+            return it->second.pipeline;
+        }
+        ++m_stats.misses;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    const auto pipeline = create(state);
+    if (!pipeline)
+        return nullptr;
+    const double milliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    HUAN_CORE_TRACE("[PipelineStateCache]: Created pipeline {:016x} in {:.2f} ms", key, milliseconds)
+
+    std::lock_guard lock(m_mutex);
+    m_stats.creationMilliseconds += milliseconds;
+    // Another thread may have created the same state meanwhile, keep the first one
+    const auto [it, inserted] = m_pipelines.try_emplace(key, Entry{pipeline, state.layout, renderPass});
+    if (!inserted)
+        deviceHandle.destroyPipeline(pipeline);
+    return it->second.pipeline;
+}
+
+void PipelineStateCache::evict(vk::PipelineLayout layout, vk::RenderPass renderPass)
+{
+    std::lock_guard lock(m_mutex);
+    std::erase_if(m_pipelines, [&](const auto& pair) {
+        const auto& entry = pair.second;
+        if (entry.layout != layout && (!renderPass || entry.renderPass != renderPass))
+            return false;
+        deviceHandle.destroyPipeline(entry.pipeline);
+        return true;
+    });
+}
+
+void PipelineStateCache::release(vk::Pipeline pipeline)
+{
+    std::lock_guard lock(m_mutex);
+    std::erase_if(m_pipelines, [&](const auto& pair) {
+        if (pair.second.pipeline != pipeline)
+            return false;
+        deviceHandle.destroyPipeline(pipeline);
+        return true;
+    });
+}
+
+void PipelineStateCache::destroy()
+{
+    std::lock_guard lock(m_mutex);
+    for (const auto& [key, entry] : m_pipelines)
+    {
+        deviceHandle.destroyPipeline(entry.pipeline);
+    }
+    m_pipelines.clear();
+}
+
+size_t PipelineStateCache::getPipelineCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pipelines.size();
+}
+
+PipelineStateCache::Stats PipelineStateCache::getStats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+vk::Pipeline PipelineStateCache::create(const GraphicsPipelineState& state)
+{
+    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+    shaderStages.reserve(state.shaderModules.size());
+    std::vector<Specialization> specializations(state.shaderModules.size());
+    for (size_t i = 0; i < state.shaderModules.size(); ++i)
+    {
+        const auto* module = state.shaderModules[i];
+        shaderStages.emplace_back(vk::PipelineShaderStageCreateFlags{}, module->getStage(), module->getHandle(),
+                                  module->getEntryPoint().c_str(), specialize(*module, specializations[i]));
+    }
+
+    std::vector<vk::DynamicState> dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    dynamicStates.insert(dynamicStates.end(), state.dynamicStates.begin(), state.dynamicStates.end());
+    vk::PipelineDynamicStateCreateInfo dynamicInfo;
+    dynamicInfo.setDynamicStates(dynamicStates);
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.setVertexBindingDescriptions(state.vertexBindings)
+                   .setVertexAttributeDescriptions(state.vertexAttributes);
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+    inputAssembly.setTopology(state.topology).setPrimitiveRestartEnable(false);
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.setViewportCount(1).setScissorCount(1);
+
+    vk::PipelineRasterizationStateCreateInfo rasterizerInfo;
+    rasterizerInfo.setDepthClampEnable(false)
+                  .setRasterizerDiscardEnable(false)
+                  .setPolygonMode(state.polygonMode)
+                  .setCullMode(state.cullMode)
+                  .setFrontFace(state.frontFace)
+                  .setDepthBiasEnable(state.depthBiasEnable)
+                  .setLineWidth(state.lineWidth);
+
+    vk::PipelineMultisampleStateCreateInfo multisamplingInfo;
+    multisamplingInfo.setSampleShadingEnable(false)
+                     .setRasterizationSamples(state.rasterizationSamples)
+                     .setMinSampleShading(1.0f);
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencilInfo;
+    depthStencilInfo.setDepthTestEnable(state.depthTestEnable)
+                    .setDepthWriteEnable(state.depthWriteEnable)
+                    .setDepthCompareOp(state.depthCompareOp)
+                    .setDepthBoundsTestEnable(false)
+                    .setMinDepthBounds(0.0f)
+                    .setMaxDepthBounds(1.0f)
+                    .setStencilTestEnable(false);
+
+    vk::PipelineColorBlendStateCreateInfo colorBlendInfo;
+    colorBlendInfo.setLogicOpEnable(false)
+                  .setLogicOp(vk::LogicOp::eCopy)
+                  .setAttachments(state.colorBlendAttachments)
+                  .setBlendConstants({0.0f, 0.0f, 0.0f, 0.0f});
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo;
+    pipelineInfo.setStages(shaderStages)
+                .setPVertexInputState(&vertexInputInfo)
+                .setPInputAssemblyState(&inputAssembly)
+                .setPViewportState(&viewportState)
+                .setPRasterizationState(&rasterizerInfo)
+                .setPMultisampleState(&multisamplingInfo)
+                .setPDepthStencilState(&depthStencilInfo)
+                .setPColorBlendState(&colorBlendInfo)
+                .setPDynamicState(&dynamicInfo)
+                .setLayout(state.layout)
+                .setRenderPass(state.renderPass)
+                .setSubpass(state.subpass)
+                .setBasePipelineHandle(nullptr)
+                .setBasePipelineIndex(-1);
+
+    const auto result = deviceHandle.createGraphicsPipeline(PipelineCache::getInstance()->getHandle(), pipelineInfo);
+    if (result.result != vk::Result::eSuccess)
+    {
+        HUAN_CORE_ERROR("[PipelineStateCache]: Failed to create graphics pipeline: {}", vk::to_string(result.result))
+        return nullptr;
+    }
+    return result.value;
+}
+
+vk::Pipeline PipelineStateCache::create(const ComputePipelineState& state)
+{
+    const auto* module = state.shaderModule;
+    Specialization specialization;
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.setStage({vk::PipelineShaderStageCreateFlags{}, module->getStage(), module->getHandle(),
+                           module->getEntryPoint().c_str(), specialize(*module, specialization)})
+                .setLayout(state.layout)
+                .setBasePipelineHandle(nullptr)
+                .setBasePipelineIndex(-1);
+
+    const auto result = deviceHandle.createComputePipeline(PipelineCache::getInstance()->getHandle(), pipelineInfo);
+    if (result.result != vk::Result::eSuccess)
+    {
+        HUAN_CORE_ERROR("[PipelineStateCache]: Failed to create compute pipeline: {}", vk::to_string(result.result))
+        return nullptr;
+    }
+    return result.value;
+}
+} // namespace huan::runtime
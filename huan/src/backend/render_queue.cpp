@@ -0,0 +1,301 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/render_queue.hpp"
+
+#include <bit>
+#include <chrono>
+
+namespace huan::runtime
+{
+namespace
+{
+constexpr uint32_t PassShift = 62;
+constexpr uint64_t PipelineMask = (1ull << RenderQueue::PipelineIDBits) - 1;
+constexpr uint64_t MaterialMask = (1ull << RenderQueue::MaterialIDBits) - 1;
+constexpr uint32_t StateBits = RenderQueue::PipelineIDBits + RenderQueue::MaterialIDBits;
+static_assert(StateBits + 32 == PassShift);
+
+// Non negative floats compare like their bits
+uint32_t getDepthBits(float viewDepth)
+{
+    return viewDepth > 0.0f ? std::bit_cast<uint32_t>(viewDepth) : 0;
+}
+
+bool isSameGeometry(const framework::scene_graph::DrawItem& a, const framework::scene_graph::DrawItem& b)
+{
+    return a.indexCount == b.indexCount && a.firstIndex == b.firstIndex && a.vertexOffset == b.vertexOffset;
+}
+} // namespace
+
+size_t RenderQueue::GeometryKeyHash::operator()(const GeometryKey& key) const
+{
+    size_t hash = std::hash<uint32_t>{}(key.indexCount);
+    hash ^= std::hash<uint32_t>{}(key.firstIndex) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int32_t>{}(key.vertexOffset) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+template <class Handle>
+uint32_t RenderQueue::StateIDs<Handle>::get(Handle handle, uint32_t frame)
+{
+    const auto [it, isNew] = m_entries.try_emplace(handle);
+    if (isNew)
+    {
+        // Without free IDs, the others are 0 to the count of the older handles
+        if (m_freeIDs.empty())
+        {
+            it->second.id = static_cast<uint32_t>(m_entries.size() - 1);
+        }
+        else
+        {
+            it->second.id = m_freeIDs.back();
+            m_freeIDs.pop_back();
+        }
+    }
+    it->second.lastFrame = frame;
+    return it->second.id;
+}
+
+template <class Handle>
+void RenderQueue::StateIDs<Handle>::retire(uint32_t frame)
+{
+    std::erase_if(m_entries, [this, frame](const auto& entry) {
+        if (frame - entry.second.lastFrame < IDRetireFrameCount)
+            return false;
+        m_freeIDs.push_back(entry.second.id);
+        return true;
+    });
+}
+
+RenderQueue::Pass RenderQueue::getPass(framework::scene_graph::AlphaMode alphaMode)
+{
+    switch (alphaMode)
+    {
+    case framework::scene_graph::AlphaMode::Mask:
+        return Pass::Masked;
+    case framework::scene_graph::AlphaMode::Blend:
+        return Pass::Blended;
+    default:
+        return Pass::Opaque;
+    }
+}
+
+uint64_t RenderQueue::makeKey(Pass pass, uint32_t pipelineID, uint32_t materialID, float viewDepth)
+{
+    const uint64_t passBits = static_cast<uint64_t>(pass) << PassShift;
+    // IDs beyond the bits of the key wrap around: the draws are still right, only less grouped
+    const uint64_t stateBits = ((pipelineID & PipelineMask) << MaterialIDBits) | (materialID & MaterialMask);
+    const uint32_t depthBits = getDepthBits(viewDepth);
+    if (pass == Pass::Blended)
+        return passBits | (static_cast<uint64_t>(~depthBits) << StateBits) | stateBits;
+    return passBits | (stateBits << 32) | depthBits;
+}
+
+void RenderQueue::clear()
+{
+    m_draws.clear();
+    m_keys.clear();
+    m_order.clear();
+    m_batches.clear();
+    m_instanceTransforms.clear();
+    m_indirectRuns.clear();
+    m_indirectCommands.clear();
+    m_indirectCounts.clear();
+    ++m_frame;
+    m_pipelineIDs.retire(m_frame);
+    m_materialIDs.retire(m_frame);
+}
+
+void RenderQueue::push(const framework::scene_graph::DrawItem& draw, const glm::mat4& world, PipelineHandle pipeline,
+                       vk::DescriptorSet descriptorSet, Pass pass, float viewDepth)
+{
+    const uint32_t pipelineID = m_pipelineIDs.get(pipeline.getValue(), m_frame);
+    const uint32_t materialID = m_materialIDs.get(static_cast<VkDescriptorSet>(descriptorSet), m_frame);
+    m_order.push_back(static_cast<uint32_t>(m_draws.size()));
+    m_keys.push_back(makeKey(pass, pipelineID, materialID, viewDepth));
+    m_draws.push_back({draw, world, pipeline, descriptorSet, pass});
+}
+
+void RenderQueue::sort(utils::ThreadPool* workers)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    utils::radixSort(m_keys, m_order, m_sortScratch, workers);
+    buildBatches();
+    buildIndirectRuns();
+    m_stats.sortMilliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void RenderQueue::buildBatches()
+{
+    m_batches.clear();
+    m_drawBatches.clear();
+    m_stateBatches.clear();
+    const QueuedDraw* stateDraw = nullptr;
+    for (const uint32_t index : m_order)
+    {
+        const QueuedDraw& queued = m_draws[index];
+        const bool isSameState = stateDraw != nullptr && queued.pass == stateDraw->pass &&
+                                 queued.pipeline == stateDraw->pipeline &&
+                                 queued.descriptorSet == stateDraw->descriptorSet;
+        if (!isSameState)
+        {
+            m_stateBatches.clear();
+            stateDraw = &queued;
+        }
+
+        uint32_t batch = static_cast<uint32_t>(m_batches.size());
+        if (queued.pass == Pass::Blended)
+        {
+            // Joining a farther batch would draw this one out of order
+            if (isSameState && isSameGeometry(m_draws[m_batches.back().draw].draw, queued.draw))
+                batch = static_cast<uint32_t>(m_batches.size() - 1);
+        }
+        else
+        {
+            const GeometryKey geometry{queued.draw.indexCount, queued.draw.firstIndex, queued.draw.vertexOffset};
+            batch = m_stateBatches.try_emplace(geometry, batch).first->second;
+        }
+        if (batch == m_batches.size())
+            m_batches.push_back({index, 0, 0});
+        ++m_batches[batch].instanceCount;
+        m_drawBatches.push_back(batch);
+    }
+
+    // Each batch gets a contiguous range, filled in the sorted order
+    uint32_t instanceCount = 0;
+    for (auto& batch : m_batches)
+    {
+        batch.firstInstance = instanceCount;
+        instanceCount += batch.instanceCount;
+        batch.instanceCount = 0;
+    }
+    m_instanceTransforms.resize(instanceCount);
+    for (size_t i = 0; i < m_order.size(); ++i)
+    {
+        Batch& batch = m_batches[m_drawBatches[i]];
+        m_instanceTransforms[batch.firstInstance + batch.instanceCount++] = m_draws[m_order[i]].world;
+    }
+}
+
+void RenderQueue::buildIndirectRuns()
+{
+    m_indirectRuns.clear();
+    m_indirectCommands.clear();
+    m_indirectCounts.clear();
+    const QueuedDraw* runDraw = nullptr;
+    for (uint32_t index = 0; index < m_batches.size(); ++index)
+    {
+        const Batch& batch = m_batches[index];
+        const QueuedDraw& queued = m_draws[batch.draw];
+        // Commands run in order, a run may cross passes
+        if (runDraw == nullptr || queued.pipeline != runDraw->pipeline ||
+            queued.descriptorSet != runDraw->descriptorSet ||
+            m_indirectRuns.back().batchCount == MaxIndirectRunLength)
+        {
+            m_indirectRuns.push_back({index, 0, 0});
+            runDraw = &queued;
+        }
+        ++m_indirectRuns.back().batchCount;
+        m_indirectRuns.back().instanceCount += batch.instanceCount;
+
+        const auto& draw = queued.draw;
+        m_indirectCommands.emplace_back(draw.indexCount, batch.instanceCount, draw.firstIndex, draw.vertexOffset,
+                                        batch.firstInstance);
+    }
+    for (const auto& run : m_indirectRuns)
+    {
+        m_indirectCounts.push_back(run.batchCount);
+    }
+}
+
+void RenderQueue::resetRecordStats()
+{
+    m_stats.drawCount = 0;
+    m_stats.instanceCount = 0;
+    m_stats.callCount = 0;
+    m_stats.pipelineBindCount = 0;
+    m_stats.descriptorSetBindCount = 0;
+    m_stats.skippedCount = 0;
+}
+
+bool RenderQueue::bindState(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout, const QueuedDraw& queued,
+                            BoundState& state)
+{
+    // Different handles may resolve to the same pipeline, e.g. to their fallback
+    if (queued.pipeline != state.handle || !state.resolved)
+    {
+        state.handle = queued.pipeline;
+        state.resolved = PipelineCompiler::getInstance()->resolve(queued.pipeline);
+    }
+    if (!state.resolved)
+        return false;
+    if (state.resolved != state.pipeline)
+    {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, state.resolved);
+        state.pipeline = state.resolved;
+        ++m_stats.pipelineBindCount;
+    }
+    // All the pipelines share the layout, the set stays bound across pipeline changes
+    if (queued.descriptorSet != state.descriptorSet)
+    {
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 0, 1, &queued.descriptorSet, 0,
+                                         nullptr);
+        state.descriptorSet = queued.descriptorSet;
+        ++m_stats.descriptorSetBindCount;
+    }
+    return true;
+}
+
+void RenderQueue::record(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout)
+{
+    resetRecordStats();
+    BoundState state;
+    for (const Batch& batch : m_batches)
+    {
+        const QueuedDraw& queued = m_draws[batch.draw];
+        if (!bindState(commandBuffer, layout, queued, state))
+        {
+            m_stats.skippedCount += batch.instanceCount;
+            continue;
+        }
+        const auto& draw = queued.draw;
+        commandBuffer.drawIndexed(draw.indexCount, batch.instanceCount, draw.firstIndex, draw.vertexOffset,
+                                  batch.firstInstance);
+        ++m_stats.drawCount;
+        ++m_stats.callCount;
+        m_stats.instanceCount += batch.instanceCount;
+    }
+}
+
+void RenderQueue::recordIndirect(vk::CommandBuffer commandBuffer, vk::PipelineLayout layout, vk::Buffer buffer,
+                                 vk::DeviceSize countsOffset, bool useCount)
+{
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+    resetRecordStats();
+    BoundState state;
+    for (size_t index = 0; index < m_indirectRuns.size(); ++index)
+    {
+        const IndirectRun& run = m_indirectRuns[index];
+        if (!bindState(commandBuffer, layout, m_draws[m_batches[run.firstBatch].draw], state))
+        {
+            m_stats.skippedCount += run.instanceCount;
+            continue;
+        }
+        const vk::DeviceSize offset = vk::DeviceSize{run.firstBatch} * stride;
+        if (useCount)
+        {
+            commandBuffer.drawIndexedIndirectCount(buffer, offset, buffer, countsOffset + index * sizeof(uint32_t),
+                                                   run.batchCount, stride);
+        }
+        else
+        {
+            commandBuffer.drawIndexedIndirect(buffer, offset, run.batchCount, stride);
+        }
+        m_stats.drawCount += run.batchCount;
+        ++m_stats.callCount;
+        m_stats.instanceCount += run.instanceCount;
+    }
+}
+} // namespace huan::runtime
@@ -0,0 +1,290 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/resource/defragmentation_system.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/resource/memory_telemetry.hpp"
+#include "huan/backend/resource/resource_system.hpp"
+#include "huan/backend/resource/vulkan_allocated.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+// Checking the statistics walks every block, no need to do it every frame
+constexpr uint32_t FragmentationCheckInterval = 240;
+// Not worth moving memory around for less free space than that
+constexpr vk::DeviceSize MinReclaimableBytes = 16ull * 1024 * 1024;
+constexpr uint32_t MaxAllocationsPerPass = 64;
+
+void accumulate(DefragmentationReport& dst, const DefragmentationReport& src)
+{
+    dst.bytesMoved += src.bytesMoved;
+    dst.bytesFreed += src.bytesFreed;
+    dst.allocationsMoved += src.allocationsMoved;
+    dst.deviceMemoryBlocksFreed += src.deviceMemoryBlocksFreed;
+    dst.passCount += src.passCount;
+    dst.frameCount += src.frameCount;
+    dst.milliseconds += src.milliseconds;
+}
+} // namespace
+
+DefragmentationSystem::DefragmentationSystem()
+    : deviceHandle(VulkanContext::getInstance()->device),
+      allocatorHandle(VulkanContext::getInstance()->allocator),
+      m_frameBudgetMs(globalAppSettings.defragmentationFrameBudgetMs),
+      m_triggerRatio(globalAppSettings.defragmentationTriggerRatio)
+{
+}
+
+bool DefragmentationSystem::begin(VmaPool pool)
+{
+    if (m_context != nullptr)
+        return false;
+
+    VmaDefragmentationInfo info{};
+    info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    info.pool = pool;
+    info.maxBytesPerPass = globalAppSettings.defragmentationMaxBytesPerPass;
+    info.maxAllocationsPerPass = MaxAllocationsPerPass;
+    if (vmaBeginDefragmentation(allocatorHandle, &info, &m_context) != VK_SUCCESS)
+    {
+        HUAN_CORE_WARN("[Defragmentation]: Failed to begin a defragmentation")
+        m_context = nullptr;
+        return false;
+    }
+
+    m_currentReport = {};
+    HUAN_CORE_INFO("[Defragmentation]: Started ({})", pool == nullptr ? "default pools" : "custom pool")
+    return true;
+}
+
+void DefragmentationSystem::update(uint32_t frameIndex)
+{
+    if (m_context == nullptr)
+    {
+        if (m_triggerRatio <= 0.0f || frameIndex - m_lastCheckFrame < FragmentationCheckInterval)
+            return;
+        m_lastCheckFrame = frameIndex;
+
+        vk::DeviceSize unusedBytes = 0;
+        if (computeFragmentation(&unusedBytes) < m_triggerRatio || unusedBytes < MinReclaimableBytes)
+            return;
+        if (!begin())
+            return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    double elapsedMs = 0.0;
+    bool done = false;
+    m_isFrameQueueDrained = false;
+    do
+    {
+        done = runPass();
+        elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    while (!done && elapsedMs < m_frameBudgetMs);
+
+    m_currentReport.frameCount++;
+    m_currentReport.milliseconds += elapsedMs;
+    if (done)
+    {
+        end();
+    }
+}
+
+void DefragmentationSystem::finish()
+{
+    if (m_context == nullptr)
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    m_isFrameQueueDrained = false;
+    while (!runPass())
+    {
+    }
+    m_currentReport.frameCount++;
+    m_currentReport.milliseconds +=
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    end();
+}
+
+void DefragmentationSystem::cancel()
+{
+    // Ending between passes is allowed, what has been moved so far stays moved
+    end();
+}
+
+bool DefragmentationSystem::isRunning() const
+{
+    return m_context != nullptr;
+}
+
+DefragmentationSystem::ListenerId DefragmentationSystem::addRelocationListener(RelocationListener listener)
+{
+    const auto id = m_nextListenerId++;
+    m_listeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void DefragmentationSystem::removeRelocationListener(ListenerId id)
+{
+    std::erase_if(m_listeners, [id](const auto& listener) { return listener.first == id; });
+}
+
+bool DefragmentationSystem::hasRelocationListener(ListenerId id) const
+{
+    return std::ranges::any_of(m_listeners, [id](const auto& listener) { return listener.first == id; });
+}
+
+float DefragmentationSystem::computeFragmentation(vk::DeviceSize* unusedBytes) const
+{
+    VmaTotalStatistics statistics{};
+    vmaCalculateStatistics(allocatorHandle, &statistics);
+
+    const auto& total = statistics.total.statistics;
+    const vk::DeviceSize unused = total.blockBytes - total.allocationBytes;
+    if (unusedBytes != nullptr)
+        *unusedBytes = unused;
+    if (total.blockBytes == 0)
+        return 0.0f;
+    return static_cast<float>(static_cast<double>(unused) / static_cast<double>(total.blockBytes));
+}
+
+const DefragmentationReport& DefragmentationSystem::getLastReport() const
+{
+    return m_lastReport;
+}
+
+const DefragmentationReport& DefragmentationSystem::getTotalReport() const
+{
+    return m_totalReport;
+}
+
+void DefragmentationSystem::setFrameBudget(double milliseconds)
+{
+    m_frameBudgetMs = milliseconds;
+}
+
+void DefragmentationSystem::setTriggerRatio(float ratio)
+{
+    m_triggerRatio = ratio;
+}
+
+bool DefragmentationSystem::runPass()
+{
+    VmaDefragmentationPassMoveInfo passInfo{};
+    auto result = vmaBeginDefragmentationPass(allocatorHandle, m_context, &passInfo);
+    if (result == VK_SUCCESS)
+        return true; // Nothing left to move
+    if (result != VK_INCOMPLETE)
+    {
+        HUAN_CORE_ERROR("[Defragmentation]: vmaBeginDefragmentationPass failed: {}", static_cast<int>(result))
+        return true;
+    }
+    m_currentReport.passCount++;
+
+    auto* context = VulkanContext::getInstance();
+    std::vector<vulkan::RelocatableAllocation*> movedResources;
+    movedResources.reserve(passInfo.moveCount);
+    {
+        ScopedCommandBuffer scopedCmd(deviceHandle, context->m_commandPool);
+        for (uint32_t i = 0; i < passInfo.moveCount; ++i)
+        {
+            auto& move = passInfo.pMoves[i];
+            VmaAllocationInfo allocationInfo{};
+            vmaGetAllocationInfo(allocatorHandle, move.srcAllocation, &allocationInfo);
+
+            VmaAllocationInfo destinationInfo{};
+            vmaGetAllocationInfo(allocatorHandle, move.dstTmpAllocation, &destinationInfo);
+
+            auto* resource = static_cast<vulkan::RelocatableAllocation*>(allocationInfo.pUserData);
+            // Nobody would refresh the handles of a resource without a listener, e.g. one removed since. Both copies
+            // live until the pass ends, which a heap close to its budget can't afford.
+            if (resource == nullptr || !hasRelocationListener(resource->getRelocationListener()) ||
+                !MemoryTelemetry::getInstance()->isMemoryTypeWithinBudget(destinationInfo.memoryType,
+                                                                          allocationInfo.size) ||
+                !resource->beginRelocation(scopedCmd.get(), move.dstTmpAllocation))
+            {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+            movedResources.push_back(resource);
+        }
+        if (!movedResources.empty())
+        {
+            waitForFramesInFlight();
+            // Only the copies of this pass, the frames are already done
+            scopedCmd.submitAndWaitFence(context->graphicsQueue);
+        }
+    }
+
+    for (auto* resource : movedResources)
+    {
+        resource->commitRelocation();
+    }
+    result = vmaEndDefragmentationPass(allocatorHandle, m_context, &passInfo);
+    for (auto* resource : movedResources)
+    {
+        resource->onRelocated();
+        notifyRelocated(*resource);
+    }
+
+    return result == VK_SUCCESS;
+}
+
+void DefragmentationSystem::waitForFramesInFlight()
+{
+    if (m_isFrameQueueDrained)
+        return;
+    // The old memory may still be used by the frames in flight. Their fences are all waitable here, the one of the
+    // frame about to be recorded is only reset after update()
+    std::vector<vk::Fence> fences;
+    for (const auto& frame : VulkanContext::getInstance()->m_frameDatas)
+    {
+        fences.push_back(frame.m_fence);
+    }
+    if (!fences.empty() && deviceHandle.waitForFences(fences, true, UINT64_MAX) != vk::Result::eSuccess)
+        HUAN_CORE_ERROR("[Defragmentation]: Failed to wait for the frames in flight")
+    m_isFrameQueueDrained = true;
+}
+
+void DefragmentationSystem::end()
+{
+    if (m_context == nullptr)
+        return;
+
+    VmaDefragmentationStats stats{};
+    vmaEndDefragmentation(allocatorHandle, m_context, &stats);
+    m_context = nullptr;
+
+    m_currentReport.bytesMoved = stats.bytesMoved;
+    m_currentReport.bytesFreed = stats.bytesFreed;
+    m_currentReport.allocationsMoved = stats.allocationsMoved;
+    m_currentReport.deviceMemoryBlocksFreed = stats.deviceMemoryBlocksFreed;
+    m_lastReport = m_currentReport;
+    accumulate(m_totalReport, m_currentReport);
+    m_currentReport = {};
+
+    HUAN_CORE_INFO("[Defragmentation]: Done, moved {} allocations ({} bytes), reclaimed {} bytes in {} blocks; "
+                   "{} passes over {} frames, {:.2f} ms",
+                   m_lastReport.allocationsMoved, m_lastReport.bytesMoved, m_lastReport.bytesFreed,
+                   m_lastReport.deviceMemoryBlocksFreed, m_lastReport.passCount, m_lastReport.frameCount,
+                   m_lastReport.milliseconds)
+}
+
+void DefragmentationSystem::notifyRelocated(vulkan::RelocatableAllocation& resource)
+{
+    for (auto& [id, listener] : m_listeners)
+    {
+        if (id == resource.getRelocationListener())
+            listener(resource);
+    }
+}
+} // namespace huan::runtime
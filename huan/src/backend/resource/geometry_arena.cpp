@@ -0,0 +1,275 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/resource/geometry_arena.hpp"
+
+#include <vector>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/backend/resource/memory_telemetry.hpp"
+#include "huan/backend/resource/resource_registry.hpp"
+#include "huan/backend/resource/resource_system.hpp"
+#include "huan/backend/resource/vulkan_buffer.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+// What the buffers end up with, TransferSrc because they are relocatable
+constexpr vk::BufferUsageFlags ArenaBufferUsage = vk::BufferUsageFlagBits::eVertexBuffer |
+                                                  vk::BufferUsageFlagBits::eIndexBuffer |
+                                                  vk::BufferUsageFlagBits::eTransferDst |
+                                                  vk::BufferUsageFlagBits::eTransferSrc;
+}
+
+GeometryArena::GeometryArena()
+    : deviceHandle(VulkanContext::getInstance()->device),
+      allocatorHandle(VulkanContext::getInstance()->allocator),
+      m_vertexAllocator(globalAppSettings.geometryArenaVertexBytes),
+      m_indexAllocator(globalAppSettings.geometryArenaIndexBytes)
+{
+    const vk::DeviceSize vertexBytes = globalAppSettings.geometryArenaVertexBytes;
+    const vk::DeviceSize indexBytes = globalAppSettings.geometryArenaIndexBytes;
+    // bind() looks the handles up every time, nothing else to refresh once the DefragmentationSystem moved them
+    m_relocationListener =
+        DefragmentationSystem::getInstance()->addRelocationListener([](vulkan::RelocatableAllocation&) {});
+
+    // Find the memory type for device local geometry buffers, then give it a pool of its own so geometry
+    // doesn't fragment the default blocks and can be defragmented on its own.
+    const vk::BufferCreateInfo sampleBufferInfo{{}, vertexBytes, ArenaBufferUsage};
+    VmaAllocationCreateInfo sampleAllocationInfo{};
+    sampleAllocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    uint32_t memoryTypeIndex = 0;
+    auto result = vmaFindMemoryTypeIndexForBufferInfo(
+        allocatorHandle, reinterpret_cast<const VkBufferCreateInfo*>(&sampleBufferInfo), &sampleAllocationInfo,
+        &memoryTypeIndex);
+    HUAN_CORE_ASSERT(result == VK_SUCCESS, "Failed to find a memory type for the geometry arena")
+
+    VmaPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.memoryTypeIndex = memoryTypeIndex;
+    // Both buffers fit in a single block, reserved up front
+    poolCreateInfo.blockSize = vertexBytes + indexBytes;
+    poolCreateInfo.minBlockCount = 1;
+    if (!MemoryTelemetry::getInstance()->isMemoryTypeWithinBudget(memoryTypeIndex, poolCreateInfo.blockSize))
+    {
+        // Not reserved then, the buffers below allocate the block within the budget or fail
+        HUAN_CORE_WARN("GeometryArena: {} bytes don't fit in the memory budget, the block isn't reserved up front",
+                       poolCreateInfo.blockSize)
+        poolCreateInfo.minBlockCount = 0;
+    }
+    result = vmaCreatePool(allocatorHandle, &poolCreateInfo, &m_pool);
+    if (result != VK_SUCCESS)
+    {
+        HUAN_CORE_BREAK("Failed to create the geometry arena pool!")
+    }
+    vmaSetPoolName(allocatorHandle, m_pool, "GeometryArena");
+
+    vulkan::BufferBuilder vertexBuilder(allocatorHandle, vertexBytes);
+    vertexBuilder.setVmaPool(m_pool)
+                 .setVmaUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                 .setUsage(vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst)
+                 .setRelocationListener(m_relocationListener)
+                 .setAllocationCategory(AllocationCategory::Vertex)
+                 .setDebugName("GeometryArena.Vertex");
+    m_vertexBuffer = ResourceRegistry::getInstance()->add(vertexBuilder.build(deviceHandle));
+
+    vulkan::BufferBuilder indexBuilder(allocatorHandle, indexBytes);
+    indexBuilder.setVmaPool(m_pool)
+                .setVmaUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                .setUsage(vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst)
+                .setRelocationListener(m_relocationListener)
+                .setAllocationCategory(AllocationCategory::Index)
+                .setDebugName("GeometryArena.Index");
+    m_indexBuffer = ResourceRegistry::getInstance()->add(indexBuilder.build(deviceHandle));
+
+    HUAN_CORE_INFO("GeometryArena created: {} bytes of vertices, {} bytes of indices.", vertexBytes, indexBytes)
+}
+
+GeometryAllocation GeometryArena::allocateVertices(uint32_t vertexCount, uint32_t stride, const void* data)
+{
+    GeometryAllocation allocation;
+    {
+        std::lock_guard lock(m_mutex);
+        allocation = allocate(m_vertexAllocator, uint64_t{vertexCount} * stride, stride);
+        if (allocation.isValid())
+            m_vertexAllocationCount++;
+    }
+    if (!allocation.isValid())
+    {
+        HUAN_CORE_ERROR("[GeometryArena]: Out of vertex memory, {} vertices of {} bytes requested", vertexCount,
+                        stride)
+        return allocation;
+    }
+    if (data != nullptr)
+    {
+        uploadVertices(allocation, data);
+    }
+    return allocation;
+}
+
+GeometryAllocation GeometryArena::allocateIndices(uint32_t indexCount, const uint32_t* data)
+{
+    GeometryAllocation allocation;
+    {
+        std::lock_guard lock(m_mutex);
+        allocation = allocate(m_indexAllocator, uint64_t{indexCount} * sizeof(uint32_t), sizeof(uint32_t));
+        if (allocation.isValid())
+            m_indexAllocationCount++;
+    }
+    if (!allocation.isValid())
+    {
+        HUAN_CORE_ERROR("[GeometryArena]: Out of index memory, {} indices requested", indexCount)
+        return allocation;
+    }
+    if (data != nullptr)
+    {
+        uploadIndices(allocation, data);
+    }
+    return allocation;
+}
+
+GeometryAllocation GeometryArena::allocateIndices(uint32_t indexCount, const uint16_t* data)
+{
+    if (data == nullptr)
+        return allocateIndices(indexCount, static_cast<const uint32_t*>(nullptr));
+
+    const std::vector<uint32_t> widened(data, data + indexCount);
+    return allocateIndices(indexCount, widened.data());
+}
+
+void GeometryArena::freeVertices(GeometryAllocation& allocation)
+{
+    if (!allocation.isValid())
+        return;
+    std::lock_guard lock(m_mutex);
+    if (allocation.generation != m_generation)
+    {
+        allocation = {};
+        return;
+    }
+    m_vertexAllocator.free(allocation.allocation);
+    m_vertexAllocationCount--;
+    allocation = {};
+}
+
+void GeometryArena::freeIndices(GeometryAllocation& allocation)
+{
+    if (!allocation.isValid())
+        return;
+    std::lock_guard lock(m_mutex);
+    if (allocation.generation != m_generation)
+    {
+        allocation = {};
+        return;
+    }
+    m_indexAllocator.free(allocation.allocation);
+    m_indexAllocationCount--;
+    allocation = {};
+}
+
+void GeometryArena::uploadVertices(const GeometryAllocation& allocation, const void* data)
+{
+    ResourceSystem::getInstance()->uploadBuffer(getVertexBuffer(), data, allocation.size, allocation.offset);
+}
+
+void GeometryArena::uploadIndices(const GeometryAllocation& allocation, const uint32_t* data)
+{
+    ResourceSystem::getInstance()->uploadBuffer(getIndexBuffer(), data, allocation.size, allocation.offset);
+}
+
+void GeometryArena::bind(vk::CommandBuffer commandBuffer, uint32_t binding) const
+{
+    const vk::DeviceSize offset = 0;
+    commandBuffer.bindVertexBuffers(binding, 1, &getVertexBuffer().getHandle(), &offset);
+    commandBuffer.bindIndexBuffer(getIndexBuffer().getHandle(), 0, IndexType);
+}
+
+const vulkan::Buffer& GeometryArena::getVertexBuffer() const
+{
+    return *ResourceRegistry::getInstance()->get(m_vertexBuffer);
+}
+
+const vulkan::Buffer& GeometryArena::getIndexBuffer() const
+{
+    return *ResourceRegistry::getInstance()->get(m_indexBuffer);
+}
+
+BufferHandle GeometryArena::getVertexBufferHandle() const
+{
+    return m_vertexBuffer;
+}
+
+BufferHandle GeometryArena::getIndexBufferHandle() const
+{
+    return m_indexBuffer;
+}
+
+VmaPool GeometryArena::getPool() const
+{
+    return m_pool;
+}
+
+GeometryArena::Stats GeometryArena::getStats() const
+{
+    std::lock_guard lock(m_mutex);
+    const auto vertexReport = m_vertexAllocator.getStorageReport();
+    const auto indexReport = m_indexAllocator.getStorageReport();
+
+    Stats stats{};
+    stats.vertexCapacity = m_vertexAllocator.getSize();
+    stats.vertexFree = vertexReport.totalFreeSpace;
+    stats.vertexLargestFreeRegion = vertexReport.largestFreeRegion;
+    stats.indexCapacity = m_indexAllocator.getSize();
+    stats.indexFree = indexReport.totalFreeSpace;
+    stats.indexLargestFreeRegion = indexReport.largestFreeRegion;
+    stats.vertexAllocationCount = m_vertexAllocationCount;
+    stats.indexAllocationCount = m_indexAllocationCount;
+    return stats;
+}
+
+void GeometryArena::destroy()
+{
+    std::lock_guard lock(m_mutex);
+    ResourceRegistry::getInstance()->destroy(m_vertexBuffer);
+    ResourceRegistry::getInstance()->destroy(m_indexBuffer);
+    DefragmentationSystem::getInstance()->removeRelocationListener(m_relocationListener);
+    m_relocationListener = DefragmentationSystem::NoListener;
+    if (m_pool != nullptr)
+    {
+        vmaDestroyPool(allocatorHandle, m_pool);
+        m_pool = nullptr;
+    }
+    m_vertexAllocator.reset();
+    m_indexAllocator.reset();
+    m_vertexAllocationCount = 0;
+    m_indexAllocationCount = 0;
+    m_generation++;
+}
+
+GeometryAllocation GeometryArena::allocate(utils::OffsetAllocator& allocator, uint64_t size, uint32_t stride)
+{
+    if (size == 0 || stride == 0 || m_pool == nullptr)
+        return {};
+
+    // The offset has to be a multiple of the stride to be addressable through vertexOffset / firstIndex.
+    // Ranges of other strides share the allocator, so over-allocate by (stride - 1) and round the offset up.
+    const uint64_t reserved = size + stride - 1;
+    // Offsets are 32 bits, larger requests can't fit whatever the arena size
+    if (reserved >= utils::OffsetAllocator::NoSpace)
+        return {};
+    const auto allocation = allocator.allocate(static_cast<uint32_t>(reserved));
+    if (!allocation.isValid())
+        return {};
+
+    GeometryAllocation result;
+    result.offset = (allocation.offset + stride - 1) / stride * stride;
+    result.size = static_cast<uint32_t>(size);
+    result.stride = stride;
+    result.allocation = allocation;
+    result.generation = m_generation;
+    return result;
+}
+
+} // namespace huan::runtime
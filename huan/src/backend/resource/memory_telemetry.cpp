@@ -0,0 +1,349 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/resource/memory_telemetry.hpp"
+
+#include <sstream>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+void appendJsonString(std::ostringstream& out, std::string_view str)
+{
+    out << '"';
+    for (const char c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out << ' ';
+            else
+                out << c;
+        }
+    }
+    out << '"';
+}
+
+constexpr size_t categoryIndex(AllocationCategory category)
+{
+    return static_cast<size_t>(category);
+}
+} // namespace
+
+const char* toString(AllocationCategory category)
+{
+    switch (category)
+    {
+    case AllocationCategory::Vertex:
+        return "vertex";
+    case AllocationCategory::Index:
+        return "index";
+    case AllocationCategory::Texture:
+        return "texture";
+    case AllocationCategory::Staging:
+        return "staging";
+    case AllocationCategory::Uniform:
+        return "uniform";
+    case AllocationCategory::Storage:
+        return "storage";
+    case AllocationCategory::Attachment:
+        return "attachment";
+    default:
+        return "unknown";
+    }
+}
+
+AllocationCategory deduceAllocationCategory(vk::BufferUsageFlags usage)
+{
+    // Order matters: a staging buffer for a uniform still counts as uniform memory, since that's how it is used.
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+        return AllocationCategory::Uniform;
+    if (usage & vk::BufferUsageFlagBits::eIndexBuffer)
+        return AllocationCategory::Index;
+    if (usage & vk::BufferUsageFlagBits::eVertexBuffer)
+        return AllocationCategory::Vertex;
+    if (usage & vk::BufferUsageFlagBits::eStorageBuffer)
+        return AllocationCategory::Storage;
+    if (usage & vk::BufferUsageFlagBits::eTransferSrc)
+        return AllocationCategory::Staging;
+    return AllocationCategory::Unknown;
+}
+
+AllocationCategory deduceAllocationCategory(vk::ImageUsageFlags usage)
+{
+    if (usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                 vk::ImageUsageFlagBits::eInputAttachment | vk::ImageUsageFlagBits::eTransientAttachment))
+        return AllocationCategory::Attachment;
+    if (usage & (vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage))
+        return AllocationCategory::Texture;
+    return AllocationCategory::Unknown;
+}
+
+MemoryTelemetry::MemoryTelemetry()
+    : allocatorHandle(VulkanContext::getInstance()->allocator),
+      m_warningRatio(globalAppSettings.memoryBudgetWarningRatio)
+{
+}
+
+void MemoryTelemetry::registerAllocation(VmaAllocator allocator, VmaAllocation allocation,
+                                         AllocationCategory category, std::string_view debugName)
+{
+    if (allocation == nullptr)
+        return;
+
+    VmaAllocationInfo allocationInfo{};
+    vmaGetAllocationInfo(allocator, allocation, &allocationInfo);
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    AllocationRecord record{};
+    record.category = category;
+    record.memoryType = allocationInfo.memoryType;
+    record.heapIndex = memoryProperties->memoryTypes[allocationInfo.memoryType].heapIndex;
+    record.size = allocationInfo.size;
+    record.name = debugName;
+
+    if (!debugName.empty())
+    {
+        // VMA keeps its own copy, so the name also shows up in vmaBuildStatsString
+        vmaSetAllocationName(allocator, allocation, record.name.c_str());
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_categoryBytes[categoryIndex(category)] += record.size;
+    m_categoryCounts[categoryIndex(category)]++;
+    if (record.heapIndex < m_pendingHeapBytes.size())
+    {
+        m_pendingHeapBytes[record.heapIndex] += record.size;
+        checkHeap(record.heapIndex);
+    }
+    m_records.insert_or_assign(allocation, std::move(record));
+}
+
+void MemoryTelemetry::unregisterAllocation(VmaAllocation allocation)
+{
+    std::lock_guard lock(m_mutex);
+    const auto it = m_records.find(allocation);
+    if (it == m_records.end())
+        return;
+
+    const auto& record = it->second;
+    m_categoryBytes[categoryIndex(record.category)] -= record.size;
+    m_categoryCounts[categoryIndex(record.category)]--;
+    if (record.heapIndex < m_pendingHeapBytes.size())
+    {
+        auto& pending = m_pendingHeapBytes[record.heapIndex];
+        pending = pending > record.size ? pending - record.size : 0;
+    }
+    m_records.erase(it);
+}
+
+void MemoryTelemetry::update(uint32_t frameIndex)
+{
+    vmaSetCurrentFrameIndex(allocatorHandle, frameIndex);
+
+    std::lock_guard lock(m_mutex);
+    refreshHeapBudgets();
+    for (uint32_t heapIndex = 0; heapIndex < m_heapBudgets.size(); ++heapIndex)
+    {
+        checkHeap(heapIndex);
+    }
+}
+
+bool MemoryTelemetry::isWithinBudget(uint32_t heapIndex, vk::DeviceSize size) const
+{
+    std::lock_guard lock(m_mutex);
+    if (heapIndex >= m_heapBudgets.size())
+        return true;
+
+    const auto& heap = m_heapBudgets[heapIndex];
+    const auto expected = heap.usage + m_pendingHeapBytes[heapIndex] + size;
+    return static_cast<double>(expected) <= static_cast<double>(heap.budget) * m_warningRatio;
+}
+
+bool MemoryTelemetry::isMemoryTypeWithinBudget(uint32_t memoryType, vk::DeviceSize size) const
+{
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(allocatorHandle, &memoryProperties);
+    if (memoryType >= memoryProperties->memoryTypeCount)
+        return true;
+    return isWithinBudget(memoryProperties->memoryTypes[memoryType].heapIndex, size);
+}
+
+std::vector<HeapBudget> MemoryTelemetry::getHeapBudgets() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_heapBudgets;
+}
+
+vk::DeviceSize MemoryTelemetry::getCategoryBytes(AllocationCategory category) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_categoryBytes[categoryIndex(category)];
+}
+
+uint32_t MemoryTelemetry::getCategoryCount(AllocationCategory category) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_categoryCounts[categoryIndex(category)];
+}
+
+size_t MemoryTelemetry::getAllocationCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_records.size();
+}
+
+void MemoryTelemetry::setWarningRatio(float ratio)
+{
+    std::lock_guard lock(m_mutex);
+    m_warningRatio = ratio;
+}
+
+float MemoryTelemetry::getWarningRatio() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_warningRatio;
+}
+
+std::string MemoryTelemetry::dumpJson(bool detailed) const
+{
+    std::lock_guard lock(m_mutex);
+    std::ostringstream out;
+
+    out << "{\"heaps\":[";
+    for (size_t i = 0; i < m_heapBudgets.size(); ++i)
+    {
+        const auto& heap = m_heapBudgets[i];
+        out << (i == 0 ? "" : ",") << "{\"index\":" << i
+            << ",\"deviceLocal\":" << ((heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) ? "true" : "false")
+            << ",\"size\":" << heap.size << ",\"budget\":" << heap.budget << ",\"usage\":" << heap.usage
+            << ",\"blockBytes\":" << heap.blockBytes << ",\"allocationBytes\":" << heap.allocationBytes
+            << ",\"allocationCount\":" << heap.allocationCount << "}";
+    }
+    out << "],\"categories\":{";
+    for (size_t i = 0; i < m_categoryBytes.size(); ++i)
+    {
+        out << (i == 0 ? "" : ",");
+        appendJsonString(out, toString(static_cast<AllocationCategory>(i)));
+        out << ":{\"bytes\":" << m_categoryBytes[i] << ",\"count\":" << m_categoryCounts[i] << "}";
+    }
+    out << "},\"allocationCount\":" << m_records.size();
+
+    if (detailed)
+    {
+        out << ",\"allocations\":[";
+        bool first = true;
+        for (const auto& [allocation, record] : m_records)
+        {
+            out << (first ? "" : ",") << "{\"name\":";
+            appendJsonString(out, record.name);
+            out << ",\"category\":";
+            appendJsonString(out, toString(record.category));
+            out << ",\"size\":" << record.size << ",\"memoryType\":" << record.memoryType
+                << ",\"heap\":" << record.heapIndex << "}";
+            first = false;
+        }
+        out << "]";
+
+        char* vmaStats = nullptr;
+        vmaBuildStatsString(allocatorHandle, &vmaStats, VK_TRUE);
+        if (vmaStats != nullptr)
+        {
+            // Already a JSON document
+            out << ",\"vma\":" << vmaStats;
+            vmaFreeStatsString(allocatorHandle, vmaStats);
+        }
+    }
+    out << "}";
+    return out.str();
+}
+
+void MemoryTelemetry::reportLeaks() const
+{
+    std::lock_guard lock(m_mutex);
+    for (const auto& [allocation, record] : m_records)
+    {
+        HUAN_CORE_WARN("[MemoryTelemetry]: Leaked {} allocation [{}] of {} bytes", toString(record.category),
+                       record.name.empty() ? "unnamed" : record.name, record.size)
+    }
+}
+
+void MemoryTelemetry::refreshHeapBudgets()
+{
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(allocatorHandle, &memoryProperties);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(allocatorHandle, budgets.data());
+
+    const uint32_t heapCount = memoryProperties->memoryHeapCount;
+    m_heapBudgets.resize(heapCount);
+    m_pendingHeapBytes.assign(heapCount, 0);
+    m_heapWarned.resize(heapCount, false);
+    for (uint32_t i = 0; i < heapCount; ++i)
+    {
+        auto& heap = m_heapBudgets[i];
+        heap.flags = static_cast<vk::MemoryHeapFlags>(memoryProperties->memoryHeaps[i].flags);
+        heap.size = memoryProperties->memoryHeaps[i].size;
+        heap.budget = budgets[i].budget;
+        heap.usage = budgets[i].usage;
+        heap.blockBytes = budgets[i].statistics.blockBytes;
+        heap.allocationBytes = budgets[i].statistics.allocationBytes;
+        heap.allocationCount = budgets[i].statistics.allocationCount;
+    }
+}
+
+void MemoryTelemetry::checkHeap(uint32_t heapIndex)
+{
+    if (heapIndex >= m_heapBudgets.size())
+        return;
+
+    const auto& heap = m_heapBudgets[heapIndex];
+    if (heap.budget == 0)
+        return;
+
+    const double usage = static_cast<double>(heap.usage + m_pendingHeapBytes[heapIndex]);
+    const double ratio = usage / static_cast<double>(heap.budget);
+    if (ratio >= m_warningRatio)
+    {
+        if (!m_heapWarned[heapIndex])
+        {
+            m_heapWarned[heapIndex] = true;
+            if (ratio >= 1.0)
+            {
+                HUAN_CORE_ERROR("[MemoryTelemetry]: Heap {} is over budget: {} / {} bytes", heapIndex,
+                                static_cast<vk::DeviceSize>(usage), heap.budget)
+            }
+            else
+            {
+                HUAN_CORE_WARN("[MemoryTelemetry]: Heap {} is close to its budget ({:.1f}%): {} / {} bytes",
+                               heapIndex, ratio * 100.0, static_cast<vk::DeviceSize>(usage), heap.budget)
+            }
+        }
+    }
+    else if (ratio < m_warningRatio * 0.95)
+    {
+        // A bit of hysteresis, so streaming around the threshold doesn't flood the log
+        m_heapWarned[heapIndex] = false;
+    }
+}
+} // namespace huan::runtime
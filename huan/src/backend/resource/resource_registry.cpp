@@ -0,0 +1,72 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/resource/resource_registry.hpp"
+
+#include <algorithm>
+
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+
+namespace huan::runtime
+{
+ImageViewHandle ResourceRegistry::createImageView(ImageHandle image, vk::ImageViewType viewType, vk::Format format,
+                                                  uint32_t mipLevels)
+{
+    auto* imagePtr = get(image);
+    if (imagePtr == nullptr)
+    {
+        HUAN_CORE_ERROR("[ResourceRegistry]: Creating a view of a stale image handle")
+        return {};
+    }
+    return emplace<vulkan::ImageView>(*imagePtr, viewType, format, 0, 0, mipLevels);
+}
+
+void ResourceRegistry::update(uint32_t frameNumber)
+{
+    m_frameNumber = frameNumber;
+    const uint32_t latency = static_cast<uint32_t>(globalAppSettings.maxFramesInFlight);
+
+    // Take the due ones out first, a destruction may defer others
+    std::vector<PendingDestruction> due;
+    auto firstKept = std::stable_partition(m_pendingDestructions.begin(), m_pendingDestructions.end(),
+                                           [&](const PendingDestruction& pending) {
+                                               return pending.frameNumber + latency <= frameNumber;
+                                           });
+    std::move(m_pendingDestructions.begin(), firstKept, std::back_inserter(due));
+    m_pendingDestructions.erase(m_pendingDestructions.begin(), firstKept);
+    for (auto& pending : due)
+    {
+        pending.destroy();
+    }
+}
+
+void ResourceRegistry::clear()
+{
+    for (auto& pending : m_pendingDestructions)
+    {
+        pending.destroy();
+    }
+    m_pendingDestructions.clear();
+
+    // Views before the images they look at
+    storage<vulkan::ImageView>().clear();
+    storage<vulkan::Image>().clear();
+    storage<vulkan::Sampler>().clear();
+    storage<vulkan::Buffer>().clear();
+}
+
+void ResourceRegistry::destroyViewsOf(vulkan::Image& image)
+{
+    auto& views = storage<vulkan::ImageView>();
+    while (!image.getViews().empty())
+    {
+        auto* view = *image.getViews().begin();
+        // A view not owned by the registry only gets unlinked, its owner destroys it
+        if (!views.erase(views.handleOf(view)))
+        {
+            image.getViews().erase(view);
+        }
+    }
+}
+} // namespace huan::runtime
@@ -5,6 +5,7 @@
 
 #include "huan/VulkanContext.hpp"
 #include "huan/backend/vulkan_command.hpp"
+#include "huan/backend/resource/resource_registry.hpp"
 #include "huan/backend/resource/vulkan_image_view.hpp"
 #include "huan/log/Log.hpp"
 
@@ -13,11 +14,17 @@ namespace huan::runtime
 
 Scope<vulkan::Buffer> ResourceSystem::createStagingBuffer(vk::BufferUsageFlags usage,
                                                           vk::DeviceSize size,
-                                                          const void* srcData)
+                                                          const void* srcData,
+                                                          const std::string& debugName)
 {
+    // Host visible uniform buffers are created through here as well, count them as uniform memory
+    const auto category = (usage & vk::BufferUsageFlagBits::eUniformBuffer) ? AllocationCategory::Uniform
+                                                                            : AllocationCategory::Staging;
     vulkan::BufferBuilder builder(allocatorHandle, size);
     builder.setVmaFlags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
-           .setUsage(vk::BufferUsageFlagBits::eTransferSrc | usage);
+           .setUsage(vk::BufferUsageFlagBits::eTransferSrc | usage)
+           .setAllocationCategory(category)
+           .setDebugName(debugName);
     auto res = builder.buildScope(deviceHandle);
     if (srcData != nullptr)
     {
@@ -27,66 +34,147 @@ Scope<vulkan::Buffer> ResourceSystem::createStagingBuffer(vk::BufferUsageFlags u
     return res;
 }
 
-Scope<vulkan::Buffer> ResourceSystem::createDeviceLocalBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
-                                                              void* srcData)
+BufferHandle ResourceSystem::createUniformBuffer(vk::DeviceSize size, const std::string& debugName)
+{
+    vulkan::BufferBuilder builder(allocatorHandle, size);
+    builder.setVmaFlags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
+           .setUsage(vk::BufferUsageFlagBits::eUniformBuffer)
+           .setAllocationCategory(AllocationCategory::Uniform)
+           .setDebugName(debugName);
+    return ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
+}
+
+BufferHandle ResourceSystem::createReadbackBuffer(vk::DeviceSize size, const std::string& debugName)
+{
+    vulkan::BufferBuilder builder(allocatorHandle, size);
+    // Random access picks cached memory, reading uncached memory is very slow
+    builder.setVmaFlags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)
+           .setUsage(vk::BufferUsageFlagBits::eTransferDst)
+           .setAllocationCategory(AllocationCategory::Staging)
+           .setDebugName(debugName);
+    return ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
+}
+
+BufferHandle ResourceSystem::createDeviceLocalBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
+                                                     void* srcData, const std::string& debugName,
+                                                     DefragmentationSystem::ListenerId relocationListener)
 {
     // 创建 device local buffer
     vulkan::BufferBuilder builder(allocatorHandle, size);
     builder.setVmaUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
-           .setUsage(usage | vk::BufferUsageFlagBits::eTransferDst);
+           .setUsage(usage | vk::BufferUsageFlagBits::eTransferDst)
+           .setRelocationListener(relocationListener)
+           .setDebugName(debugName);
 
-    auto deviceBuffer = builder.buildScope(deviceHandle);
+    const auto handle = ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
 
     // 如果有源数据，通过 staging buffer 传输
     if (srcData != nullptr)
     {
-        executeImmediateTransfer([&](vk::CommandBuffer cmd) {
-            // 创建临时 staging buffer
-            auto stagingBuffer = createStagingBuffer(usage, size, srcData);
-
-            // 记录复制命令
-            vk::BufferCopy copyRegion{};
-            copyRegion.size = size;
-            cmd.copyBuffer(stagingBuffer->getHandle(), deviceBuffer->getHandle(), copyRegion);
-            m_deletingBufferQueue.emplace(std::move(stagingBuffer));
-        });
+        uploadBuffer(*ResourceRegistry::getInstance()->get(handle), srcData, size);
     }
-    return deviceBuffer;
+    return handle;
 }
 
-Scope<vulkan::Buffer> ResourceSystem::createDeviceDedicateBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
-                                                                 void* srcData)
+BufferHandle ResourceSystem::createDeviceDedicateBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
+                                                        void* srcData, const std::string& debugName)
 {
     // 创建 device local buffer
     vulkan::BufferBuilder builder(allocatorHandle, size);
     builder.setVmaFlags(VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT)
            .setVmaUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
-           .setUsage(usage | vk::BufferUsageFlagBits::eTransferDst);
+           .setUsage(usage | vk::BufferUsageFlagBits::eTransferDst)
+           .setDebugName(debugName);
 
-    auto deviceBuffer = builder.buildScope(deviceHandle);
+    const auto handle = ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
 
     // 如果有源数据，通过 staging buffer 传输
     if (srcData != nullptr)
     {
-        executeImmediateTransfer([&](vk::CommandBuffer cmd) {
-            // 创建临时 staging buffer
-            auto stagingBuffer = createStagingBuffer(usage, size, srcData);
-
-            // 记录复制命令
-            vk::BufferCopy copyRegion{};
-            copyRegion.size = size;
-            cmd.copyBuffer(stagingBuffer->getHandle(), deviceBuffer->getHandle(), copyRegion);
-            m_deletingBufferQueue.emplace(std::move(stagingBuffer));
-        });
+        uploadBuffer(*ResourceRegistry::getInstance()->get(handle), srcData, size);
+    }
+    return handle;
+}
+
+BufferHandle ResourceSystem::createDynamicBuffer(vk::BufferUsageFlags usage, vk::DeviceSize size,
+                                                 const void* srcData, const std::string& debugName,
+                                                 DefragmentationSystem::ListenerId relocationListener)
+{
+    vulkan::BufferBuilder builder(allocatorHandle, size);
+    // TransferDst for the staging fallback
+    // VMA picks a HOST_VISIBLE | DEVICE_LOCAL type if one has room left, else host memory the GPU reads over PCIe,
+    // which beats a staging copy for data written once per frame. It may still prefer a device local type the host
+    // can't map (ALLOW_TRANSFER_INSTEAD), writeBuffer() then stages.
+    builder.setUsage(usage | vk::BufferUsageFlagBits::eTransferDst)
+           .setVmaFlags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                        VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT)
+           .setRelocationListener(relocationListener)
+           .setDebugName(debugName);
+
+    const auto handle = ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
+    if (srcData != nullptr)
+    {
+        writeBuffer(*ResourceRegistry::getInstance()->get(handle), srcData, size);
     }
-    return deviceBuffer;
+    return handle;
+}
+
+bool ResourceSystem::writeBuffer(vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size,
+                                 vk::DeviceSize dstOffset)
+{
+    if (dst.mapped())
+    {
+        dst.updateDirectly(srcData, size, dstOffset);
+        m_uploadStats.directBytes += size;
+        return true;
+    }
+    uploadBuffer(dst, srcData, size, dstOffset);
+    return false;
+}
+
+bool ResourceSystem::writeBuffer(vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size,
+                                 vk::DeviceSize dstOffset, vk::CommandBuffer commandBuffer, StagingRing& stagingRing)
+{
+    if (dst.mapped())
+    {
+        dst.updateDirectly(srcData, size, dstOffset);
+        m_uploadStats.directBytes += size;
+        return true;
+    }
+    stagingRing.write(commandBuffer, dst, srcData, size, dstOffset);
+    m_uploadStats.recordedBytes += size;
+    return false;
+}
+
+const ResourceSystem::UploadStats& ResourceSystem::getUploadStats() const
+{
+    return m_uploadStats;
+}
+
+void ResourceSystem::uploadBuffer(const vulkan::Buffer& dst, const void* srcData, vk::DeviceSize size,
+                                  vk::DeviceSize dstOffset)
+{
+    executeImmediateTransfer([&](vk::CommandBuffer cmd) {
+        // 创建临时 staging buffer
+        auto stagingBuffer = createStagingBuffer(vk::BufferUsageFlagBits::eTransferSrc, size, srcData);
+
+        // 记录复制命令
+        vk::BufferCopy copyRegion{};
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        cmd.copyBuffer(stagingBuffer->getHandle(), dst.getHandle(), copyRegion);
+        m_deletingBufferQueue.emplace(std::move(stagingBuffer));
+    });
+    m_uploadStats.immediateBytes += size;
+    m_uploadStats.immediateSubmitCount++;
 }
 
-Scope<vulkan::Image> ResourceSystem::createImage(vk::ImageType imageType, const vk::Extent3D& extent,
-                                                 uint32_t mipLevels,
-                                                 vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage,
-                                                 vk::MemoryPropertyFlags properties,
-                                                 void* data)
+ImageHandle ResourceSystem::createImage(vk::ImageType imageType, const vk::Extent3D& extent,
+                                        uint32_t mipLevels,
+                                        vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage,
+                                        vk::MemoryPropertyFlags properties,
+                                        void* data, const std::string& debugName,
+                                        DefragmentationSystem::ListenerId relocationListener)
 {
     vulkan::ImageBuilder builder(allocatorHandle, extent);
     builder.setImageType(imageType)
@@ -94,9 +182,12 @@ Scope<vulkan::Image> ResourceSystem::createImage(vk::ImageType imageType, const
            .setFormat(format)
            .setTiling(tiling)
            .setUsage(usage)
-           .setVmaPreferredFlags(properties);
+           .setVmaPreferredFlags(properties)
+           .setRelocationListener(relocationListener)
+           .setDebugName(debugName);
 
-    auto image = builder.buildUnique(deviceHandle);
+    const auto handle = ResourceRegistry::getInstance()->add(builder.build(deviceHandle));
+    auto* image = ResourceRegistry::getInstance()->get(handle);
     vk::MemoryRequirements memoryRequirements{};
     deviceHandle.getImageMemoryRequirements(image->getHandle(), &memoryRequirements);
 
@@ -108,10 +199,11 @@ Scope<vulkan::Image> ResourceSystem::createImage(vk::ImageType imageType, const
         copyBufferToImage(stagingBuffer->getHandle(), image->getHandle(), extent);
         transitionImageLayout(image->getHandle(), format, vk::ImageLayout::eTransferDstOptimal,
                               vk::ImageLayout::eShaderReadOnlyOptimal);
+        image->setLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
         stagingBuffer.reset();
     }
 
-    return image;
+    return handle;
 }
 
 
@@ -194,11 +286,11 @@ uint32_t ResourceSystem::findRequiredMemoryTypeIndex(uint32_t typeFilter, vk::Me
  * @param format 
  * @param mipLevels 生成的MipLevel的级数
  */
-vulkan::ImageView* ResourceSystem::createImageView(vulkan::Image& image, vk::ImageViewType imageViewType,
-                                                   vk::Format format,
-                                                   uint32_t mipLevels)
+ImageViewHandle ResourceSystem::createImageView(ImageHandle image, vk::ImageViewType imageViewType,
+                                                vk::Format format,
+                                                uint32_t mipLevels)
 {
-    return new vulkan::ImageView{image, imageViewType, format, mipLevels};
+    return ResourceRegistry::getInstance()->createImageView(image, imageViewType, format, mipLevels);
 }
 
 /**
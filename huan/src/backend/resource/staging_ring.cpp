@@ -0,0 +1,60 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/resource/staging_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "huan/backend/resource/resource_system.hpp"
+#include "huan/backend/resource/vulkan_buffer.hpp"
+
+namespace huan::runtime
+{
+StagingRing::StagingRing() = default;
+StagingRing::StagingRing(StagingRing&& that) noexcept = default;
+StagingRing& StagingRing::operator=(StagingRing&& that) noexcept = default;
+StagingRing::~StagingRing() = default;
+
+void StagingRing::reset()
+{
+    m_offset = 0;
+    m_retiredBuffers.clear();
+}
+
+void StagingRing::destroy()
+{
+    reset();
+    m_buffer.reset();
+}
+
+void StagingRing::write(vk::CommandBuffer commandBuffer, const vulkan::Buffer& dst, const void* srcData,
+                        vk::DeviceSize size, vk::DeviceSize dstOffset)
+{
+    if (size == 0)
+        return;
+    const vk::DeviceSize offset = (m_offset + Alignment - 1) / Alignment * Alignment;
+    if (m_buffer == nullptr || offset + size > m_buffer->getSize())
+    {
+        // At least twice as large, so that it settles after a few frames
+        const vk::DeviceSize capacity = std::max({MinCapacity, size, getCapacity() * 2});
+        if (m_buffer != nullptr)
+            m_retiredBuffers.push_back(std::move(m_buffer));
+        m_buffer = ResourceSystem::getInstance()->createStagingBuffer(vk::BufferUsageFlagBits::eTransferSrc, capacity,
+                                                                      nullptr, "StagingRing");
+        m_offset = 0;
+        write(commandBuffer, dst, srcData, size, dstOffset);
+        return;
+    }
+
+    m_buffer->updateDirectly(srcData, size, offset);
+    const vk::BufferCopy copy{offset, dstOffset, size};
+    commandBuffer.copyBuffer(m_buffer->getHandle(), dst.getHandle(), copy);
+    m_offset = offset + size;
+}
+
+vk::DeviceSize StagingRing::getCapacity() const
+{
+    return m_buffer != nullptr ? m_buffer->getSize() : 0;
+}
+} // namespace huan::runtime
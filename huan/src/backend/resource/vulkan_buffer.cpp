@@ -35,8 +35,27 @@ BufferBuilder& BufferBuilder::setUsage(vk::BufferUsageFlags usage)
 Buffer::Buffer(vk::Device& device, const BufferBuilder& builder)
     : ParentType(device, builder.getAllocator(), builder.getAllocationCreateInfo())
 {
-    this->setHandle(this->createBuffer(builder.getCreateInfo()));
-    this->m_size = builder.getCreateInfo().size;
+    const auto category = builder.getAllocationCategory() != runtime::AllocationCategory::Unknown
+                              ? builder.getAllocationCategory()
+                              : runtime::deduceAllocationCategory(builder.getCreateInfo().usage);
+    this->setAllocationTag(category, builder.getDebugName());
+    this->setRelocationListener(builder.getRelocationListener());
+    auto createInfo = builder.getCreateInfo();
+    if (builder.getRelocationListener() != DefragmentationSystem::NoListener)
+    {
+        // A move copies the content into a new buffer
+        createInfo.usage |= vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+    }
+    this->setHandle(this->createBuffer(createInfo));
+    this->m_size = createInfo.size;
+    this->m_flags = createInfo.flags;
+    this->m_usage = createInfo.usage;
+    this->m_sharingMode = createInfo.sharingMode;
+    if (createInfo.pQueueFamilyIndices != nullptr)
+    {
+        this->m_queueFamilyIndices.assign(createInfo.pQueueFamilyIndices,
+                                          createInfo.pQueueFamilyIndices + createInfo.queueFamilyIndexCount);
+    }
 #ifdef HUAN_DEBUG
     if (!builder.getDebugName().empty())
     {
@@ -45,6 +64,23 @@ Buffer::Buffer(vk::Device& device, const BufferBuilder& builder)
 #endif
 }
 
+Buffer& Buffer::operator=(Buffer&& that) noexcept
+{
+    if (this != &that)
+    {
+        // Release ours first, the allocation is about to be overwritten
+        this->destroyBuffer(getHandle());
+        ParentType::operator=(std::move(that));
+        m_size = that.m_size;
+        m_flags = that.m_flags;
+        m_usage = that.m_usage;
+        m_sharingMode = that.m_sharingMode;
+        m_queueFamilyIndices = std::move(that.m_queueFamilyIndices);
+        m_relocatedHandle = std::exchange(that.m_relocatedHandle, VK_NULL_HANDLE);
+    }
+    return *this;
+}
+
 Buffer::~Buffer()
 {
     this->destroyBuffer(getHandle());
@@ -60,5 +96,38 @@ vk::DeviceSize Buffer::getDeviceAddress() const
     return this->getDeviceHandle().getBufferAddress(vk::BufferDeviceAddressInfo{ getHandle()});
 }
 
+vk::BufferUsageFlags Buffer::getUsage() const
+{
+    return m_usage;
+}
+
+bool Buffer::beginRelocation(vk::CommandBuffer commandBuffer, VmaAllocation dstAllocation)
+{
+    if (getRelocationListener() == DefragmentationSystem::NoListener)
+        return false;
+
+    vk::BufferCreateInfo createInfo{m_flags, m_size, m_usage, m_sharingMode};
+    createInfo.setQueueFamilyIndices(m_queueFamilyIndices);
+    m_relocatedHandle = getDeviceHandle().createBuffer(createInfo);
+    if (vmaBindBufferMemory(getAllocator(), dstAllocation, m_relocatedHandle) != VK_SUCCESS)
+    {
+        getDeviceHandle().destroyBuffer(m_relocatedHandle);
+        m_relocatedHandle = VK_NULL_HANDLE;
+        return false;
+    }
+
+    commandBuffer.copyBuffer(getHandle(), m_relocatedHandle, vk::BufferCopy{0, 0, m_size});
+    return true;
+}
+
+void Buffer::commitRelocation()
+{
+    if (!m_relocatedHandle)
+        return;
+    // Only the handle goes away, the allocation is kept and swapped by VMA
+    getDeviceHandle().destroyBuffer(getHandle());
+    setHandle(std::exchange(m_relocatedHandle, VK_NULL_HANDLE));
+}
+
 #pragma endregion
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "huan/backend/resource/vulkan_image_view.hpp"
 #include "huan/backend/resource/resource_system.hpp"
+#include <array>
 #include <stdexcept>
 
 namespace huan::runtime::vulkan
@@ -183,9 +184,30 @@ Image::Image(vk::Device& device, const ImageBuilder& builder)
     : ParentType(device, builder.getAllocator(), builder.getAllocationCreateInfo())
       , m_createInfo(builder.getCreateInfo())
 {
-    this->setHandle(this->createImage(builder.getCreateInfo()));
+    const auto category = builder.getAllocationCategory() != runtime::AllocationCategory::Unknown
+                              ? builder.getAllocationCategory()
+                              : runtime::deduceAllocationCategory(builder.getCreateInfo().usage);
+    this->setAllocationTag(category, builder.getDebugName());
+    this->setRelocationListener(builder.getRelocationListener());
+    if (builder.getRelocationListener() != DefragmentationSystem::NoListener)
+    {
+        // A move copies the content into a new image
+        m_createInfo.usage |= vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+    }
+    this->setHandle(this->createImage(m_createInfo));
     this->m_subresource.arrayLayer = m_createInfo.arrayLayers;
     this->m_subresource.mipLevel = m_createInfo.mipLevels;
+    this->m_layout = m_createInfo.initialLayout;
+
+    // The builder owns whatever the create info points to, keep our own copy
+    if (m_createInfo.pQueueFamilyIndices != nullptr)
+    {
+        m_queueFamilyIndices.assign(m_createInfo.pQueueFamilyIndices,
+                                    m_createInfo.pQueueFamilyIndices + m_createInfo.queueFamilyIndexCount);
+    }
+    m_createInfo.setQueueFamilyIndices(m_queueFamilyIndices);
+    m_hasExtensions = m_createInfo.pNext != nullptr;
+    m_createInfo.pNext = nullptr;
 
 #ifdef HUAN_DEBUG
     if (!builder.getDebugName().empty())
@@ -199,9 +221,14 @@ Image::Image(vk::Device& device, const ImageBuilder& builder)
 Image::Image(Image&& other) noexcept
     : ParentType(std::move(other)), m_createInfo(other.m_createInfo),
       m_subresource(other.m_subresource),
-      m_views(std::move(other.m_views))
+      m_views(std::move(other.m_views)),
+      m_queueFamilyIndices(std::move(other.m_queueFamilyIndices)),
+      m_layout(other.m_layout),
+      m_hasExtensions(other.m_hasExtensions),
+      m_relocatedHandle(std::exchange(other.m_relocatedHandle, VK_NULL_HANDLE))
 {
-    for (auto& view : other.m_views)
+    m_createInfo.setQueueFamilyIndices(m_queueFamilyIndices);
+    for (auto& view : m_views)
     {
         view->setImage(*this);
     }
@@ -209,6 +236,10 @@ Image::Image(Image&& other) noexcept
 
 Image::~Image()
 {
+    for (auto* view : m_views)
+    {
+        view->m_image = nullptr;
+    }
     destroyImage(getHandle());
 }
 
@@ -257,6 +288,108 @@ std::unordered_set<ImageView*>& Image::getViews()
     return m_views;
 }
 
+vk::ImageLayout Image::getLayout() const
+{
+    return m_layout;
+}
+
+void Image::setLayout(vk::ImageLayout layout)
+{
+    m_layout = layout;
+}
+
+bool Image::beginRelocation(vk::CommandBuffer commandBuffer, VmaAllocation dstAllocation)
+{
+    if (getRelocationListener() == DefragmentationSystem::NoListener || m_layout == vk::ImageLayout::eUndefined ||
+        m_hasExtensions)
+        return false;
+
+    vk::ImageCreateInfo createInfo = m_createInfo;
+    createInfo.setInitialLayout(vk::ImageLayout::eUndefined);
+    createInfo.setUsage(createInfo.usage | vk::ImageUsageFlagBits::eTransferDst);
+    if (createInfo.usage != m_createInfo.usage)
+    {
+        // Extra usage may change the memory requirements, don't risk it
+        return false;
+    }
+    m_relocatedHandle = getDeviceHandle().createImage(createInfo);
+    if (vmaBindImageMemory(getAllocator(), dstAllocation, m_relocatedHandle) != VK_SUCCESS)
+    {
+        getDeviceHandle().destroyImage(m_relocatedHandle);
+        m_relocatedHandle = VK_NULL_HANDLE;
+        return false;
+    }
+
+    vk::ImageAspectFlags aspectMask = vk::ImageAspectFlagBits::eColor;
+    if (ResourceSystem::isDepthStencilFormat(m_createInfo.format))
+    {
+        aspectMask = vk::ImageAspectFlagBits::eDepth;
+        if (ResourceSystem::hasStencilComponent(m_createInfo.format))
+            aspectMask |= vk::ImageAspectFlagBits::eStencil;
+    }
+    const vk::ImageSubresourceRange range{aspectMask, 0, m_createInfo.mipLevels, 0, m_createInfo.arrayLayers};
+
+    std::array<vk::ImageMemoryBarrier, 2> toTransfer{};
+    toTransfer[0].setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+                 .setDstAccessMask(vk::AccessFlagBits::eTransferRead)
+                 .setOldLayout(m_layout)
+                 .setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                 .setImage(getHandle())
+                 .setSubresourceRange(range);
+    toTransfer[1].setSrcAccessMask({})
+                 .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+                 .setOldLayout(vk::ImageLayout::eUndefined)
+                 .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+                 .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                 .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                 .setImage(m_relocatedHandle)
+                 .setSubresourceRange(range);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {},
+                                  nullptr, nullptr, toTransfer);
+
+    std::vector<vk::ImageCopy> regions(m_createInfo.mipLevels);
+    for (uint32_t mip = 0; mip < m_createInfo.mipLevels; ++mip)
+    {
+        const vk::ImageSubresourceLayers layers{aspectMask, mip, 0, m_createInfo.arrayLayers};
+        const vk::Extent3D extent{std::max(1u, m_createInfo.extent.width >> mip),
+                                  std::max(1u, m_createInfo.extent.height >> mip),
+                                  std::max(1u, m_createInfo.extent.depth >> mip)};
+        regions[mip] = vk::ImageCopy{layers, {}, layers, {}, extent};
+    }
+    commandBuffer.copyImage(getHandle(), vk::ImageLayout::eTransferSrcOptimal, m_relocatedHandle,
+                            vk::ImageLayout::eTransferDstOptimal, regions);
+
+    vk::ImageMemoryBarrier toOriginal{};
+    toOriginal.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+              .setDstAccessMask(vk::AccessFlagBits::eMemoryRead)
+              .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+              .setNewLayout(m_layout)
+              .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+              .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+              .setImage(m_relocatedHandle)
+              .setSubresourceRange(range);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {},
+                                  nullptr, nullptr, toOriginal);
+    return true;
+}
+
+void Image::commitRelocation()
+{
+    if (!m_relocatedHandle)
+        return;
+    const vk::Image oldHandle = getHandle();
+    setHandle(std::exchange(m_relocatedHandle, VK_NULL_HANDLE));
+    // Views still reference the old handle, recreate them before it goes away
+    for (auto* view : m_views)
+    {
+        view->recreate();
+    }
+    // Only the handle goes away, the allocation is kept and swapped by VMA
+    getDeviceHandle().destroyImage(oldHandle);
+}
+
 uint8_t* Image::map()
 {
     if (m_createInfo.tiling != vk::ImageTiling::eLinear)
@@ -12,35 +12,31 @@ namespace huan::runtime::vulkan
 {
 ImageView::ImageView(Image& image, vk::ImageViewType viewType, vk::Format format, uint32_t baseMipLevel,
                      uint32_t baseArrayLayer, uint32_t nMipLevels, uint32_t nArrayLayers)
-    : ParentType(image.getDeviceHandle()), m_image(&image)
+    : ParentType(image.getDeviceHandle()), m_image(&image), m_viewType(viewType),
+      m_format(format == vk::Format::eUndefined ? image.getFormat() : format)
 {
-    if (format == vk::Format::eUndefined)
-        m_format = image.getFormat();
-
-    m_subresourceRange.setAspectMask((std::string(vk::componentName(format, 0)) == "D")
+    m_subresourceRange.setAspectMask((std::string(vk::componentName(m_format, 0)) == "D")
                                          ? vk::ImageAspectFlagBits::eDepth
                                          : vk::ImageAspectFlagBits::eColor)
                       .setBaseMipLevel(baseMipLevel)
                       .setLevelCount(nMipLevels == 0 ? image.getSubresource().mipLevel : nMipLevels)
                       .setBaseArrayLayer(baseArrayLayer)
                       .setLayerCount(nArrayLayers == 0 ? image.getSubresource().arrayLayer : nArrayLayers);
-    vk::ImageViewCreateInfo info{};
-    info.setImage(m_image->getHandle())
-      .setViewType(viewType)
-      .setFormat(format)
-      .setSubresourceRange(m_subresourceRange);
-    
-    setHandle(VulkanContext::getInstance()->device.createImageView(info));
+    setHandle(createHandle());
     m_image->getViews().emplace(this);
 }
 
 ImageView::ImageView(ImageView&& that) noexcept
-    : ParentType(std::move(that)), m_image(that.m_image), m_format(that.m_format),
+    : ParentType(std::move(that)), m_image(that.m_image), m_viewType(that.m_viewType), m_format(that.m_format),
       m_subresourceRange(that.m_subresourceRange)
 {
-    auto& views = m_image->getViews();
-    views.erase(&that);
-    views.emplace(this);
+    if (m_image != nullptr)
+    {
+        auto& views = m_image->getViews();
+        views.erase(&that);
+        views.emplace(this);
+    }
+    that.m_image = nullptr;
     that.setHandle(nullptr);
 }
 
@@ -50,6 +46,10 @@ ImageView::~ImageView()
     {
         getDeviceHandle().destroyImageView(getHandle());
     }
+    if (m_image != nullptr)
+    {
+        m_image->getViews().erase(this);
+    }
 }
 
 vk::Format ImageView::getFormat() const
@@ -81,4 +81,24 @@ vk::ImageSubresourceRange ImageView::getSubresourceRange() const
 {
     return m_subresourceRange;
 }
+
+void ImageView::recreate()
+{
+    if (getHandle())
+    {
+        getDeviceHandle().destroyImageView(getHandle());
+    }
+    setHandle(createHandle());
+}
+
+vk::ImageView ImageView::createHandle() const
+{
+    vk::ImageViewCreateInfo info{};
+    info.setImage(m_image->getHandle())
+        .setViewType(m_viewType)
+        .setFormat(m_format)
+        .setSubresourceRange(m_subresourceRange);
+
+    return getDeviceHandle().createImageView(info);
+}
 }
\ No newline at end of file
@@ -8,10 +8,16 @@
 #include <vulkan/vulkan.hpp>
 
 #include "huan/VulkanContext.hpp"
+#ifdef HUAN_ENABLE_SHADER_COMPILER
 #include "huan/backend/shader/glsl_compiler.hpp"
+#include "huan/backend/shader/spirv_cache.hpp"
+#include "huan/backend/shader/spirv_optimizer.hpp"
+#endif
+#include "huan/backend/shader/shader_preprocessor.hpp"
 #include "huan/backend/shader/spirv_reflection.hpp"
 #include "huan/log/Log.hpp"
 #include "huan/utils/file_system.hpp"
+#include "huan/utils/hash.hpp"
 
 namespace huan::runtime::vulkan
 {
@@ -31,33 +37,10 @@ namespace huan::runtime::vulkan
 //         HUAN_CLIENT_INFO("Created shader module!");
 //     return shaderModule;
 // }
-std::string preprocessShader(std::string_view source)
+bool preprocessShader(std::string_view source, std::string_view sourceName, std::string& output, std::string& infoLog,
+                      std::vector<std::string>* includedFiles)
 {
-    std::string finalSource;
-    finalSource.reserve(source.size() * 2 + 10);
-
-    auto lines = source | std::views::split('\n');
-    for (auto line : lines)
-    {
-        std::string_view lineView{line.begin(), line.end()};
-        if (lineView.starts_with("#include \""))
-        {
-            std::string_view includePath = lineView.substr(10);
-            size_t lastQuote = includePath.find('"');
-            if (!includePath.empty() && lastQuote != std::string_view::npos)
-            {
-                includePath = includePath.substr(0, lastQuote);
-            }
-            finalSource.append(
-                preprocessShader(FileSystem::loadFile(includePath)));
-        }
-        else
-        {
-            finalSource.append(lineView);
-            finalSource.append("\n");
-        }
-    }
-    return finalSource;
+    return ShaderPreprocessor::getInstance()->preprocess(source, sourceName, output, infoLog, includedFiles);
 }
 
 ShaderSource::ShaderSource(const std::string& fileName)
@@ -144,6 +127,12 @@ void ShaderVariant::setRuntimeArraySize(const std::string& name, size_t size)
     m_runtimeArraySizes[name] = size;
 }
 
+void ShaderVariant::setSpecializationConstant(uint32_t constantID, uint32_t value)
+{
+    m_specializationConstants[constantID] = value;
+    updateID();
+}
+
 const std::string& ShaderVariant::getPreamble() const
 {
     return m_preamble;
@@ -159,11 +148,17 @@ const std::unordered_map<std::string, size_t>& ShaderVariant::getRuntimeArraySiz
     return m_runtimeArraySizes;
 }
 
+const std::map<uint32_t, uint32_t>& ShaderVariant::getSpecializationConstants() const
+{
+    return m_specializationConstants;
+}
+
 void ShaderVariant::clear()
 {
     m_preamble.clear();
     m_processes.clear();
     m_runtimeArraySizes.clear();
+    m_specializationConstants.clear();
     updateID();
 }
 
@@ -171,12 +166,23 @@ void ShaderVariant::updateID()
 {
     std::hash<std::string> hash;
     m_id = hash(m_preamble);
+    if (m_specializationConstants.empty())
+        return;
+
+    utils::Hasher hasher;
+    hasher.add(m_id);
+    for (const auto& [constantID, value] : m_specializationConstants)
+    {
+        hasher.add(constantID).add(value);
+    }
+    m_id = static_cast<uint32_t>(hasher.get());
 }
 
+#ifdef HUAN_ENABLE_SHADER_COMPILER
 ShaderModule::ShaderModule(vk::Device& device, vk::ShaderStageFlagBits stage, const ShaderSource& glslSource,
                            const std::string& entryPoint, const ShaderVariant& variant)
     : ParentType(device, nullptr),
-      m_stage(stage), m_entryPoint(entryPoint)
+      m_stage(stage), m_entryPoint(entryPoint), m_specializationConstants(variant.getSpecializationConstants())
 {
 #ifdef HUAN_DEBUG
     setDebugName(fmt::format("[Source]: {}, [Variant]: {:X}, [EntryPoint]: {}", glslSource.getFileName(),
@@ -193,26 +199,60 @@ ShaderModule::ShaderModule(vk::Device& device, vk::ShaderStageFlagBits stage, co
         HUAN_CORE_BREAK("Renderer: Shader Init Failed!")
     }
 
-    const auto glslFinalSource = preprocessShader(source);
-    HUAN_CORE_TRACE("glsl {} FinalSource:\n{}",glslSource.getFileName(), glslFinalSource)
-    GLSLCompiler compiler;
-    if (!compiler.compileToSPIRV(stage, glslFinalSource, entryPoint, variant, m_binary, m_infoLog))
+    std::string glslFinalSource;
+    if (!preprocessShader(source, glslSource.getFileName(), glslFinalSource, m_infoLog))
     {
-        HUAN_CORE_ERROR("Renderer: Shader compilation failed for shader [{}]", glslSource.getFileName())
+        HUAN_CORE_ERROR("Renderer: Shader preprocessing failed for shader [{}]", glslSource.getFileName())
         HUAN_CORE_BREAK(m_infoLog)
     }
-    SPIRVReflection spirvReflection;
-    if (!SPIRVReflection::reflectShaderResources(stage, m_binary, variant, m_resources))
+    HUAN_CORE_TRACE("glsl {} FinalSource:\n{}",glslSource.getFileName(), glslFinalSource)
+    auto* spirvCache = SPIRVCache::getInstance();
+    const auto cacheKey = SPIRVCache::computeKey(stage, glslFinalSource, entryPoint, variant);
+    if (!spirvCache->load(cacheKey, m_binary, m_resources))
+    {
+        GLSLCompiler compiler;
+        if (!compiler.compileToSPIRV(stage, glslFinalSource, entryPoint, variant, m_binary, m_infoLog))
+        {
+            HUAN_CORE_ERROR("Renderer: Shader compilation failed for shader [{}]", glslSource.getFileName())
+            HUAN_CORE_BREAK(m_infoLog)
+        }
+        if (!SPIRVReflection::reflectShaderResources(stage, m_binary, variant, m_resources))
+        {
+            HUAN_CORE_BREAK("Renderer: Shader Init Failed!")
+        }
+        if (SPIRVOptimizer::isStripEnabled() && !SPIRVOptimizer::strip(m_binary, m_infoLog))
+        {
+            HUAN_CORE_BREAK(m_infoLog)
+        }
+        spirvCache->store(cacheKey, m_binary, m_resources);
+    }
+    createHandle();
+}
+#endif
+
+ShaderModule::ShaderModule(vk::Device& device, vk::ShaderStageFlagBits stage, std::vector<uint32_t>&& spirv,
+                           std::vector<ShaderResource>&& resources, const std::string& entryPoint,
+                           const ShaderVariant& variant)
+    : ParentType(device, nullptr),
+      m_stage(stage), m_entryPoint(entryPoint), m_resources(std::move(resources)), m_binary(std::move(spirv)),
+      m_specializationConstants(variant.getSpecializationConstants())
+{
+    if (entryPoint.empty() || m_binary.empty())
     {
         HUAN_CORE_BREAK("Renderer: Shader Init Failed!")
     }
-    constexpr std::hash<std::string> hash{};
-    m_id = hash(std::string(m_binary.begin(), m_binary.end()));
+    createHandle();
+}
+
+void ShaderModule::createHandle()
+{
+    // Over every byte of the words, pipelines are keyed by this ID
+    m_id = utils::hash64(m_binary.data(), m_binary.size() * sizeof(uint32_t));
 
     vk::ShaderModuleCreateInfo createInfo{};
     createInfo.setCodeSize(m_binary.size() * sizeof(uint32_t))
               .setCode(m_binary);
-    setHandle(device.createShaderModule(createInfo));
+    setHandle(getDeviceHandle().createShaderModule(createInfo));
     if (!getHandle())
     {
         HUAN_CORE_BREAK("Renderer: Shader Init Failed!")
@@ -226,7 +266,8 @@ ShaderModule::ShaderModule(ShaderModule&& that) noexcept
       m_entryPoint(std::move(that.m_entryPoint)),
       m_infoLog(std::move(that.m_infoLog)),
       m_resources(std::move(that.m_resources)),
-      m_binary(std::move(that.m_binary))
+      m_binary(std::move(that.m_binary)),
+      m_specializationConstants(std::move(that.m_specializationConstants))
 {
     that.m_stage = {};
 }
@@ -269,6 +310,11 @@ const std::vector<uint32_t>& ShaderModule::getBinary() const
     return m_binary;
 }
 
+const std::map<uint32_t, uint32_t>& ShaderModule::getSpecializationConstants() const
+{
+    return m_specializationConstants;
+}
+
 void ShaderModule::setResourceMode(const std::string& resourceName, const ShaderResourceMode& resourceMode)
 {
     auto it = std::ranges::find_if(m_resources, [&resourceName](const ShaderResource& resource) {
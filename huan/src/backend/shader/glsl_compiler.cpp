@@ -5,11 +5,17 @@
 #include <vulkan/vulkan.hpp>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/Public/ResourceLimits.h>
+#include <glslang/build_info.h>
 #include <spirv/GlslangToSpv.h>
 
 #include "huan/backend/shader/glsl_compiler.hpp"
+#include "huan/backend/shader/spirv_optimizer.hpp"
+
+#include <mutex>
 
 #include "StandAlone/DirStackFileIncluder.h"
+#include "huan/log/Log.hpp"
+#include "huan/utils/thread_pool.hpp"
 
 namespace huan::runtime
 {
@@ -67,6 +73,64 @@ void GLSLCompiler::resetTargetEnv()
     envTargetLanguageVersion = glslang::EShTargetLanguageVersion::EShTargetSpv_1_0;
 }
 
+glslang::EShTargetLanguage GLSLCompiler::getTargetLanguage()
+{
+    return envTargetLanguage;
+}
+
+glslang::EShTargetLanguageVersion GLSLCompiler::getTargetLanguageVersion()
+{
+    return envTargetLanguageVersion;
+}
+
+uint32_t GLSLCompiler::getCompilerVersion()
+{
+    return GLSLANG_VERSION_MAJOR << 20 | GLSLANG_VERSION_MINOR << 10 | GLSLANG_VERSION_PATCH;
+}
+
+void GLSLCompiler::ensureProcessInitialized()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        glslang::InitializeProcess();
+        std::atexit([]() { glslang::FinalizeProcess(); });
+    });
+}
+
+utils::ThreadPool& GLSLCompiler::getThreadPool()
+{
+    static utils::ThreadPool threadPool;
+    return threadPool;
+}
+
+std::future<ShaderCompileResult> GLSLCompiler::compileAsync(ShaderCompileJob job)
+{
+    // Registers FinalizeProcess before the pool exists, so at exit the workers are joined first
+    ensureProcessInitialized();
+    return getThreadPool().submit([job = std::move(job)]() {
+        ShaderCompileResult result;
+        GLSLCompiler compiler;
+        result.success = compiler.compileToSPIRV(job.stage, job.source, job.entryPoint, job.variant, result.spirv,
+                                                 result.infoLog);
+        if (!result.success)
+        {
+            HUAN_CORE_ERROR("[GLSLCompiler]: Failed to compile [{}]:\n{}", job.name, result.infoLog)
+        }
+        return result;
+    });
+}
+
+std::vector<std::future<ShaderCompileResult>> GLSLCompiler::compileBatch(std::vector<ShaderCompileJob> jobs)
+{
+    std::vector<std::future<ShaderCompileResult>> futures;
+    futures.reserve(jobs.size());
+    for (auto& job : jobs)
+    {
+        futures.push_back(compileAsync(std::move(job)));
+    }
+    return futures;
+}
+
 bool GLSLCompiler::compileToSPIRV(vk::ShaderStageFlagBits stage,
                                   const std::string& glslSource,
                                   std::string_view entryPoint,
@@ -74,7 +138,7 @@ bool GLSLCompiler::compileToSPIRV(vk::ShaderStageFlagBits stage,
                                   std::vector<uint32_t>& spirvCode,
                                   std::string& infoLog)
 {
-    glslang::InitializeProcess();
+    ensureProcessInitialized();
     auto messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
     EShLanguage language = FindShaderLanguage(stage);
     std::string_view source = glslSource;
@@ -88,9 +152,10 @@ bool GLSLCompiler::compileToSPIRV(vk::ShaderStageFlagBits stage,
     shader.setSourceEntryPoint(entryPoint.data());
     shader.setPreamble(shaderVariant.getPreamble().data());
     shader.addProcesses(shaderVariant.getProcesses());
-    if (GLSLCompiler::envTargetLanguage != glslang::EShTargetNone)
+    const auto targetLanguage = GLSLCompiler::envTargetLanguage.load();
+    if (targetLanguage != glslang::EShTargetNone)
     {
-        shader.setEnvTarget(GLSLCompiler::envTargetLanguage, GLSLCompiler::envTargetLanguageVersion);
+        shader.setEnvTarget(targetLanguage, GLSLCompiler::envTargetLanguageVersion.load());
     }
 
     DirStackFileIncluder includeDir;
@@ -128,7 +193,8 @@ bool GLSLCompiler::compileToSPIRV(vk::ShaderStageFlagBits stage,
     glslang::GlslangToSpv(*intermediate, spirvCode, &logger);
 
     infoLog += logger.getAllMessages() + "\n";
-    glslang::FinalizeProcess();
+    if (SPIRVOptimizer::isEnabled() && !SPIRVOptimizer::optimize(spirvCode, shaderVariant, infoLog))
+        return false;
     return true;
 }
 }
\ No newline at end of file
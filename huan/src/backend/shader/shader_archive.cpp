@@ -0,0 +1,233 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/shader/shader_archive.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "huan/backend/shader.hpp"
+#include "huan/backend/shader/shader_resource_io.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/utils/binary_stream.hpp"
+#include "huan/utils/file_system.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+constexpr uint32_t ArchiveMagic = 0x52415348; // "HSAR"
+// Bump whenever the layout or the reflection output changes
+constexpr uint32_t ArchiveFormatVersion = 3;
+
+struct ArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    // Hash of everything after the header
+    uint64_t dataHash;
+};
+} // namespace
+
+// Offsets are from the beginning of the file
+struct ShaderArchive::Entry
+{
+    uint64_t variantID;
+    uint32_t stage;
+    uint32_t spirvWordCount;
+    uint64_t spirvOffset;
+    uint64_t resourcesOffset;
+    uint32_t resourcesSize;
+    uint32_t reserved;
+};
+
+uint64_t ShaderArchive::computeVariantID(std::string_view shaderName, vk::ShaderStageFlagBits stage,
+                                         std::string_view entryPoint, const vulkan::ShaderVariant& variant)
+{
+    utils::Hasher hasher;
+    hasher.add(shaderName).add(static_cast<uint32_t>(stage)).add(entryPoint);
+
+    std::vector<std::string_view> processes(variant.getProcesses().begin(), variant.getProcesses().end());
+    std::ranges::sort(processes);
+    hasher.add(static_cast<uint64_t>(processes.size()));
+    for (const auto process : processes)
+    {
+        hasher.add(process);
+    }
+
+    std::vector<std::pair<std::string_view, size_t>> arraySizes(variant.getRuntimeArraySizes().begin(),
+                                                                variant.getRuntimeArraySizes().end());
+    std::ranges::sort(arraySizes);
+    for (const auto& [name, size] : arraySizes)
+    {
+        hasher.add(name).add(static_cast<uint64_t>(size));
+    }
+    for (const auto& [constantID, value] : variant.getSpecializationConstants())
+    {
+        hasher.add(constantID).add(value);
+    }
+    return hasher.get();
+}
+
+bool ShaderArchive::load(std::string_view filePath)
+{
+    m_data.clear();
+    m_entries = nullptr;
+    m_entryCount = 0;
+
+    std::vector<char> data;
+    if (!FileSystem::tryLoadBytes(filePath, data))
+    {
+        HUAN_CORE_WARN("[ShaderArchive]: Can't read {}", filePath)
+        return false;
+    }
+
+    utils::BinaryReader reader(data.data(), data.size());
+    ArchiveHeader header{};
+    if (!reader.read(header) || header.magic != ArchiveMagic || header.version != ArchiveFormatVersion ||
+        header.dataHash != utils::hash64(data.data() + sizeof(ArchiveHeader), data.size() - sizeof(ArchiveHeader)))
+    {
+        HUAN_CORE_ERROR("[ShaderArchive]: {} is not a valid shader archive (version {} expected)", filePath,
+                        ArchiveFormatVersion)
+        return false;
+    }
+    const char* entryData = reader.skip(static_cast<size_t>(header.entryCount) * sizeof(Entry));
+    if (entryData == nullptr)
+    {
+        HUAN_CORE_ERROR("[ShaderArchive]: {} is truncated", filePath)
+        return false;
+    }
+
+    // The header size keeps the entry table 8 bytes aligned, and vector storage is suitably aligned for it
+    const auto* entries = reinterpret_cast<const Entry*>(entryData);
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        const auto& entry = entries[i];
+        const bool spirvInBounds = entry.spirvOffset <= data.size() &&
+                                   (data.size() - entry.spirvOffset) / sizeof(uint32_t) >= entry.spirvWordCount;
+        const bool resourcesInBounds = entry.resourcesOffset <= data.size() &&
+                                       data.size() - entry.resourcesOffset >= entry.resourcesSize;
+        const bool sorted = i == 0 || entries[i - 1].variantID < entry.variantID;
+        if (!spirvInBounds || !resourcesInBounds || !sorted)
+        {
+            HUAN_CORE_ERROR("[ShaderArchive]: {} has an invalid entry table", filePath)
+            return false;
+        }
+    }
+
+    m_data = std::move(data);
+    m_entries = reinterpret_cast<const Entry*>(m_data.data() + sizeof(ArchiveHeader));
+    m_entryCount = header.entryCount;
+    HUAN_CORE_INFO("[ShaderArchive]: Loaded {} shader variants from {}", m_entryCount, filePath)
+    return true;
+}
+
+bool ShaderArchive::contains(uint64_t variantID) const
+{
+    return findEntry(variantID) != nullptr;
+}
+
+bool ShaderArchive::find(uint64_t variantID, std::vector<uint32_t>& spirv,
+                         std::vector<vulkan::ShaderResource>& resources) const
+{
+    const auto* entry = findEntry(variantID);
+    if (entry == nullptr)
+        return false;
+
+    utils::BinaryReader reader(m_data.data() + entry->resourcesOffset, entry->resourcesSize);
+    std::vector<vulkan::ShaderResource> entryResources;
+    if (!readShaderResources(reader, entryResources))
+    {
+        HUAN_CORE_ERROR("[ShaderArchive]: Invalid resources for variant {:016x}", variantID)
+        return false;
+    }
+    spirv.resize(entry->spirvWordCount);
+    std::memcpy(spirv.data(), m_data.data() + entry->spirvOffset, spirv.size() * sizeof(uint32_t));
+    resources = std::move(entryResources);
+    return true;
+}
+
+size_t ShaderArchive::getEntryCount() const
+{
+    return m_entryCount;
+}
+
+bool ShaderArchive::isEmpty() const
+{
+    return m_entryCount == 0;
+}
+
+const ShaderArchive::Entry* ShaderArchive::findEntry(uint64_t variantID) const
+{
+    const auto* end = m_entries + m_entryCount;
+    const auto* it = std::lower_bound(m_entries, end, variantID,
+                                      [](const Entry& entry, uint64_t id) { return entry.variantID < id; });
+    return (it != end && it->variantID == variantID) ? it : nullptr;
+}
+
+bool ShaderArchiveWriter::add(uint64_t variantID, vk::ShaderStageFlagBits stage, const std::vector<uint32_t>& spirv,
+                              const std::vector<vulkan::ShaderResource>& resources)
+{
+    if (std::ranges::any_of(m_entries, [&](const PendingEntry& entry) { return entry.variantID == variantID; }))
+        return false;
+
+    utils::BinaryWriter resourceWriter;
+    writeShaderResources(resourceWriter, resources);
+    m_entries.push_back({variantID, static_cast<uint32_t>(stage), spirv, std::move(resourceWriter.getData())});
+    return true;
+}
+
+bool ShaderArchiveWriter::write(std::string_view filePath) const
+{
+    std::vector<const PendingEntry*> sorted;
+    sorted.reserve(m_entries.size());
+    for (const auto& entry : m_entries)
+    {
+        sorted.push_back(&entry);
+    }
+    std::ranges::sort(sorted, {}, &PendingEntry::variantID);
+
+    // Header, entry table, then the blobs, each SPIR-V blob aligned to 4 bytes
+    std::vector<ShaderArchive::Entry> table(sorted.size());
+    uint64_t offset = sizeof(ArchiveHeader) + table.size() * sizeof(ShaderArchive::Entry);
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        const auto& pending = *sorted[i];
+        auto& entry = table[i];
+        entry.variantID = pending.variantID;
+        entry.stage = pending.stage;
+        entry.spirvWordCount = static_cast<uint32_t>(pending.spirv.size());
+        entry.spirvOffset = offset;
+        offset += pending.spirv.size() * sizeof(uint32_t);
+        entry.resourcesOffset = offset;
+        entry.resourcesSize = static_cast<uint32_t>(pending.resources.size());
+        offset += (pending.resources.size() + 3) & ~size_t(3);
+        entry.reserved = 0;
+    }
+
+    utils::BinaryWriter body;
+    body.write(table.data(), table.size() * sizeof(ShaderArchive::Entry));
+    for (const auto* pending : sorted)
+    {
+        body.write(pending->spirv.data(), pending->spirv.size() * sizeof(uint32_t));
+        body.write(pending->resources.data(), pending->resources.size());
+        constexpr char padding[3] = {};
+        body.write(padding, ((pending->resources.size() + 3) & ~size_t(3)) - pending->resources.size());
+    }
+
+    const ArchiveHeader header{ArchiveMagic, ArchiveFormatVersion, static_cast<uint32_t>(table.size()), 0,
+                               utils::hash64(body.getData().data(), body.getSize())};
+    utils::BinaryWriter file;
+    file.write(header);
+    file.write(body.getData().data(), body.getSize());
+    return FileSystem::writeFileAtomic(filePath, file.getData().data(), file.getSize());
+}
+
+size_t ShaderArchiveWriter::getEntryCount() const
+{
+    return m_entries.size();
+}
+} // namespace huan::runtime
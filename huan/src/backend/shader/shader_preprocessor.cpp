@@ -0,0 +1,262 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/shader/shader_preprocessor.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "huan/utils/file_system.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+std::string_view trim(std::string_view text)
+{
+    const auto begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos)
+        return {};
+    return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+// Matches `# name argument`, with `argument` trimmed
+bool matchDirective(std::string_view line, std::string_view name, std::string_view& argument)
+{
+    if (!line.starts_with('#'))
+        return false;
+    line = trim(line.substr(1));
+    if (!line.starts_with(name))
+        return false;
+    const auto rest = line.substr(name.size());
+    // Not a longer directive starting with the same letters
+    if (!rest.empty() && rest.front() != ' ' && rest.front() != '\t' && rest.front() != '"')
+        return false;
+    argument = trim(rest);
+    return true;
+}
+
+std::string_view firstWord(std::string_view text)
+{
+    return text.substr(0, text.find_first_of(" \t"));
+}
+
+std::string toKey(const std::filesystem::path& file)
+{
+    return std::filesystem::absolute(file).lexically_normal().generic_string();
+}
+} // namespace
+
+bool ShaderPreprocessor::preprocess(std::string_view source, std::string_view sourceName, std::string& output,
+                                    std::string& infoLog, std::vector<std::string>* includedFiles)
+{
+    const auto file = parse(source);
+    const std::filesystem::path sourcePath(sourceName);
+
+    output.clear();
+    output.reserve(source.size() * 2);
+    ExpandState state{output, infoLog, includedFiles};
+    state.stack.emplace_back(sourceName.empty() ? std::string() : toKey(sourcePath), std::string(sourceName));
+    return expand(file, sourcePath.parent_path(), true, state);
+}
+
+void ShaderPreprocessor::invalidate(const std::filesystem::path& file)
+{
+    std::lock_guard lock(m_mutex);
+    m_files.erase(toKey(file));
+}
+
+void ShaderPreprocessor::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_files.clear();
+}
+
+size_t ShaderPreprocessor::getFileCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_files.size();
+}
+
+ShaderPreprocessor::Stats ShaderPreprocessor::getStats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+ShaderPreprocessor::SourceFile ShaderPreprocessor::parse(std::string_view text)
+{
+    SourceFile file;
+    file.segments.emplace_back();
+    // First two and last lines which are neither blank nor comments, to spot an include guard
+    std::vector<std::string_view> significantLines;
+    std::string_view lastSignificantLine;
+
+    uint32_t lineNumber = 0;
+    for (size_t begin = 0; begin < text.size();)
+    {
+        size_t end = text.find('\n', begin);
+        if (end == std::string_view::npos)
+            end = text.size();
+        auto line = text.substr(begin, end - begin);
+        begin = end + 1;
+        ++lineNumber;
+        if (line.ends_with('\r'))
+            line.remove_suffix(1);
+
+        const auto trimmed = trim(line);
+        if (!trimmed.empty() && !trimmed.starts_with("//"))
+        {
+            if (significantLines.size() < 2)
+                significantLines.push_back(trimmed);
+            lastSignificantLine = trimmed;
+        }
+
+        std::string_view argument;
+        auto& segment = file.segments.back();
+        if (matchDirective(trimmed, "include", argument) && argument.starts_with('"'))
+        {
+            const auto closingQuote = argument.find('"', 1);
+            if (closingQuote != std::string_view::npos)
+            {
+                segment.include = argument.substr(1, closingQuote - 1);
+                segment.includeLine = lineNumber;
+                file.segments.emplace_back();
+                continue;
+            }
+        }
+        if (matchDirective(trimmed, "pragma", argument) && argument == "once")
+        {
+            // glslang doesn't know it, an empty line keeps the numbering
+            file.isPragmaOnce = true;
+            segment.text += '\n';
+            continue;
+        }
+
+        segment.text.append(line);
+        segment.text += '\n';
+        if (file.versionEnd == 0 && file.segments.size() == 1 && matchDirective(trimmed, "version", argument))
+        {
+            file.versionEnd = segment.text.size();
+            file.versionNextLine = lineNumber + 1;
+        }
+    }
+
+    std::string_view guard;
+    std::string_view defined;
+    if (significantLines.size() == 2 && matchDirective(significantLines[0], "ifndef", guard) &&
+        matchDirective(significantLines[1], "define", defined) && firstWord(guard) == firstWord(defined) &&
+        matchDirective(lastSignificantLine, "endif", defined))
+    {
+        file.guard = firstWord(guard);
+    }
+    return file;
+}
+
+Ref<const ShaderPreprocessor::SourceFile> ShaderPreprocessor::load(const std::filesystem::path& directory,
+                                                                   const std::string& include, std::string& key,
+                                                                   std::string& path)
+{
+    // Next to the including file, then from the working directory
+    const std::filesystem::path candidates[] = {directory / include, std::filesystem::path(include)};
+
+    // The cache first, so that a cached file costs no I/O whichever candidate it was found at
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& candidate : candidates)
+        {
+            if (const auto it = m_files.find(toKey(candidate)); it != m_files.end())
+            {
+                ++m_stats.cacheHits;
+                key = it->first;
+                path = candidate.lexically_normal().generic_string();
+                return it->second;
+            }
+        }
+    }
+
+    for (const auto& candidate : candidates)
+    {
+        std::vector<char> bytes;
+        if (!FileSystem::tryLoadBytes(candidate.string(), bytes))
+            continue;
+        auto file = createRef<const SourceFile>(parse(std::string_view(bytes.data(), bytes.size())));
+
+        std::lock_guard lock(m_mutex);
+        ++m_stats.fileLoads;
+        // Another thread may have loaded it meanwhile, both are the same
+        const auto [it, inserted] = m_files.try_emplace(toKey(candidate), std::move(file));
+        key = it->first;
+        path = candidate.lexically_normal().generic_string();
+        return it->second;
+    }
+    return nullptr;
+}
+
+bool ShaderPreprocessor::expand(const SourceFile& file, const std::filesystem::path& directory, bool isMainSource,
+                                ExpandState& state)
+{
+    // Copied, the stack grows while expanding the includes
+    const std::string name = state.stack.back().second;
+    const bool hasIncludes = file.segments.size() > 1;
+
+    for (size_t i = 0; i < file.segments.size(); ++i)
+    {
+        const auto& segment = file.segments[i];
+        if (i == 0 && isMainSource && hasIncludes)
+        {
+            // The extension must follow #version, then the numbering resumes where it was
+            state.output.append(segment.text, 0, file.versionEnd);
+            state.output += "#extension GL_GOOGLE_cpp_style_line_directive : require\n";
+            state.output += fmt::format("#line {} \"{}\"\n", file.versionNextLine, name);
+            state.output.append(segment.text, file.versionEnd);
+        }
+        else
+        {
+            state.output += segment.text;
+        }
+        if (segment.include.empty())
+            continue;
+
+        std::string key;
+        std::string path;
+        const auto included = load(directory, segment.include, key, path);
+        if (!included)
+        {
+            state.infoLog = fmt::format("{}:{}: Can't open include \"{}\"", name, segment.includeLine,
+                                        segment.include);
+            return false;
+        }
+        if (state.guardedFiles.contains(key))
+        {
+            // Expanded already, the directive becomes an empty line
+            state.output += '\n';
+            continue;
+        }
+        if (std::ranges::any_of(state.stack, [&](const auto& entry) { return entry.first == key; }))
+        {
+            state.infoLog = fmt::format("{}:{}: Include cycle: ", name, segment.includeLine);
+            for (const auto& entry : state.stack)
+            {
+                state.infoLog += entry.second + " -> ";
+            }
+            state.infoLog += segment.include;
+            return false;
+        }
+
+        if (included->isPragmaOnce || !included->guard.empty())
+            state.guardedFiles.insert(key);
+        if (state.includedFiles != nullptr && state.reportedFiles.insert(key).second)
+            state.includedFiles->push_back(path);
+
+        state.output += fmt::format("#line 1 \"{}\"\n", segment.include);
+        state.stack.emplace_back(key, segment.include);
+        if (!expand(*included, std::filesystem::path(path).parent_path(), false, state))
+            return false;
+        state.stack.pop_back();
+        state.output += fmt::format("#line {} \"{}\"\n", segment.includeLine + 1, name);
+    }
+    return true;
+}
+} // namespace huan::runtime
@@ -0,0 +1,109 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/shader/shader_resource_io.hpp"
+
+#include <unordered_map>
+
+#include "huan/backend/shader.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+// On-disk record of a ShaderResource, the name lives in the string table after the records
+struct PackedShaderResource
+{
+    uint32_t stage;
+    uint8_t type;
+    uint8_t mode;
+    uint8_t vecSize;
+    uint8_t columns;
+    uint32_t set;
+    uint32_t binding;
+    uint32_t location;
+    uint32_t inputAttachmentIndex;
+    uint32_t arraySize;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t constantID;
+    uint32_t qualifiers;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+static_assert(sizeof(PackedShaderResource) == 52 && std::is_trivially_copyable_v<PackedShaderResource>);
+} // namespace
+
+void writeShaderResources(utils::BinaryWriter& writer, const std::vector<vulkan::ShaderResource>& resources)
+{
+    std::vector<PackedShaderResource> records;
+    records.reserve(resources.size());
+    std::string stringTable;
+    // Stages reflect the same names (interface blocks, shared bindings), each is stored once
+    std::unordered_map<std::string_view, uint32_t> nameOffsets;
+    for (const auto& resource : resources)
+    {
+        const auto [it, inserted] =
+            nameOffsets.try_emplace(resource.name, static_cast<uint32_t>(stringTable.size()));
+        if (inserted)
+            stringTable += resource.name;
+
+        records.push_back({static_cast<uint32_t>(resource.stage),
+                           static_cast<uint8_t>(resource.type),
+                           static_cast<uint8_t>(resource.mode),
+                           static_cast<uint8_t>(resource.vecSize),
+                           static_cast<uint8_t>(resource.columns),
+                           resource.set,
+                           resource.binding,
+                           resource.location,
+                           resource.inputAttachmentIndex,
+                           resource.arraySize,
+                           resource.offset,
+                           resource.size,
+                           resource.constantID,
+                           resource.qualifiers,
+                           it->second,
+                           static_cast<uint32_t>(resource.name.size())});
+    }
+
+    writer.writeVector(records);
+    writer.writeString(stringTable);
+}
+
+bool readShaderResources(utils::BinaryReader& reader, std::vector<vulkan::ShaderResource>& resources)
+{
+    std::vector<PackedShaderResource> records;
+    std::string stringTable;
+    if (!reader.readVector(records) || !reader.readString(stringTable))
+        return false;
+
+    resources.clear();
+    resources.reserve(records.size());
+    for (const auto& record : records)
+    {
+        if (record.type > static_cast<uint8_t>(vulkan::ShaderResourceType::All) ||
+            record.mode > static_cast<uint8_t>(vulkan::ShaderResourceMode::UpdateAfterBind) ||
+            record.nameOffset > stringTable.size() || stringTable.size() - record.nameOffset < record.nameLength)
+        {
+            return false;
+        }
+        auto& resource = resources.emplace_back();
+        resource.stage = vk::ShaderStageFlags(record.stage);
+        resource.type = static_cast<vulkan::ShaderResourceType>(record.type);
+        resource.mode = static_cast<vulkan::ShaderResourceMode>(record.mode);
+        resource.set = record.set;
+        resource.binding = record.binding;
+        resource.location = record.location;
+        resource.inputAttachmentIndex = record.inputAttachmentIndex;
+        resource.vecSize = record.vecSize;
+        resource.columns = record.columns;
+        resource.arraySize = record.arraySize;
+        resource.offset = record.offset;
+        resource.size = record.size;
+        resource.constantID = record.constantID;
+        resource.qualifiers = record.qualifiers;
+        resource.name.assign(stringTable, record.nameOffset, record.nameLength);
+    }
+    return true;
+}
+} // namespace huan::runtime
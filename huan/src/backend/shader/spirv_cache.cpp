@@ -0,0 +1,160 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/shader/spirv_cache.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include "huan/backend/shader.hpp"
+#include "huan/backend/shader/glsl_compiler.hpp"
+#include "huan/backend/shader/shader_resource_io.hpp"
+#include "huan/backend/shader/spirv_optimizer.hpp"
+#include "huan/log/Log.hpp"
+#include "huan/settings.hpp"
+#include "huan/utils/binary_stream.hpp"
+#include "huan/utils/file_system.hpp"
+#include "huan/utils/hash.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+constexpr uint32_t CacheMagic = 0x43565053; // "SPVC"
+// Bump whenever the layout below or the reflection output changes
+constexpr uint32_t CacheFormatVersion = 4;
+
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    // Hash of everything after the header
+    uint64_t payloadHash;
+};
+} // namespace
+
+SPIRVCache::SPIRVCache()
+    : m_directory(globalAppSettings.shaderCacheDirectory), m_enabled(globalAppSettings.isShaderCacheEnabled)
+{
+}
+
+uint64_t SPIRVCache::computeKey(vk::ShaderStageFlagBits stage, std::string_view preprocessedSource,
+                                std::string_view entryPoint, const vulkan::ShaderVariant& variant)
+{
+    utils::Hasher hasher;
+    hasher.add(CacheFormatVersion)
+          .add(GLSLCompiler::getCompilerVersion())
+          .add(static_cast<uint32_t>(GLSLCompiler::getTargetLanguage()))
+          .add(static_cast<uint32_t>(GLSLCompiler::getTargetLanguageVersion()))
+          .add(SPIRVOptimizer::isEnabled())
+          .add(SPIRVOptimizer::isStripEnabled())
+          .add(static_cast<uint32_t>(stage))
+          .add(entryPoint)
+          .add(preprocessedSource)
+          .add(variant.getPreamble());
+    hasher.add(static_cast<uint64_t>(variant.getProcesses().size()));
+    for (const auto& process : variant.getProcesses())
+    {
+        hasher.add(process);
+    }
+
+    // Runtime array sizes end up in the reflected resources, in a stable order
+    std::vector<std::pair<std::string_view, size_t>> arraySizes(variant.getRuntimeArraySizes().begin(),
+                                                                variant.getRuntimeArraySizes().end());
+    std::ranges::sort(arraySizes);
+    for (const auto& [name, size] : arraySizes)
+    {
+        hasher.add(name).add(static_cast<uint64_t>(size));
+    }
+    for (const auto& [constantID, value] : variant.getSpecializationConstants())
+    {
+        hasher.add(constantID).add(value);
+    }
+    return hasher.get();
+}
+
+bool SPIRVCache::load(uint64_t key, std::vector<uint32_t>& spirv, std::vector<vulkan::ShaderResource>& resources)
+{
+    if (!m_enabled)
+        return false;
+
+    std::vector<char> data;
+    if (!FileSystem::tryLoadBytes(getEntryPath(key).string(), data))
+    {
+        ++m_misses;
+        return false;
+    }
+
+    // Payload: SPIR-V words, then the reflected resources
+    utils::BinaryReader reader(data.data(), data.size());
+    CacheHeader header{};
+    std::vector<uint32_t> cachedSpirv;
+    std::vector<vulkan::ShaderResource> cachedResources;
+    if (!reader.read(header) || header.magic != CacheMagic || header.version != CacheFormatVersion ||
+        header.key != key || header.payloadHash != utils::hash64(data.data() + sizeof(CacheHeader),
+                                                                 data.size() - sizeof(CacheHeader)) ||
+        !reader.readVector(cachedSpirv) || !readShaderResources(reader, cachedResources) || !reader.isAtEnd())
+    {
+        HUAN_CORE_WARN("[SPIRVCache]: Ignoring invalid entry {:016x}", key)
+        ++m_rejected;
+        return false;
+    }
+
+    spirv = std::move(cachedSpirv);
+    resources = std::move(cachedResources);
+    ++m_hits;
+    return true;
+}
+
+bool SPIRVCache::store(uint64_t key, const std::vector<uint32_t>& spirv,
+                       const std::vector<vulkan::ShaderResource>& resources)
+{
+    if (!m_enabled)
+        return false;
+
+    utils::BinaryWriter payload;
+    payload.writeVector(spirv);
+    writeShaderResources(payload, resources);
+    const CacheHeader header{CacheMagic, CacheFormatVersion, key,
+                             utils::hash64(payload.getData().data(), payload.getSize())};
+
+    utils::BinaryWriter file;
+    file.write(header);
+    file.write(payload.getData().data(), payload.getSize());
+    if (!FileSystem::writeFileAtomic(getEntryPath(key).string(), file.getData().data(), file.getSize()))
+        return false;
+    ++m_stores;
+    return true;
+}
+
+void SPIRVCache::setDirectory(const std::filesystem::path& directory)
+{
+    m_directory = directory;
+}
+
+const std::filesystem::path& SPIRVCache::getDirectory() const
+{
+    return m_directory;
+}
+
+void SPIRVCache::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool SPIRVCache::isEnabled() const
+{
+    return m_enabled;
+}
+
+SPIRVCache::Stats SPIRVCache::getStats() const
+{
+    return {m_hits.load(), m_misses.load(), m_stores.load(), m_rejected.load()};
+}
+
+std::filesystem::path SPIRVCache::getEntryPath(uint64_t key) const
+{
+    return m_directory / std::format("{:016x}.spvc", key);
+}
+} // namespace huan::runtime
@@ -0,0 +1,167 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/backend/shader/spirv_optimizer.hpp"
+
+#include <chrono>
+#include <mutex>
+
+#ifdef HUAN_ENABLE_SPIRV_OPT
+#include <spirv-tools/optimizer.hpp>
+
+#include "huan/backend/shader/glsl_compiler.hpp"
+#endif
+#include "huan/backend/shader.hpp"
+#include "huan/log/Log.hpp"
+
+namespace huan::runtime
+{
+namespace
+{
+std::mutex s_statsMutex;
+SPIRVOptimizer::Stats s_stats;
+
+#ifdef HUAN_ENABLE_SPIRV_OPT
+// The SPIR-V version glslang was asked to emit
+spv_target_env getTargetEnv()
+{
+    if (GLSLCompiler::getTargetLanguage() == glslang::EShTargetNone)
+        return SPV_ENV_UNIVERSAL_1_0;
+    switch (GLSLCompiler::getTargetLanguageVersion())
+    {
+    case glslang::EShTargetSpv_1_1:
+        return SPV_ENV_UNIVERSAL_1_1;
+    case glslang::EShTargetSpv_1_2:
+        return SPV_ENV_UNIVERSAL_1_2;
+    case glslang::EShTargetSpv_1_3:
+        return SPV_ENV_UNIVERSAL_1_3;
+    case glslang::EShTargetSpv_1_4:
+        return SPV_ENV_UNIVERSAL_1_4;
+    case glslang::EShTargetSpv_1_5:
+        return SPV_ENV_UNIVERSAL_1_5;
+    case glslang::EShTargetSpv_1_6:
+        return SPV_ENV_UNIVERSAL_1_6;
+    default:
+        return SPV_ENV_UNIVERSAL_1_0;
+    }
+}
+
+bool run(spvtools::Optimizer& optimizer, std::vector<uint32_t>& spirv, std::string& infoLog)
+{
+    optimizer.SetMessageConsumer(
+        [&infoLog](spv_message_level_t, const char*, const spv_position_t& position, const char* message) {
+            infoLog += fmt::format("spirv-opt: {} (word {})\n", message, position.index);
+        });
+
+    spvtools::OptimizerOptions options;
+    // Unused bindings stay, layouts are shared between variants; unfrozen constants stay specializable
+    options.set_preserve_bindings(true);
+    options.set_preserve_spec_constants(true);
+
+    std::vector<uint32_t> output;
+    if (!optimizer.Run(spirv.data(), spirv.size(), &output, options))
+        return false;
+    spirv = std::move(output);
+    return true;
+}
+#endif
+} // namespace
+
+bool SPIRVOptimizer::isAvailable()
+{
+#ifdef HUAN_ENABLE_SPIRV_OPT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SPIRVOptimizer::setEnabled(bool enabled)
+{
+    if (enabled && !isAvailable())
+        HUAN_CORE_WARN("[SPIRVOptimizer]: Built without HUAN_ENABLE_SPIRV_OPT, SPIR-V won't be optimized")
+    s_enabled = enabled;
+}
+
+bool SPIRVOptimizer::isEnabled()
+{
+    return s_enabled && isAvailable();
+}
+
+void SPIRVOptimizer::setStripEnabled(bool enabled)
+{
+    if (enabled && !isAvailable())
+        HUAN_CORE_WARN("[SPIRVOptimizer]: Built without HUAN_ENABLE_SPIRV_OPT, SPIR-V won't be stripped")
+    s_stripEnabled = enabled;
+}
+
+bool SPIRVOptimizer::isStripEnabled()
+{
+    return s_stripEnabled && isAvailable();
+}
+
+bool SPIRVOptimizer::optimize(std::vector<uint32_t>& spirv, const vulkan::ShaderVariant& variant,
+                              std::string& infoLog)
+{
+#ifdef HUAN_ENABLE_SPIRV_OPT
+    const auto begin = std::chrono::steady_clock::now();
+    const size_t sizeIn = spirv.size() * sizeof(uint32_t);
+
+    spvtools::Optimizer optimizer(getTargetEnv());
+    if (!variant.getSpecializationConstants().empty())
+    {
+        // Baked as constants, then folded like any other by the performance passes
+        std::unordered_map<uint32_t, std::vector<uint32_t>> values;
+        for (const auto& [constantID, value] : variant.getSpecializationConstants())
+        {
+            values[constantID] = {value};
+        }
+        optimizer.RegisterPass(spvtools::CreateSetSpecConstantDefaultValuePass(values))
+                 .RegisterPass(spvtools::CreateFreezeSpecConstantValuePass());
+    }
+    optimizer.RegisterPerformancePasses();
+    if (!run(optimizer, spirv, infoLog))
+        return false;
+
+    const double milliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::lock_guard lock(s_statsMutex);
+    ++s_stats.optimizedCount;
+    s_stats.bytesIn += sizeIn;
+    s_stats.bytesOut += spirv.size() * sizeof(uint32_t);
+    s_stats.optimizeMilliseconds += milliseconds;
+    return true;
+#else
+    (void)spirv;
+    (void)variant;
+    (void)infoLog;
+    return true;
+#endif
+}
+
+bool SPIRVOptimizer::strip(std::vector<uint32_t>& spirv, std::string& infoLog)
+{
+#ifdef HUAN_ENABLE_SPIRV_OPT
+    const size_t sizeIn = spirv.size() * sizeof(uint32_t);
+    spvtools::Optimizer optimizer(getTargetEnv());
+    optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+    if (!run(optimizer, spirv, infoLog))
+        return false;
+
+    std::lock_guard lock(s_statsMutex);
+    ++s_stats.strippedCount;
+    s_stats.strippedBytes += sizeIn - spirv.size() * sizeof(uint32_t);
+    return true;
+#else
+    (void)spirv;
+    (void)infoLog;
+    return true;
+#endif
+}
+
+SPIRVOptimizer::Stats SPIRVOptimizer::getStats()
+{
+    std::lock_guard lock(s_statsMutex);
+    return s_stats;
+}
+} // namespace huan::runtime
@@ -217,7 +217,8 @@ void readShaderResource<vulkan::ShaderResourceType::ImageSampler>(const spirv_cr
                                                                   const vulkan::ShaderVariant& variant,
                                                                   std::vector<vulkan::ShaderResource>& shaderResources)
 {
-    for (const auto& resource : compiler.get_shader_resources().separate_samplers)
+    // Combined image samplers (sampler2D...), separate samplers are ShaderResourceType::Sampler
+    for (const auto& resource : compiler.get_shader_resources().sampled_images)
     {
         vulkan::ShaderResource shaderResource{};
         shaderResource.type = vulkan::ShaderResourceType::ImageSampler;
@@ -230,6 +231,25 @@ void readShaderResource<vulkan::ShaderResourceType::ImageSampler>(const spirv_cr
     }
 }
 
+template <>
+void readShaderResource<vulkan::ShaderResourceType::Sampler>(const spirv_cross::Compiler& compiler,
+                                                             vk::ShaderStageFlagBits stage,
+                                                             const vulkan::ShaderVariant& variant,
+                                                             std::vector<vulkan::ShaderResource>& shaderResources)
+{
+    for (const auto& resource : compiler.get_shader_resources().separate_samplers)
+    {
+        vulkan::ShaderResource shaderResource{};
+        shaderResource.type = vulkan::ShaderResourceType::Sampler;
+        shaderResource.stage = stage;
+        shaderResource.name = resource.name;
+        readResourceArraySize(compiler, resource, variant, shaderResource);
+        readResourceDecoration<spv::DecorationDescriptorSet>(compiler, resource, variant, shaderResource);
+        readResourceDecoration<spv::DecorationBinding>(compiler, resource, variant, shaderResource);
+        shaderResources.push_back(shaderResource);
+    }
+}
+
 template <>
 void readShaderResource<vulkan::ShaderResourceType::ImageStorage>(const spirv_cross::Compiler& compiler,
                                                                   vk::ShaderStageFlagBits stage,
@@ -319,6 +339,7 @@ void SPIRVReflection::parseShaderResources(const spirv_cross::Compiler& compiler
     readShaderResource<vulkan::ShaderResourceType::Image>(compiler, stage, variant, shaderResources);
     readShaderResource<vulkan::ShaderResourceType::ImageSampler>(compiler, stage, variant, shaderResources);
     readShaderResource<vulkan::ShaderResourceType::ImageStorage>(compiler, stage, variant, shaderResources);
+    readShaderResource<vulkan::ShaderResourceType::Sampler>(compiler, stage, variant, shaderResources);
 
     readShaderResource<vulkan::ShaderResourceType::BufferUniform>(compiler, stage, variant, shaderResources);
     readShaderResource<vulkan::ShaderResourceType::BufferStorage>(compiler, stage, variant, shaderResources);
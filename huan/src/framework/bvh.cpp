@@ -0,0 +1,834 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/scene_framework/bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+#include "huan/log/Log.hpp"
+#include "huan/utils/simd.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::framework::scene_graph
+{
+using utils::Float4;
+
+namespace
+{
+constexpr uint32_t BinCount = 12;
+// Below it a subtree isn't worth a task of its own
+constexpr uint32_t MinSubtreeSize = 1024;
+// Marks a traversal stack entry whose subtree is fully inside the query
+constexpr uint32_t InsideFlag = 0x80000000u;
+
+bool contains(const BoundingBox& outer, const BoundingBox& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+float getSquaredDistance(const BoundingBox& box, const glm::vec3& point)
+{
+    const glm::vec3 delta = glm::max(box.min - point, glm::vec3(0.0f)) + glm::max(point - box.max, glm::vec3(0.0f));
+    return glm::dot(delta, delta);
+}
+
+// 1 / direction, huge instead of infinite so that 0 * it stays a number
+glm::vec3 getSafeInverse(const glm::vec3& direction)
+{
+    glm::vec3 result;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float value = direction[axis];
+        result[axis] = std::abs(value) > 1e-20f ? 1.0f / value : std::copysign(1e20f, value);
+    }
+    return result;
+}
+
+bool intersectRay(const BoundingBox& box, const glm::vec3& origin, const glm::vec3& inverseDirection,
+                  float maxDistance, float& distance)
+{
+    const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    distance = enter;
+    return enter <= exit && !box.isEmpty();
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+} // namespace
+
+struct SceneBVH::BuildContext
+{
+    // Permuted in place, concurrent builds own disjoint ranges
+    std::vector<ObjectID>& objects;
+    // By ObjectID
+    const std::vector<glm::vec3>& centroids;
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+
+    // Children left to another task, whose slot is filled once it's done
+    struct Subtree
+    {
+        uint32_t node;
+        uint32_t slot;
+        uint32_t first;
+        uint32_t last;
+        uint32_t depth;
+    };
+    // Null to build all the subtrees in place
+    std::vector<Subtree>* subtrees = nullptr;
+    uint32_t subtreeSize = 0;
+};
+
+SceneBVH::ObjectID SceneBVH::insert(const BoundingBox& bounds, uint32_t userData)
+{
+    ObjectID object;
+    if (!m_freeObjects.empty())
+    {
+        object = m_freeObjects.back();
+        m_freeObjects.pop_back();
+        m_bounds[object] = bounds;
+        m_userData[object] = userData;
+    }
+    else
+    {
+        object = static_cast<ObjectID>(m_bounds.size());
+        m_bounds.push_back(bounds);
+        m_userData.push_back(userData);
+        m_objectLocations.push_back(InvalidIndex);
+    }
+    ++m_objectCount;
+    ++m_insertedCount;
+    if (!insertInTree(object))
+        pushOverflow(object);
+    return object;
+}
+
+void SceneBVH::remove(ObjectID object)
+{
+    if (!isValid(object))
+        return;
+    const uint32_t location = m_objectLocations[object];
+    if ((location & OverflowFlag) != 0)
+    {
+        const uint32_t position = location & ~OverflowFlag;
+        m_overflow[position] = m_overflow.back();
+        m_objectLocations[m_overflow[position]] = OverflowFlag | position;
+        m_overflow.pop_back();
+    }
+    else
+    {
+        removeFromLeaf(object, location);
+    }
+    m_objectLocations[object] = InvalidIndex;
+    m_freeObjects.push_back(object);
+    --m_objectCount;
+}
+
+void SceneBVH::update(ObjectID object, const BoundingBox& bounds)
+{
+    // A removed object has no location, and its slot may be handed out again by insert()
+    if (!isValid(object))
+    {
+        HUAN_CORE_ERROR("[SceneBVH]: Update of object {}, which isn't in the tree", object)
+        return;
+    }
+    m_bounds[object] = bounds;
+    const uint32_t location = m_objectLocations[object];
+    if ((location & OverflowFlag) != 0)
+        return;
+    const Leaf& leaf = m_leaves[location];
+    growToFit(leaf.node, leaf.slot, bounds);
+    markDirty(leaf.node);
+}
+
+void SceneBVH::clear()
+{
+    m_bounds.clear();
+    m_userData.clear();
+    m_objectLocations.clear();
+    m_freeObjects.clear();
+    m_objectCount = 0;
+    m_nodes.clear();
+    m_leaves.clear();
+    m_dirtyNodes.clear();
+    m_overflow.clear();
+    m_builtObjectCount = 0;
+    m_insertedCount = 0;
+    m_hasDirtyNodes = false;
+    m_stats = {};
+}
+
+void SceneBVH::build(utils::ThreadPool* workers)
+{
+    const auto begin = std::chrono::steady_clock::now();
+
+    std::vector<ObjectID> objects;
+    objects.reserve(m_objectCount);
+    std::vector<glm::vec3> centroids(m_bounds.size());
+    for (ObjectID object = 0; object < m_bounds.size(); ++object)
+    {
+        if (m_objectLocations[object] == InvalidIndex)
+            continue;
+        objects.push_back(object);
+        centroids[object] = m_bounds[object].getCenter();
+    }
+    const auto objectCount = static_cast<uint32_t>(objects.size());
+
+    std::vector<BuildContext::Subtree> subtrees;
+    BuildContext context{objects, centroids};
+    if (workers != nullptr && objectCount >= 2 * MinSubtreeSize)
+    {
+        // A few subtrees per worker, so that uneven ones even out
+        context.subtrees = &subtrees;
+        context.subtreeSize = std::max(MinSubtreeSize, objectCount / ((workers->getThreadCount() + 1) * 4));
+    }
+    context.nodes.emplace_back().parent = InvalidIndex;
+    buildNode(context, 0, objectCount, 0, 0);
+    m_nodes = std::move(context.nodes);
+    m_leaves = std::move(context.leaves);
+
+    if (!subtrees.empty())
+    {
+        std::vector<std::pair<std::vector<Node>, std::vector<Leaf>>> results(subtrees.size());
+        workers->parallelFor(subtrees.size(), 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const auto& subtree = subtrees[i];
+                BuildContext subtreeContext{objects, centroids};
+                subtreeContext.nodes.emplace_back().parent = InvalidIndex;
+                buildNode(subtreeContext, subtree.first, subtree.last, 0, subtree.depth);
+                results[i] = {std::move(subtreeContext.nodes), std::move(subtreeContext.leaves)};
+            }
+        });
+
+        // Appended after the top of the tree, parents still come before their children
+        for (size_t i = 0; i < subtrees.size(); ++i)
+        {
+            const auto nodeOffset = static_cast<uint32_t>(m_nodes.size());
+            const auto leafOffset = static_cast<uint32_t>(m_leaves.size());
+            for (Node node : results[i].first)
+            {
+                for (uint32_t& child : node.children)
+                {
+                    if (child == InvalidIndex)
+                        continue;
+                    child = (child & LeafFlag) != 0 ? ((child & ~LeafFlag) + leafOffset) | LeafFlag : child + nodeOffset;
+                }
+                node.parent = node.parent == InvalidIndex ? subtrees[i].node : node.parent + nodeOffset;
+                m_nodes.push_back(node);
+            }
+            for (Leaf leaf : results[i].second)
+            {
+                leaf.node += nodeOffset;
+                m_leaves.push_back(leaf);
+            }
+            m_nodes[subtrees[i].node].children[subtrees[i].slot] = nodeOffset;
+        }
+    }
+
+    m_overflow.clear();
+    for (uint32_t leafIndex = 0; leafIndex < m_leaves.size(); ++leafIndex)
+    {
+        const Leaf& leaf = m_leaves[leafIndex];
+        for (uint32_t i = 0; i < leaf.count; ++i)
+        {
+            m_objectLocations[leaf.objects[i]] = leafIndex;
+        }
+    }
+    m_dirtyNodes.assign(m_nodes.size(), 0);
+    m_hasDirtyNodes = false;
+    m_builtObjectCount = objectCount;
+    m_insertedCount = 0;
+
+    // Parents come first, one pass finds every depth
+    std::vector<uint32_t> depths(m_nodes.size(), 1);
+    m_stats.depth = 1;
+    for (uint32_t i = 1; i < m_nodes.size(); ++i)
+    {
+        depths[i] = depths[m_nodes[i].parent] + 1;
+        m_stats.depth = std::max(m_stats.depth, depths[i]);
+    }
+    m_stats.buildMilliseconds = millisecondsSince(begin);
+}
+
+void SceneBVH::refit()
+{
+    if (!m_hasDirtyNodes)
+        return;
+    const auto begin = std::chrono::steady_clock::now();
+    // Children come after their parent, walking backwards refits them first
+    for (size_t i = m_nodes.size(); i-- > 0;)
+    {
+        if (m_dirtyNodes[i] == 0)
+            continue;
+        Node& node = m_nodes[i];
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            const uint32_t child = node.children[slot];
+            if (child == InvalidIndex)
+                continue;
+            if ((child & LeafFlag) != 0)
+            {
+                setSlot(node, slot, getLeafBounds(m_leaves[child & ~LeafFlag]));
+                continue;
+            }
+            BoundingBox bounds;
+            for (uint32_t childSlot = 0; childSlot < 4; ++childSlot)
+            {
+                bounds.merge(getSlot(m_nodes[child], childSlot));
+            }
+            setSlot(node, slot, bounds);
+        }
+        m_dirtyNodes[i] = 0;
+    }
+    m_hasDirtyNodes = false;
+    m_stats.refitMilliseconds = millisecondsSince(begin);
+}
+
+bool SceneBVH::needsRebuild() const
+{
+    return m_insertedCount > std::max<size_t>(64, m_builtObjectCount / 4);
+}
+
+bool SceneBVH::isValid(ObjectID object) const
+{
+    return object < m_objectLocations.size() && m_objectLocations[object] != InvalidIndex;
+}
+
+const BoundingBox& SceneBVH::getBounds(ObjectID object) const
+{
+    return m_bounds[object];
+}
+
+uint32_t SceneBVH::getUserData(ObjectID object) const
+{
+    return m_userData[object];
+}
+
+SceneBVH::Stats SceneBVH::getStats() const
+{
+    Stats stats = m_stats;
+    stats.objectCount = static_cast<uint32_t>(m_objectCount);
+    stats.nodeCount = static_cast<uint32_t>(m_nodes.size());
+    stats.leafCount = static_cast<uint32_t>(m_leaves.size());
+    stats.overflowCount = static_cast<uint32_t>(m_overflow.size());
+    return stats;
+}
+
+template <class NodeTest, class ObjectTest>
+void SceneBVH::traverse(NodeTest&& nodeTest, ObjectTest&& objectTest) const
+{
+    if (!m_nodes.empty())
+    {
+        uint32_t stack[TraversalStackSize];
+        uint32_t stackSize = 0;
+        // Only used once the inserts made the tree deeper than the stack, until the next build
+        std::vector<uint32_t> overflowStack;
+        stack[stackSize++] = 0;
+        while (stackSize > 0 || !overflowStack.empty())
+        {
+            uint32_t entry;
+            if (!overflowStack.empty())
+            {
+                entry = overflowStack.back();
+                overflowStack.pop_back();
+            }
+            else
+            {
+                entry = stack[--stackSize];
+            }
+            const Node& node = m_nodes[entry & ~InsideFlag];
+            int insideMask = 0xF;
+            int hitMask = 0xF;
+            if ((entry & InsideFlag) == 0)
+            {
+                insideMask = 0;
+                hitMask = nodeTest(node, insideMask);
+            }
+            for (uint32_t slot = 0; slot < 4; ++slot)
+            {
+                const uint32_t child = node.children[slot];
+                if ((hitMask & (1 << slot)) == 0 || child == InvalidIndex)
+                    continue;
+                const bool isInside = (insideMask & (1 << slot)) != 0;
+                if ((child & LeafFlag) != 0)
+                {
+                    const Leaf& leaf = m_leaves[child & ~LeafFlag];
+                    for (uint32_t i = 0; i < leaf.count; ++i)
+                    {
+                        objectTest(leaf.objects[i], isInside);
+                    }
+                    continue;
+                }
+                // 3 more entries per level at most, and a built tree is at most MaxSAHDepth + log4(objects) deep.
+                // The nodes insert() splits off only add one pending entry per level, but nothing bounds the tree
+                // a long run of inserts and removes leaves until the next build.
+                const uint32_t childEntry = child | (isInside ? InsideFlag : 0);
+                if (stackSize < TraversalStackSize)
+                    stack[stackSize++] = childEntry;
+                else
+                    overflowStack.push_back(childEntry);
+            }
+        }
+    }
+    for (const ObjectID object : m_overflow)
+    {
+        objectTest(object, false);
+    }
+}
+void SceneBVH::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& userData) const
+{
+    traverse(
+        [&frustum](const Node& node, int& insideMask) {
+            const Float4 half = Float4::broadcast(0.5f);
+            const Float4 minX = Float4::load(node.minX);
+            const Float4 minY = Float4::load(node.minY);
+            const Float4 minZ = Float4::load(node.minZ);
+            const Float4 maxX = Float4::load(node.maxX);
+            const Float4 maxY = Float4::load(node.maxY);
+            const Float4 maxZ = Float4::load(node.maxZ);
+            const Float4 centerX = (minX + maxX) * half;
+            const Float4 centerY = (minY + maxY) * half;
+            const Float4 centerZ = (minZ + maxZ) * half;
+            const Float4 extentX = (maxX - minX) * half;
+            const Float4 extentY = (maxY - minY) * half;
+            const Float4 extentZ = (maxZ - minZ) * half;
+            const Float4 zero = Float4::broadcast(0.0f);
+
+            int outsideMask = 0;
+            insideMask = 0xF;
+            for (const auto& plane : frustum.planes)
+            {
+                const Float4 distance = Float4::broadcast(plane.x) * centerX + Float4::broadcast(plane.y) * centerY +
+                                        Float4::broadcast(plane.z) * centerZ + Float4::broadcast(plane.w);
+                const Float4 radius = Float4::broadcast(std::abs(plane.x)) * extentX +
+                                      Float4::broadcast(std::abs(plane.y)) * extentY +
+                                      Float4::broadcast(std::abs(plane.z)) * extentZ;
+                outsideMask |= utils::lessThan(distance + radius, zero);
+                insideMask &= utils::greaterEqual(distance - radius, zero);
+            }
+            const int hitMask = ~outsideMask & 0xF;
+            insideMask &= hitMask;
+            return hitMask;
+        },
+        [&](ObjectID object, bool isInside) {
+            if (isInside || frustum.intersects(m_bounds[object]))
+                userData.push_back(m_userData[object]);
+        });
+}
+
+void SceneBVH::queryBox(const BoundingBox& box, std::vector<uint32_t>& userData) const
+{
+    traverse(
+        [&box](const Node& node, int&) {
+            return utils::lessEqual(Float4::load(node.minX), Float4::broadcast(box.max.x)) &
+                   utils::lessEqual(Float4::load(node.minY), Float4::broadcast(box.max.y)) &
+                   utils::lessEqual(Float4::load(node.minZ), Float4::broadcast(box.max.z)) &
+                   utils::greaterEqual(Float4::load(node.maxX), Float4::broadcast(box.min.x)) &
+                   utils::greaterEqual(Float4::load(node.maxY), Float4::broadcast(box.min.y)) &
+                   utils::greaterEqual(Float4::load(node.maxZ), Float4::broadcast(box.min.z));
+        },
+        [&](ObjectID object, bool) {
+            if (m_bounds[object].overlaps(box))
+                userData.push_back(m_userData[object]);
+        });
+}
+
+void SceneBVH::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& userData) const
+{
+    const float squaredRadius = radius * radius;
+    traverse(
+        [&](const Node& node, int&) {
+            // Distance to the closest point of each box
+            const Float4 x = Float4::broadcast(center.x);
+            const Float4 y = Float4::broadcast(center.y);
+            const Float4 z = Float4::broadcast(center.z);
+            const Float4 dx = utils::vmax(utils::vmin(x, Float4::load(node.maxX)), Float4::load(node.minX)) - x;
+            const Float4 dy = utils::vmax(utils::vmin(y, Float4::load(node.maxY)), Float4::load(node.minY)) - y;
+            const Float4 dz = utils::vmax(utils::vmin(z, Float4::load(node.maxZ)), Float4::load(node.minZ)) - z;
+            return utils::lessEqual(dx * dx + dy * dy + dz * dz, Float4::broadcast(squaredRadius));
+        },
+        [&](ObjectID object, bool) {
+            if (getSquaredDistance(m_bounds[object], center) <= squaredRadius)
+                userData.push_back(m_userData[object]);
+        });
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    const glm::vec3 inverseDirection = getSafeInverse(direction);
+    float closest = maxDistance;
+    ObjectID closestObject = InvalidObject;
+    traverse(
+        [&](const Node& node, int&) {
+            const Float4 minX = Float4::load(node.minX);
+            const Float4 maxX = Float4::load(node.maxX);
+            const Float4 originX = Float4::broadcast(origin.x);
+            const Float4 originY = Float4::broadcast(origin.y);
+            const Float4 originZ = Float4::broadcast(origin.z);
+            const Float4 inverseX = Float4::broadcast(inverseDirection.x);
+            const Float4 inverseY = Float4::broadcast(inverseDirection.y);
+            const Float4 inverseZ = Float4::broadcast(inverseDirection.z);
+            const Float4 t0X = (minX - originX) * inverseX;
+            const Float4 t1X = (maxX - originX) * inverseX;
+            const Float4 t0Y = (Float4::load(node.minY) - originY) * inverseY;
+            const Float4 t1Y = (Float4::load(node.maxY) - originY) * inverseY;
+            const Float4 t0Z = (Float4::load(node.minZ) - originZ) * inverseZ;
+            const Float4 t1Z = (Float4::load(node.maxZ) - originZ) * inverseZ;
+            const Float4 enter = utils::vmax(utils::vmax(utils::vmin(t0X, t1X), utils::vmin(t0Y, t1Y)),
+                                             utils::vmax(utils::vmin(t0Z, t1Z), Float4::broadcast(0.0f)));
+            const Float4 exit = utils::vmin(utils::vmin(utils::vmax(t0X, t1X), utils::vmax(t0Y, t1Y)),
+                                            utils::vmin(utils::vmax(t0Z, t1Z), Float4::broadcast(closest)));
+            // Empty slots have min > max, which the slabs alone would take for the whole line
+            return utils::lessEqual(enter, exit) & utils::lessEqual(minX, maxX);
+        },
+        [&](ObjectID object, bool) {
+            float distance;
+            if (intersectRay(m_bounds[object], origin, inverseDirection, closest, distance) &&
+                (closestObject == InvalidObject || distance < closest))
+            {
+                closest = distance;
+                closestObject = object;
+            }
+        });
+
+    if (closestObject == InvalidObject)
+        return false;
+    hit.object = closestObject;
+    hit.userData = m_userData[closestObject];
+    hit.distance = closest;
+    return true;
+}
+
+void SceneBVH::setSlot(Node& node, uint32_t slot, const BoundingBox& bounds)
+{
+    node.minX[slot] = bounds.min.x;
+    node.minY[slot] = bounds.min.y;
+    node.minZ[slot] = bounds.min.z;
+    node.maxX[slot] = bounds.max.x;
+    node.maxY[slot] = bounds.max.y;
+    node.maxZ[slot] = bounds.max.z;
+}
+
+BoundingBox SceneBVH::getSlot(const Node& node, uint32_t slot)
+{
+    return {{node.minX[slot], node.minY[slot], node.minZ[slot]}, {node.maxX[slot], node.maxY[slot], node.maxZ[slot]}};
+}
+
+void SceneBVH::buildNode(BuildContext& context, uint32_t first, uint32_t last, uint32_t nodeIndex,
+                         uint32_t depth) const
+{
+    // Split the largest range until there are 4, or only leaves
+    std::array<std::pair<uint32_t, uint32_t>, 4> ranges{};
+    ranges[0] = {first, last};
+    uint32_t rangeCount = 1;
+    while (rangeCount < 4)
+    {
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < rangeCount; ++i)
+        {
+            if (ranges[i].second - ranges[i].first > ranges[largest].second - ranges[largest].first)
+                largest = i;
+        }
+        auto& range = ranges[largest];
+        if (range.second - range.first <= LeafCapacity)
+            break;
+        const uint32_t middle = splitRange(context, range.first, range.second, depth >= MaxSAHDepth);
+        ranges[rangeCount++] = {middle, range.second};
+        range.second = middle;
+    }
+
+    for (uint32_t slot = 0; slot < 4; ++slot)
+    {
+        if (slot >= rangeCount)
+        {
+            context.nodes[nodeIndex].children[slot] = InvalidIndex;
+            setSlot(context.nodes[nodeIndex], slot, BoundingBox{});
+            continue;
+        }
+        const auto [rangeFirst, rangeLast] = ranges[slot];
+        setSlot(context.nodes[nodeIndex], slot, getRangeBounds(context, rangeFirst, rangeLast));
+
+        const uint32_t count = rangeLast - rangeFirst;
+        if (count <= LeafCapacity)
+        {
+            Leaf leaf{};
+            std::copy(context.objects.begin() + rangeFirst, context.objects.begin() + rangeLast, leaf.objects);
+            leaf.count = count;
+            leaf.node = nodeIndex;
+            leaf.slot = slot;
+            context.nodes[nodeIndex].children[slot] = static_cast<uint32_t>(context.leaves.size()) | LeafFlag;
+            context.leaves.push_back(leaf);
+        }
+        else if (context.subtrees != nullptr && count <= context.subtreeSize)
+        {
+            context.nodes[nodeIndex].children[slot] = InvalidIndex;
+            context.subtrees->push_back({nodeIndex, slot, rangeFirst, rangeLast, depth + 1});
+        }
+        else
+        {
+            const auto child = static_cast<uint32_t>(context.nodes.size());
+            context.nodes.emplace_back().parent = nodeIndex;
+            context.nodes[nodeIndex].children[slot] = child;
+            buildNode(context, rangeFirst, rangeLast, child, depth + 1);
+        }
+    }
+}
+
+uint32_t SceneBVH::splitRange(BuildContext& context, uint32_t first, uint32_t last, bool isMedianSplit) const
+{
+    const auto objects = context.objects.begin();
+    const uint32_t median = first + (last - first) / 2;
+    BoundingBox centroidBounds;
+    for (uint32_t i = first; i < last; ++i)
+    {
+        centroidBounds.merge(context.centroids[objects[i]]);
+    }
+    const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+
+    const auto splitAtMedian = [&]() {
+        int axis = 0;
+        if (extent.y > extent[axis])
+            axis = 1;
+        if (extent.z > extent[axis])
+            axis = 2;
+        std::nth_element(objects + first, objects + median, objects + last, [&](ObjectID a, ObjectID b) {
+            return context.centroids[a][axis] < context.centroids[b][axis];
+        });
+        return median;
+    };
+    if (isMedianSplit)
+        return splitAtMedian();
+
+    // Cost of each split between bins: area * count on both sides
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    uint32_t bestSplit = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.0f)
+            continue;
+        const float scale = BinCount / extent[axis];
+        const float origin = centroidBounds.min[axis];
+        std::array<BoundingBox, BinCount> binBounds{};
+        std::array<uint32_t, BinCount> binCounts{};
+        for (uint32_t i = first; i < last; ++i)
+        {
+            const auto bin = std::min(static_cast<uint32_t>((context.centroids[objects[i]][axis] - origin) * scale),
+                                      BinCount - 1);
+            binBounds[bin].merge(m_bounds[objects[i]]);
+            ++binCounts[bin];
+        }
+
+        std::array<float, BinCount - 1> rightCosts{};
+        BoundingBox right;
+        uint32_t rightCount = 0;
+        for (uint32_t bin = BinCount - 1; bin > 0; --bin)
+        {
+            right.merge(binBounds[bin]);
+            rightCount += binCounts[bin];
+            rightCosts[bin - 1] = right.getSurfaceArea() * static_cast<float>(rightCount);
+        }
+        BoundingBox left;
+        uint32_t leftCount = 0;
+        for (uint32_t split = 1; split < BinCount; ++split)
+        {
+            left.merge(binBounds[split - 1]);
+            leftCount += binCounts[split - 1];
+            const float cost = left.getSurfaceArea() * static_cast<float>(leftCount) + rightCosts[split - 1];
+            if (leftCount > 0 && leftCount < last - first && cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+    if (bestAxis < 0)
+        return splitAtMedian();
+
+    const float scale = BinCount / extent[bestAxis];
+    const float origin = centroidBounds.min[bestAxis];
+    const auto middle = std::partition(objects + first, objects + last, [&](ObjectID object) {
+        const auto bin =
+            std::min(static_cast<uint32_t>((context.centroids[object][bestAxis] - origin) * scale), BinCount - 1);
+        return bin < bestSplit;
+    });
+    return static_cast<uint32_t>(middle - context.objects.begin());
+}
+
+BoundingBox SceneBVH::getRangeBounds(const BuildContext& context, uint32_t first, uint32_t last) const
+{
+    BoundingBox bounds;
+    for (uint32_t i = first; i < last; ++i)
+    {
+        bounds.merge(m_bounds[context.objects[i]]);
+    }
+    return bounds;
+}
+
+BoundingBox SceneBVH::getLeafBounds(const Leaf& leaf) const
+{
+    BoundingBox bounds;
+    for (uint32_t i = 0; i < leaf.count; ++i)
+    {
+        bounds.merge(m_bounds[leaf.objects[i]]);
+    }
+    return bounds;
+}
+
+void SceneBVH::growToFit(uint32_t nodeIndex, uint32_t slot, const BoundingBox& bounds)
+{
+    while (true)
+    {
+        Node& node = m_nodes[nodeIndex];
+        BoundingBox slotBounds = getSlot(node, slot);
+        // The ancestors contain the slot, so they contain the bounds already
+        if (contains(slotBounds, bounds))
+            return;
+        slotBounds.merge(bounds);
+        setSlot(node, slot, slotBounds);
+
+        const uint32_t parent = node.parent;
+        if (parent == InvalidIndex)
+            return;
+        slot = static_cast<uint32_t>(std::find(m_nodes[parent].children, m_nodes[parent].children + 4, nodeIndex) -
+                                     m_nodes[parent].children);
+        nodeIndex = parent;
+    }
+}
+
+void SceneBVH::markDirty(uint32_t nodeIndex)
+{
+    // A dirty node has dirty ancestors already
+    while (nodeIndex != InvalidIndex && m_dirtyNodes[nodeIndex] == 0)
+    {
+        m_dirtyNodes[nodeIndex] = 1;
+        nodeIndex = m_nodes[nodeIndex].parent;
+    }
+    m_hasDirtyNodes = true;
+}
+
+bool SceneBVH::insertInTree(ObjectID object)
+{
+    if (m_nodes.empty())
+        return false;
+    const BoundingBox& bounds = m_bounds[object];
+
+    uint32_t nodeIndex = 0;
+    uint32_t depth = 1;
+    while (true)
+    {
+        Node& node = m_nodes[nodeIndex];
+        // The child growing the least, preferring those with room, and a free slot to put a new leaf in
+        uint32_t bestSlot = InvalidIndex;
+        uint32_t freeSlot = InvalidIndex;
+        bool isBestFull = true;
+        float bestGrowth = std::numeric_limits<float>::max();
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            const uint32_t child = node.children[slot];
+            if (child == InvalidIndex)
+            {
+                freeSlot = slot;
+                continue;
+            }
+            const bool isFull = (child & LeafFlag) != 0 && m_leaves[child & ~LeafFlag].count == LeafCapacity;
+            const BoundingBox slotBounds = getSlot(node, slot);
+            BoundingBox grown = slotBounds;
+            grown.merge(bounds);
+            const float growth = grown.getSurfaceArea() - slotBounds.getSurfaceArea();
+            if ((isBestFull && !isFull) || (isBestFull == isFull && growth < bestGrowth))
+            {
+                bestGrowth = growth;
+                bestSlot = slot;
+                isBestFull = isFull;
+            }
+        }
+
+        if (bestSlot == InvalidIndex || (isBestFull && freeSlot != InvalidIndex))
+        {
+            addLeaf(object, nodeIndex, freeSlot);
+            return true;
+        }
+        const uint32_t child = node.children[bestSlot];
+        if ((child & LeafFlag) == 0)
+        {
+            nodeIndex = child;
+            ++depth;
+            continue;
+        }
+        if (!isBestFull)
+        {
+            Leaf& leaf = m_leaves[child & ~LeafFlag];
+            leaf.objects[leaf.count++] = object;
+            m_objectLocations[object] = child & ~LeafFlag;
+            growToFit(nodeIndex, bestSlot, bounds);
+            return true;
+        }
+
+        // Every child is a full leaf: one becomes a node holding it and a new leaf. Appended, the new node still
+        // comes after its parent.
+        const auto splitIndex = static_cast<uint32_t>(m_nodes.size());
+        Node& split = m_nodes.emplace_back();
+        split.parent = nodeIndex;
+        for (uint32_t slot = 0; slot < 4; ++slot)
+        {
+            split.children[slot] = InvalidIndex;
+            setSlot(split, slot, BoundingBox{});
+        }
+        Leaf& fullLeaf = m_leaves[child & ~LeafFlag];
+        setSlot(split, 0, getSlot(m_nodes[nodeIndex], bestSlot));
+        split.children[0] = child;
+        fullLeaf.node = splitIndex;
+        fullLeaf.slot = 0;
+        m_nodes[nodeIndex].children[bestSlot] = splitIndex;
+        m_dirtyNodes.push_back(0);
+        m_stats.depth = std::max(m_stats.depth, depth + 1);
+        addLeaf(object, splitIndex, 1);
+        return true;
+    }
+}
+
+void SceneBVH::addLeaf(ObjectID object, uint32_t nodeIndex, uint32_t slot)
+{
+    const auto leafIndex = static_cast<uint32_t>(m_leaves.size());
+    Leaf& leaf = m_leaves.emplace_back();
+    leaf.objects[0] = object;
+    leaf.count = 1;
+    leaf.node = nodeIndex;
+    leaf.slot = slot;
+    m_nodes[nodeIndex].children[slot] = leafIndex | LeafFlag;
+    m_objectLocations[object] = leafIndex;
+    growToFit(nodeIndex, slot, m_bounds[object]);
+}
+
+void SceneBVH::removeFromLeaf(ObjectID object, uint32_t leafIndex)
+{
+    Leaf& leaf = m_leaves[leafIndex];
+    auto* const end = leaf.objects + leaf.count;
+    auto* const it = std::find(leaf.objects, end, object);
+    *it = *(end - 1);
+    --leaf.count;
+    // Until then the bounds are too large, which queries don't mind
+    markDirty(leaf.node);
+}
+
+void SceneBVH::pushOverflow(ObjectID object)
+{
+    m_objectLocations[object] = OverflowFlag | static_cast<uint32_t>(m_overflow.size());
+    m_overflow.push_back(object);
+}
+
+} // namespace huan::framework::scene_graph
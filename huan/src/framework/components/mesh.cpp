@@ -37,6 +37,10 @@ void Mesh::addNode(Node& node)
 {
     m_nodes.push_back(&node);
 }
+void Mesh::removeNode(const Node& node)
+{
+    std::erase(m_nodes, &node);
+}
 const std::vector<Node*>& Mesh::getNodes() const
 {
     return m_nodes;
@@ -3,18 +3,90 @@
 //
 
 #include "huan/scene_framework/components/sub_mesh.hpp"
-#include "huan/backend/resource/vulkan_buffer.hpp"
 
 namespace huan::framework::scene_graph
 {
 SubMesh::SubMesh(const std::string& name) : Component(name)
 {
 }
+
+SubMesh::~SubMesh()
+{
+    releaseGeometry();
+}
+
 std::type_index SubMesh::getType() const
 {
     return typeid(SubMesh);
 }
 
+bool SubMesh::setGeometry(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride,
+                          const uint32_t* indexData, uint32_t indexCount)
+{
+    releaseGeometry();
+    auto* arena = runtime::GeometryArena::getInstance();
+    m_vertexAllocation = arena->allocateVertices(vertexCount, vertexStride, vertexData);
+    m_indexAllocation = arena->allocateIndices(indexCount, indexData);
+    if (!m_vertexAllocation.isValid() || !m_indexAllocation.isValid())
+    {
+        releaseGeometry();
+        return false;
+    }
+    m_indexType = runtime::GeometryArena::IndexType;
+    m_indexOffset = m_indexAllocation.offset;
+    m_verticesCount = vertexCount;
+    m_vertexIndices = indexCount;
+    return true;
+}
+
+void SubMesh::releaseGeometry()
+{
+    if (!m_vertexAllocation.isValid() && !m_indexAllocation.isValid())
+        return;
+    auto* arena = runtime::GeometryArena::getInstance();
+    arena->freeVertices(m_vertexAllocation);
+    arena->freeIndices(m_indexAllocation);
+    m_indexOffset = 0;
+    m_verticesCount = 0;
+    m_vertexIndices = 0;
+}
+
+uint32_t SubMesh::getFirstIndex() const
+{
+    return m_indexAllocation.getFirstElement();
+}
+
+int32_t SubMesh::getVertexOffset() const
+{
+    return static_cast<int32_t>(m_vertexAllocation.getFirstElement());
+}
+
+uint32_t SubMesh::getIndexCount() const
+{
+    return m_vertexIndices;
+}
+
+void SubMesh::setOccluderGeometry(std::vector<glm::vec3> positions, std::vector<uint32_t> indices)
+{
+    m_occluderPositions = std::move(positions);
+    m_occluderIndices = std::move(indices);
+}
+
+bool SubMesh::isOccluder() const
+{
+    return !m_occluderIndices.empty();
+}
+
+const std::vector<glm::vec3>& SubMesh::getOccluderPositions() const
+{
+    return m_occluderPositions;
+}
+
+const std::vector<uint32_t>& SubMesh::getOccluderIndices() const
+{
+    return m_occluderIndices;
+}
+
 void SubMesh::setAttribute(const std::string& name, const VertexAttribute& attribute)
 {
     m_vertexAttributes[name] = attribute;
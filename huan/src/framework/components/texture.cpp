@@ -3,8 +3,6 @@
 //
 
 #include "huan/scene_framework/components/texture.hpp"
-#include "huan/backend/resource/vulkan_image.hpp"
-#include "huan/backend/resource/sampler.hpp"
 
 namespace huan::framework::scene_graph {
 
@@ -22,18 +20,23 @@ std::type_index Texture::getType() const
     return typeid(Texture);
 }
 
-void Texture::setImage(runtime::vulkan::Image* image)
+void Texture::setImage(runtime::ImageHandle image)
 {
-    m_image = createScope<runtime::vulkan::Image>(std::move(*image));
+    m_image = image;
 }
 
-runtime::vulkan::Image* Texture::getImage() const
+runtime::ImageHandle Texture::getImage() const
 {
-    return m_image.get();
+    return m_image;
 }
 
-void Texture::setSampler(runtime::vulkan::Sampler sampler)
+void Texture::setSampler(runtime::SamplerHandle sampler)
 {
-    m_sampler = createScope<runtime::vulkan::Sampler>(std::move(sampler));
+    m_sampler = sampler;
+}
+
+runtime::SamplerHandle Texture::getSampler() const
+{
+    return m_sampler;
 }
 } // namespace huan::framework
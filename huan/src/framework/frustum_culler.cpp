@@ -0,0 +1,221 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/scene_framework/frustum_culler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "huan/scene_framework/components/sub_mesh.hpp"
+#include "huan/scene_framework/occlusion_culler.hpp"
+#include "huan/utils/simd.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::framework::scene_graph
+{
+namespace
+{
+#ifdef HUAN_SIMD_AVX2
+using Lanes = utils::Float8;
+#else
+using Lanes = utils::Float4;
+#endif
+// The arrays are padded to the widest lanes whatever the build uses
+constexpr uint32_t PaddingWidth = 8;
+static_assert(PaddingWidth % Lanes::Width == 0);
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+} // namespace
+
+DrawItem DrawItem::fromSubMesh(const SubMesh& subMesh, uint32_t transform)
+{
+    DrawItem draw;
+    draw.subMesh = &subMesh;
+    draw.indexCount = subMesh.getIndexCount();
+    draw.firstIndex = subMesh.getFirstIndex();
+    draw.vertexOffset = subMesh.getVertexOffset();
+    draw.transform = transform;
+    return draw;
+}
+
+uint32_t FrustumCuller::add(const BoundingBox& worldBounds, const DrawItem& draw)
+{
+    const auto index = static_cast<uint32_t>(m_draws.size());
+    if (index == m_centerX.size())
+    {
+        // Negative extents put the padding outside of every plane
+        const size_t paddedSize = m_centerX.size() + PaddingWidth;
+        m_centerX.resize(paddedSize, 0.0f);
+        m_centerY.resize(paddedSize, 0.0f);
+        m_centerZ.resize(paddedSize, 0.0f);
+        m_extentX.resize(paddedSize, std::numeric_limits<float>::lowest());
+        m_extentY.resize(paddedSize, std::numeric_limits<float>::lowest());
+        m_extentZ.resize(paddedSize, std::numeric_limits<float>::lowest());
+    }
+    m_draws.push_back(draw);
+    setBounds(index, worldBounds);
+    return index;
+}
+
+void FrustumCuller::setBounds(uint32_t index, const BoundingBox& worldBounds)
+{
+    const glm::vec3 center = worldBounds.getCenter();
+    const glm::vec3 extents = worldBounds.getExtents();
+    m_centerX[index] = center.x;
+    m_centerY[index] = center.y;
+    m_centerZ[index] = center.z;
+    m_extentX[index] = extents.x;
+    m_extentY[index] = extents.y;
+    m_extentZ[index] = extents.z;
+}
+
+BoundingBox FrustumCuller::getBounds(uint32_t index) const
+{
+    const glm::vec3 center(m_centerX[index], m_centerY[index], m_centerZ[index]);
+    const glm::vec3 extents(m_extentX[index], m_extentY[index], m_extentZ[index]);
+    return {center - extents, center + extents};
+}
+
+void FrustumCuller::clear()
+{
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_extentX.clear();
+    m_extentY.clear();
+    m_extentZ.clear();
+    m_draws.clear();
+}
+
+void FrustumCuller::reserve(size_t count)
+{
+    const size_t paddedCount = (count + PaddingWidth - 1) / PaddingWidth * PaddingWidth;
+    m_centerX.reserve(paddedCount);
+    m_centerY.reserve(paddedCount);
+    m_centerZ.reserve(paddedCount);
+    m_extentX.reserve(paddedCount);
+    m_extentY.reserve(paddedCount);
+    m_extentZ.reserve(paddedCount);
+    m_draws.reserve(count);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<DrawItem>& visible, utils::ThreadPool* workers,
+                         const OcclusionCuller* occlusion)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    visible.clear();
+
+    const size_t paddedCount = m_centerX.size();
+    const size_t blockCount = (paddedCount + BlockSize - 1) / BlockSize;
+    m_visibleIndices.resize(paddedCount);
+    m_blockVisibleCounts.resize(blockCount);
+    m_blockOccludedCounts.resize(blockCount);
+    if (occlusion != nullptr && !occlusion->hasOccluders())
+        occlusion = nullptr;
+    if (workers != nullptr && blockCount > 1)
+    {
+        workers->parallelFor(blockCount, 1, [&](size_t firstBlock, size_t lastBlock) {
+            cullBlocks(frustum, occlusion, firstBlock, lastBlock);
+        });
+    }
+    else
+    {
+        cullBlocks(frustum, occlusion, 0, blockCount);
+    }
+
+    // In block order, so in the order of the boxes
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+        const uint32_t* indices = m_visibleIndices.data() + block * BlockSize;
+        for (uint32_t i = 0; i < m_blockVisibleCounts[block]; ++i)
+        {
+            visible.push_back(m_draws[indices[i]]);
+        }
+    }
+
+    m_stats.testedCount = static_cast<uint32_t>(m_draws.size());
+    m_stats.visibleCount = static_cast<uint32_t>(visible.size());
+    m_stats.occludedCount = 0;
+    for (const uint32_t occludedCount : m_blockOccludedCounts)
+    {
+        m_stats.occludedCount += occludedCount;
+    }
+    m_stats.cullMilliseconds = millisecondsSince(begin);
+}
+
+void FrustumCuller::cullBlocks(const Frustum& frustum, const OcclusionCuller* occlusion, size_t firstBlock,
+                               size_t lastBlock)
+{
+    // Same terms as Frustum::intersects(): center distance plus the extents projected on the normal
+    Lanes normalX[Frustum::PlaneCount];
+    Lanes normalY[Frustum::PlaneCount];
+    Lanes normalZ[Frustum::PlaneCount];
+    Lanes absNormalX[Frustum::PlaneCount];
+    Lanes absNormalY[Frustum::PlaneCount];
+    Lanes absNormalZ[Frustum::PlaneCount];
+    Lanes distance[Frustum::PlaneCount];
+    for (int plane = 0; plane < Frustum::PlaneCount; ++plane)
+    {
+        const glm::vec4& p = frustum.planes[plane];
+        normalX[plane] = Lanes::broadcast(p.x);
+        normalY[plane] = Lanes::broadcast(p.y);
+        normalZ[plane] = Lanes::broadcast(p.z);
+        absNormalX[plane] = Lanes::broadcast(std::abs(p.x));
+        absNormalY[plane] = Lanes::broadcast(std::abs(p.y));
+        absNormalZ[plane] = Lanes::broadcast(std::abs(p.z));
+        distance[plane] = Lanes::broadcast(p.w);
+    }
+    const Lanes zero = Lanes::broadcast(0.0f);
+    constexpr int AllLanes = (1 << Lanes::Width) - 1;
+
+    for (size_t block = firstBlock; block < lastBlock; ++block)
+    {
+        const size_t first = block * BlockSize;
+        // The padding lanes are loaded but only the groups holding a real box are tested
+        const size_t last = std::min(first + BlockSize, m_draws.size());
+        uint32_t* indices = m_visibleIndices.data() + first;
+        uint32_t visibleCount = 0;
+        uint32_t occludedCount = 0;
+        for (size_t i = first; i < last; i += Lanes::Width)
+        {
+            const Lanes centerX = Lanes::load(m_centerX.data() + i);
+            const Lanes centerY = Lanes::load(m_centerY.data() + i);
+            const Lanes centerZ = Lanes::load(m_centerZ.data() + i);
+            const Lanes extentX = Lanes::load(m_extentX.data() + i);
+            const Lanes extentY = Lanes::load(m_extentY.data() + i);
+            const Lanes extentZ = Lanes::load(m_extentZ.data() + i);
+            int mask = AllLanes;
+            for (int plane = 0; plane < Frustum::PlaneCount; ++plane)
+            {
+                const Lanes centerDistance =
+                    normalX[plane] * centerX + normalY[plane] * centerY + normalZ[plane] * centerZ + distance[plane];
+                const Lanes radius = absNormalX[plane] * extentX + absNormalY[plane] * extentY +
+                                     absNormalZ[plane] * extentZ;
+                mask &= greaterEqual(centerDistance + radius, zero);
+            }
+            // The padding is outside of any real frustum, not of degenerate ones. i < last, so 0 < last - i
+            if (i + Lanes::Width > last)
+                mask &= (1 << (last - i)) - 1;
+            while (mask != 0)
+            {
+                const auto index = static_cast<uint32_t>(i) + std::countr_zero(static_cast<unsigned>(mask));
+                mask &= mask - 1;
+                if (occlusion != nullptr && !occlusion->isVisible(getBounds(index)))
+                {
+                    ++occludedCount;
+                    continue;
+                }
+                indices[visibleCount++] = index;
+            }
+        }
+        m_blockVisibleCounts[block] = visibleCount;
+        m_blockOccludedCounts[block] = occludedCount;
+    }
+}
+} // namespace huan::framework::scene_graph
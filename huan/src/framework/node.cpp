@@ -19,11 +19,21 @@ size_t Node::getId() const
     return m_id;
 }
 
-std::string Node::getName() const
+const std::string& Node::getName() const
+{
+    return m_name.str();
+}
+
+utils::InternedString Node::getInternedName() const
 {
     return m_name;
 }
 
+void Node::setName(std::string_view name)
+{
+    m_name = utils::InternedString(name);
+}
+
 void Node::setParent(Node* parent)
 {
     m_parent = parent;
@@ -39,11 +49,36 @@ void Node::addChild(Node* child)
     m_children.push_back(child);
 }
 
+void Node::removeChild(Node* child)
+{
+    std::erase(m_children, child);
+}
+
 const std::vector<Node*>& Node::getChildren() const
 {
     return m_children;
 }
 
+void Node::setTransform(TransformID transform)
+{
+    m_transform = transform;
+}
+
+TransformID Node::getTransform() const
+{
+    return m_transform;
+}
+
+void Node::setEntity(Entity entity)
+{
+    m_entity = entity;
+}
+
+Entity Node::getEntity() const
+{
+    return m_entity;
+}
+
 void Node::setComponent(Component* component)
 {
     auto it = m_components.find(component->getType());
@@ -0,0 +1,356 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/scene_framework/occlusion_culler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "huan/utils/simd.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::framework::scene_graph
+{
+namespace
+{
+#ifdef HUAN_SIMD_AVX2
+using Lanes = utils::Float8;
+#else
+using Lanes = utils::Float4;
+#endif
+static_assert(OcclusionCuller::TileWidth % Lanes::Width == 0);
+
+constexpr uint32_t TileCount = OcclusionCuller::TilesX * OcclusionCuller::TilesY;
+// Lets the occludee test load a full group of lanes at the end of the last row
+constexpr uint32_t TilePadding = 8;
+constexpr uint32_t FullCoverage = 0xFFFFFFFFu;
+// Vertices nearer than this to the camera plane aren't projected, their triangles aren't rasterized
+constexpr float MinClipW = 1e-4f;
+// Beyond it in pixels the edge functions lose too much precision, the triangle isn't rasterized
+constexpr float GuardBand = 16.0f * OcclusionCuller::Width;
+// Rows of tiles rasterized by one task
+constexpr uint32_t RowGrainSize = 4;
+
+// Centers of the pixels of a tile row, relative to the tile
+alignas(32) constexpr float PixelCenters[OcclusionCuller::TileWidth] = {0.5f, 1.5f, 2.5f, 3.5f,
+                                                                        4.5f, 5.5f, 6.5f, 7.5f};
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Screen space position in pixels and NDC depth
+glm::vec3 toScreen(const glm::vec4& clip)
+{
+    const float inverseW = 1.0f / clip.w;
+    return {(clip.x * inverseW * 0.5f + 0.5f) * OcclusionCuller::Width,
+            (clip.y * inverseW * 0.5f + 0.5f) * OcclusionCuller::Height, clip.z * inverseW};
+}
+
+int32_t toTile(float pixel, uint32_t tileSize, uint32_t tileCount)
+{
+    const auto tile = static_cast<int32_t>(std::floor(pixel / static_cast<float>(tileSize)));
+    return std::clamp(tile, 0, static_cast<int32_t>(tileCount) - 1);
+}
+} // namespace
+
+OcclusionCuller::OcclusionCuller()
+    : m_tileDepths(TileCount + TilePadding, 1.0f),
+      m_layerDepths(TileCount, 0.0f),
+      m_layerMasks(TileCount, 0)
+{
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_occluders.clear();
+    // Nothing drawn is the far plane
+    std::fill(m_tileDepths.begin(), m_tileDepths.end(), 1.0f);
+    std::fill(m_layerDepths.begin(), m_layerDepths.end(), 0.0f);
+    std::fill(m_layerMasks.begin(), m_layerMasks.end(), 0);
+    m_stats = {};
+}
+
+void OcclusionCuller::addOccluder(const glm::mat4& world, std::span<const glm::vec3> positions,
+                                  std::span<const uint32_t> indices)
+{
+    Occluder occluder;
+    occluder.world = world;
+    occluder.positions = positions;
+    occluder.indices = indices;
+    occluder.firstVertex = m_occluders.empty() ? 0 : m_occluders.back().firstVertex +
+                                                         static_cast<uint32_t>(m_occluders.back().positions.size());
+    occluder.firstTriangle = m_occluders.empty() ? 0 : m_occluders.back().firstTriangle +
+                                                           static_cast<uint32_t>(m_occluders.back().indices.size() / 3);
+    m_occluders.push_back(occluder);
+}
+
+void OcclusionCuller::rasterize(utils::ThreadPool* workers)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    if (m_occluders.empty())
+        return;
+
+    const Occluder& last = m_occluders.back();
+    m_clipVertices.resize(last.firstVertex + last.positions.size());
+    m_triangles.resize(last.firstTriangle + last.indices.size() / 3);
+    // Every occluder and every row of tiles writes its own range, the order of the tasks doesn't matter
+    if (workers != nullptr)
+    {
+        workers->parallelFor(m_occluders.size(), 1, [this](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                setupOccluder(m_occluders[i]);
+            }
+        });
+        workers->parallelFor(TilesY, RowGrainSize, [this](size_t firstRow, size_t lastRow) {
+            rasterizeRows(static_cast<uint32_t>(firstRow), static_cast<uint32_t>(lastRow));
+        });
+    }
+    else
+    {
+        for (const auto& occluder : m_occluders)
+        {
+            setupOccluder(occluder);
+        }
+        rasterizeRows(0, TilesY);
+    }
+
+    m_stats.occluderCount = static_cast<uint32_t>(m_occluders.size());
+    m_stats.triangleCount = static_cast<uint32_t>(m_triangles.size());
+    m_stats.rasterizedCount =
+        static_cast<uint32_t>(std::count_if(m_triangles.begin(), m_triangles.end(), [](const Triangle& triangle) {
+            return triangle.minTileX <= triangle.maxTileX;
+        }));
+    m_stats.rasterMilliseconds = millisecondsSince(begin);
+}
+
+void OcclusionCuller::setupOccluder(const Occluder& occluder)
+{
+    const glm::mat4 transform = m_viewProjection * occluder.world;
+    glm::vec4* clipVertices = m_clipVertices.data() + occluder.firstVertex;
+    for (size_t i = 0; i < occluder.positions.size(); ++i)
+    {
+        clipVertices[i] = transform * glm::vec4(occluder.positions[i], 1.0f);
+    }
+
+    const auto vertexCount = static_cast<uint32_t>(occluder.positions.size());
+    for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3)
+    {
+        Triangle& triangle = m_triangles[occluder.firstTriangle + i / 3];
+        // Not rasterized unless set up to the end
+        triangle.minTileX = triangle.minTileY = 0;
+        triangle.maxTileX = triangle.maxTileY = -1;
+
+        glm::vec3 vertices[3];
+        bool isProjectable = true;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const uint32_t index = occluder.indices[i + corner];
+            if (index >= vertexCount || clipVertices[index].w < MinClipW)
+            {
+                isProjectable = false;
+                break;
+            }
+            vertices[corner] = toScreen(clipVertices[index]);
+            if (std::abs(vertices[corner].x) > GuardBand || std::abs(vertices[corner].y) > GuardBand)
+                isProjectable = false;
+        }
+        if (!isProjectable)
+            continue;
+
+        float area = (vertices[1].x - vertices[0].x) * (vertices[2].y - vertices[0].y) -
+                     (vertices[2].x - vertices[0].x) * (vertices[1].y - vertices[0].y);
+        if (std::abs(area) < 1e-6f)
+            continue;
+        // Both faces are rasterized, turn them counterclockwise
+        if (area < 0.0f)
+        {
+            std::swap(vertices[1], vertices[2]);
+            area = -area;
+        }
+
+        const float minX = std::min({vertices[0].x, vertices[1].x, vertices[2].x});
+        const float maxX = std::max({vertices[0].x, vertices[1].x, vertices[2].x});
+        const float minY = std::min({vertices[0].y, vertices[1].y, vertices[2].y});
+        const float maxY = std::max({vertices[0].y, vertices[1].y, vertices[2].y});
+        if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(Width) || minY >= static_cast<float>(Height))
+            continue;
+
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            const glm::vec3& a = vertices[edge];
+            const glm::vec3& b = vertices[(edge + 1) % 3];
+            // The same anchor whatever the direction: a neighbour sharing the edge gets the exact opposite function
+            const glm::vec3& anchor = a.x < b.x || (a.x == b.x && a.y < b.y) ? a : b;
+            triangle.edgeA[edge] = a.y - b.y;
+            triangle.edgeB[edge] = b.x - a.x;
+            triangle.edgeC[edge] = -(triangle.edgeA[edge] * anchor.x + triangle.edgeB[edge] * anchor.y);
+            // Fill rule: pixels on an edge belong to exactly one of the triangles sharing it
+            triangle.isEdgeInclusive[edge] =
+                triangle.edgeA[edge] > 0.0f || (triangle.edgeA[edge] == 0.0f && triangle.edgeB[edge] > 0.0f);
+        }
+        const glm::vec3 delta1 = vertices[1] - vertices[0];
+        const glm::vec3 delta2 = vertices[2] - vertices[0];
+        triangle.depthA = (delta1.z * delta2.y - delta2.z * delta1.y) / area;
+        triangle.depthB = (delta2.z * delta1.x - delta1.z * delta2.x) / area;
+        triangle.depthC = vertices[0].z - triangle.depthA * vertices[0].x - triangle.depthB * vertices[0].y;
+        triangle.minDepth = std::min({vertices[0].z, vertices[1].z, vertices[2].z});
+        triangle.maxDepth = std::max({vertices[0].z, vertices[1].z, vertices[2].z});
+        triangle.minTileX = toTile(minX, TileWidth, TilesX);
+        triangle.maxTileX = toTile(maxX, TileWidth, TilesX);
+        triangle.minTileY = toTile(minY, TileHeight, TilesY);
+        triangle.maxTileY = toTile(maxY, TileHeight, TilesY);
+    }
+}
+
+void OcclusionCuller::rasterizeRows(uint32_t firstRow, uint32_t lastRow)
+{
+    const Lanes zero = Lanes::broadcast(0.0f);
+    constexpr int AllLanes = (1 << Lanes::Width) - 1;
+    Lanes pixelCenters[TileWidth / Lanes::Width];
+    for (uint32_t group = 0; group < TileWidth / Lanes::Width; ++group)
+    {
+        pixelCenters[group] = Lanes::load(PixelCenters + group * Lanes::Width);
+    }
+
+    // In the order of the occluders, what makes the result independent of the split
+    for (const Triangle& triangle : m_triangles)
+    {
+        const int32_t minTileY = std::max(triangle.minTileY, static_cast<int32_t>(firstRow));
+        const int32_t maxTileY = std::min(triangle.maxTileY, static_cast<int32_t>(lastRow) - 1);
+        if (minTileY > maxTileY)
+            continue;
+
+        Lanes edgeA[3];
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            edgeA[edge] = Lanes::broadcast(triangle.edgeA[edge]);
+        }
+        for (int32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+        {
+            const float top = static_cast<float>(tileY * TileHeight) + 0.5f;
+            const float bottom = top + static_cast<float>(TileHeight - 1);
+            for (int32_t tileX = triangle.minTileX; tileX <= triangle.maxTileX; ++tileX)
+            {
+                const float left = static_cast<float>(tileX * TileWidth) + 0.5f;
+                const float right = left + static_cast<float>(TileWidth - 1);
+
+                // Skip the tiles whose pixel centers are all outside of an edge
+                bool isOutside = false;
+                for (int edge = 0; edge < 3 && !isOutside; ++edge)
+                {
+                    const float a = triangle.edgeA[edge];
+                    const float b = triangle.edgeB[edge];
+                    isOutside = a * (a > 0.0f ? right : left) + b * (b > 0.0f ? bottom : top) + triangle.edgeC[edge] <
+                                0.0f;
+                }
+                if (isOutside)
+                    continue;
+
+                uint32_t coverage = 0;
+                const Lanes tileLeft = Lanes::broadcast(static_cast<float>(tileX * TileWidth));
+                for (uint32_t row = 0; row < TileHeight; ++row)
+                {
+                    const float y = top + static_cast<float>(row);
+                    Lanes rowBase[3];
+                    for (int edge = 0; edge < 3; ++edge)
+                    {
+                        rowBase[edge] = Lanes::broadcast(triangle.edgeB[edge] * y + triangle.edgeC[edge]);
+                    }
+                    for (uint32_t group = 0; group < TileWidth / Lanes::Width; ++group)
+                    {
+                        const Lanes x = tileLeft + pixelCenters[group];
+                        int inside = AllLanes;
+                        for (int edge = 0; edge < 3; ++edge)
+                        {
+                            const Lanes value = edgeA[edge] * x + rowBase[edge];
+                            inside &= triangle.isEdgeInclusive[edge] ? greaterEqual(value, zero)
+                                                                     : lessThan(zero, value);
+                        }
+                        coverage |= static_cast<uint32_t>(inside) << (row * TileWidth + group * Lanes::Width);
+                    }
+                }
+                if (coverage == 0)
+                    continue;
+
+                // The farthest depth of the triangle over the tile: the plane at its farthest corner
+                const float cornerDepth = triangle.depthA * (triangle.depthA > 0.0f ? right : left) +
+                                          triangle.depthB * (triangle.depthB > 0.0f ? bottom : top) +
+                                          triangle.depthC;
+                updateTile(tileY * TilesX + tileX, coverage, std::min(cornerDepth, triangle.maxDepth));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::updateTile(uint32_t tile, uint32_t coverage, float depth)
+{
+    float& tileDepth = m_tileDepths[tile];
+    if (depth >= tileDepth)
+        return;
+    float& layerDepth = m_layerDepths[tile];
+    uint32_t& layerMask = m_layerMasks[tile];
+    // Merging a triangle much nearer than the layer would push it back to the layer's depth, it starts a new one
+    if (layerDepth - depth > tileDepth - layerDepth)
+    {
+        layerDepth = 0.0f;
+        layerMask = 0;
+    }
+    layerDepth = std::max(layerDepth, depth);
+    layerMask |= coverage;
+    if (layerMask == FullCoverage)
+    {
+        tileDepth = layerDepth;
+        layerDepth = 0.0f;
+        layerMask = 0;
+    }
+}
+
+bool OcclusionCuller::isVisible(const BoundingBox& worldBounds) const
+{
+    if (worldBounds.isEmpty())
+        return false;
+
+    glm::vec3 screenMin(std::numeric_limits<float>::max());
+    glm::vec3 screenMax(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 position((corner & 1) != 0 ? worldBounds.max.x : worldBounds.min.x,
+                                 (corner & 2) != 0 ? worldBounds.max.y : worldBounds.min.y,
+                                 (corner & 4) != 0 ? worldBounds.max.z : worldBounds.min.z);
+        const glm::vec4 clip = m_viewProjection * glm::vec4(position, 1.0f);
+        // Crosses the camera plane
+        if (clip.w < MinClipW)
+            return true;
+        const glm::vec3 screen = toScreen(clip);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+    }
+    if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= static_cast<float>(Width) ||
+        screenMin.y >= static_cast<float>(Height))
+        return false;
+
+    const int32_t minTileX = toTile(screenMin.x, TileWidth, TilesX);
+    const int32_t maxTileX = toTile(screenMax.x, TileWidth, TilesX);
+    const int32_t minTileY = toTile(screenMin.y, TileHeight, TilesY);
+    const int32_t maxTileY = toTile(screenMax.y, TileHeight, TilesY);
+    const Lanes nearest = Lanes::broadcast(screenMin.z);
+    for (int32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+    {
+        const float* row = m_tileDepths.data() + tileY * TilesX;
+        for (int32_t tileX = minTileX; tileX <= maxTileX; tileX += Lanes::Width)
+        {
+            int mask = lessThan(nearest, Lanes::load(row + tileX));
+            if (maxTileX - tileX + 1 < Lanes::Width)
+                mask &= (1 << (maxTileX - tileX + 1)) - 1;
+            if (mask != 0)
+                return true;
+        }
+    }
+    return false;
+}
+} // namespace huan::framework::scene_graph
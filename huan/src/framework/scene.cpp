@@ -6,10 +6,14 @@
 #include "huan/log/Log.hpp"
 #include "huan/scene_framework/scene.hpp"
 
-#include <queue>
+#include <algorithm>
 
 #include "huan/scene_framework/component.hpp"
+#include "huan/scene_framework/frustum_culler.hpp"
 #include "huan/scene_framework/node.hpp"
+#include "huan/scene_framework/occlusion_culler.hpp"
+#include "huan/scene_framework/components/mesh.hpp"
+#include "huan/scene_framework/components/mesh_instance.hpp"
 
 namespace huan::framework::scene_graph
 {
@@ -37,12 +41,97 @@ void Scene::setNodes(std::vector<Node*> nodes)
 
 void Scene::addNode(Scope<Node>&& node)
 {
+    if (node->getTransform() == InvalidTransformID)
+    {
+        const Node* parent = node->getParent();
+        node->setTransform(m_transforms.create(parent != nullptr ? parent->getTransform() : InvalidTransformID));
+    }
+    if (!m_freeEntities.empty())
+    {
+        node->setEntity(m_freeEntities.back());
+        m_freeEntities.pop_back();
+        m_entityNodes[node->getEntity()] = node.get();
+    }
+    else
+    {
+        node->setEntity(static_cast<Entity>(m_entityNodes.size()));
+        m_entityNodes.push_back(node.get());
+    }
+    m_nameIndex[node->getInternedName().view()].push_back(node.get());
     m_nodes.emplace_back(std::move(node));
 }
 
+void Scene::removeNode(Node& node)
+{
+    // The TransformSystem reparents the children transforms the same way
+    Node* parent = node.getParent();
+    for (Node* child : node.getChildren())
+    {
+        child->setParent(parent);
+        if (parent != nullptr)
+            parent->addChild(child);
+    }
+    if (parent != nullptr)
+        parent->removeChild(&node);
+    if (m_root == &node)
+        m_root = nullptr;
+
+    removeFromNameIndex(node);
+    // The meshes outlive their nodes, collectDraws() would read the destroyed node
+    if (node.hasComponent<Mesh>())
+        node.getComponent<Mesh>()->removeNode(node);
+    for (auto& [type, pool] : m_componentPools)
+    {
+        pool->remove(node.getEntity());
+    }
+    m_entityNodes[node.getEntity()] = nullptr;
+    m_freeEntities.push_back(node.getEntity());
+    m_transforms.destroy(node.getTransform());
+
+    const auto it = std::ranges::find_if(m_nodes, [&node](const Scope<Node>& owned) { return owned.get() == &node; });
+    if (it != m_nodes.end())
+    {
+        std::swap(*it, m_nodes.back());
+        m_nodes.pop_back();
+    }
+}
+
+void Scene::renameNode(Node& node, std::string_view name)
+{
+    removeFromNameIndex(node);
+    node.setName(name);
+    m_nameIndex[node.getInternedName().view()].push_back(&node);
+}
+
+void Scene::removeFromNameIndex(const Node& node)
+{
+    const auto it = m_nameIndex.find(node.getName());
+    if (it == m_nameIndex.end())
+        return;
+    std::erase(it->second, &node);
+    if (it->second.empty())
+        m_nameIndex.erase(it);
+}
+
 void Scene::addChild(Node* node)
 {
-    m_root->addChild(node);
+    setParent(*node, m_root);
+}
+
+void Scene::setParent(Node& node, Node* parent)
+{
+    if (m_transforms.isValid(node.getTransform()) &&
+        !m_transforms.setParent(node.getTransform(), parent != nullptr ? parent->getTransform() : InvalidTransformID))
+    {
+        HUAN_CORE_ERROR("[Scene]: Node {} can't be the child of its own descendant {}", node.getName(), parent->getName())
+        return;
+    }
+
+    if (Node* oldParent = node.getParent(); oldParent != nullptr)
+        oldParent->removeChild(&node);
+    node.setParent(parent);
+    if (parent != nullptr)
+        parent->addChild(&node);
 }
 
 void Scene::addComponent(Scope<Component>&& component)
@@ -57,13 +146,32 @@ void Scene::addComponent(Scope<Component>&& component, Node* node)
 {
     if (component)
     {
-        node->setComponent(component.get());
+        if (component->getType() == typeid(Mesh))
+            setMesh(*node, static_cast<Mesh&>(*component));
+        else
+            node->setComponent(component.get());
         m_components[component->getType()].emplace_back(std::move(component));
     }
 }
 
+void Scene::setMesh(Node& node, Mesh& mesh)
+{
+    HUAN_CORE_ASSERT(node.getEntity() != InvalidEntity, "The node is not in the scene")
+    if (node.hasComponent<Mesh>())
+        node.getComponent<Mesh>()->removeNode(node);
+    node.setComponent(&mesh);
+    mesh.addNode(node);
+    emplaceComponent<MeshInstance>(node, MeshInstance{&mesh, node.getTransform()});
+}
+
 void Scene::setComponents(const std::type_index& typeInfo, std::vector<Scope<Component>>&& components)
 {
+    // The instances would show the destroyed meshes
+    if (typeInfo == typeid(Mesh))
+    {
+        if (auto* pool = getComponentPool<MeshInstance>(); pool != nullptr)
+            pool->clear();
+    }
     m_components[typeInfo] = std::move(components);
 }
 
@@ -78,31 +186,71 @@ bool Scene::hasComponent(const std::type_index& type_info) const
     return (it != m_components.end() && !it->second.empty());
 }
 
-/**
- * 根据名字进行层次优先遍历查找第一个Node
- */
-Node* Scene::findNode(const std::string& name) const
+namespace
+{
+uint32_t getDepth(const Node* node)
+{
+    uint32_t depth = 0;
+    for (; node->getParent() != nullptr; node = node->getParent())
+    {
+        ++depth;
+    }
+    return depth;
+}
+} // namespace
+
+Node* Scene::findNode(std::string_view name) const
 {
-    for (auto& node : m_root->getChildren())
+    const auto it = m_nameIndex.find(name);
+    if (it == m_nameIndex.end())
+        return nullptr;
+    const auto& nodes = it->second;
+    if (nodes.size() == 1)
+        return nodes.front();
+
+    // Same as the first match of a breadth first search from the root
+    Node* result = nodes.front();
+    uint32_t resultDepth = getDepth(result);
+    for (size_t i = 1; i < nodes.size(); ++i)
     {
-        // 层次优先遍历
-        std::queue<Node*> traverseNodes{};
-        traverseNodes.push(m_root);
-        while (!traverseNodes.empty())
+        if (const uint32_t depth = getDepth(nodes[i]); depth < resultDepth)
         {
-            auto node = traverseNodes.front();
-            traverseNodes.pop();
-            if (node->getName() == name)
-            {
-                return node;
-            }
-            for (auto& child : node->getChildren())
-            {
-                traverseNodes.push(child);
-            }
+            result = nodes[i];
+            resultDepth = depth;
         }
     }
-    return nullptr;
+    return result;
+}
+
+Node* Scene::findNodeByPath(std::string_view path) const
+{
+    if (path.starts_with('/'))
+        path.remove_prefix(1);
+
+    Node* node = nullptr;
+    while (true)
+    {
+        const auto separator = path.find('/');
+        const std::string_view name = path.substr(0, separator);
+        if (node == nullptr)
+        {
+            if (m_root == nullptr || m_root->getName() != name)
+                return nullptr;
+            node = m_root;
+        }
+        else
+        {
+            const auto& children = node->getChildren();
+            const auto it =
+                std::ranges::find_if(children, [name](const Node* child) { return child->getName() == name; });
+            if (it == children.end())
+                return nullptr;
+            node = *it;
+        }
+        if (separator == std::string_view::npos)
+            return node;
+        path.remove_prefix(separator + 1);
+    }
 }
 
 void Scene::setRootNode(Node* root)
@@ -114,4 +262,53 @@ Node* Scene::getRootNode() const
 {
     return m_root;
 }
-}
\ No newline at end of file
+
+Node* Scene::getNode(Entity entity) const
+{
+    return entity < m_entityNodes.size() ? m_entityNodes[entity] : nullptr;
+}
+
+TransformSystem& Scene::getTransformSystem()
+{
+    return m_transforms;
+}
+
+const TransformSystem& Scene::getTransformSystem() const
+{
+    return m_transforms;
+}
+
+void Scene::updateTransforms(utils::ThreadPool* workers)
+{
+    m_transforms.update(workers);
+}
+
+void Scene::collectDraws(FrustumCuller& culler)
+{
+    view<MeshInstance>().each([this, &culler](Entity, const MeshInstance& instance) {
+        if (!m_transforms.isValid(instance.transform))
+            return;
+        const AABB3D& bounds = instance.mesh->getBounds();
+        const BoundingBox worldBounds = BoundingBox{bounds.getMin(), bounds.getMax()}.transformed(
+            m_transforms.getWorldMatrix(instance.transform));
+        for (const SubMesh* subMesh : instance.mesh->getSubMeshes())
+        {
+            culler.add(worldBounds, DrawItem::fromSubMesh(*subMesh, instance.transform));
+        }
+    });
+}
+
+void Scene::collectOccluders(OcclusionCuller& culler)
+{
+    view<MeshInstance>().each([this, &culler](Entity, const MeshInstance& instance) {
+        if (!m_transforms.isValid(instance.transform))
+            return;
+        for (const SubMesh* subMesh : instance.mesh->getSubMeshes())
+        {
+            if (subMesh->isOccluder())
+                culler.addOccluder(m_transforms.getWorldMatrix(instance.transform), subMesh->getOccluderPositions(),
+                                   subMesh->getOccluderIndices());
+        }
+    });
+}
+}
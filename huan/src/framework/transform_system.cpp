@@ -0,0 +1,364 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/scene_framework/transform_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "huan/log/Log.hpp"
+#include "huan/utils/simd.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::framework::scene_graph
+{
+namespace
+{
+// Same as glm::translate(position) * glm::mat4_cast(rotation) * glm::scale(scale), without the two products
+glm::mat4 composeLocal(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    const float xx = rotation.x * rotation.x;
+    const float yy = rotation.y * rotation.y;
+    const float zz = rotation.z * rotation.z;
+    const float xy = rotation.x * rotation.y;
+    const float xz = rotation.x * rotation.z;
+    const float yz = rotation.y * rotation.z;
+    const float wx = rotation.w * rotation.x;
+    const float wy = rotation.w * rotation.y;
+    const float wz = rotation.w * rotation.z;
+
+    glm::mat4 result;
+    result[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+    result[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+    result[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+    result[3] = glm::vec4(position, 1.0f);
+    return result;
+}
+
+template <class T>
+void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+{
+    std::vector<T> sorted;
+    sorted.reserve(values.size());
+    for (const uint32_t index : order)
+    {
+        sorted.push_back(values[index]);
+    }
+    values = std::move(sorted);
+}
+
+template <class T>
+void swapRemove(std::vector<T>& values, uint32_t index)
+{
+    values[index] = values.back();
+    values.pop_back();
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+} // namespace
+
+TransformID TransformSystem::create(TransformID parent)
+{
+    HUAN_CORE_ASSERT(parent == InvalidTransformID || isValid(parent), "Invalid parent transform")
+    TransformID id;
+    if (!m_freeIDs.empty())
+    {
+        id = m_freeIDs.back();
+        m_freeIDs.pop_back();
+    }
+    else
+    {
+        id = static_cast<TransformID>(m_idToDense.size());
+        m_idToDense.push_back(InvalidIndex);
+    }
+
+    m_idToDense[id] = static_cast<uint32_t>(m_denseToID.size());
+    m_denseToID.push_back(id);
+    m_parentIDs.push_back(parent);
+    m_positions.emplace_back(0.0f);
+    m_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+    m_scales.emplace_back(1.0f);
+    m_worldMatrices.emplace_back(1.0f);
+    m_localDirty.push_back(1);
+    m_worldChanged.push_back(0);
+    m_parents.push_back(InvalidIndex);
+
+    m_isOrderStale = true;
+    m_hasDirty = true;
+    return id;
+}
+
+void TransformSystem::destroy(TransformID id)
+{
+    if (!isValid(id))
+        return;
+    const uint32_t index = m_idToDense[id];
+    const TransformID parent = m_parentIDs[index];
+    for (uint32_t i = 0; i < m_parentIDs.size(); ++i)
+    {
+        if (m_parentIDs[i] == id)
+        {
+            m_parentIDs[i] = parent;
+            markDirty(i);
+        }
+    }
+
+    // The order is sorted again anyway
+    m_idToDense[m_denseToID.back()] = index;
+    swapRemove(m_denseToID, index);
+    swapRemove(m_parentIDs, index);
+    swapRemove(m_positions, index);
+    swapRemove(m_rotations, index);
+    swapRemove(m_scales, index);
+    swapRemove(m_worldMatrices, index);
+    swapRemove(m_localDirty, index);
+    swapRemove(m_worldChanged, index);
+    swapRemove(m_parents, index);
+
+    m_idToDense[id] = InvalidIndex;
+    m_freeIDs.push_back(id);
+    m_isOrderStale = true;
+}
+
+void TransformSystem::clear()
+{
+    m_parentIDs.clear();
+    m_positions.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_worldMatrices.clear();
+    m_localDirty.clear();
+    m_worldChanged.clear();
+    m_denseToID.clear();
+    m_parents.clear();
+    m_levelOffsets.clear();
+    m_idToDense.clear();
+    m_freeIDs.clear();
+    m_isOrderStale = false;
+    m_hasDirty = false;
+    m_stats = {};
+}
+
+bool TransformSystem::isValid(TransformID id) const
+{
+    return id < m_idToDense.size() && m_idToDense[id] != InvalidIndex;
+}
+
+bool TransformSystem::setParent(TransformID id, TransformID parent)
+{
+    HUAN_CORE_ASSERT(isValid(id), "Invalid transform")
+    HUAN_CORE_ASSERT(parent == InvalidTransformID || isValid(parent), "Invalid parent transform")
+    for (TransformID ancestor = parent; ancestor != InvalidTransformID;
+         ancestor = m_parentIDs[m_idToDense[ancestor]])
+    {
+        if (ancestor == id)
+            return false;
+    }
+
+    const uint32_t index = m_idToDense[id];
+    if (m_parentIDs[index] != parent)
+    {
+        m_parentIDs[index] = parent;
+        markDirty(index);
+        m_isOrderStale = true;
+    }
+    return true;
+}
+
+TransformID TransformSystem::getParent(TransformID id) const
+{
+    return m_parentIDs[m_idToDense[id]];
+}
+
+void TransformSystem::setPosition(TransformID id, const glm::vec3& position)
+{
+    const uint32_t index = m_idToDense[id];
+    m_positions[index] = position;
+    markDirty(index);
+}
+
+void TransformSystem::setRotation(TransformID id, const glm::quat& rotation)
+{
+    const uint32_t index = m_idToDense[id];
+    m_rotations[index] = rotation;
+    markDirty(index);
+}
+
+void TransformSystem::setScale(TransformID id, const glm::vec3& scale)
+{
+    const uint32_t index = m_idToDense[id];
+    m_scales[index] = scale;
+    markDirty(index);
+}
+
+void TransformSystem::setLocal(TransformID id, const glm::vec3& position, const glm::quat& rotation,
+                               const glm::vec3& scale)
+{
+    const uint32_t index = m_idToDense[id];
+    m_positions[index] = position;
+    m_rotations[index] = rotation;
+    m_scales[index] = scale;
+    markDirty(index);
+}
+
+const glm::vec3& TransformSystem::getPosition(TransformID id) const
+{
+    return m_positions[m_idToDense[id]];
+}
+
+const glm::quat& TransformSystem::getRotation(TransformID id) const
+{
+    return m_rotations[m_idToDense[id]];
+}
+
+const glm::vec3& TransformSystem::getScale(TransformID id) const
+{
+    return m_scales[m_idToDense[id]];
+}
+
+const glm::mat4& TransformSystem::getWorldMatrix(TransformID id) const
+{
+    return m_worldMatrices[m_idToDense[id]];
+}
+
+void TransformSystem::update(utils::ThreadPool* workers)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    const bool wasSorted = m_isOrderStale;
+    if (m_isOrderStale)
+        sortBreadthFirst();
+    // Flags of the previous update, the sort cleared them already
+    if (!wasSorted && m_stats.updatedCount != 0)
+        std::fill(m_worldChanged.begin(), m_worldChanged.end(), uint8_t{0});
+
+    uint32_t updatedCount = 0;
+    if (m_hasDirty)
+    {
+        // A level only reads the world matrices of the previous one
+        for (size_t level = 0; level + 1 < m_levelOffsets.size(); ++level)
+        {
+            const size_t levelBegin = m_levelOffsets[level];
+            const size_t levelEnd = m_levelOffsets[level + 1];
+            if (workers == nullptr || levelEnd - levelBegin < 2 * ParallelGrainSize)
+            {
+                updatedCount += updateRange(levelBegin, levelEnd);
+                continue;
+            }
+            std::atomic<uint32_t> levelUpdatedCount = 0;
+            workers->parallelFor(levelEnd - levelBegin, ParallelGrainSize, [&](size_t first, size_t last) {
+                levelUpdatedCount += updateRange(levelBegin + first, levelBegin + last);
+            });
+            updatedCount += levelUpdatedCount;
+        }
+        m_hasDirty = false;
+    }
+
+    m_stats.transformCount = static_cast<uint32_t>(size());
+    m_stats.updatedCount = updatedCount;
+    m_stats.updateMilliseconds = millisecondsSince(begin);
+}
+
+void TransformSystem::markDirty(uint32_t denseIndex)
+{
+    m_localDirty[denseIndex] = 1;
+    m_hasDirty = true;
+}
+
+void TransformSystem::sortBreadthFirst()
+{
+    const auto begin = std::chrono::steady_clock::now();
+    const auto count = static_cast<uint32_t>(size());
+
+    // Children grouped by parent with a counting sort: those of i end up in [m_childOffsets[i], m_childOffsets[i + 1])
+    m_childOffsets.assign(count + 2, 0);
+    for (const TransformID parent : m_parentIDs)
+    {
+        if (parent != InvalidTransformID)
+            ++m_childOffsets[m_idToDense[parent] + 2];
+    }
+    for (uint32_t i = 2; i < count + 2; ++i)
+    {
+        m_childOffsets[i] += m_childOffsets[i - 1];
+    }
+    m_children.resize(m_childOffsets[count + 1]);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (m_parentIDs[i] != InvalidTransformID)
+            m_children[m_childOffsets[m_idToDense[m_parentIDs[i]] + 1]++] = i;
+    }
+
+    m_sortOrder.clear();
+    m_sortOrder.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (m_parentIDs[i] == InvalidTransformID)
+            m_sortOrder.push_back(i);
+    }
+    m_levelOffsets.assign(1, 0);
+    for (size_t levelBegin = 0; levelBegin < m_sortOrder.size();)
+    {
+        const size_t levelEnd = m_sortOrder.size();
+        m_levelOffsets.push_back(static_cast<uint32_t>(levelEnd));
+        for (size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            const uint32_t parent = m_sortOrder[i];
+            m_sortOrder.insert(m_sortOrder.end(), m_children.begin() + m_childOffsets[parent],
+                               m_children.begin() + m_childOffsets[parent + 1]);
+        }
+        levelBegin = levelEnd;
+    }
+    // setParent() refuses cycles, so every transform hangs from a root
+    HUAN_CORE_ASSERT(m_sortOrder.size() == count, "Cycle in the transform hierarchy")
+
+    permute(m_denseToID, m_sortOrder);
+    permute(m_parentIDs, m_sortOrder);
+    permute(m_positions, m_sortOrder);
+    permute(m_rotations, m_sortOrder);
+    permute(m_scales, m_sortOrder);
+    permute(m_worldMatrices, m_sortOrder);
+    permute(m_localDirty, m_sortOrder);
+    m_worldChanged.assign(count, 0);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_idToDense[m_denseToID[i]] = i;
+    }
+    m_parents.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_parents[i] = m_parentIDs[i] == InvalidTransformID ? InvalidIndex : m_idToDense[m_parentIDs[i]];
+    }
+
+    m_isOrderStale = false;
+    m_stats.levelCount = static_cast<uint32_t>(m_levelOffsets.size() - 1);
+    m_stats.sortMilliseconds = millisecondsSince(begin);
+}
+
+uint32_t TransformSystem::updateRange(size_t begin, size_t end)
+{
+    uint32_t updatedCount = 0;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t parent = m_parents[i];
+        if (m_localDirty[i] == 0 && (parent == InvalidIndex || m_worldChanged[parent] == 0))
+            continue;
+
+        const glm::mat4 local = composeLocal(m_positions[i], m_rotations[i], m_scales[i]);
+        if (parent == InvalidIndex)
+            m_worldMatrices[i] = local;
+        else
+            utils::multiplyMat4(glm::value_ptr(m_worldMatrices[parent]), glm::value_ptr(local),
+                                glm::value_ptr(m_worldMatrices[i]));
+        m_localDirty[i] = 0;
+        m_worldChanged[i] = 1;
+        ++updatedCount;
+    }
+    return updatedCount;
+}
+} // namespace huan::framework::scene_graph
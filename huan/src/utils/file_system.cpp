@@ -2,7 +2,15 @@
 // Created by 86156 on 5/9/2025.
 //
 #include <cassert>
+#include <filesystem>
+#include <format>
 #include <fstream>
+#include <thread>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 #include <huan/utils/file_system.hpp>
 
 #include "huan/common.hpp"
@@ -50,4 +58,57 @@ std::vector<uint32_t> FileSystem::Imp_loadBinaryFileImp(std::string_view filePat
     HUAN_CORE_INFO("Loaded file: {}", filePath)
     return buffer;
 }
+
+bool FileSystem::Imp_tryLoadBytes(std::string_view filePath, std::vector<char>& bytes)
+{
+    std::ifstream file(std::filesystem::path(filePath), std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    const auto fileSize = static_cast<size_t>(file.tellg());
+    bytes.resize(fileSize);
+    file.seekg(0);
+    file.read(bytes.data(), static_cast<std::streamsize>(fileSize));
+    return static_cast<bool>(file);
+}
+
+bool FileSystem::Imp_writeFileAtomic(std::string_view filePath, const void* data, size_t size)
+{
+    const std::filesystem::path path(filePath);
+    std::error_code error;
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    // Unique per process, thread and write, two writers of the same file then only race on the rename, which is
+    // atomic
+#ifdef _WIN32
+    const auto processId = _getpid();
+#else
+    const auto processId = getpid();
+#endif
+    auto tempPath = path;
+    tempPath += std::format(".{}.{:x}.{}.tmp", processId, std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                            m_tempCounter++);
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        file.close();
+        if (!file)
+        {
+            HUAN_CORE_WARN("[FileSystem]: Failed to write {}", tempPath.string())
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        HUAN_CORE_WARN("[FileSystem]: Failed to replace {}: {}", path.string(), error.message())
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
 }
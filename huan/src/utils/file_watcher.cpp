@@ -0,0 +1,145 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/utils/file_watcher.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "huan/log/Log.hpp"
+
+namespace huan::utils
+{
+FileWatcher::FileWatcher(std::chrono::milliseconds pollInterval)
+    : m_pollInterval(pollInterval)
+{
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0)
+        HUAN_CORE_WARN("[FileWatcher]: inotify unavailable, polling every {} ms", m_pollInterval.count())
+#endif
+    m_thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_stopping = true;
+    m_thread.join();
+#ifdef __linux__
+    if (m_inotifyFd >= 0)
+        close(m_inotifyFd);
+#endif
+}
+
+bool FileWatcher::watch(const std::filesystem::path& file)
+{
+    const auto key = normalize(file);
+    const auto directory = std::filesystem::path(key).parent_path();
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error))
+        return false;
+
+    std::lock_guard lock(m_mutex);
+    if (m_files.contains(key))
+        return true;
+#ifdef __linux__
+    if (m_inotifyFd >= 0)
+    {
+        // Adding the same directory again returns its existing descriptor
+        const int descriptor =
+            inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (descriptor < 0)
+            return false;
+        m_directories[descriptor] = directory.generic_string();
+    }
+#endif
+    m_files[key] = std::filesystem::last_write_time(key, error);
+    return true;
+}
+
+bool FileWatcher::isWatching(const std::filesystem::path& file) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_files.contains(normalize(file));
+}
+
+std::vector<std::string> FileWatcher::pollChanges()
+{
+    std::lock_guard lock(m_mutex);
+    std::vector<std::string> changes(m_changed.begin(), m_changed.end());
+    m_changed.clear();
+    return changes;
+}
+
+std::string FileWatcher::normalize(const std::filesystem::path& file)
+{
+    return std::filesystem::absolute(file).lexically_normal().generic_string();
+}
+
+void FileWatcher::run()
+{
+    while (!m_stopping)
+    {
+        if (m_inotifyFd >= 0)
+        {
+            readNativeEvents();
+        }
+        else
+        {
+            pollWriteTimes();
+            std::this_thread::sleep_for(m_pollInterval);
+        }
+    }
+}
+
+void FileWatcher::pollWriteTimes()
+{
+    std::lock_guard lock(m_mutex);
+    for (auto& [file, lastWriteTime] : m_files)
+    {
+        std::error_code error;
+        const auto writeTime = std::filesystem::last_write_time(file, error);
+        // A file being replaced may briefly not exist, keep the old time until it's back
+        if (!error && writeTime != lastWriteTime)
+        {
+            lastWriteTime = writeTime;
+            m_changed.insert(file);
+        }
+    }
+}
+
+void FileWatcher::readNativeEvents()
+{
+#ifdef __linux__
+    pollfd descriptor{m_inotifyFd, POLLIN, 0};
+    // Bounded, so that the destructor doesn't wait for a file to change
+    if (poll(&descriptor, 1, static_cast<int>(m_pollInterval.count())) <= 0)
+        return;
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(m_inotifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        std::lock_guard lock(m_mutex);
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            const auto directory = m_directories.find(event->wd);
+            if (event->len == 0 || directory == m_directories.end())
+                continue;
+
+            auto file = directory->second + "/" + event->name;
+            // Other files of the directory are not watched
+            if (m_files.contains(file))
+                m_changed.insert(std::move(file));
+        }
+    }
+#endif
+}
+} // namespace huan::utils
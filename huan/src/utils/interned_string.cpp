@@ -0,0 +1,57 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/utils/interned_string.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace huan::utils
+{
+namespace
+{
+struct InternTable
+{
+    std::mutex mutex;
+    // Keys view the strings they map to, which never move
+    std::unordered_map<std::string_view, Scope<std::string>> strings;
+};
+
+InternTable& getTable()
+{
+    // Never destroyed, interned strings may be used by static destructors
+    static auto* table = new InternTable();
+    return *table;
+}
+
+const std::string* intern(std::string_view string)
+{
+    auto& table = getTable();
+    std::lock_guard lock(table.mutex);
+    if (const auto it = table.strings.find(string); it != table.strings.end())
+        return it->second.get();
+    auto stored = createScope<std::string>(string);
+    const std::string* result = stored.get();
+    table.strings.emplace(*result, std::move(stored));
+    return result;
+}
+} // namespace
+
+InternedString::InternedString()
+{
+    static const std::string* empty = intern({});
+    m_string = empty;
+}
+
+InternedString::InternedString(std::string_view string)
+    : m_string(intern(string))
+{
+}
+
+size_t InternedString::getInternedCount()
+{
+    auto& table = getTable();
+    std::lock_guard lock(table.mutex);
+    return table.strings.size();
+}
+} // namespace huan::utils
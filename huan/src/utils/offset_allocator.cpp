@@ -0,0 +1,373 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// Adapted from OffsetAllocator (https://github.com/sebbbi/OffsetAllocator), under the MIT License:
+//
+// Copyright (c) 2023 Sebastian Aaltonen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+// documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+// Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+#include "huan/utils/offset_allocator.hpp"
+
+#include <bit>
+#include <cassert>
+
+namespace huan::utils
+{
+namespace
+{
+constexpr uint32_t MantissaBits = 3;
+constexpr uint32_t MantissaValue = 1 << MantissaBits;
+constexpr uint32_t MantissaMask = MantissaValue - 1;
+
+// Bin sizes follow a floating point (exponent + mantissa) distribution, so the relative waste is bounded.
+// Round up when searching, so any node of the bin is big enough.
+uint32_t uintToFloatRoundUp(uint32_t size)
+{
+    uint32_t exp = 0;
+    uint32_t mantissa = 0;
+
+    if (size < MantissaValue)
+    {
+        // Denorm: 0..(MantissaValue - 1)
+        mantissa = size;
+    }
+    else
+    {
+        // Normalized: hidden high bit always 1, not stored, just like float
+        const uint32_t highestSetBit = std::bit_width(size) - 1;
+        const uint32_t mantissaStartBit = highestSetBit - MantissaBits;
+        exp = mantissaStartBit + 1;
+        mantissa = (size >> mantissaStartBit) & MantissaMask;
+
+        const uint32_t lowBitsMask = (1u << mantissaStartBit) - 1;
+        if ((size & lowBitsMask) != 0)
+        {
+            // Round up, the carry may overflow into the exponent, which is fine
+            mantissa++;
+        }
+    }
+    return (exp << MantissaBits) + mantissa;
+}
+
+// Round down when storing, so every node of the bin is at least the bin size
+uint32_t uintToFloatRoundDown(uint32_t size)
+{
+    uint32_t exp = 0;
+    uint32_t mantissa = 0;
+
+    if (size < MantissaValue)
+    {
+        mantissa = size;
+    }
+    else
+    {
+        const uint32_t highestSetBit = std::bit_width(size) - 1;
+        const uint32_t mantissaStartBit = highestSetBit - MantissaBits;
+        exp = mantissaStartBit + 1;
+        mantissa = (size >> mantissaStartBit) & MantissaMask;
+    }
+    return (exp << MantissaBits) | mantissa;
+}
+
+uint32_t floatToUint(uint32_t floatValue)
+{
+    const uint32_t exponent = floatValue >> MantissaBits;
+    const uint32_t mantissa = floatValue & MantissaMask;
+    if (exponent == 0)
+        return mantissa;
+    return (mantissa | MantissaValue) << (exponent - 1);
+}
+
+uint32_t findLowestSetBitAfter(uint32_t bitMask, uint32_t startBitIndex)
+{
+    if (startBitIndex >= 32)
+        return OffsetAllocator::NoSpace;
+    const uint32_t maskBeforeStartIndex = (1u << startBitIndex) - 1;
+    const uint32_t bitsAfter = bitMask & ~maskBeforeStartIndex;
+    if (bitsAfter == 0)
+        return OffsetAllocator::NoSpace;
+    return std::countr_zero(bitsAfter);
+}
+} // namespace
+
+OffsetAllocator::OffsetAllocator(uint32_t size, uint32_t maxAllocations)
+    : m_size(size), m_maxAllocations(maxAllocations)
+{
+    reset();
+}
+
+void OffsetAllocator::reset()
+{
+    m_freeStorage = 0;
+    m_usedBinsTop = 0;
+    m_freeOffset = m_maxAllocations - 1;
+
+    for (auto& usedBin : m_usedBins)
+        usedBin = 0;
+    for (auto& binIndex : m_binIndices)
+        binIndex = Unused;
+
+    m_nodes.assign(m_maxAllocations, Node{});
+    m_freeNodes.resize(m_maxAllocations);
+
+    // Freelist is a stack. Nodes in inverse order so that [0] pops first.
+    for (uint32_t i = 0; i < m_maxAllocations; i++)
+    {
+        m_freeNodes[i] = m_maxAllocations - i - 1;
+    }
+
+    // Start state: Whole storage as one big node
+    // Algorithm will split remainders and push them back as smaller nodes
+    insertNodeIntoBin(m_size, 0);
+}
+
+OffsetAllocator::Allocation OffsetAllocator::allocate(uint32_t size)
+{
+    // Out of allocations?
+    if (m_freeOffset == Unused || size == 0)
+        return {};
+
+    // Round up to bin index to ensure that alloc >= bin
+    // Gives us min bin index that fits the size
+    const uint32_t minBinIndex = uintToFloatRoundUp(size);
+    const uint32_t minTopBinIndex = minBinIndex >> TopBinsIndexShift;
+    const uint32_t minLeafBinIndex = minBinIndex & LeafBinsIndexMask;
+
+    uint32_t topBinIndex = minTopBinIndex;
+    uint32_t leafBinIndex = NoSpace;
+
+    // If top bin exists, scan its leaf bin. This can fail (NoSpace).
+    if (topBinIndex < NumTopBins && (m_usedBinsTop & (1u << topBinIndex)))
+    {
+        leafBinIndex = findLowestSetBitAfter(m_usedBins[topBinIndex], minLeafBinIndex);
+    }
+
+    // If we didn't find space in top bin, we search top bin from +1
+    if (leafBinIndex == NoSpace)
+    {
+        topBinIndex = findLowestSetBitAfter(m_usedBinsTop, minTopBinIndex + 1);
+
+        // Out of space?
+        if (topBinIndex == NoSpace)
+            return {};
+
+        // All leaf bins here fit the alloc, since the top bin was rounded up. Start leaf search from bit 0.
+        // NOTE: This search can't fail since at least one leaf bit was set because the top bit was set.
+        leafBinIndex = std::countr_zero(static_cast<uint32_t>(m_usedBins[topBinIndex]));
+    }
+
+    const uint32_t binIndex = (topBinIndex << TopBinsIndexShift) | leafBinIndex;
+
+    // Pop the top node of the bin. Bin top = node.next.
+    const NodeIndex nodeIndex = m_binIndices[binIndex];
+    Node& node = m_nodes[nodeIndex];
+    const uint32_t nodeTotalSize = node.dataSize;
+    node.dataSize = size;
+    node.used = true;
+    m_binIndices[binIndex] = node.binListNext;
+    if (node.binListNext != Unused)
+        m_nodes[node.binListNext].binListPrev = Unused;
+    m_freeStorage -= nodeTotalSize;
+
+    // Bin empty?
+    if (m_binIndices[binIndex] == Unused)
+    {
+        m_usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+        if (m_usedBins[topBinIndex] == 0)
+        {
+            m_usedBinsTop &= ~(1u << topBinIndex);
+        }
+    }
+
+    // Push back the remainder N elements to a lower bin
+    const uint32_t remainderSize = nodeTotalSize - size;
+    if (remainderSize > 0)
+    {
+        const NodeIndex newNodeIndex = insertNodeIntoBin(remainderSize, node.dataOffset + size);
+
+        // Link nodes next to each other so that we can merge them later if both are free
+        // And update the old next neighbor to point to the new node (in middle)
+        // NOTE: `node` may dangle after insertNodeIntoBin if m_nodes reallocated, but it never does (fixed size)
+        if (node.neighborNext != Unused)
+            m_nodes[node.neighborNext].neighborPrev = newNodeIndex;
+        m_nodes[newNodeIndex].neighborPrev = nodeIndex;
+        m_nodes[newNodeIndex].neighborNext = node.neighborNext;
+        node.neighborNext = newNodeIndex;
+    }
+
+    return {node.dataOffset, nodeIndex};
+}
+
+void OffsetAllocator::free(Allocation allocation)
+{
+    if (!allocation.isValid() || allocation.metadata == NoSpace)
+        return;
+
+    const NodeIndex nodeIndex = allocation.metadata;
+    Node& node = m_nodes[nodeIndex];
+
+    // Double delete check
+    assert(node.used);
+
+    // Merge with neighbors...
+    uint32_t offset = node.dataOffset;
+    uint32_t size = node.dataSize;
+
+    if (node.neighborPrev != Unused && !m_nodes[node.neighborPrev].used)
+    {
+        // Previous (contiguous) free node: Change offset to previous node offset. Sum sizes
+        const Node& prevNode = m_nodes[node.neighborPrev];
+        offset = prevNode.dataOffset;
+        size += prevNode.dataSize;
+
+        // Remove node from the bin linked list and put it in the freelist
+        removeNodeFromBin(node.neighborPrev);
+
+        assert(prevNode.neighborNext == nodeIndex);
+        node.neighborPrev = prevNode.neighborPrev;
+    }
+
+    if (node.neighborNext != Unused && !m_nodes[node.neighborNext].used)
+    {
+        // Next (contiguous) free node: Offset remains the same. Sum sizes.
+        const Node& nextNode = m_nodes[node.neighborNext];
+        size += nextNode.dataSize;
+
+        removeNodeFromBin(node.neighborNext);
+
+        assert(nextNode.neighborPrev == nodeIndex);
+        node.neighborNext = nextNode.neighborNext;
+    }
+
+    const NodeIndex neighborNext = node.neighborNext;
+    const NodeIndex neighborPrev = node.neighborPrev;
+
+    // Insert the removed node to freelist
+    m_freeNodes[++m_freeOffset] = nodeIndex;
+
+    // Insert the (combined) free node to bin
+    const NodeIndex combinedNodeIndex = insertNodeIntoBin(size, offset);
+
+    // Connect neighbors with the new combined node
+    if (neighborNext != Unused)
+    {
+        m_nodes[combinedNodeIndex].neighborNext = neighborNext;
+        m_nodes[neighborNext].neighborPrev = combinedNodeIndex;
+    }
+    if (neighborPrev != Unused)
+    {
+        m_nodes[combinedNodeIndex].neighborPrev = neighborPrev;
+        m_nodes[neighborPrev].neighborNext = combinedNodeIndex;
+    }
+}
+
+uint32_t OffsetAllocator::getAllocationSize(Allocation allocation) const
+{
+    if (!allocation.isValid() || allocation.metadata == NoSpace)
+        return 0;
+    return m_nodes[allocation.metadata].dataSize;
+}
+
+OffsetAllocator::StorageReport OffsetAllocator::getStorageReport() const
+{
+    uint32_t largestFreeRegion = 0;
+    uint32_t freeStorage = 0;
+
+    // Out of allocations? -> Zero free space
+    if (m_freeOffset != Unused)
+    {
+        freeStorage = m_freeStorage;
+        if (m_usedBinsTop)
+        {
+            const uint32_t topBinIndex = 31 - std::countl_zero(m_usedBinsTop);
+            const uint32_t leafBinIndex = 31 - std::countl_zero(static_cast<uint32_t>(m_usedBins[topBinIndex]));
+            largestFreeRegion = floatToUint((topBinIndex << TopBinsIndexShift) | leafBinIndex);
+        }
+    }
+
+    return {freeStorage, largestFreeRegion};
+}
+
+uint32_t OffsetAllocator::getSize() const
+{
+    return m_size;
+}
+
+OffsetAllocator::NodeIndex OffsetAllocator::insertNodeIntoBin(uint32_t size, uint32_t dataOffset)
+{
+    // Round down to bin index to ensure that bin >= alloc
+    const uint32_t binIndex = uintToFloatRoundDown(size);
+
+    const uint32_t topBinIndex = binIndex >> TopBinsIndexShift;
+    const uint32_t leafBinIndex = binIndex & LeafBinsIndexMask;
+
+    // Bin was empty before?
+    if (m_binIndices[binIndex] == Unused)
+    {
+        // Set bin mask bits
+        m_usedBins[topBinIndex] |= 1u << leafBinIndex;
+        m_usedBinsTop |= 1u << topBinIndex;
+    }
+
+    // Take a freelist node and insert on top of the bin linked list (next = old top)
+    const NodeIndex topNodeIndex = m_binIndices[binIndex];
+    const NodeIndex nodeIndex = m_freeNodes[m_freeOffset--];
+    m_nodes[nodeIndex] = {.dataOffset = dataOffset, .dataSize = size, .binListNext = topNodeIndex};
+    if (topNodeIndex != Unused)
+        m_nodes[topNodeIndex].binListPrev = nodeIndex;
+    m_binIndices[binIndex] = nodeIndex;
+
+    m_freeStorage += size;
+    return nodeIndex;
+}
+
+void OffsetAllocator::removeNodeFromBin(NodeIndex nodeIndex)
+{
+    const Node& node = m_nodes[nodeIndex];
+
+    if (node.binListPrev != Unused)
+    {
+        // Easy case: We have previous node. Just remove this node from the middle of the list.
+        m_nodes[node.binListPrev].binListNext = node.binListNext;
+        if (node.binListNext != Unused)
+            m_nodes[node.binListNext].binListPrev = node.binListPrev;
+    }
+    else
+    {
+        // Hard case: We are the first node in a bin. Find the bin.
+        const uint32_t binIndex = uintToFloatRoundDown(node.dataSize);
+        const uint32_t topBinIndex = binIndex >> TopBinsIndexShift;
+        const uint32_t leafBinIndex = binIndex & LeafBinsIndexMask;
+
+        m_binIndices[binIndex] = node.binListNext;
+        if (node.binListNext != Unused)
+            m_nodes[node.binListNext].binListPrev = Unused;
+
+        // Bin empty?
+        if (m_binIndices[binIndex] == Unused)
+        {
+            m_usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+            if (m_usedBins[topBinIndex] == 0)
+            {
+                m_usedBinsTop &= ~(1u << topBinIndex);
+            }
+        }
+    }
+
+    // Insert the node to freelist
+    m_freeNodes[++m_freeOffset] = nodeIndex;
+    m_freeStorage -= node.dataSize;
+}
+} // namespace huan::utils
@@ -0,0 +1,125 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/utils/radix_sort.hpp"
+
+#include <algorithm>
+
+#include "huan/utils/thread_pool.hpp"
+
+namespace huan::utils
+{
+namespace
+{
+constexpr uint32_t RadixBits = 8;
+constexpr uint32_t BucketCount = 1u << RadixBits;
+constexpr uint32_t PassCount = 64 / RadixBits;
+// Items counted and scattered by one task
+constexpr size_t ChunkSize = 16 * 1024;
+
+uint32_t getDigit(uint64_t key, uint32_t pass)
+{
+    return static_cast<uint32_t>(key >> (pass * RadixBits)) & (BucketCount - 1);
+}
+
+template <class F>
+void forEachChunk(ThreadPool* workers, size_t chunkCount, F&& function)
+{
+    if (workers != nullptr && chunkCount > 1)
+    {
+        workers->parallelFor(chunkCount, 1, [&function](size_t first, size_t last) {
+            for (size_t chunk = first; chunk < last; ++chunk)
+            {
+                function(chunk);
+            }
+        });
+    }
+    else
+    {
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            function(chunk);
+        }
+    }
+}
+} // namespace
+
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, RadixSortScratch& scratch,
+               ThreadPool* workers)
+{
+    const size_t count = keys.size();
+    if (count <= 1)
+        return;
+    const size_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    scratch.keys.resize(count);
+    scratch.values.resize(count);
+    // Per chunk and bucket, counts then scatter offsets
+    scratch.histograms.resize(chunkCount * BucketCount);
+
+    // A pass is useless when all the keys have the same byte: the one of any key, e.g. the first
+    uint32_t passMask = 0;
+    {
+        uint64_t differingBits = 0;
+        for (const uint64_t key : keys)
+        {
+            differingBits |= key ^ keys[0];
+        }
+        for (uint32_t pass = 0; pass < PassCount; ++pass)
+        {
+            if (getDigit(differingBits, pass) != 0)
+                passMask |= 1u << pass;
+        }
+    }
+
+    uint64_t* sourceKeys = keys.data();
+    uint32_t* sourceValues = values.data();
+    uint64_t* targetKeys = scratch.keys.data();
+    uint32_t* targetValues = scratch.values.data();
+    for (uint32_t pass = 0; pass < PassCount; ++pass)
+    {
+        if ((passMask & (1u << pass)) == 0)
+            continue;
+
+        forEachChunk(workers, chunkCount, [&](size_t chunk) {
+            uint32_t* histogram = scratch.histograms.data() + chunk * BucketCount;
+            std::fill(histogram, histogram + BucketCount, 0);
+            const size_t last = std::min(count, (chunk + 1) * ChunkSize);
+            for (size_t i = chunk * ChunkSize; i < last; ++i)
+            {
+                ++histogram[getDigit(sourceKeys[i], pass)];
+            }
+        });
+        // Bucket major, then chunk order: what keeps the sort stable
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < BucketCount; ++bucket)
+        {
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                uint32_t& entry = scratch.histograms[chunk * BucketCount + bucket];
+                const uint32_t bucketCount = entry;
+                entry = offset;
+                offset += bucketCount;
+            }
+        }
+        forEachChunk(workers, chunkCount, [&](size_t chunk) {
+            uint32_t* offsets = scratch.histograms.data() + chunk * BucketCount;
+            const size_t last = std::min(count, (chunk + 1) * ChunkSize);
+            for (size_t i = chunk * ChunkSize; i < last; ++i)
+            {
+                const uint32_t target = offsets[getDigit(sourceKeys[i], pass)]++;
+                targetKeys[target] = sourceKeys[i];
+                targetValues[target] = sourceValues[i];
+            }
+        });
+        std::swap(sourceKeys, targetKeys);
+        std::swap(sourceValues, targetValues);
+    }
+
+    // After an odd number of passes the result is in the scratch buffers
+    if (sourceKeys != keys.data())
+    {
+        keys.swap(scratch.keys);
+        values.swap(scratch.values);
+    }
+}
+} // namespace huan::utils
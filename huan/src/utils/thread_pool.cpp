@@ -0,0 +1,89 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+#include "huan/utils/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace huan::utils
+{
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        // hardware_concurrency() may return 0 when unknown
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskAvailable.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::waitIdle()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_tasks.empty() && m_busyCount == 0; });
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+    return static_cast<uint32_t>(m_workers.size());
+}
+
+size_t ThreadPool::getPendingCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_tasks.size();
+}
+
+void ThreadPool::enqueue(std::function<void()>&& task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_taskAvailable.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            // Drain the queue before stopping, futures of queued tasks would be broken otherwise
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+            ++m_busyCount;
+        }
+
+        task();
+
+        {
+            std::lock_guard lock(m_mutex);
+            --m_busyCount;
+            if (m_tasks.empty() && m_busyCount == 0)
+                m_idle.notify_all();
+        }
+    }
+}
+} // namespace huan::utils
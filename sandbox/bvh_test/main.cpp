@@ -0,0 +1,261 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// SceneBVH on the CPU only, every query compared with a brute force loop over the live objects:
+// - before the first build, after a serial and a threaded build, and after inserts, removes and refitted updates,
+// - once inserts made the tree deeper than the traversal stack has entries,
+// - an update of a removed object is ignored and leaves every query as it was.
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "huan/scene_framework/bvh.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace
+{
+using namespace huan::framework::scene_graph;
+
+constexpr uint32_t ObjectCount = 20000;
+constexpr uint32_t QueryCount = 64;
+constexpr float DistanceTolerance = 1e-3f;
+
+struct Object
+{
+    SceneBVH::ObjectID id;
+    BoundingBox bounds;
+    bool isAlive;
+};
+
+bool check(bool condition, const char* name)
+{
+    if (!condition)
+        std::cerr << "Failed: " << name << std::endl;
+    return condition;
+}
+
+BoundingBox makeBox(const glm::vec3& center, const glm::vec3& extents)
+{
+    BoundingBox box;
+    box.min = center - extents;
+    box.max = center + extents;
+    return box;
+}
+
+BoundingBox randomBox(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 4.0f);
+    return makeBox({position(random), position(random), position(random)},
+                   {extent(random), extent(random), extent(random)});
+}
+
+float getSquaredDistance(const BoundingBox& box, const glm::vec3& point)
+{
+    const glm::vec3 delta = glm::max(glm::min(point, box.max), box.min) - point;
+    return delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+}
+
+// Slab test in doubles, -1 on a miss
+double getRayDistance(const BoundingBox& box, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    double enter = 0.0;
+    double exit = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis])
+                return -1.0;
+            continue;
+        }
+        double t0 = (static_cast<double>(box.min[axis]) - origin[axis]) / direction[axis];
+        double t1 = (static_cast<double>(box.max[axis]) - origin[axis]) / direction[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+    }
+    return enter <= exit ? enter : -1.0;
+}
+
+bool isSameSet(std::vector<uint32_t> found, std::vector<uint32_t> expected)
+{
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    return found == expected;
+}
+
+/**
+ * @brief Every query of the tree against the objects still alive, user data being the index in `objects`.
+ */
+bool testQueries(const SceneBVH& bvh, const std::vector<Object>& objects, std::mt19937& random, const char* stage)
+{
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 60.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool isPassing = true;
+    std::vector<uint32_t> found;
+    std::vector<uint32_t> expected;
+
+    uint32_t aliveCount = 0;
+    for (const Object& object : objects)
+        aliveCount += object.isAlive ? 1 : 0;
+    isPassing &= check(bvh.size() == aliveCount, stage);
+
+    for (uint32_t query = 0; query < QueryCount; ++query)
+    {
+        const glm::vec3 center(position(random), position(random), position(random));
+
+        const BoundingBox box = makeBox(center, {extent(random), extent(random), extent(random)});
+        found.clear();
+        expected.clear();
+        bvh.queryBox(box, found);
+        for (uint32_t index = 0; index < objects.size(); ++index)
+            if (objects[index].isAlive && objects[index].bounds.overlaps(box))
+                expected.push_back(index);
+        isPassing &= check(isSameSet(found, expected), "queryBox");
+
+        const float radius = extent(random);
+        found.clear();
+        expected.clear();
+        bvh.querySphere(center, radius, found);
+        for (uint32_t index = 0; index < objects.size(); ++index)
+            if (objects[index].isAlive && getSquaredDistance(objects[index].bounds, center) <= radius * radius)
+                expected.push_back(index);
+        isPassing &= check(isSameSet(found, expected), "querySphere");
+
+        glm::vec3 direction(unit(random), unit(random), unit(random));
+        direction = glm::normalize(direction);
+        const glm::mat4 projection = glm::perspective(glm::radians(40.0f), 1.0f, 1.0f, 200.0f);
+        const Frustum frustum =
+            Frustum::fromMatrix(projection * glm::lookAt(center, center + direction, glm::vec3(0.0f, 0.0f, 1.0f)));
+        found.clear();
+        expected.clear();
+        bvh.queryFrustum(frustum, found);
+        for (uint32_t index = 0; index < objects.size(); ++index)
+            if (objects[index].isAlive && frustum.intersects(objects[index].bounds))
+                expected.push_back(index);
+        isPassing &= check(isSameSet(found, expected), "queryFrustum");
+
+        constexpr float MaxDistance = 2000.0f;
+        double closest = -1.0;
+        for (const Object& object : objects)
+        {
+            if (!object.isAlive)
+                continue;
+            const double distance = getRayDistance(object.bounds, center, direction, MaxDistance);
+            if (distance >= 0.0 && (closest < 0.0 || distance < closest))
+                closest = distance;
+        }
+        SceneBVH::RayHit hit;
+        const bool isHit = bvh.raycast(center, direction, MaxDistance, hit);
+        isPassing &= check(isHit == (closest >= 0.0), "raycast hit");
+        if (isHit && closest >= 0.0)
+        {
+            isPassing &= check(std::abs(hit.distance - closest) <= DistanceTolerance, "raycast distance");
+            isPassing &= check(objects[hit.userData].isAlive && objects[hit.userData].id == hit.object,
+                               "raycast object");
+        }
+    }
+    if (!isPassing)
+        std::cerr << "  at: " << stage << std::endl;
+    return isPassing;
+}
+
+bool testIncremental(huan::utils::ThreadPool& pool)
+{
+    std::mt19937 random(7);
+    SceneBVH bvh;
+    std::vector<Object> objects;
+    const auto insert = [&](const BoundingBox& bounds) {
+        const auto index = static_cast<uint32_t>(objects.size());
+        objects.push_back({bvh.insert(bounds, index), bounds, true});
+    };
+    for (uint32_t index = 0; index < ObjectCount; ++index)
+        insert(randomBox(random));
+
+    bool isPassing = testQueries(bvh, objects, random, "before the first build");
+    bvh.build();
+    isPassing &= testQueries(bvh, objects, random, "serial build");
+
+    for (uint32_t index = 0; index < ObjectCount / 4; ++index)
+        insert(randomBox(random));
+    for (uint32_t index = 0; index < objects.size(); index += 3)
+    {
+        bvh.remove(objects[index].id);
+        objects[index].isAlive = false;
+    }
+    isPassing &= testQueries(bvh, objects, random, "inserts and removes");
+
+    std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+    for (Object& object : objects)
+    {
+        if (!object.isAlive)
+            continue;
+        const glm::vec3 delta(offset(random), offset(random), offset(random));
+        object.bounds = makeBox(object.bounds.getCenter() + delta, object.bounds.getExtents());
+        bvh.update(object.id, object.bounds);
+    }
+    bvh.refit();
+    isPassing &= testQueries(bvh, objects, random, "updates and refit");
+
+    // Ignored: the bounds of a removed object aren't anywhere in the tree any more
+    for (uint32_t index = 0; index < objects.size(); index += 3)
+        bvh.update(objects[index].id, makeBox({0.0f, 0.0f, 0.0f}, {1000.0f, 1000.0f, 1000.0f}));
+    bvh.refit();
+    for (uint32_t index = 0; index < objects.size(); index += 3)
+        isPassing &= check(!bvh.isValid(objects[index].id), "removed stays removed");
+    isPassing &= testQueries(bvh, objects, random, "update of removed objects");
+
+    bvh.build(&pool);
+    isPassing &= testQueries(bvh, objects, random, "threaded build");
+    return isPassing;
+}
+
+bool testDeepTree()
+{
+    std::mt19937 random(11);
+    SceneBVH bvh;
+    std::vector<Object> objects;
+    // A few built objects, then boxes each nested in the previous one: every insert goes down the same path and
+    // splits the leaf at its end, so the tree gets much deeper than the traversal stack before the next build
+    for (uint32_t index = 0; index < 64; ++index)
+    {
+        const BoundingBox bounds = randomBox(random);
+        objects.push_back({bvh.insert(bounds, index), bounds, true});
+    }
+    bvh.build();
+    float extent = 1000.0f;
+    for (uint32_t index = 0; index < 4000; ++index)
+    {
+        const BoundingBox bounds = makeBox({0.0f, 0.0f, 0.0f}, glm::vec3(extent));
+        extent *= 0.999f;
+        const auto userData = static_cast<uint32_t>(objects.size());
+        objects.push_back({bvh.insert(bounds, userData), bounds, true});
+    }
+    const SceneBVH::Stats stats = bvh.getStats();
+    bool isPassing = check(stats.depth > 256, "tree deeper than the traversal stack");
+    std::cout << "Depth after the nested inserts: " << stats.depth << std::endl;
+    isPassing &= testQueries(bvh, objects, random, "deep tree");
+    bvh.build();
+    isPassing &= testQueries(bvh, objects, random, "deep tree rebuilt");
+    return isPassing;
+}
+} // namespace
+
+int main()
+{
+    huan::utils::ThreadPool pool;
+    bool isPassing = testIncremental(pool);
+    isPassing &= testDeepTree();
+    std::cout << (isPassing ? "Passed" : "Failed") << std::endl;
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,223 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// ComponentPool and ComponentView against std::map references through random emplaces, replaces and removes:
+// - each pool finds every component of its entities, its entities stay parallel to its components,
+// - a view visits exactly the entities having all its components, once each, with their components, and allocates
+//   nothing while doing so,
+// - getComponentTypeID() tells the types apart and ignores const and references.
+//
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "huan/scene_framework/component_pool.hpp"
+#include "huan/scene_framework/component_type.hpp"
+
+namespace
+{
+std::atomic<uint64_t> s_allocationCount = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++s_allocationCount;
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+using namespace huan::framework::scene_graph;
+
+constexpr Entity EntityCount = 4000;
+constexpr uint32_t OperationCount = 100000;
+
+struct Position
+{
+    uint32_t stamp;
+    float x = 0.0f;
+};
+
+struct Velocity
+{
+    uint32_t stamp;
+};
+
+/**
+ * Move only, so that remove() moves the last component into the hole.
+ */
+struct Payload
+{
+    explicit Payload(uint32_t stamp) : stamp(std::make_unique<uint32_t>(stamp))
+    {
+    }
+
+    std::unique_ptr<uint32_t> stamp;
+};
+
+static_assert(getComponentTypeID<Position>() != getComponentTypeID<Velocity>());
+static_assert(getComponentTypeID<Position>() == getComponentTypeID<const Position&>());
+
+bool check(bool condition, const char* name)
+{
+    if (!condition)
+        std::cerr << "Failed: " << name << std::endl;
+    return condition;
+}
+
+uint32_t getStamp(const Position& position)
+{
+    return position.stamp;
+}
+uint32_t getStamp(const Velocity& velocity)
+{
+    return velocity.stamp;
+}
+uint32_t getStamp(const Payload& payload)
+{
+    return *payload.stamp;
+}
+
+template <class T>
+bool isMatching(const ComponentPool<T>& pool, const std::map<Entity, uint32_t>& expected)
+{
+    bool isPassing = check(pool.size() == expected.size(), "pool size");
+    for (Entity entity = 0; entity < EntityCount; ++entity)
+    {
+        const auto it = expected.find(entity);
+        const T* component = pool.tryGet(entity);
+        if (!check(pool.contains(entity) == (it != expected.end()) && (component != nullptr) == pool.contains(entity),
+                   "pool contains"))
+            return false;
+        if (component != nullptr)
+            isPassing &= check(getStamp(*component) == it->second && &pool.get(entity) == component, "pool component");
+    }
+    const auto& entities = pool.getEntities();
+    const auto components = pool.getComponents();
+    isPassing &= check(entities.size() == components.size(), "entities parallel to components");
+    for (size_t i = 0; i < entities.size() && i < components.size(); ++i)
+        isPassing &= check(pool.tryGet(entities[i]) == &components[i], "entity of the component");
+    return isPassing;
+}
+
+template <class T>
+void mutate(ComponentPool<T>& pool, std::map<Entity, uint32_t>& expected, std::mt19937& random, uint32_t stamp)
+{
+    const Entity entity = random() % EntityCount;
+    // More emplaces than removes, so that the pools hold about 2/3 of the entities
+    if (random() % 3 != 0)
+    {
+        pool.emplace(entity, T{stamp});
+        expected[entity] = stamp;
+    }
+    else
+    {
+        pool.remove(entity);
+        expected.erase(entity);
+    }
+}
+
+bool testPoolsAndViews()
+{
+    std::mt19937 random(3);
+    ComponentPool<Position> positions;
+    ComponentPool<Velocity> velocities;
+    ComponentPool<Payload> payloads;
+    std::map<Entity, uint32_t> expectedPositions;
+    std::map<Entity, uint32_t> expectedVelocities;
+    std::map<Entity, uint32_t> expectedPayloads;
+    bool isPassing = true;
+    for (uint32_t operation = 1; operation <= OperationCount; ++operation)
+    {
+        mutate(positions, expectedPositions, random, operation);
+        mutate(velocities, expectedVelocities, random, operation);
+        mutate(payloads, expectedPayloads, random, operation);
+        if (operation % 10000 != 0)
+            continue;
+
+        isPassing &= isMatching(positions, expectedPositions);
+        isPassing &= isMatching(velocities, expectedVelocities);
+        isPassing &= isMatching(payloads, expectedPayloads);
+
+        std::vector<Entity> expected;
+        for (const auto& [entity, stamp] : expectedPositions)
+        {
+            if (expectedVelocities.contains(entity) && expectedPayloads.contains(entity))
+                expected.push_back(entity);
+        }
+        const ComponentView<Position, Velocity, Payload> view(&positions, &velocities, &payloads);
+        isPassing &= check(view.sizeHint() == std::min({positions.size(), velocities.size(), payloads.size()}),
+                           "sizeHint");
+        std::vector<Entity> visited;
+        visited.reserve(EntityCount);
+        bool isRight = true;
+        const uint64_t allocationCount = s_allocationCount;
+        view.each([&](Entity entity, Position& position, Velocity& velocity, Payload& payload) {
+            const auto positionIt = expectedPositions.find(entity);
+            const auto velocityIt = expectedVelocities.find(entity);
+            const auto payloadIt = expectedPayloads.find(entity);
+            isRight &= positionIt != expectedPositions.end() && getStamp(position) == positionIt->second &&
+                       velocityIt != expectedVelocities.end() && getStamp(velocity) == velocityIt->second &&
+                       payloadIt != expectedPayloads.end() && getStamp(payload) == payloadIt->second;
+            visited.push_back(entity);
+            // Written through the view, read back from the pool below
+            position.x = static_cast<float>(entity);
+        });
+        isPassing &= check(s_allocationCount == allocationCount, "view allocates nothing");
+        isPassing &= check(isRight, "view components");
+        std::sort(visited.begin(), visited.end());
+        isPassing &= check(visited == expected, "view entities, once each");
+        for (const Entity entity : expected)
+            isPassing &= check(positions.get(entity).x == static_cast<float>(entity), "written through the view");
+
+        size_t visitedCount = 0;
+        const uint64_t singleAllocationCount = s_allocationCount;
+        ComponentView<Velocity>(&velocities).each([&](Entity entity, Velocity& velocity) {
+            isRight &= getStamp(velocity) == expectedVelocities.at(entity);
+            ++visitedCount;
+        });
+        isPassing &= check(isRight && visitedCount == velocities.size(), "single pool view");
+        isPassing &= check(s_allocationCount == singleAllocationCount, "single pool view allocates nothing");
+    }
+
+    // A type never added has no pool, see Scene::view()
+    const ComponentView<Position, Velocity> missing(&positions, nullptr);
+    bool isVisited = false;
+    missing.each([&isVisited](Entity, Position&, Velocity&) { isVisited = true; });
+    isPassing &= check(!isVisited && missing.sizeHint() == 0, "view of a missing pool");
+
+    payloads.clear();
+    expectedPayloads.clear();
+    isPassing &= isMatching(payloads, expectedPayloads);
+    payloads.emplace(EntityCount - 1, 7u);
+    expectedPayloads[EntityCount - 1] = 7;
+    isPassing &= isMatching(payloads, expectedPayloads);
+    return isPassing;
+}
+} // namespace
+
+int main()
+{
+    const bool isPassing = testPoolsAndViews();
+    std::cout << (isPassing ? "Passed" : "Failed") << std::endl;
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,228 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// Synthetic alloc/free churn for the DefragmentationSystem, e.g. on lavapipe: fills a small-block pool with buffers
+// of known content, frees most of them at random, then renders frames until the incremental defragmentation is done.
+// Fails if nothing was reclaimed or if a surviving buffer lost its content.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "huan/VulkanContext.hpp"
+#include "huan/settings.hpp"
+#include "huan/backend/resource/defragmentation_system.hpp"
+#include "huan/backend/resource/resource_registry.hpp"
+#include "huan/backend/resource/resource_system.hpp"
+#include "huan/backend/resource/vulkan_buffer.hpp"
+
+namespace
+{
+using namespace huan::runtime;
+
+// Small blocks, so freeing most buffers leaves whole blocks to reclaim
+constexpr vk::DeviceSize BlockSize = 4ull * 1024 * 1024;
+constexpr uint32_t BufferCount = 1024;
+constexpr uint32_t MinWords = 4 * 1024;
+constexpr uint32_t MaxWords = 64 * 1024;
+constexpr uint32_t ChurnRounds = 4;
+constexpr uint32_t MaxFrames = 10000;
+
+struct ChurnBuffer
+{
+    BufferHandle handle;
+    uint32_t wordCount = 0;
+    uint32_t seed = 0;
+};
+
+std::vector<uint32_t> makeContent(uint32_t wordCount, uint32_t seed)
+{
+    std::vector<uint32_t> words(wordCount);
+    std::minstd_rand generator(seed);
+    for (auto& word : words)
+    {
+        word = static_cast<uint32_t>(generator());
+    }
+    return words;
+}
+
+VmaPool createPool(huan::VulkanContext& context)
+{
+    const vk::BufferCreateInfo sampleBufferInfo{
+        {}, MaxWords * sizeof(uint32_t), vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst};
+    VmaAllocationCreateInfo sampleAllocationInfo{};
+    sampleAllocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    uint32_t memoryTypeIndex = 0;
+    if (vmaFindMemoryTypeIndexForBufferInfo(context.allocator,
+                                            reinterpret_cast<const VkBufferCreateInfo*>(&sampleBufferInfo),
+                                            &sampleAllocationInfo, &memoryTypeIndex) != VK_SUCCESS)
+        return nullptr;
+
+    VmaPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.memoryTypeIndex = memoryTypeIndex;
+    poolCreateInfo.blockSize = BlockSize;
+    VmaPool pool = nullptr;
+    if (vmaCreatePool(context.allocator, &poolCreateInfo, &pool) != VK_SUCCESS)
+        return nullptr;
+    vmaSetPoolName(context.allocator, pool, "DefragChurn");
+    return pool;
+}
+
+ChurnBuffer createBuffer(huan::VulkanContext& context, VmaPool pool, DefragmentationSystem::ListenerId listener,
+                         uint32_t wordCount, uint32_t seed)
+{
+    // TRANSFER_SRC to check the content, the listener lets the DefragmentationSystem move it
+    vulkan::BufferBuilder builder(context.allocator, vk::DeviceSize{wordCount} * sizeof(uint32_t));
+    builder.setVmaPool(pool)
+           .setVmaUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+           .setUsage(vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst)
+           .setRelocationListener(listener)
+           .setDebugName("DefragChurn");
+    ChurnBuffer buffer{ResourceRegistry::getInstance()->add(builder.build(context.device)), wordCount, seed};
+    const auto content = makeContent(wordCount, seed);
+    ResourceSystem::getInstance()->uploadBuffer(*ResourceRegistry::getInstance()->get(buffer.handle), content.data(),
+                                                content.size() * sizeof(uint32_t));
+    return buffer;
+}
+
+uint32_t getBlockCount(const huan::VulkanContext& context, VmaPool pool)
+{
+    VmaDetailedStatistics statistics{};
+    vmaCalculatePoolStatistics(context.allocator, pool, &statistics);
+    return statistics.statistics.blockCount;
+}
+
+/**
+ * @return True if the device content of `buffer` is still the one it was created with.
+ */
+bool checkContent(const ChurnBuffer& buffer, const vulkan::Buffer& readback)
+{
+    auto* registry = ResourceRegistry::getInstance();
+    const vk::DeviceSize size = vk::DeviceSize{buffer.wordCount} * sizeof(uint32_t);
+    ResourceSystem::getInstance()->executeImmediateTransfer([&](vk::CommandBuffer commandBuffer) {
+        commandBuffer.copyBuffer(registry->get(buffer.handle)->getHandle(), readback.getHandle(),
+                                 vk::BufferCopy{0, 0, size});
+    });
+    readback.invalidate(0, size);
+    const auto expected = makeContent(buffer.wordCount, buffer.seed);
+    return std::memcmp(readback.getData(), expected.data(), size) == 0;
+}
+} // namespace
+
+int main()
+{
+    huan::globalAppSettings = {
+        .title = "Defragmentation churn",
+        .width = 320,
+        .height = 240,
+        // Only the requested defragmentation runs
+        .defragmentationTriggerRatio = 0.0f,
+    };
+
+    huan::VulkanContext* app = huan::VulkanContext::getInstance();
+    int exitCode = EXIT_SUCCESS;
+    try
+    {
+        app->init();
+        VmaPool pool = createPool(*app);
+        if (pool == nullptr)
+            throw std::runtime_error("Failed to create the churn pool");
+
+        // The buffers hold no handle cache, counting the moves is enough
+        uint32_t relocatedCount = 0;
+        auto* defragmentation = DefragmentationSystem::getInstance();
+        const auto listener = defragmentation->addRelocationListener(
+            [&](vulkan::RelocatableAllocation&) { relocatedCount++; });
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<uint32_t> wordCounts(MinWords, MaxWords);
+        std::vector<ChurnBuffer> buffers;
+        uint32_t nextSeed = 1;
+        for (uint32_t i = 0; i < BufferCount; ++i)
+        {
+            buffers.push_back(createBuffer(*app, pool, listener, wordCounts(generator), nextSeed++));
+        }
+        // Free half at random and refill with other sizes, then free most of what is left
+        for (uint32_t round = 0; round < ChurnRounds; ++round)
+        {
+            std::shuffle(buffers.begin(), buffers.end(), generator);
+            for (size_t i = buffers.size() / 2; i < buffers.size(); ++i)
+            {
+                ResourceRegistry::getInstance()->destroy(buffers[i].handle);
+                buffers[i] = createBuffer(*app, pool, listener, wordCounts(generator), nextSeed++);
+            }
+        }
+        std::shuffle(buffers.begin(), buffers.end(), generator);
+        for (size_t i = buffers.size() / 4; i < buffers.size(); ++i)
+        {
+            ResourceRegistry::getInstance()->destroy(buffers[i].handle);
+        }
+        buffers.resize(buffers.size() / 4);
+
+        const uint32_t blocksBefore = getBlockCount(*app, pool);
+        if (!defragmentation->begin(pool))
+            throw std::runtime_error("Failed to begin the defragmentation");
+        // The passes run between frames, while other frames are in flight
+        uint32_t frameCount = 0;
+        while (defragmentation->isRunning() && frameCount < MaxFrames)
+        {
+            app->drawFrame();
+            frameCount++;
+        }
+        app->device.waitIdle();
+        defragmentation->removeRelocationListener(listener);
+        if (defragmentation->isRunning())
+        {
+            std::cerr << "Defragmentation still running after " << frameCount << " frames" << std::endl;
+            defragmentation->cancel();
+            exitCode = EXIT_FAILURE;
+        }
+
+        const auto& report = defragmentation->getLastReport();
+        const uint32_t blocksAfter = getBlockCount(*app, pool);
+        std::cout << "Moved " << report.allocationsMoved << " allocations (" << report.bytesMoved << " bytes, "
+                  << relocatedCount << " relocations), reclaimed " << report.bytesFreed << " bytes, blocks "
+                  << blocksBefore << " -> " << blocksAfter << ", " << report.passCount << " passes over "
+                  << report.frameCount << " frames, " << report.milliseconds << " ms" << std::endl;
+        if (report.bytesFreed == 0 || blocksAfter >= blocksBefore)
+        {
+            std::cerr << "Nothing was reclaimed" << std::endl;
+            exitCode = EXIT_FAILURE;
+        }
+
+        const auto readbackHandle =
+            ResourceSystem::getInstance()->createReadbackBuffer(MaxWords * sizeof(uint32_t), "DefragChurn.Readback");
+        uint32_t corruptedCount = 0;
+        for (const auto& buffer : buffers)
+        {
+            if (!checkContent(buffer, *ResourceRegistry::getInstance()->get(readbackHandle)))
+                corruptedCount++;
+        }
+        if (corruptedCount != 0)
+        {
+            std::cerr << corruptedCount << " of " << buffers.size() << " buffers lost their content" << std::endl;
+            exitCode = EXIT_FAILURE;
+        }
+
+        ResourceRegistry::getInstance()->destroy(readbackHandle);
+        for (auto& buffer : buffers)
+        {
+            ResourceRegistry::getInstance()->destroy(buffer.handle);
+        }
+        vmaDestroyPool(app->allocator, pool);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    app->cleanup();
+
+    return exitCode;
+}
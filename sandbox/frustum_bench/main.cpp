@@ -0,0 +1,143 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// FrustumCuller against the scalar Frustum::intersects over random boxes and cameras, on the calling thread and
+// across a ThreadPool.
+// Usage: FrustumBench [box count, 1M by default] [worker count, 0 for one per hardware thread minus one]
+// Fails if the culler keeps other draws than the scalar test, or in another order.
+//
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "huan/scene_framework/frustum_culler.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace
+{
+using namespace huan::framework::scene_graph;
+
+constexpr uint32_t CameraCount = 10;
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+ * @brief The draws carry the index of their box in `transform`.
+ */
+bool matches(const std::vector<DrawItem>& visible, const std::vector<uint32_t>& expected, const char* name)
+{
+    bool isMatching = visible.size() == expected.size();
+    for (size_t i = 0; isMatching && i < expected.size(); ++i)
+    {
+        isMatching = visible[i].transform == expected[i];
+    }
+    if (!isMatching)
+    {
+        std::cerr << name << ": " << visible.size() << " draws kept, " << expected.size() << " expected" << std::endl;
+    }
+    return isMatching;
+}
+
+void cullReference(const Frustum& frustum, const std::vector<BoundingBox>& boxes, size_t count,
+                   std::vector<uint32_t>& expected)
+{
+    expected.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (frustum.intersects(boxes[i]))
+            expected.push_back(static_cast<uint32_t>(i));
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t boxCount = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const uint32_t workerCount = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 0;
+    huan::utils::ThreadPool workers(workerCount);
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    std::vector<BoundingBox> boxes(boxCount);
+    FrustumCuller culler;
+    culler.reserve(boxCount);
+    for (size_t i = 0; i < boxCount; ++i)
+    {
+        const glm::vec3 center(position(generator), position(generator), position(generator));
+        const glm::vec3 extents(size(generator), size(generator), size(generator));
+        boxes[i] = {center - extents, center + extents};
+        DrawItem draw;
+        draw.transform = static_cast<uint32_t>(i);
+        culler.add(boxes[i], draw);
+    }
+
+    bool isMatching = true;
+    std::vector<uint32_t> expected;
+    std::vector<DrawItem> visible;
+    double scalarMilliseconds = 0.0;
+    double serialMilliseconds = 0.0;
+    double parallelMilliseconds = 0.0;
+    size_t visibleCount = 0;
+    for (uint32_t camera = 0; camera < CameraCount; ++camera)
+    {
+        const glm::vec3 eye = 0.2f * glm::vec3(position(generator), position(generator), position(generator));
+        const glm::vec3 direction(position(generator), position(generator), position(generator));
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+        projection[1][1] *= -1;
+        const Frustum frustum =
+            Frustum::fromMatrix(projection * glm::lookAt(eye, eye + direction, glm::vec3(0.0f, 0.0f, 1.0f)));
+
+        const auto begin = std::chrono::steady_clock::now();
+        cullReference(frustum, boxes, boxCount, expected);
+        scalarMilliseconds += millisecondsSince(begin) / CameraCount;
+        visibleCount += expected.size();
+
+        culler.cull(frustum, visible);
+        serialMilliseconds += culler.getStats().cullMilliseconds / CameraCount;
+        isMatching &= matches(visible, expected, "serial");
+        culler.cull(frustum, visible, &workers);
+        parallelMilliseconds += culler.getStats().cullMilliseconds / CameraCount;
+        isMatching &= matches(visible, expected, "parallel");
+    }
+    std::cout << boxCount << " boxes, " << visibleCount / CameraCount << " visible on average, "
+              << workers.getThreadCount() << " workers" << std::endl;
+    std::cout << "  scalar " << scalarMilliseconds << " ms, culler " << serialMilliseconds << " ms, culler in parallel "
+              << parallelMilliseconds << " ms" << std::endl;
+
+    // Every count up to two SIMD groups against a frustum keeping every box, the padding must never come out
+    Frustum everything;
+    for (auto& plane : everything.planes)
+    {
+        plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    for (size_t count = 0; count <= 16 && count <= boxCount; ++count)
+    {
+        culler.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            DrawItem draw;
+            draw.transform = static_cast<uint32_t>(i);
+            culler.add(boxes[i], draw);
+        }
+        cullReference(everything, boxes, count, expected);
+        culler.cull(everything, visible, &workers);
+        isMatching &= matches(visible, expected, "every box kept");
+    }
+
+    if (!isMatching)
+    {
+        std::cerr << "The culler differs from Frustum::intersects" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// OcclusionCuller on the CPU only:
+// - a wall hides the boxes behind it, not those in front of it, beside it or sticking out of it,
+// - the tile depths are never nearer than a per pixel reference rasterizer, and what is culled is hidden in it,
+// - rasterizing across a ThreadPool gives the same bits as on the calling thread, FrustumCuller keeps the same draws.
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "huan/scene_framework/frustum_culler.hpp"
+#include "huan/scene_framework/occlusion_culler.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace
+{
+using namespace huan::framework::scene_graph;
+
+constexpr uint32_t QuadCount = 100;
+constexpr uint32_t OccludeeCount = 20000;
+constexpr float DepthTolerance = 1e-5f;
+
+glm::vec3 toScreen(const glm::vec4& clip)
+{
+    return {(clip.x / clip.w * 0.5f + 0.5f) * OcclusionCuller::Width,
+            (clip.y / clip.w * 0.5f + 0.5f) * OcclusionCuller::Height, clip.z / clip.w};
+}
+
+BoundingBox makeBox(const glm::vec3& center, float extent)
+{
+    return {center - glm::vec3(extent), center + glm::vec3(extent)};
+}
+
+/**
+ * @brief Nearest depth at each pixel center, top left rule, one pixel at a time. Triangles crossing the camera
+ * plane are skipped as OcclusionCuller does.
+ */
+std::vector<float> rasterizeReference(const glm::mat4& viewProjection, const std::vector<glm::vec3>& positions,
+                                      const std::vector<uint32_t>& indices)
+{
+    constexpr auto Width = static_cast<int>(OcclusionCuller::Width);
+    constexpr auto Height = static_cast<int>(OcclusionCuller::Height);
+    std::vector<float> depths(Width * Height, 1.0f);
+    for (size_t first = 0; first + 2 < indices.size(); first += 3)
+    {
+        glm::vec3 vertices[3];
+        bool isProjected = true;
+        for (int k = 0; k < 3; ++k)
+        {
+            const glm::vec4 clip = viewProjection * glm::vec4(positions[indices[first + k]], 1.0f);
+            isProjected = isProjected && clip.w >= 1e-4f;
+            vertices[k] = toScreen(clip);
+        }
+        float area = (vertices[1].x - vertices[0].x) * (vertices[2].y - vertices[0].y) -
+                     (vertices[2].x - vertices[0].x) * (vertices[1].y - vertices[0].y);
+        if (!isProjected || std::abs(area) < 1e-6f)
+            continue;
+        if (area < 0.0f)
+        {
+            std::swap(vertices[1], vertices[2]);
+            area = -area;
+        }
+        for (int y = 0; y < Height; ++y)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                const float pixelX = static_cast<float>(x) + 0.5f;
+                const float pixelY = static_cast<float>(y) + 0.5f;
+                float weights[3];
+                bool isInside = true;
+                for (int edge = 0; edge < 3; ++edge)
+                {
+                    const glm::vec3& a = vertices[edge];
+                    const glm::vec3& b = vertices[(edge + 1) % 3];
+                    weights[edge] = (b.x - a.x) * (pixelY - a.y) - (b.y - a.y) * (pixelX - a.x);
+                    const float edgeA = a.y - b.y;
+                    const float edgeB = b.x - a.x;
+                    const bool isInclusive = edgeA > 0.0f || (edgeA == 0.0f && edgeB > 0.0f);
+                    isInside = isInside && (isInclusive ? weights[edge] >= 0.0f : weights[edge] > 0.0f);
+                }
+                if (!isInside)
+                    continue;
+                const float depth =
+                    (weights[1] * vertices[0].z + weights[2] * vertices[1].z + weights[0] * vertices[2].z) / area;
+                float& pixel = depths[y * Width + x];
+                pixel = std::min(pixel, depth);
+            }
+        }
+    }
+    return depths;
+}
+
+/**
+ * @brief Visible in the reference if a pixel under its screen rectangle is farther than its nearest point.
+ */
+bool isVisibleInReference(const glm::mat4& viewProjection, const std::vector<float>& depths, const BoundingBox& box)
+{
+    glm::vec3 screenMin(std::numeric_limits<float>::max());
+    glm::vec3 screenMax(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 position((corner & 1) != 0 ? box.max.x : box.min.x, (corner & 2) != 0 ? box.max.y : box.min.y,
+                                 (corner & 4) != 0 ? box.max.z : box.min.z);
+        const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+        if (clip.w < 1e-4f)
+            return true;
+        const glm::vec3 screen = toScreen(clip);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+    }
+    // Pixels touched by the rectangle, none if it is off the screen
+    const int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    const int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    const int maxX = std::min(static_cast<int>(OcclusionCuller::Width) - 1, static_cast<int>(std::floor(screenMax.x)));
+    const int maxY = std::min(static_cast<int>(OcclusionCuller::Height) - 1, static_cast<int>(std::floor(screenMax.y)));
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            if (depths[y * OcclusionCuller::Width + x] > screenMin.z)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool check(bool condition, const char* name)
+{
+    if (!condition)
+        std::cerr << "Failed: " << name << std::endl;
+    return condition;
+}
+
+bool testWall(const glm::mat4& viewProjection)
+{
+    // 10x10 quad at z = 0, the camera at z = 10 looking down -z
+    const std::vector<glm::vec3> positions = {{-5.0f, -5.0f, 0.0f}, {5.0f, -5.0f, 0.0f}, {5.0f, 5.0f, 0.0f},
+                                              {-5.0f, 5.0f, 0.0f}};
+    const std::vector<uint32_t> indices = {0, 1, 2, 0, 2, 3};
+    OcclusionCuller culler;
+    culler.begin(viewProjection);
+    culler.addOccluder(glm::mat4(1.0f), positions, indices);
+    culler.rasterize();
+
+    bool isPassing = check(!culler.isVisible(makeBox({0.0f, 0.0f, -5.0f}, 1.0f)), "box behind the wall hidden");
+    isPassing &= check(culler.isVisible(makeBox({0.0f, 0.0f, 5.0f}, 1.0f)), "box in front of the wall visible");
+    isPassing &= check(culler.isVisible(makeBox({12.0f, 0.0f, -5.0f}, 1.0f)), "box beside the wall visible");
+    isPassing &= check(culler.isVisible(makeBox({4.5f, 0.0f, -3.0f}, 1.5f)), "box sticking out visible");
+    isPassing &= check(!culler.isVisible(BoundingBox{}), "empty box hidden");
+    return isPassing;
+}
+
+bool testRandomQuads(const glm::mat4& viewProjection, huan::utils::ThreadPool& workers)
+{
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> lateral(-8.0f, 8.0f);
+    std::uniform_real_distribution<float> depth(-20.0f, 5.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for (uint32_t quad = 0; quad < QuadCount; ++quad)
+    {
+        const glm::vec3 center(lateral(generator), lateral(generator), depth(generator));
+        const glm::vec3 right(size(generator), 0.04f * lateral(generator), 0.03f * lateral(generator));
+        const glm::vec3 up(0.03f * lateral(generator), size(generator), 0.04f * lateral(generator));
+        const auto base = static_cast<uint32_t>(positions.size());
+        positions.insert(positions.end(), {center - right - up, center + right - up, center + right + up,
+                                           center - right + up});
+        for (const uint32_t corner : {0u, 1u, 2u, 0u, 2u, 3u})
+        {
+            indices.push_back(base + corner);
+        }
+    }
+
+    // Two occluders, the second with its own vertex numbering
+    const size_t splitVertex = positions.size() / 2 / 4 * 4;
+    const size_t splitIndex = splitVertex / 4 * 6;
+    const std::vector<glm::vec3> secondPositions(positions.begin() + static_cast<ptrdiff_t>(splitVertex),
+                                                 positions.end());
+    std::vector<uint32_t> secondIndices;
+    for (size_t i = splitIndex; i < indices.size(); ++i)
+    {
+        secondIndices.push_back(indices[i] - static_cast<uint32_t>(splitVertex));
+    }
+    OcclusionCuller serial;
+    OcclusionCuller parallel;
+    for (OcclusionCuller* culler : {&serial, &parallel})
+    {
+        culler->begin(viewProjection);
+        culler->addOccluder(glm::mat4(1.0f), std::span(positions.data(), splitVertex),
+                            std::span(indices.data(), splitIndex));
+        culler->addOccluder(glm::mat4(1.0f), secondPositions, secondIndices);
+    }
+    serial.rasterize();
+    parallel.rasterize(&workers);
+
+    const std::span<const float> tileDepths = serial.getTileDepths();
+    bool isPassing = check(std::memcmp(tileDepths.data(), parallel.getTileDepths().data(),
+                                       OcclusionCuller::TilesX * OcclusionCuller::TilesY * sizeof(float)) == 0,
+                           "threaded tile depths identical to serial");
+
+    const std::vector<float> reference = rasterizeReference(viewProjection, positions, indices);
+    uint32_t nearerPixelCount = 0;
+    for (uint32_t y = 0; y < OcclusionCuller::Height; ++y)
+    {
+        for (uint32_t x = 0; x < OcclusionCuller::Width; ++x)
+        {
+            const float tileDepth =
+                tileDepths[y / OcclusionCuller::TileHeight * OcclusionCuller::TilesX + x / OcclusionCuller::TileWidth];
+            if (reference[y * OcclusionCuller::Width + x] > tileDepth + DepthTolerance)
+                ++nearerPixelCount;
+        }
+    }
+    isPassing &= check(nearerPixelCount == 0, "tile depths never nearer than the reference pixels");
+
+    FrustumCuller frustumCuller;
+    uint32_t culledCount = 0;
+    uint32_t wronglyCulledCount = 0;
+    for (uint32_t i = 0; i < OccludeeCount; ++i)
+    {
+        // Wider than the quads, some are beside them
+        const BoundingBox box =
+            makeBox({2.0f * lateral(generator), 2.0f * lateral(generator), depth(generator) - 10.0f}, 0.3f);
+        DrawItem draw;
+        draw.transform = i;
+        frustumCuller.add(box, draw);
+        if (serial.isVisible(box))
+            continue;
+        ++culledCount;
+        if (isVisibleInReference(viewProjection, reference, box))
+            ++wronglyCulledCount;
+    }
+    isPassing &= check(culledCount > 0 && culledCount < OccludeeCount, "random occludees culled, not all of them");
+    isPassing &= check(wronglyCulledCount == 0, "culled occludees hidden in the reference");
+
+    std::vector<DrawItem> serialVisible;
+    std::vector<DrawItem> parallelVisible;
+    const Frustum frustum = Frustum::fromMatrix(viewProjection);
+    frustumCuller.cull(frustum, serialVisible, nullptr, &serial);
+    const uint32_t occludedCount = frustumCuller.getStats().occludedCount;
+    frustumCuller.cull(frustum, parallelVisible, &workers, &parallel);
+    bool isSameDraws = serialVisible.size() == parallelVisible.size() && occludedCount > 0;
+    for (size_t i = 0; isSameDraws && i < serialVisible.size(); ++i)
+    {
+        isSameDraws = serialVisible[i].transform == parallelVisible[i].transform;
+    }
+    isPassing &= check(isSameDraws, "threaded FrustumCuller with occlusion identical to serial");
+
+    std::cout << serial.getStats().triangleCount << " triangles, " << serial.getStats().rasterizedCount
+              << " rasterized, " << culledCount << " of " << OccludeeCount << " occludees culled, "
+              << occludedCount << " draws occluded" << std::endl;
+    return isPassing;
+}
+} // namespace
+
+int main()
+{
+    const glm::mat4 projection = glm::perspectiveZO(1.0f, 2.0f, 0.1f, 100.0f);
+    const glm::mat4 view =
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 viewProjection = projection * view;
+    huan::utils::ThreadPool workers(3);
+
+    bool isPassing = testWall(viewProjection);
+    isPassing &= testRandomQuads(viewProjection, workers);
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
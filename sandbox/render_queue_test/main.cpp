@@ -0,0 +1,332 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// RenderQueue on the CPU only, nothing is recorded:
+// - makeKey() orders the passes, the states of the opaque draws front to back, and the blended draws back to front,
+// - radixSort() gives the order of std::stable_sort, with and without workers,
+// - after sort(), every instanced draw holds draws of one state and geometry, the opaque ones in one draw per state
+//   and geometry, the blended ones still back to front, and the indirect runs share their pipeline and material,
+// - past 2^14 pipelines the IDs wrap around and the draws are still right.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "huan/backend/render_queue.hpp"
+#include "huan/utils/radix_sort.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace
+{
+using namespace huan::runtime;
+using huan::framework::scene_graph::DrawItem;
+
+constexpr uint32_t DrawCount = 20000;
+constexpr uint32_t PipelineCount = 12;
+constexpr uint32_t MaterialCount = 40;
+constexpr uint32_t GeometryCount = 16;
+
+/**
+ * What was pushed, the world matrix of each draw carries its index in [3].x to find it back among the instances.
+ */
+struct Pushed
+{
+    RenderQueue::Pass pass;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t geometry;
+    float viewDepth;
+};
+
+bool check(bool condition, const char* name)
+{
+    if (!condition)
+        std::cerr << "Failed: " << name << std::endl;
+    return condition;
+}
+
+vk::DescriptorSet makeDescriptorSet(uint32_t material)
+{
+    return vk::DescriptorSet(reinterpret_cast<VkDescriptorSet>(static_cast<uintptr_t>(material + 1) * 0x10));
+}
+
+DrawItem makeDraw(uint32_t geometry)
+{
+    DrawItem draw;
+    draw.indexCount = 36 + geometry % 4 * 12;
+    draw.firstIndex = geometry * 96;
+    draw.vertexOffset = static_cast<int32_t>(geometry * 24);
+    return draw;
+}
+
+void push(RenderQueue& queue, const std::vector<Pushed>& pushed)
+{
+    for (uint32_t index = 0; index < pushed.size(); ++index)
+    {
+        const Pushed& draw = pushed[index];
+        glm::mat4 world(1.0f);
+        world[3] = glm::vec4(static_cast<float>(index), 0.0f, 0.0f, 1.0f);
+        queue.push(makeDraw(draw.geometry), world, PipelineHandle(draw.pipeline + 1, 1),
+                   makeDescriptorSet(draw.material), draw.pass, draw.viewDepth);
+    }
+}
+
+std::vector<Pushed> makeDraws(std::mt19937& random, uint32_t count, uint32_t pipelineCount)
+{
+    std::uniform_int_distribution<uint32_t> pass(0, 2);
+    std::uniform_int_distribution<uint32_t> pipeline(0, pipelineCount - 1);
+    std::uniform_int_distribution<uint32_t> material(0, MaterialCount - 1);
+    std::uniform_int_distribution<uint32_t> geometry(0, GeometryCount - 1);
+    std::uniform_real_distribution<float> depth(-1.0f, 200.0f);
+    std::vector<Pushed> draws(count);
+    for (auto& draw : draws)
+    {
+        draw = {static_cast<RenderQueue::Pass>(pass(random)), pipeline(random), material(random), geometry(random),
+                depth(random)};
+    }
+    return draws;
+}
+
+float getDepth(const Pushed& draw)
+{
+    return std::max(draw.viewDepth, 0.0f);
+}
+
+bool testKeys()
+{
+    using Pass = RenderQueue::Pass;
+    bool isPassing = check(RenderQueue::makeKey(Pass::Opaque, 9999, 9999, 1e6f) <
+                               RenderQueue::makeKey(Pass::Masked, 0, 0, 0.0f),
+                           "opaque before masked");
+    isPassing &= check(RenderQueue::makeKey(Pass::Masked, 9999, 9999, 1e6f) <
+                           RenderQueue::makeKey(Pass::Blended, 0, 0, 1e6f),
+                       "masked before blended");
+    isPassing &= check(RenderQueue::makeKey(Pass::Opaque, 1, 9, 1e6f) < RenderQueue::makeKey(Pass::Opaque, 2, 0, 0.0f),
+                       "opaque sorted by pipeline first");
+    isPassing &= check(RenderQueue::makeKey(Pass::Opaque, 1, 1, 1e6f) < RenderQueue::makeKey(Pass::Opaque, 1, 2, 0.0f),
+                       "opaque sorted by material next");
+    isPassing &= check(RenderQueue::makeKey(Pass::Opaque, 1, 1, 2.0f) < RenderQueue::makeKey(Pass::Opaque, 1, 1, 3.0f),
+                       "opaque front to back");
+    isPassing &= check(RenderQueue::makeKey(Pass::Opaque, 1, 1, -5.0f) ==
+                           RenderQueue::makeKey(Pass::Opaque, 1, 1, 0.0f),
+                       "negative depth counts as 0");
+    isPassing &= check(RenderQueue::makeKey(Pass::Blended, 9, 9, 3.0f) <
+                           RenderQueue::makeKey(Pass::Blended, 0, 0, 2.0f),
+                       "blended back to front whatever the state");
+    isPassing &= check(RenderQueue::makeKey(Pass::Opaque, 1u << RenderQueue::PipelineIDBits, 0, 0.0f) ==
+                           RenderQueue::makeKey(Pass::Opaque, 0, 0, 0.0f),
+                       "pipeline IDs wrap around");
+    return isPassing;
+}
+
+bool testRadixSort(huan::utils::ThreadPool& pool)
+{
+    std::mt19937_64 random(7);
+    huan::utils::RadixSortScratch scratch;
+    bool isPassing = true;
+    // Full keys, keys using a few low bits, and keys differing in their top byte only
+    const uint64_t masks[] = {~0ull, 0x3ffull, 0xff00000000000000ull};
+    for (const size_t count : {size_t{0}, size_t{1}, size_t{1000}, size_t{300000}})
+    {
+        for (const uint64_t mask : masks)
+        {
+            std::vector<uint64_t> keys(count);
+            for (auto& key : keys)
+                key = random() & mask;
+            std::vector<uint32_t> expected(count);
+            std::iota(expected.begin(), expected.end(), 0u);
+            std::stable_sort(expected.begin(), expected.end(),
+                             [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+            for (huan::utils::ThreadPool* workers : {static_cast<huan::utils::ThreadPool*>(nullptr), &pool})
+            {
+                std::vector<uint64_t> sortedKeys = keys;
+                std::vector<uint32_t> values(count);
+                std::iota(values.begin(), values.end(), 0u);
+                huan::utils::radixSort(sortedKeys, values, scratch, workers);
+                isPassing &= check(values == expected, workers ? "radixSort threaded" : "radixSort serial");
+                isPassing &= check(std::is_sorted(sortedKeys.begin(), sortedKeys.end()), "radixSort keys sorted");
+            }
+        }
+    }
+    return isPassing;
+}
+
+/**
+ * Checks the instanced draws and the indirect runs of a sorted queue against what was pushed.
+ * @param isGrouped Whether each opaque or masked state and geometry must be a single draw, false once IDs wrap.
+ */
+bool testBatches(const RenderQueue& queue, const std::vector<Pushed>& pushed, bool isGrouped)
+{
+    const auto commands = queue.getIndirectCommands();
+    const auto transforms = queue.getInstanceTransforms();
+    bool isPassing = check(transforms.size() == pushed.size(), "one instance per draw");
+
+    std::vector<bool> isSeen(pushed.size(), false);
+    // (pass, pipeline, material, geometry) of the opaque and masked draws
+    std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> states;
+    uint32_t opaqueCommandCount = 0;
+    uint32_t nextInstance = 0;
+    uint32_t lastPass = 0;
+    float lastBlendedDepth = 1e30f;
+    const Pushed* lastBlended = nullptr;
+    std::vector<const Pushed*> commandDraws;
+    for (const auto& command : commands)
+    {
+        isPassing &= check(command.firstInstance == nextInstance && command.instanceCount > 0, "contiguous instances");
+        nextInstance += command.instanceCount;
+        if (nextInstance > transforms.size())
+            return check(false, "instances in range");
+
+        const Pushed* first = nullptr;
+        float lastDepth = 0.0f;
+        for (uint32_t instance = command.firstInstance; instance < nextInstance; ++instance)
+        {
+            const auto index = static_cast<uint32_t>(transforms[instance][3].x);
+            if (index >= pushed.size() || isSeen[index])
+                return check(false, "each draw drawn once");
+            isSeen[index] = true;
+            const Pushed& draw = pushed[index];
+            const DrawItem geometry = makeDraw(draw.geometry);
+            isPassing &= check(geometry.indexCount == command.indexCount && geometry.firstIndex == command.firstIndex &&
+                                   geometry.vertexOffset == command.vertexOffset,
+                               "draw of the command geometry");
+            if (first == nullptr)
+            {
+                first = &draw;
+                isPassing &= check(static_cast<uint32_t>(draw.pass) >= lastPass, "passes in order");
+                lastPass = static_cast<uint32_t>(draw.pass);
+                if (draw.pass != RenderQueue::Pass::Blended)
+                {
+                    states.emplace(static_cast<uint32_t>(draw.pass), draw.pipeline, draw.material, draw.geometry);
+                    ++opaqueCommandCount;
+                }
+            }
+            else
+            {
+                isPassing &= check(draw.pass == first->pass && draw.pipeline == first->pipeline &&
+                                       draw.material == first->material,
+                                   "draw of the command state");
+            }
+            if (draw.pass == RenderQueue::Pass::Blended)
+            {
+                isPassing &= check(getDepth(draw) <= lastBlendedDepth, "blended back to front");
+                lastBlendedDepth = getDepth(draw);
+            }
+            else
+            {
+                isPassing &= check(instance == command.firstInstance || getDepth(draw) >= lastDepth,
+                                   "instances front to back");
+                lastDepth = getDepth(draw);
+            }
+        }
+        if (first->pass == RenderQueue::Pass::Blended)
+        {
+            // Neighbours of the same state and geometry are merged
+            isPassing &= check(lastBlended == nullptr || lastBlended->pipeline != first->pipeline ||
+                                   lastBlended->material != first->material || lastBlended->geometry != first->geometry,
+                               "blended neighbours merged");
+            lastBlended = &pushed[static_cast<uint32_t>(transforms[nextInstance - 1][3].x)];
+        }
+        commandDraws.push_back(first);
+    }
+    isPassing &= check(nextInstance == pushed.size(), "every draw drawn");
+    if (isGrouped)
+        isPassing &= check(opaqueCommandCount == states.size(), "one draw per opaque state and geometry");
+
+    uint32_t commandIndex = 0;
+    for (const uint32_t count : queue.getIndirectCounts())
+    {
+        if (count == 0 || commandIndex + count > commandDraws.size())
+            return check(false, "indirect counts in range");
+        for (uint32_t index = commandIndex + 1; index < commandIndex + count; ++index)
+        {
+            isPassing &= check(commandDraws[index]->pipeline == commandDraws[commandIndex]->pipeline &&
+                                   commandDraws[index]->material == commandDraws[commandIndex]->material,
+                               "indirect run state");
+        }
+        commandIndex += count;
+    }
+    isPassing &= check(commandIndex == commandDraws.size(), "indirect counts cover the commands");
+    return isPassing;
+}
+
+bool isSameResult(const RenderQueue& a, const RenderQueue& b)
+{
+    const auto commandsA = a.getIndirectCommands();
+    const auto commandsB = b.getIndirectCommands();
+    if (commandsA.size() != commandsB.size() || a.getInstanceTransforms().size() != b.getInstanceTransforms().size())
+        return false;
+    for (size_t index = 0; index < commandsA.size(); ++index)
+    {
+        if (commandsA[index].firstInstance != commandsB[index].firstInstance ||
+            commandsA[index].instanceCount != commandsB[index].instanceCount ||
+            commandsA[index].firstIndex != commandsB[index].firstIndex)
+            return false;
+    }
+    for (size_t index = 0; index < a.getInstanceTransforms().size(); ++index)
+    {
+        if (a.getInstanceTransforms()[index][3].x != b.getInstanceTransforms()[index][3].x)
+            return false;
+    }
+    return std::ranges::equal(a.getIndirectCounts(), b.getIndirectCounts());
+}
+
+bool testQueue(huan::utils::ThreadPool& pool)
+{
+    std::mt19937 random(11);
+    RenderQueue serial;
+    RenderQueue threaded;
+    bool isPassing = true;
+    // A few frames, so that the IDs kept across frames are used again
+    for (uint32_t frame = 0; frame < 3; ++frame)
+    {
+        const std::vector<Pushed> pushed = makeDraws(random, DrawCount, PipelineCount);
+        serial.clear();
+        threaded.clear();
+        push(serial, pushed);
+        push(threaded, pushed);
+        serial.sort();
+        threaded.sort(&pool);
+        isPassing &= check(serial.size() == pushed.size(), "size");
+        isPassing &= testBatches(serial, pushed, true);
+        isPassing &= check(isSameResult(serial, threaded), "threaded sort same as serial");
+    }
+
+    RenderQueue empty;
+    empty.sort(&pool);
+    isPassing &= check(empty.getIndirectCommands().empty() && empty.getIndirectCounts().empty(), "empty queue");
+    return isPassing;
+}
+
+bool testWrapAround(huan::utils::ThreadPool& pool)
+{
+    std::mt19937 random(13);
+    const uint32_t pipelineCount = (1u << RenderQueue::PipelineIDBits) + 100;
+    std::vector<Pushed> pushed = makeDraws(random, pipelineCount * 2, pipelineCount);
+    // Every pipeline at least once, so that the IDs go past the bits of the key
+    for (uint32_t pipeline = 0; pipeline < pipelineCount; ++pipeline)
+        pushed[pipeline].pipeline = pipeline;
+    RenderQueue queue;
+    push(queue, pushed);
+    queue.sort(&pool);
+    return testBatches(queue, pushed, false);
+}
+} // namespace
+
+int main()
+{
+    huan::utils::ThreadPool pool;
+    bool isPassing = testKeys();
+    isPassing &= testRadixSort(pool);
+    isPassing &= testQueue(pool);
+    isPassing &= testWrapAround(pool);
+    std::cout << (isPassing ? "Passed" : "Failed") << std::endl;
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
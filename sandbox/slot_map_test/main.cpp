@@ -0,0 +1,169 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// SlotMap against a std::unordered_map through random inserts and erases:
+// - every live handle finds its value, handleOf() gives it back, iteration sees each value once,
+// - a handle erased, or invalidated by clear(), stays stale once its slot is given again,
+// - the generation of a slot reused past 2^12 times wraps around and never makes the null handle,
+// - past MaxIndex slots emplace() returns the null handle.
+//
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "huan/common_templates/slot_map.hpp"
+
+namespace
+{
+using huan::SlotMap;
+
+constexpr uint32_t OperationCount = 200000;
+
+/**
+ * Move constructible only, like the resources the map holds, so that erase() rebuilds the moved value in place.
+ */
+struct Value
+{
+    explicit Value(uint32_t key) : key(key), payload(std::make_unique<uint32_t>(key * 3 + 1))
+    {
+    }
+    Value(Value&&) = default;
+    Value& operator=(Value&&) = delete;
+
+    uint32_t key;
+    std::unique_ptr<uint32_t> payload;
+};
+using Map = SlotMap<Value>;
+using Handle = Map::HandleType;
+
+bool check(bool condition, const char* name)
+{
+    if (!condition)
+        std::cerr << "Failed: " << name << std::endl;
+    return condition;
+}
+
+bool isMatching(const Map& map, const std::unordered_map<uint32_t, uint32_t>& expected)
+{
+    bool isPassing = check(map.size() == expected.size(), "size");
+    for (const auto& [value, key] : expected)
+    {
+        const Handle handle(value & Handle::IndexMask, value >> Handle::IndexBits);
+        const Value* found = map.get(handle);
+        if (!check(found != nullptr && found->key == key && *found->payload == key * 3 + 1, "live handle value"))
+            return false;
+        isPassing &= check(map.handleOf(found) == handle, "handleOf");
+    }
+    std::unordered_set<uint32_t> seen;
+    for (const Value& value : map)
+        isPassing &= check(seen.insert(value.key).second, "iterated once");
+    return isPassing && check(seen.size() == expected.size(), "iteration size");
+}
+
+bool testRandom()
+{
+    std::mt19937 random(5);
+    Map map;
+    // Key of each live handle, by handle value
+    std::unordered_map<uint32_t, uint32_t> expected;
+    std::vector<Handle> live;
+    std::vector<Handle> stale;
+    bool isPassing = true;
+    uint32_t nextKey = 0;
+    for (uint32_t operation = 0; operation < OperationCount; ++operation)
+    {
+        // Grows to a few thousand values, then shrinks, so that slots get reused many times
+        const bool isGrowing = (operation / 20000) % 2 == 0;
+        if (live.empty() || random() % 100 < (isGrowing ? 60u : 40u))
+        {
+            const Handle handle = map.emplace(nextKey);
+            isPassing &= check(handle.isValid() && !map.contains(Handle{}), "emplace");
+            expected.emplace(handle.getValue(), nextKey++);
+            live.push_back(handle);
+        }
+        else
+        {
+            const size_t index = random() % live.size();
+            const Handle handle = live[index];
+            isPassing &= check(map.erase(handle), "erase");
+            isPassing &= check(!map.erase(handle), "erase twice");
+            expected.erase(handle.getValue());
+            stale.push_back(handle);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        if (operation % 10000 == 0)
+            isPassing &= isMatching(map, expected);
+    }
+    isPassing &= isMatching(map, expected);
+
+    // Slots are reused at most a few hundred times here, far from wrapping the generation around
+    for (const Handle handle : stale)
+    {
+        if (!check(!map.contains(handle) && map.get(handle) == nullptr, "stale handle after erase"))
+            return false;
+    }
+
+    map.clear();
+    isPassing &= check(map.empty(), "clear");
+    for (const Handle handle : live)
+        isPassing &= check(!map.contains(handle), "stale handle after clear");
+    // The slots freed by clear() are given again, with a new generation
+    for (const Handle handle : live)
+    {
+        const Handle reused = map.emplace(0u);
+        isPassing &= check(reused != handle && !map.contains(handle), "reused slot, new handle");
+    }
+    return isPassing;
+}
+
+bool testGenerationWrapAround()
+{
+    Map map;
+    bool isPassing = true;
+    // One slot, reused until its generation wraps around twice
+    const Handle first = map.emplace(0u);
+    Handle handle = first;
+    for (uint32_t reuse = 0; reuse < 2 * Handle::GenerationMask + 2; ++reuse)
+    {
+        isPassing &= check(map.erase(handle), "erase of the only value");
+        const Handle previous = handle;
+        handle = map.emplace(reuse + 1);
+        isPassing &= check(handle.isValid() && handle.getIndex() == first.getIndex(), "same slot, never null");
+        isPassing &= check(handle.getGeneration() != 0 && handle != previous, "generation moves on, skipping 0");
+        isPassing &= check(!map.contains(previous), "previous handle stale");
+        if (!isPassing)
+            return false;
+    }
+    return isPassing;
+}
+
+bool testFull()
+{
+    SlotMap<uint32_t> map;
+    map.reserve(Handle::MaxIndex + 1);
+    bool isPassing = true;
+    for (uint32_t index = 0; index <= Handle::MaxIndex; ++index)
+    {
+        if (!check(map.emplace(index).isValid(), "emplace below MaxIndex"))
+            return false;
+    }
+    isPassing &= check(!map.emplace(0u).isValid(), "emplace past MaxIndex");
+    isPassing &= check(map.size() == Handle::MaxIndex + 1, "size when full");
+    return isPassing;
+}
+} // namespace
+
+int main()
+{
+    bool isPassing = testRandom();
+    isPassing &= testGenerationWrapAround();
+    isPassing &= testFull();
+    std::cout << (isPassing ? "Passed" : "Failed") << std::endl;
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
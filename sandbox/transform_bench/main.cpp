@@ -0,0 +1,129 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// TransformSystem::update over a large hierarchy, on the calling thread then split across a ThreadPool.
+// Usage: TransformBench [transform count, 1M by default] [worker count, 0 for one per hardware thread minus one]
+// Fails if the parallel world matrices differ from the serial ones.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "huan/scene_framework/transform_system.hpp"
+#include "huan/utils/thread_pool.hpp"
+
+namespace
+{
+using namespace huan::framework::scene_graph;
+
+constexpr uint32_t RootCount = 1000;
+// Children per parent, the hierarchy is about log8(count) levels deep
+constexpr uint32_t Fanout = 8;
+constexpr uint32_t RepeatCount = 10;
+
+struct Timing
+{
+    double minMilliseconds = 0.0;
+    double averageMilliseconds = 0.0;
+    uint32_t updatedCount = 0;
+};
+
+/**
+ * @brief Runs `prepare` then update() `RepeatCount` times.
+ */
+template <class Prepare>
+Timing measure(TransformSystem& transforms, huan::utils::ThreadPool* workers, Prepare&& prepare)
+{
+    Timing timing;
+    timing.minMilliseconds = 1e30;
+    for (uint32_t i = 0; i < RepeatCount; ++i)
+    {
+        prepare(i);
+        transforms.update(workers);
+        const auto& stats = transforms.getStats();
+        timing.minMilliseconds = std::min(timing.minMilliseconds, stats.updateMilliseconds);
+        timing.averageMilliseconds += stats.updateMilliseconds / RepeatCount;
+        timing.updatedCount = stats.updatedCount;
+    }
+    return timing;
+}
+
+void print(const char* name, const Timing& timing)
+{
+    std::cout << "  " << name << ": " << timing.updatedCount << " updated, min " << timing.minMilliseconds
+              << " ms, average " << timing.averageMilliseconds << " ms" << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t transformCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 1000000;
+    const uint32_t workerCount = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 0;
+    huan::utils::ThreadPool workers(workerCount);
+
+    TransformSystem transforms;
+    std::vector<TransformID> ids;
+    ids.reserve(transformCount);
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (uint32_t i = 0; i < transformCount; ++i)
+    {
+        const TransformID parent = i < RootCount ? InvalidTransformID : ids[(i - RootCount) / Fanout];
+        ids.push_back(transforms.create(parent));
+        const glm::quat rotation =
+            glm::normalize(glm::quat(1.0f, 0.2f * unit(generator), 0.2f * unit(generator), 0.0f));
+        transforms.setLocal(ids.back(), {unit(generator), unit(generator), unit(generator)}, rotation,
+                            glm::vec3(1.0f + 0.01f * unit(generator)));
+    }
+
+    transforms.update(&workers);
+    const auto& firstStats = transforms.getStats();
+    std::cout << transforms.size() << " transforms, " << firstStats.levelCount << " levels, "
+              << workers.getThreadCount() << " workers" << std::endl;
+    std::cout << "  first update: sort " << firstStats.sortMilliseconds << " ms, update "
+              << firstStats.updateMilliseconds << " ms" << std::endl;
+
+    auto moveAll = [&](uint32_t iteration) {
+        for (const auto id : ids)
+        {
+            transforms.setPosition(id, {static_cast<float>(iteration), 0.0f, 0.0f});
+        }
+    };
+    // The roots move, which dirties everything below them
+    auto moveRoots = [&](uint32_t iteration) {
+        for (uint32_t i = 0; i < RootCount; ++i)
+        {
+            transforms.setPosition(ids[i], {0.0f, static_cast<float>(iteration), 0.0f});
+        }
+    };
+    // About one percent of the leaves
+    auto moveLeaves = [&](uint32_t iteration) {
+        for (size_t i = ids.size() - ids.size() / 100; i < ids.size(); ++i)
+        {
+            transforms.setPosition(ids[i], {0.0f, 0.0f, static_cast<float>(iteration)});
+        }
+    };
+    auto nothing = [](uint32_t) {};
+
+    print("all dirty, serial", measure(transforms, nullptr, moveAll));
+    const std::vector<glm::mat4> serialMatrices = transforms.getWorldMatrices();
+    print("all dirty, parallel", measure(transforms, &workers, moveAll));
+    const bool isIdentical = std::memcmp(serialMatrices.data(), transforms.getWorldMatrices().data(),
+                                         serialMatrices.size() * sizeof(glm::mat4)) == 0;
+
+    print("roots moved, parallel", measure(transforms, &workers, moveRoots));
+    print("1% of leaves moved, parallel", measure(transforms, &workers, moveLeaves));
+    print("clean, parallel", measure(transforms, &workers, nothing));
+
+    if (!isIdentical)
+    {
+        std::cerr << "The parallel world matrices differ from the serial ones" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
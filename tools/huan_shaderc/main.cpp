@@ -0,0 +1,404 @@
+//
+// Created by 86156 on 10/19/2026.
+//
+// huan_shaderc: expands a permutation manifest (see assets/Shaders/permutations.txt), compiles every
+// permutation in parallel and packs the results into a ShaderArchive.
+//
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "huan/backend/shader.hpp"
+#include "huan/backend/shader/glsl_compiler.hpp"
+#include "huan/backend/shader/shader_archive.hpp"
+#include "huan/backend/shader/shader_resource_io.hpp"
+#include "huan/backend/shader/spirv_optimizer.hpp"
+#include "huan/backend/shader/spirv_reflection.hpp"
+#include "huan/log/Log.hpp"
+
+namespace
+{
+struct Axis
+{
+    std::string name;
+    // "_" leaves the definition out
+    std::vector<std::string> values;
+};
+
+struct ShaderEntry
+{
+    std::string path;
+    vk::ShaderStageFlagBits stage;
+    std::string entryPoint = "main";
+    std::vector<Axis> axes;
+    // Every rule is a list of NAME=value pairs
+    std::vector<std::vector<std::pair<std::string, std::string>>> exclusions;
+};
+
+struct Manifest
+{
+    std::filesystem::path root;
+    std::vector<ShaderEntry> shaders;
+};
+
+struct Permutation
+{
+    const ShaderEntry* shader;
+    huan::runtime::vulkan::ShaderVariant variant;
+    std::string description;
+};
+
+std::optional<vk::ShaderStageFlagBits> parseStage(std::string_view stage)
+{
+    static const std::unordered_map<std::string_view, vk::ShaderStageFlagBits> stages = {
+        {"vert", vk::ShaderStageFlagBits::eVertex},
+        {"frag", vk::ShaderStageFlagBits::eFragment},
+        {"comp", vk::ShaderStageFlagBits::eCompute},
+        {"geom", vk::ShaderStageFlagBits::eGeometry},
+        {"tesc", vk::ShaderStageFlagBits::eTessellationControl},
+        {"tese", vk::ShaderStageFlagBits::eTessellationEvaluation},
+    };
+    const auto it = stages.find(stage);
+    return it == stages.end() ? std::nullopt : std::optional(it->second);
+}
+
+std::optional<Manifest> parseManifest(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Can't open manifest " << path << std::endl;
+        return std::nullopt;
+    }
+
+    Manifest manifest;
+    manifest.root = path.parent_path();
+    std::string line;
+    uint32_t lineNumber = 0;
+    auto fail = [&](std::string_view message) {
+        std::cerr << path.string() << ":" << lineNumber << ": " << message << std::endl;
+        return std::nullopt;
+    };
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (const auto comment = line.find('#'); comment != std::string::npos)
+            line.resize(comment);
+
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command))
+            continue;
+
+        if (command == "root")
+        {
+            std::string root;
+            if (!(words >> root))
+                return fail("root needs a directory");
+            manifest.root = path.parent_path() / root;
+        }
+        else if (command == "shader")
+        {
+            ShaderEntry shader;
+            std::string stage;
+            if (!(words >> shader.path >> stage))
+                return fail("shader needs a path and a stage");
+            const auto parsedStage = parseStage(stage);
+            if (!parsedStage)
+                return fail("unknown stage " + stage);
+            shader.stage = *parsedStage;
+            words >> shader.entryPoint;
+            manifest.shaders.push_back(std::move(shader));
+        }
+        else if (command == "axis" || command == "exclude")
+        {
+            if (manifest.shaders.empty())
+                return fail(command + " before any shader");
+            auto& shader = manifest.shaders.back();
+            if (command == "axis")
+            {
+                Axis axis;
+                std::string value;
+                if (!(words >> axis.name))
+                    return fail("axis needs a name");
+                while (words >> value)
+                    axis.values.push_back(value);
+                if (axis.values.empty())
+                    return fail("axis " + axis.name + " has no value");
+                shader.axes.push_back(std::move(axis));
+            }
+            else
+            {
+                std::vector<std::pair<std::string, std::string>> rule;
+                std::string pair;
+                while (words >> pair)
+                {
+                    const auto equal = pair.find('=');
+                    if (equal == std::string::npos)
+                        return fail("exclude expects NAME=value pairs");
+                    rule.emplace_back(pair.substr(0, equal), pair.substr(equal + 1));
+                }
+                shader.exclusions.push_back(std::move(rule));
+            }
+        }
+        else
+        {
+            return fail("unknown command " + command);
+        }
+    }
+    return manifest;
+}
+
+/**
+ * Cartesian product of the axes of `shader`, minus the excluded combinations.
+ */
+void expandPermutations(const ShaderEntry& shader, std::vector<Permutation>& permutations)
+{
+    std::vector<size_t> choice(shader.axes.size(), 0);
+    while (true)
+    {
+        const bool excluded = std::ranges::any_of(shader.exclusions, [&](const auto& rule) {
+            return std::ranges::all_of(rule, [&](const auto& pair) {
+                for (size_t i = 0; i < shader.axes.size(); ++i)
+                {
+                    if (shader.axes[i].name == pair.first)
+                        return shader.axes[i].values[choice[i]] == pair.second;
+                }
+                return false;
+            });
+        });
+
+        if (!excluded)
+        {
+            Permutation permutation{&shader, {}, shader.path};
+            for (size_t i = 0; i < shader.axes.size(); ++i)
+            {
+                const auto& value = shader.axes[i].values[choice[i]];
+                permutation.description += " " + shader.axes[i].name + "=" + value;
+                if (value != "_")
+                    permutation.variant.addDef(shader.axes[i].name + "=" + value);
+            }
+            permutations.push_back(std::move(permutation));
+        }
+
+        // Odometer increment, the first axis changes fastest
+        size_t axis = 0;
+        while (axis < choice.size() && ++choice[axis] == shader.axes[axis].values.size())
+        {
+            choice[axis++] = 0;
+        }
+        if (axis == choice.size())
+            break;
+    }
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// What a module pays for its resources: a spirv_cross reflection on a cold cache, reading the serialized form on a
+// warm one
+struct ReflectionBenchmark
+{
+    uint32_t moduleCount = 0;
+    double reflectMilliseconds = 0.0;
+    double readMilliseconds = 0.0;
+    size_t serializedBytes = 0;
+
+    void addModule(double reflectTime, const std::vector<huan::runtime::vulkan::ShaderResource>& resources)
+    {
+        // Repeated, a single read is below the clock resolution
+        constexpr uint32_t ReadRepeatCount = 100;
+        huan::utils::BinaryWriter writer;
+        huan::runtime::writeShaderResources(writer, resources);
+        std::vector<huan::runtime::vulkan::ShaderResource> readBack;
+        const auto begin = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ReadRepeatCount; ++i)
+        {
+            huan::utils::BinaryReader reader(writer.getData().data(), writer.getSize());
+            huan::runtime::readShaderResources(reader, readBack);
+        }
+        readMilliseconds += millisecondsSince(begin) / ReadRepeatCount;
+        reflectMilliseconds += reflectTime;
+        serializedBytes += writer.getSize();
+        ++moduleCount;
+    }
+
+    void print() const
+    {
+        if (moduleCount == 0)
+            return;
+        const double reflectUs = reflectMilliseconds * 1000.0 / moduleCount;
+        const double readUs = readMilliseconds * 1000.0 / moduleCount;
+        std::cout << "Reflection per module: " << reflectUs << " us with spirv_cross, " << readUs
+                  << " us from the cache (" << serializedBytes / moduleCount << " bytes, "
+                  << (readUs > 0.0 ? reflectUs / readUs : 0.0) << "x)" << std::endl;
+    }
+};
+
+std::optional<std::string> readText(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return std::nullopt;
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+int printUsage()
+{
+    std::cerr << "Usage: huan_shaderc <manifest> -o <archive> [--list] [--bench] [--no-opt] [--strip]" << std::endl;
+    return EXIT_FAILURE;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path manifestPath;
+    std::filesystem::path outputPath;
+    bool listOnly = false;
+    bool benchmark = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "-o" && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (argument == "--list")
+            listOnly = true;
+        else if (argument == "--bench")
+            benchmark = true;
+        else if (argument == "--no-opt")
+            huan::runtime::SPIRVOptimizer::setEnabled(false);
+        else if (argument == "--strip")
+            huan::runtime::SPIRVOptimizer::setStripEnabled(true);
+        else if (manifestPath.empty())
+            manifestPath = argument;
+        else
+            return printUsage();
+    }
+    if (manifestPath.empty() || (outputPath.empty() && !listOnly))
+        return printUsage();
+
+    huan::Log::init();
+    const auto manifest = parseManifest(manifestPath);
+    if (!manifest)
+        return EXIT_FAILURE;
+
+    std::vector<Permutation> permutations;
+    for (const auto& shader : manifest->shaders)
+    {
+        expandPermutations(shader, permutations);
+    }
+    std::cout << permutations.size() << " permutations from " << manifest->shaders.size() << " shaders" << std::endl;
+    if (listOnly)
+    {
+        for (const auto& permutation : permutations)
+        {
+            std::cout << "  " << permutation.description << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // The output is opened relative to the working directory, includes are resolved relative to the root
+    outputPath = std::filesystem::absolute(outputPath);
+    std::filesystem::current_path(manifest->root);
+
+    // Preprocess every shader file once, its permutations only differ by the preamble
+    std::unordered_map<std::string, std::string> sources;
+    std::vector<huan::runtime::ShaderCompileJob> jobs;
+    jobs.reserve(permutations.size());
+    for (const auto& permutation : permutations)
+    {
+        auto [source, inserted] = sources.try_emplace(permutation.shader->path);
+        if (inserted)
+        {
+            const auto text = readText(permutation.shader->path);
+            if (!text)
+            {
+                std::cerr << "Can't read " << (manifest->root / permutation.shader->path) << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::string infoLog;
+            if (!huan::runtime::vulkan::preprocessShader(*text, permutation.shader->path, source->second, infoLog))
+            {
+                std::cerr << infoLog << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        jobs.push_back({permutation.shader->stage, source->second, permutation.shader->entryPoint,
+                        permutation.variant, permutation.description});
+    }
+
+    auto futures = huan::runtime::GLSLCompiler::compileBatch(std::move(jobs));
+
+    huan::runtime::ShaderArchiveWriter writer;
+    uint32_t failureCount = 0;
+    ReflectionBenchmark reflectionBenchmark;
+    for (size_t i = 0; i < permutations.size(); ++i)
+    {
+        const auto& permutation = permutations[i];
+        auto result = futures[i].get();
+        std::vector<huan::runtime::vulkan::ShaderResource> resources;
+        const auto reflectBegin = std::chrono::steady_clock::now();
+        if (!result.success || !huan::runtime::SPIRVReflection::reflectShaderResources(
+                                   permutation.shader->stage, result.spirv, permutation.variant, resources))
+        {
+            std::cerr << "Failed: " << permutation.description << std::endl;
+            ++failureCount;
+            continue;
+        }
+        if (benchmark)
+            reflectionBenchmark.addModule(millisecondsSince(reflectBegin), resources);
+        if (huan::runtime::SPIRVOptimizer::isStripEnabled() &&
+            !huan::runtime::SPIRVOptimizer::strip(result.spirv, result.infoLog))
+        {
+            std::cerr << "Failed to strip: " << permutation.description << "\n" << result.infoLog << std::endl;
+            ++failureCount;
+            continue;
+        }
+
+        const auto variantID = huan::runtime::ShaderArchive::computeVariantID(
+            permutation.shader->path, permutation.shader->stage, permutation.shader->entryPoint, permutation.variant);
+        if (!writer.add(variantID, permutation.shader->stage, result.spirv, resources))
+        {
+            std::cerr << "Duplicated permutation: " << permutation.description << std::endl;
+            ++failureCount;
+        }
+    }
+
+    if (failureCount != 0)
+    {
+        std::cerr << failureCount << " permutations failed, " << outputPath << " is left untouched" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!writer.write(outputPath.string()))
+    {
+        std::cerr << "Can't write " << outputPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << writer.getEntryCount() << " variants to " << outputPath << std::endl;
+    if (benchmark)
+    {
+        reflectionBenchmark.print();
+        const auto optimizerStats = huan::runtime::SPIRVOptimizer::getStats();
+        if (optimizerStats.optimizedCount != 0)
+        {
+            std::cout << "spirv-opt: " << optimizerStats.bytesIn << " -> " << optimizerStats.bytesOut << " bytes over "
+                      << optimizerStats.optimizedCount << " modules, "
+                      << optimizerStats.optimizeMilliseconds / optimizerStats.optimizedCount << " ms per module"
+                      << std::endl;
+        }
+        if (optimizerStats.strippedCount != 0)
+            std::cout << "Stripped " << optimizerStats.strippedBytes << " bytes of debug info" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}